@@ -20,6 +20,9 @@
 #include <algorithm> // std::transform
 #include <cassert>
 #include <cmath>
+#include <cstdio> // std::sprintf, std::rename
+#include <cstdlib> // std::atof
+#include <fstream>
 
 #include "Defaults.h"
 #include "Paths.h"
@@ -29,6 +32,8 @@
 #include "WindowsWarnings.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
 
 #include <madaisys/SystemTools.hxx>
 
@@ -112,6 +117,18 @@ std::string GetPosteriorAnalysisDirectory( const std::string & statisticsDirecto
     Defaults::POSTERIOR_ANALYSIS_DIRECTORY );
 }
 
+std::string GetChainFileName( const std::string & traceFile, int chain )
+{
+  char suffix[32];
+  std::sprintf( suffix, "_%03d", chain );
+  std::string fileName( traceFile );
+  size_t extension = fileName.rfind( ".csv" );
+  if ( extension == std::string::npos ) {
+    extension = fileName.size();
+  }
+  return fileName.insert( extension, suffix );
+}
+
 bool IsTraceCompressed( const std::string & traceFile )
 {
     std::ifstream file(traceFile.c_str(), std::ios_base::in | std::ios_base::binary);
@@ -126,6 +143,131 @@ bool IsTraceCompressed( const std::string & traceFile )
     return true;
 }
 
+/** Count the lines of a file, up to maximumNumberOfLines if it is not
+ * negative, and find where the last of them ends and where the file
+ * ends. Returns the number of lines, or -1 if the file cannot be
+ * read. */
+static int CountLines( const std::string & file, int maximumNumberOfLines,
+                       std::streamoff & linesEnd, std::streamoff & fileEnd )
+{
+  std::ifstream input( file.c_str(), std::ios_base::in | std::ios_base::binary );
+  if ( !input.good() ) {
+    return -1;
+  }
+
+  int numberOfLines = 0;
+  linesEnd = 0;
+  fileEnd = 0;
+  std::vector< char > buffer( 1 << 16 );
+  while ( input.read( &buffer[0], buffer.size() ) || input.gcount() > 0 ) {
+    std::streamsize count = input.gcount();
+    for ( std::streamsize i = 0; i < count; ++i ) {
+      if ( buffer[i] == '\n' && numberOfLines != maximumNumberOfLines ) {
+        ++numberOfLines;
+        linesEnd = fileEnd + i + 1;
+      }
+    }
+    fileEnd += count;
+  }
+  return numberOfLines;
+}
+
+/** Replace a file with its first length bytes. */
+static bool TruncateFile( const std::string & file, std::streamoff length )
+{
+  std::string temporaryFile = file + ".tmp";
+  {
+    std::ifstream input( file.c_str(), std::ios_base::in | std::ios_base::binary );
+    std::ofstream output( temporaryFile.c_str(), std::ios_base::out | std::ios_base::binary );
+    std::vector< char > buffer( 1 << 16 );
+    for ( std::streamoff copied = 0; copied < length; ) {
+      std::streamsize count = static_cast< std::streamsize >(
+        std::min( static_cast< std::streamoff >( buffer.size() ), length - copied ) );
+      input.read( &buffer[0], count );
+      output.write( &buffer[0], count );
+      copied += count;
+    }
+    if ( !input.good() || !output.good() ) {
+      return false;
+    }
+  }
+  SystemTools::RemoveFile( file.c_str() );
+  return ( std::rename( temporaryFile.c_str(), file.c_str() ) == 0 );
+}
+
+int TruncateTraceToCompleteLines( const std::string & traceFile )
+{
+  std::streamoff linesEnd, fileEnd;
+  int numberOfLines = CountLines( traceFile, -1, linesEnd, fileEnd );
+  if ( numberOfLines < 0 ||
+       ( linesEnd != fileEnd && !TruncateFile( traceFile, linesEnd ) ) ) {
+    return -1;
+  }
+  return numberOfLines;
+}
+
+bool TruncateTraceToLines( const std::string & traceFile, int numberOfLines )
+{
+  std::streamoff linesEnd, fileEnd;
+  if ( CountLines( traceFile, numberOfLines, linesEnd, fileEnd ) != numberOfLines ) {
+    return false;
+  }
+  return ( linesEnd == fileEnd || TruncateFile( traceFile, linesEnd ) );
+}
+
+bool ReadTraceSamples( const std::string & traceFile,
+                       const std::vector< Parameter > & parameters,
+                       std::vector< Sample > & samples )
+{
+  samples.clear();
+  std::ifstream file( traceFile.c_str(), std::ios_base::in | std::ios_base::binary );
+  if ( !file.good() ) {
+    return false;
+  }
+  boost::iostreams::filtering_streambuf< boost::iostreams::input > inbuf;
+  if ( IsTraceCompressed( traceFile ) ) {
+    inbuf.push( boost::iostreams::gzip_decompressor() );
+  }
+  inbuf.push( file );
+  std::istream trace( &inbuf );
+
+  // Find the columns of the parameters and of the log likelihood.
+  std::string header;
+  if ( !std::getline( trace, header ) ) {
+    return false;
+  }
+  std::vector< std::string > names = SplitString( header, ',' );
+  for ( size_t i = 0; i < names.size(); ++i ) {
+    boost::algorithm::trim_if( names[i], boost::algorithm::is_any_of( "\"" ) );
+  }
+  std::vector< int > columns;
+  for ( size_t i = 0; i < parameters.size(); ++i ) {
+    columns.push_back( FindIndex( names, parameters[i].m_Name ) );
+    if ( columns.back() < 0 ) {
+      return false;
+    }
+  }
+  int logLikelihoodColumn = FindIndex( names, std::string( "LogLikelihood" ) );
+  if ( logLikelihoodColumn < 0 ) {
+    return false;
+  }
+
+  std::string line;
+  while ( std::getline( trace, line ) ) {
+    std::vector< std::string > fields = SplitString( line, ',' );
+    if ( fields.size() < names.size() ) {
+      return false;
+    }
+    Sample sample;
+    for ( size_t i = 0; i < columns.size(); ++i ) {
+      sample.m_ParameterValues.push_back( std::atof( fields[ columns[i] ].c_str() ) );
+    }
+    sample.m_LogLikelihood = std::atof( fields[ logLikelihoodColumn ].c_str() );
+    samples.push_back( sample );
+  }
+  return true;
+}
+
 bool IsFile( const char * path )
 {
   return ( SystemTools::FileExists( path ) &&
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "Model.h"
+#include "Sample.h"
 
 namespace madai {
 
@@ -62,12 +63,41 @@ std::string GetInactiveParametersFile( const std::string & statisticsDirectory,
 std::string GetPosteriorAnalysisDirectory( const std::string & statisticsDirectory,
                                            const RuntimeParameterFileReader & settings );
 
+/**
+ * Get the name of the trace file of one of several chains. The chain
+ * number is inserted as _001, _002, ... before the ".csv" extension,
+ * or appended if the file name has no such extension. */
+std::string GetChainFileName( const std::string & traceFile, int chain );
+
 /**
  * Opens the trace file and determines whether it has been gzipped or
  * not. This is done by checking if the first character is '"' which
  * indicates that it is not compressed. */
 bool IsTraceCompressed( const std::string & traceFile );
 
+/**
+ * Prepares an uncompressed trace file for appending after an
+ * interruption: removes an incomplete last line, if any, and returns
+ * the number of complete lines, including the header. Returns -1 if
+ * the file cannot be read or rewritten. */
+int TruncateTraceToCompleteLines( const std::string & traceFile );
+
+/**
+ * Keeps only the first numberOfLines lines of an uncompressed trace
+ * file, as when restarting from a checkpoint that was written before
+ * the lines that follow. Returns false if the file has fewer complete
+ * lines or cannot be rewritten. */
+bool TruncateTraceToLines( const std::string & traceFile, int numberOfLines );
+
+/**
+ * Reads the parameter values and log likelihoods of the samples in a
+ * trace file, which may be compressed. The columns are matched to the
+ * parameters by name. Returns false if the file cannot be read or has
+ * no column for one of the parameters or for the log likelihood. */
+bool ReadTraceSamples( const std::string & traceFile,
+                       const std::vector< Parameter > & parameters,
+                       std::vector< Sample > & samples );
+
 /**
  * Returns a string where all the characters in the input parameter
  * are lowercase. */
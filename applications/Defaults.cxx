@@ -66,12 +66,74 @@ const int Defaults::SAMPLER_NUMBER_OF_SAMPLES = 100;
 
 const std::string Defaults::SAMPLER_INACTIVE_PARAMETERS_FILE = "";
 
+const int Defaults::SAMPLER_NUMBER_OF_CHAINS = 1;
+
+const bool Defaults::SAMPLER_INTERLEAVE_CHAINS = false;
+
+const int Defaults::SAMPLER_RANDOM_SEED = 0;
+
+const int Defaults::SAMPLER_SCAN_START_INDEX = 0;
+
+const int Defaults::SAMPLER_SCAN_END_INDEX = 0;
+
+const bool Defaults::SAMPLER_RESUME = false;
+
+const int Defaults::SAMPLER_CHECKPOINT_INTERVAL = 0;
+
+const double Defaults::SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE = 0.0;
+
+const double Defaults::SAMPLER_R_HAT_THRESHOLD = 0.0;
+
+const std::string Defaults::SAMPLER_WARM_START = "none";
+
+const std::string Defaults::SAMPLER_WARM_START_TRACE = "";
+
 const bool Defaults::MCMC_USE_MODEL_ERROR = false;
 
 const int Defaults::MCMC_NUMBER_OF_BURN_IN_SAMPLES = 0;
 
+const bool Defaults::MCMC_AUTOMATIC_BURN_IN = false;
+
 const double Defaults::MCMC_STEP_SIZE = 0.025;
 
+const double Defaults::MCMC_TARGET_ACCEPTANCE_RATE = 0.234;
+
+const int Defaults::MCMC_SPECULATIVE_DEPTH = 1;
+
+const double Defaults::GIBBS_TARGET_ACCEPTANCE_RATE = 0.44;
+
+const double Defaults::MALA_TARGET_ACCEPTANCE_RATE = 0.574;
+
+const int Defaults::HMC_NUMBER_OF_LEAPFROG_STEPS = 20;
+
+const int Defaults::HMC_MAXIMUM_TREE_DEPTH = 10;
+
+const double Defaults::HMC_TARGET_ACCEPTANCE_RATE = 0.8;
+
+const int Defaults::ENSEMBLE_NUMBER_OF_WALKERS = 0;
+
+const double Defaults::ENSEMBLE_STRETCH_SCALE = 2.0;
+
+const int Defaults::DIFFERENTIAL_EVOLUTION_NUMBER_OF_CHAINS = 0;
+
+const double Defaults::DIFFERENTIAL_EVOLUTION_CROSSOVER_PROBABILITY = 1.0;
+
+const int Defaults::PARALLEL_TEMPERING_NUMBER_OF_TEMPERATURES = 8;
+
+const double Defaults::PARALLEL_TEMPERING_MAXIMUM_TEMPERATURE = 100.0;
+
+const int Defaults::PARALLEL_TEMPERING_SWAP_INTERVAL = 1;
+
+const int Defaults::SMC_NUMBER_OF_PARTICLES = 1000;
+
+const int Defaults::SMC_NUMBER_OF_MOVE_STEPS = 5;
+
+const double Defaults::SMC_TARGET_EFFECTIVE_SAMPLE_FRACTION = 0.5;
+
+const int Defaults::OPTIMIZER_NUMBER_OF_STARTS = 1;
+
+const int Defaults::OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS = 1000;
+
 const std::string Defaults::EXTERNAL_MODEL_EXECUTABLE = "";
 
 const std::string Defaults::EXTERNAL_MODEL_ARGUMENTS = "";
@@ -108,10 +170,42 @@ void Defaults::PrintAllDefaults(std::ostream & o) {
     << "SAMPLER "                                          << Defaults::SAMPLER << '\n'
     << "SAMPLER_NUMBER_OF_SAMPLES "                        << Defaults::SAMPLER_NUMBER_OF_SAMPLES << '\n'
     << "SAMPLER_INACTIVE_PARAMETERS_FILE "                 << Defaults::SAMPLER_INACTIVE_PARAMETERS_FILE << '\n'
+    << "SAMPLER_NUMBER_OF_CHAINS "                         << Defaults::SAMPLER_NUMBER_OF_CHAINS << '\n'
+    << "SAMPLER_INTERLEAVE_CHAINS "                        << Defaults::SAMPLER_INTERLEAVE_CHAINS << '\n'
+    << "SAMPLER_RANDOM_SEED "                              << Defaults::SAMPLER_RANDOM_SEED << '\n'
+    << "SAMPLER_SCAN_START_INDEX "                         << Defaults::SAMPLER_SCAN_START_INDEX << '\n'
+    << "SAMPLER_SCAN_END_INDEX "                           << Defaults::SAMPLER_SCAN_END_INDEX << '\n'
+    << "SAMPLER_RESUME "                                   << Defaults::SAMPLER_RESUME << '\n'
+    << "SAMPLER_CHECKPOINT_INTERVAL "                      << Defaults::SAMPLER_CHECKPOINT_INTERVAL << '\n'
+    << "SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE "             << Defaults::SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE << '\n'
+    << "SAMPLER_R_HAT_THRESHOLD "                          << Defaults::SAMPLER_R_HAT_THRESHOLD << '\n'
+    << "SAMPLER_WARM_START "                               << Defaults::SAMPLER_WARM_START << '\n'
+    << "SAMPLER_WARM_START_TRACE "                         << Defaults::SAMPLER_WARM_START_TRACE << '\n'
     << "#\n"
     << "MCMC_USE_MODEL_ERROR "                             << Defaults::MCMC_USE_MODEL_ERROR << '\n'
     << "MCMC_NUMBER_OF_BURN_IN_SAMPLES "                   << Defaults::MCMC_NUMBER_OF_BURN_IN_SAMPLES << '\n'
+    << "MCMC_AUTOMATIC_BURN_IN "                           << Defaults::MCMC_AUTOMATIC_BURN_IN << '\n'
     << "MCMC_STEP_SIZE "                                   << Defaults::MCMC_STEP_SIZE << '\n'
+    << "MCMC_TARGET_ACCEPTANCE_RATE "                      << Defaults::MCMC_TARGET_ACCEPTANCE_RATE << '\n'
+    << "MCMC_SPECULATIVE_DEPTH "                           << Defaults::MCMC_SPECULATIVE_DEPTH << '\n'
+    << "GIBBS_TARGET_ACCEPTANCE_RATE "                     << Defaults::GIBBS_TARGET_ACCEPTANCE_RATE << '\n'
+    << "MALA_TARGET_ACCEPTANCE_RATE "                      << Defaults::MALA_TARGET_ACCEPTANCE_RATE << '\n'
+    << "HMC_NUMBER_OF_LEAPFROG_STEPS "                     << Defaults::HMC_NUMBER_OF_LEAPFROG_STEPS << '\n'
+    << "HMC_MAXIMUM_TREE_DEPTH "                           << Defaults::HMC_MAXIMUM_TREE_DEPTH << '\n'
+    << "HMC_TARGET_ACCEPTANCE_RATE "                       << Defaults::HMC_TARGET_ACCEPTANCE_RATE << '\n'
+    << "ENSEMBLE_NUMBER_OF_WALKERS "                       << Defaults::ENSEMBLE_NUMBER_OF_WALKERS << '\n'
+    << "ENSEMBLE_STRETCH_SCALE "                           << Defaults::ENSEMBLE_STRETCH_SCALE << '\n'
+    << "DIFFERENTIAL_EVOLUTION_NUMBER_OF_CHAINS "           << Defaults::DIFFERENTIAL_EVOLUTION_NUMBER_OF_CHAINS << '\n'
+    << "DIFFERENTIAL_EVOLUTION_CROSSOVER_PROBABILITY "      << Defaults::DIFFERENTIAL_EVOLUTION_CROSSOVER_PROBABILITY << '\n'
+    << "PARALLEL_TEMPERING_NUMBER_OF_TEMPERATURES "        << Defaults::PARALLEL_TEMPERING_NUMBER_OF_TEMPERATURES << '\n'
+    << "PARALLEL_TEMPERING_MAXIMUM_TEMPERATURE "           << Defaults::PARALLEL_TEMPERING_MAXIMUM_TEMPERATURE << '\n'
+    << "PARALLEL_TEMPERING_SWAP_INTERVAL "                 << Defaults::PARALLEL_TEMPERING_SWAP_INTERVAL << '\n'
+    << "SMC_NUMBER_OF_PARTICLES "                          << Defaults::SMC_NUMBER_OF_PARTICLES << '\n'
+    << "SMC_NUMBER_OF_MOVE_STEPS "                         << Defaults::SMC_NUMBER_OF_MOVE_STEPS << '\n'
+    << "SMC_TARGET_EFFECTIVE_SAMPLE_FRACTION "             << Defaults::SMC_TARGET_EFFECTIVE_SAMPLE_FRACTION << '\n'
+    << "#\n"
+    << "OPTIMIZER_NUMBER_OF_STARTS "                       << Defaults::OPTIMIZER_NUMBER_OF_STARTS << '\n'
+    << "OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS "           << Defaults::OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS << '\n'
     << "#\n"
     << "EXTERNAL_MODEL_EXECUTABLE "                        << Defaults::EXTERNAL_MODEL_EXECUTABLE << '\n'
     << "EXTERNAL_MODEL_ARGUMENTS "                         << Defaults::EXTERNAL_MODEL_ARGUMENTS << '\n'
@@ -77,14 +77,78 @@ namespace Defaults {
 
   extern const std::string SAMPLER_INACTIVE_PARAMETERS_FILE;
 
+  extern const int SAMPLER_NUMBER_OF_CHAINS;
+
+  extern const bool SAMPLER_INTERLEAVE_CHAINS;
+
+  extern const int SAMPLER_RANDOM_SEED;
+
+  extern const int SAMPLER_SCAN_START_INDEX;
+
+  extern const int SAMPLER_SCAN_END_INDEX;
+
+  extern const bool SAMPLER_RESUME;
+
+  extern const int SAMPLER_CHECKPOINT_INTERVAL;
+
+  extern const double SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE;
+
+  extern const double SAMPLER_R_HAT_THRESHOLD;
+
+  extern const std::string SAMPLER_WARM_START;
+
+  extern const std::string SAMPLER_WARM_START_TRACE;
+
   /**
    MCMC Variables */
   extern const bool MCMC_USE_MODEL_ERROR;
 
   extern const int MCMC_NUMBER_OF_BURN_IN_SAMPLES;
 
+  extern const bool MCMC_AUTOMATIC_BURN_IN;
+
   extern const double MCMC_STEP_SIZE;
 
+  extern const double MCMC_TARGET_ACCEPTANCE_RATE;
+
+  extern const int MCMC_SPECULATIVE_DEPTH;
+
+  extern const double GIBBS_TARGET_ACCEPTANCE_RATE;
+
+  extern const double MALA_TARGET_ACCEPTANCE_RATE;
+
+  extern const int HMC_NUMBER_OF_LEAPFROG_STEPS;
+
+  extern const int HMC_MAXIMUM_TREE_DEPTH;
+
+  extern const double HMC_TARGET_ACCEPTANCE_RATE;
+
+  extern const int ENSEMBLE_NUMBER_OF_WALKERS;
+
+  extern const double ENSEMBLE_STRETCH_SCALE;
+
+  extern const int DIFFERENTIAL_EVOLUTION_NUMBER_OF_CHAINS;
+
+  extern const double DIFFERENTIAL_EVOLUTION_CROSSOVER_PROBABILITY;
+
+  extern const int PARALLEL_TEMPERING_NUMBER_OF_TEMPERATURES;
+
+  extern const double PARALLEL_TEMPERING_MAXIMUM_TEMPERATURE;
+
+  extern const int PARALLEL_TEMPERING_SWAP_INTERVAL;
+
+  extern const int SMC_NUMBER_OF_PARTICLES;
+
+  extern const int SMC_NUMBER_OF_MOVE_STEPS;
+
+  extern const double SMC_TARGET_EFFECTIVE_SAMPLE_FRACTION;
+
+  /**
+   Optimizer Variables */
+  extern const int OPTIMIZER_NUMBER_OF_STARTS;
+
+  extern const int OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS;
+
   /**
    External Model Variables */
   extern const std::string EXTERNAL_MODEL_EXECUTABLE;
@@ -0,0 +1,249 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+
+#include "ApplicationUtilities.h"
+#include "Defaults.h"
+#include "ExternalModel.h"
+#include "GaussianProcessEmulator.h"
+#include "GaussianProcessEmulatorDirectoryFormatIO.h"
+#include "GaussianProcessEmulatedModel.h"
+#include "LBFGSOptimizer.h"
+#include "Paths.h"
+#include "Random.h"
+#include "RuntimeParameterFileReader.h"
+
+
+int main(int argc, char ** argv) {
+
+  if (argc < 2) {
+    std::cerr
+      << "Usage:\n"
+      << "    " << argv[0] << " <StatisticsDirectory>\n"
+      << "\n"
+      << "This program finds the parameters that maximize the posterior \n"
+      << "density, by evaluating either a model defined in an external \n"
+      << "process or a trained emulator. The program madai_pca_decompose \n"
+      << "must have been run on <StatisticsDirectory> prior to running this \n"
+      << "program and if no EXTERNAL_MODEL_EXECUTABLE is specified in the \n"
+      << "settings file, madai_train_emulator must have been run as well.\n"
+      << "\n"
+      << "<StatisticsDirectory> is the directory in which all \n"
+      << "statistics data are stored. It contains the parameter file "
+      << madai::Paths::RUNTIME_PARAMETER_FILE << "\n"
+      << "\n"
+      << "The maximum is written to standard output as lines of parameter \n"
+      << "names and values, followed by the outputs and log likelihood as \n"
+      << "comments. The output can be used as a \n"
+      << "SAMPLER_INACTIVE_PARAMETERS_FILE.\n"
+      << "\n"
+      << "The first search starts from the medians of the priors and any \n"
+      << "further searches from random draws from the priors. Parameters \n"
+      << "listed in the SAMPLER_INACTIVE_PARAMETERS_FILE are held fixed.\n"
+      << "\n"
+      << "Format of entries in " << madai::Paths::RUNTIME_PARAMETER_FILE
+      << ":\n\n"
+      << "MODEL_OUTPUT_DIRECTORY <value> (default: "
+      << madai::Defaults::MODEL_OUTPUT_DIRECTORY << ")\n"
+      << "EXPERIMENTAL_RESULTS_FILE <value> (default: "
+      << madai::Defaults::EXPERIMENTAL_RESULTS_FILE << ")\n"
+      << "SAMPLER_INACTIVE_PARAMETERS_FILE <value> (default: "
+      << madai::Defaults::SAMPLER_INACTIVE_PARAMETERS_FILE << ")\n"
+      << "MCMC_USE_MODEL_ERROR <value> (default: "
+      << madai::Defaults::MCMC_USE_MODEL_ERROR << ")\n"
+      << "OPTIMIZER_NUMBER_OF_STARTS <value> (default: "
+      << madai::Defaults::OPTIMIZER_NUMBER_OF_STARTS << ")\n"
+      << "OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS <value> (default: "
+      << madai::Defaults::OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS << ")\n"
+      << "EXTERNAL_MODEL_EXECUTABLE <value> (default: \""
+      << madai::Defaults::EXTERNAL_MODEL_EXECUTABLE << "\")\n"
+      << "EXTERNAL_MODEL_ARGUMENTS <Argument1> <Argument2> ... <LastArgument>\n"
+      << "VERBOSE <value> (default: "
+      << madai::Defaults::VERBOSE << ")\n";
+
+    return EXIT_FAILURE;
+  }
+  std::string statisticsDirectory( argv[1] );
+  madai::EnsurePathSeparatorAtEnd( statisticsDirectory );
+
+  madai::RuntimeParameterFileReader settings;
+  std::string settingsFile = statisticsDirectory + madai::Paths::RUNTIME_PARAMETER_FILE;
+  if ( !settings.ParseFile( settingsFile ) ) {
+    std::cerr << "Could not open runtime parameter file '" << settingsFile << "'\n";
+    return EXIT_FAILURE;
+  }
+
+  std::string modelOutputDirectory =
+    madai::GetModelOutputDirectory( statisticsDirectory, settings );
+  std::string experimentalResultsFile =
+    madai::GetExperimentalResultsFile( statisticsDirectory, settings );
+
+  bool useModelError = settings.GetOptionAsBool(
+      "MCMC_USE_MODEL_ERROR",
+      madai::Defaults::MCMC_USE_MODEL_ERROR);
+
+  int numberOfStarts = settings.GetOptionAsInt(
+      "OPTIMIZER_NUMBER_OF_STARTS",
+      madai::Defaults::OPTIMIZER_NUMBER_OF_STARTS );
+
+  int maximumNumberOfIterations = settings.GetOptionAsInt(
+      "OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS",
+      madai::Defaults::OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS );
+
+  std::string executable = settings.GetOption(
+      "EXTERNAL_MODEL_EXECUTABLE",
+      madai::Defaults::EXTERNAL_MODEL_EXECUTABLE);
+
+  bool verbose = settings.GetOptionAsBool( "VERBOSE", madai::Defaults::VERBOSE );
+
+  madai::ExternalModel externalModel;
+  madai::GaussianProcessEmulatedModel gpem;
+
+  madai::Model * model;
+  if ( executable == "" ) { // Use emulator
+    bool pcaUseModelError = settings.GetOptionAsBool(
+        "PCA_USE_MODEL_ERROR", madai::Defaults::PCA_USE_MODEL_ERROR );
+    boost::shared_ptr< madai::GaussianProcessEmulator > gpe(
+      new madai::GaussianProcessEmulator( pcaUseModelError ) );
+    madai::GaussianProcessEmulatorDirectoryFormatIO directoryReader;
+    if ( !directoryReader.LoadTrainingData( gpe.get(),
+                                            modelOutputDirectory,
+                                            statisticsDirectory,
+                                            experimentalResultsFile ) ) {
+      std::cerr << "Error loading training data from the directory structure.\n";
+      return EXIT_FAILURE;
+    }
+    if ( !directoryReader.LoadPCA( gpe.get(), statisticsDirectory ) ) {
+      std::cerr << "Error loading the PCA decomposition data. Did you "
+                << "run madai_pca_decompose?\n";
+      return EXIT_FAILURE;
+    }
+    if ( !directoryReader.LoadEmulator( gpe.get(), statisticsDirectory ) ) {
+      std::cerr << "Error loading emulator data. Did you run "
+                << "madai_train_emulator?\n";
+      return EXIT_FAILURE;
+    }
+    gpem.SetGaussianProcessEmulator( gpe );
+    model = &gpem;
+
+    if ( verbose ) {
+      std::cout << "# Using emulator to find the posterior maximum.\n";
+    }
+  } else { // Use external model
+
+    // Split arguments into vector of strings
+    std::vector< std::string > arguments;
+    if ( settings.HasOption( "EXTERNAL_MODEL_ARGUMENTS" ) ) {
+      std::string argumentsString =
+        settings.GetOption( "EXTERNAL_MODEL_ARGUMENTS" );
+      arguments = madai::SplitString( argumentsString, ' ' );
+    }
+
+    if ( verbose ) {
+      std::cout << "# Using external model executable '" << executable << "'.\n";
+    }
+
+    externalModel.StartProcess( executable, arguments );
+    if (! externalModel.IsReady()) {
+      std::cerr << "Something is wrong with the external model\n";
+      return EXIT_FAILURE;
+    }
+
+    model = &externalModel;
+  }
+
+  std::ifstream experimentalResults(experimentalResultsFile.c_str());
+  if ( madai::Model::NO_ERROR !=
+       madai::LoadObservations( model, experimentalResults ) ) {
+    std::cerr << "Error loading observations.\n";
+    externalModel.StopProcess();
+    return EXIT_FAILURE;
+  }
+  experimentalResults.close();
+  model->SetUseModelCovarianceToCalulateLogLikelihood( useModelError );
+
+  madai::LBFGSOptimizer optimizer;
+  optimizer.SetModel( model );
+
+  std::string samplerInactiveParametersFile =
+    madai::GetInactiveParametersFile( statisticsDirectory, settings );
+  if ( ! madai::SetInactiveParameters( samplerInactiveParametersFile,
+                                       optimizer, false ) ) {
+    std::cerr << "Error when setting inactive parameters from file '"
+              << samplerInactiveParametersFile << "'.\n";
+    externalModel.StopProcess();
+    return EXIT_FAILURE;
+  }
+
+  // The first search starts from the medians of the priors.
+  const std::vector< madai::Parameter > & parameters = optimizer.GetParameters();
+  std::vector< double > medians( optimizer.GetCurrentParameters() );
+  madai::Random random;
+  madai::Sample best;
+  bool converged = false;
+  for ( int start = 0; start < std::max( numberOfStarts, 1 ); ++start ) {
+    std::vector< double > startingPoint( medians );
+    for ( unsigned int i = 0; start > 0 && i < parameters.size(); ++i ) {
+      if ( optimizer.IsParameterActive( i ) ) {
+        startingPoint[i] = parameters[i].GetPriorDistribution()->GetSample( random );
+      }
+    }
+    optimizer.SetParameterValues( startingPoint );
+
+    madai::Sample maximum = optimizer.FindMaximum(
+      static_cast< unsigned int >( std::max( maximumNumberOfIterations, 0 ) ) );
+    if ( verbose ) {
+      std::cout << "# Search " << start + 1 << ": log likelihood "
+                << maximum.m_LogLikelihood << " after "
+                << optimizer.GetNumberOfIterations() << " iterations and "
+                << optimizer.GetNumberOfModelEvaluations()
+                << " model evaluations"
+                << ( optimizer.HasConverged() ? "" : ", not converged" )
+                << "\n";
+    }
+    if ( start == 0 || best < maximum ) {
+      best = maximum;
+      converged = optimizer.HasConverged();
+    }
+  }
+  externalModel.StopProcess();
+
+  if ( !converged ) {
+    std::cerr << "The search did not converge within "
+              << "OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS iterations.\n";
+  }
+
+  std::cout.precision( 17 );
+  for ( unsigned int i = 0; i < parameters.size(); ++i ) {
+    std::cout << parameters[i].m_Name << ' ' << best.m_ParameterValues[i] << '\n';
+  }
+  const std::vector< std::string > & outputNames = model->GetScalarOutputNames();
+  for ( unsigned int i = 0; i < outputNames.size() && i < best.m_OutputValues.size(); ++i ) {
+    std::cout << "# " << outputNames[i] << ' ' << best.m_OutputValues[i] << '\n';
+  }
+  std::cout << "# LogLikelihood " << best.m_LogLikelihood << '\n';
+
+  return EXIT_SUCCESS;
+}
@@ -25,22 +25,62 @@
 #include <algorithm>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <boost/shared_ptr.hpp>
 
+#include "AdaptiveMetropolisSampler.h"
 #include "ApplicationUtilities.h"
+#include "ConvergenceMonitor.h"
 #include "Defaults.h"
+#include "DelayedAcceptanceSampler.h"
+#include "DifferentialEvolutionSampler.h"
+#include "EnsembleSampler.h"
 #include "ExternalModel.h"
+#include "HamiltonianMonteCarloSampler.h"
+#include "LBFGSOptimizer.h"
+#include "MetropolisAdjustedLangevinSampler.h"
 #include "MetropolisHastingsSampler.h"
+#include "MetropolisWithinGibbsSampler.h"
+#include "ParallelTemperingSampler.h"
 #include "GaussianProcessEmulator.h"
 #include "GaussianProcessEmulatorDirectoryFormatIO.h"
 #include "GaussianProcessEmulatedModel.h"
 #include "Paths.h"
 #include "PercentileGridSampler.h"
+#include "Random.h"
 #include "RuntimeParameterFileReader.h"
 #include "SamplerCSVWriter.h"
+#include "SequentialMonteCarloSampler.h"
+#include "SobolSampler.h"
 
 #include "madaisys/SystemTools.hxx"
 
 
+/** Output stream to a trace file, gzip-compressed if requested, and
+ * appended to if requested. The members are destroyed in reverse
+ * order, so the stream is flushed through the compressor before the
+ * file is closed. */
+struct TraceFile {
+  TraceFile( const std::string & path, bool compressed, bool append ) :
+    m_File( path.c_str(), std::ios_base::out | std::ios_base::binary |
+            ( append ? std::ios_base::app : std::ios_base::trunc ) ),
+    m_Stream( &m_Buffer )
+  {
+    if ( compressed ) {
+      m_Buffer.push( boost::iostreams::gzip_compressor() );
+      m_Buffer.push( m_File );
+    } else {
+      // Write straight to the file, so that flushing the stream before
+      // a checkpoint reaches the file.
+      m_Stream.rdbuf( m_File.rdbuf() );
+    }
+  }
+
+  std::ofstream m_File;
+  boost::iostreams::filtering_streambuf< boost::iostreams::output > m_Buffer;
+  std::ostream m_Stream;
+};
+
+
 int main(int argc, char ** argv) {
 
   if (argc < 3) {
@@ -62,6 +102,34 @@ int main(int argc, char ** argv) {
       << "<OutputFileName> is the name of the comma-separated value-format \n"
       << "file in which the trace will be written. This file will be \n"
       << "written in the directory <StatisticsDirectory>/trace/.\n"
+      << "When SAMPLER_NUMBER_OF_CHAINS is greater than 1 and the chains \n"
+      << "are not interleaved, each chain is written to its own file, \n"
+      << "named by inserting _001, _002, ... before the .csv extension.\n"
+      << "\n"
+      << "The PercentileGrid and Sobol samplers can evaluate the range of \n"
+      << "indices from SAMPLER_SCAN_START_INDEX up to SAMPLER_SCAN_END_INDEX \n"
+      << "of their scan, so that a scan can be split between processes, and \n"
+      << "with SAMPLER_RESUME they continue an interrupted trace file. The \n"
+      << "traces can be joined with madai_merge_traces. The Sobol sampler \n"
+      << "then needs a nonzero SAMPLER_RANDOM_SEED, the same in every run, \n"
+      << "so that each run scrambles the sequence in the same way.\n"
+      << "\n"
+      << "The other samplers write their state every \n"
+      << "SAMPLER_CHECKPOINT_INTERVAL samples to <OutputFileName>.checkpoint, \n"
+      << "from which SAMPLER_RESUME continues an interrupted run exactly.\n"
+      << "\n"
+      << "SAMPLER_NUMBER_OF_SAMPLES is the most samples per chain. Sampling \n"
+      << "stops earlier once the effective sample size of every active \n"
+      << "parameter reaches SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE and its \n"
+      << "split R-hat is at most SAMPLER_R_HAT_THRESHOLD, for those of the \n"
+      << "two that are set.\n"
+      << "\n"
+      << "With MCMC_AUTOMATIC_BURN_IN, the burn-in ends as soon as the log \n"
+      << "likelihood of the chains is stationary, after at most \n"
+      << "MCMC_NUMBER_OF_BURN_IN_SAMPLES samples. SAMPLER_WARM_START starts \n"
+      << "the chains from the maximum of the posterior (map), or from the \n"
+      << "best or last samples of the trace SAMPLER_WARM_START_TRACE \n"
+      << "instead of from the prior (none).\n"
       << "\n"
       << "Format of entries in " << madai::Paths::RUNTIME_PARAMETER_FILE
       << ":\n\n"
@@ -75,12 +143,70 @@ int main(int argc, char ** argv) {
       << madai::Defaults::SAMPLER_NUMBER_OF_SAMPLES << ")\n"
       << "SAMPLER_INACTIVE_PARAMETERS_FILE <value> (default: "
       << madai::Defaults::SAMPLER_INACTIVE_PARAMETERS_FILE << ")\n"
+      << "SAMPLER_NUMBER_OF_CHAINS <value> (default: "
+      << madai::Defaults::SAMPLER_NUMBER_OF_CHAINS << ")\n"
+      << "SAMPLER_INTERLEAVE_CHAINS <value> (default: "
+      << madai::Defaults::SAMPLER_INTERLEAVE_CHAINS << ")\n"
+      << "SAMPLER_RANDOM_SEED <value> (default: "
+      << madai::Defaults::SAMPLER_RANDOM_SEED << ")\n"
+      << "SAMPLER_SCAN_START_INDEX <value> (default: "
+      << madai::Defaults::SAMPLER_SCAN_START_INDEX << ")\n"
+      << "SAMPLER_SCAN_END_INDEX <value> (default: "
+      << madai::Defaults::SAMPLER_SCAN_END_INDEX << ")\n"
+      << "SAMPLER_RESUME <value> (default: "
+      << madai::Defaults::SAMPLER_RESUME << ")\n"
+      << "SAMPLER_CHECKPOINT_INTERVAL <value> (default: "
+      << madai::Defaults::SAMPLER_CHECKPOINT_INTERVAL << ")\n"
+      << "SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE <value> (default: "
+      << madai::Defaults::SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE << ")\n"
+      << "SAMPLER_R_HAT_THRESHOLD <value> (default: "
+      << madai::Defaults::SAMPLER_R_HAT_THRESHOLD << ")\n"
+      << "SAMPLER_WARM_START <value> (default: "
+      << madai::Defaults::SAMPLER_WARM_START << ")\n"
+      << "SAMPLER_WARM_START_TRACE <value> (default: "
+      << madai::Defaults::SAMPLER_WARM_START_TRACE << ")\n"
       << "MCMC_NUMBER_OF_BURN_IN_SAMPLES <value> (default: "
       << madai::Defaults::MCMC_NUMBER_OF_BURN_IN_SAMPLES << ")\n"
+      << "MCMC_AUTOMATIC_BURN_IN <value> (default: "
+      << madai::Defaults::MCMC_AUTOMATIC_BURN_IN << ")\n"
       << "MCMC_USE_MODEL_ERROR <value> (default: "
       << madai::Defaults::MCMC_USE_MODEL_ERROR << ")\n"
       << "MCMC_STEP_SIZE <value> (default: "
       << madai::Defaults::MCMC_STEP_SIZE << ")\n"
+      << "MCMC_TARGET_ACCEPTANCE_RATE <value> (default: "
+      << madai::Defaults::MCMC_TARGET_ACCEPTANCE_RATE << ")\n"
+      << "MCMC_SPECULATIVE_DEPTH <value> (default: "
+      << madai::Defaults::MCMC_SPECULATIVE_DEPTH << ")\n"
+      << "GIBBS_TARGET_ACCEPTANCE_RATE <value> (default: "
+      << madai::Defaults::GIBBS_TARGET_ACCEPTANCE_RATE << ")\n"
+      << "MALA_TARGET_ACCEPTANCE_RATE <value> (default: "
+      << madai::Defaults::MALA_TARGET_ACCEPTANCE_RATE << ")\n"
+      << "HMC_NUMBER_OF_LEAPFROG_STEPS <value> (default: "
+      << madai::Defaults::HMC_NUMBER_OF_LEAPFROG_STEPS << ")\n"
+      << "HMC_MAXIMUM_TREE_DEPTH <value> (default: "
+      << madai::Defaults::HMC_MAXIMUM_TREE_DEPTH << ")\n"
+      << "HMC_TARGET_ACCEPTANCE_RATE <value> (default: "
+      << madai::Defaults::HMC_TARGET_ACCEPTANCE_RATE << ")\n"
+      << "ENSEMBLE_NUMBER_OF_WALKERS <value> (default: "
+      << madai::Defaults::ENSEMBLE_NUMBER_OF_WALKERS << ")\n"
+      << "ENSEMBLE_STRETCH_SCALE <value> (default: "
+      << madai::Defaults::ENSEMBLE_STRETCH_SCALE << ")\n"
+      << "DIFFERENTIAL_EVOLUTION_NUMBER_OF_CHAINS <value> (default: "
+      << madai::Defaults::DIFFERENTIAL_EVOLUTION_NUMBER_OF_CHAINS << ")\n"
+      << "DIFFERENTIAL_EVOLUTION_CROSSOVER_PROBABILITY <value> (default: "
+      << madai::Defaults::DIFFERENTIAL_EVOLUTION_CROSSOVER_PROBABILITY << ")\n"
+      << "PARALLEL_TEMPERING_NUMBER_OF_TEMPERATURES <value> (default: "
+      << madai::Defaults::PARALLEL_TEMPERING_NUMBER_OF_TEMPERATURES << ")\n"
+      << "PARALLEL_TEMPERING_MAXIMUM_TEMPERATURE <value> (default: "
+      << madai::Defaults::PARALLEL_TEMPERING_MAXIMUM_TEMPERATURE << ")\n"
+      << "PARALLEL_TEMPERING_SWAP_INTERVAL <value> (default: "
+      << madai::Defaults::PARALLEL_TEMPERING_SWAP_INTERVAL << ")\n"
+      << "SMC_NUMBER_OF_PARTICLES <value> (default: "
+      << madai::Defaults::SMC_NUMBER_OF_PARTICLES << ")\n"
+      << "SMC_NUMBER_OF_MOVE_STEPS <value> (default: "
+      << madai::Defaults::SMC_NUMBER_OF_MOVE_STEPS << ")\n"
+      << "SMC_TARGET_EFFECTIVE_SAMPLE_FRACTION <value> (default: "
+      << madai::Defaults::SMC_TARGET_EFFECTIVE_SAMPLE_FRACTION << ")\n"
       << "EXTERNAL_MODEL_EXECUTABLE <value> (default: \""
       << madai::Defaults::EXTERNAL_MODEL_EXECUTABLE << "\")\n"
       << "EXTERNAL_MODEL_ARGUMENTS <Argument1> <Argument2> ... <LastArgument>\n"
@@ -121,6 +247,74 @@ int main(int argc, char ** argv) {
   double stepSize = settings.GetOptionAsDouble(
       "MCMC_STEP_SIZE", madai::Defaults::MCMC_STEP_SIZE);
 
+  double targetAcceptanceRate = settings.GetOptionAsDouble(
+      "MCMC_TARGET_ACCEPTANCE_RATE",
+      madai::Defaults::MCMC_TARGET_ACCEPTANCE_RATE );
+
+  int speculativeDepth = settings.GetOptionAsInt(
+      "MCMC_SPECULATIVE_DEPTH",
+      madai::Defaults::MCMC_SPECULATIVE_DEPTH );
+
+  double gibbsTargetAcceptanceRate = settings.GetOptionAsDouble(
+      "GIBBS_TARGET_ACCEPTANCE_RATE",
+      madai::Defaults::GIBBS_TARGET_ACCEPTANCE_RATE );
+
+  double malaTargetAcceptanceRate = settings.GetOptionAsDouble(
+      "MALA_TARGET_ACCEPTANCE_RATE",
+      madai::Defaults::MALA_TARGET_ACCEPTANCE_RATE );
+
+  int numberOfLeapfrogSteps = settings.GetOptionAsInt(
+      "HMC_NUMBER_OF_LEAPFROG_STEPS",
+      madai::Defaults::HMC_NUMBER_OF_LEAPFROG_STEPS );
+
+  int maximumTreeDepth = settings.GetOptionAsInt(
+      "HMC_MAXIMUM_TREE_DEPTH",
+      madai::Defaults::HMC_MAXIMUM_TREE_DEPTH );
+
+  double hmcTargetAcceptanceRate = settings.GetOptionAsDouble(
+      "HMC_TARGET_ACCEPTANCE_RATE",
+      madai::Defaults::HMC_TARGET_ACCEPTANCE_RATE );
+
+  int numberOfWalkers = settings.GetOptionAsInt(
+      "ENSEMBLE_NUMBER_OF_WALKERS",
+      madai::Defaults::ENSEMBLE_NUMBER_OF_WALKERS );
+
+  double stretchScale = settings.GetOptionAsDouble(
+      "ENSEMBLE_STRETCH_SCALE",
+      madai::Defaults::ENSEMBLE_STRETCH_SCALE );
+
+  int numberOfDifferentialEvolutionChains = settings.GetOptionAsInt(
+      "DIFFERENTIAL_EVOLUTION_NUMBER_OF_CHAINS",
+      madai::Defaults::DIFFERENTIAL_EVOLUTION_NUMBER_OF_CHAINS );
+
+  double crossoverProbability = settings.GetOptionAsDouble(
+      "DIFFERENTIAL_EVOLUTION_CROSSOVER_PROBABILITY",
+      madai::Defaults::DIFFERENTIAL_EVOLUTION_CROSSOVER_PROBABILITY );
+
+  int numberOfTemperatures = settings.GetOptionAsInt(
+      "PARALLEL_TEMPERING_NUMBER_OF_TEMPERATURES",
+      madai::Defaults::PARALLEL_TEMPERING_NUMBER_OF_TEMPERATURES );
+
+  double maximumTemperature = settings.GetOptionAsDouble(
+      "PARALLEL_TEMPERING_MAXIMUM_TEMPERATURE",
+      madai::Defaults::PARALLEL_TEMPERING_MAXIMUM_TEMPERATURE );
+
+  int swapInterval = settings.GetOptionAsInt(
+      "PARALLEL_TEMPERING_SWAP_INTERVAL",
+      madai::Defaults::PARALLEL_TEMPERING_SWAP_INTERVAL );
+
+  int numberOfParticles = settings.GetOptionAsInt(
+      "SMC_NUMBER_OF_PARTICLES",
+      madai::Defaults::SMC_NUMBER_OF_PARTICLES );
+
+  int numberOfMoveSteps = settings.GetOptionAsInt(
+      "SMC_NUMBER_OF_MOVE_STEPS",
+      madai::Defaults::SMC_NUMBER_OF_MOVE_STEPS );
+
+  double targetEffectiveSampleFraction = settings.GetOptionAsDouble(
+      "SMC_TARGET_EFFECTIVE_SAMPLE_FRACTION",
+      madai::Defaults::SMC_TARGET_EFFECTIVE_SAMPLE_FRACTION );
+
   std::string executable = settings.GetOption(
       "EXTERNAL_MODEL_EXECUTABLE",
       madai::Defaults::EXTERNAL_MODEL_EXECUTABLE);
@@ -133,35 +327,145 @@ int main(int argc, char ** argv) {
 
   bool compressed = settings.GetOptionAsBool( "COMPRESS_TRACE", madai::Defaults::COMPRESS_TRACE );
 
+  int numberOfChains = settings.GetOptionAsInt(
+      "SAMPLER_NUMBER_OF_CHAINS",
+      madai::Defaults::SAMPLER_NUMBER_OF_CHAINS );
+  if ( numberOfChains < 1 ) {
+    std::cerr << "SAMPLER_NUMBER_OF_CHAINS must be at least 1.\n";
+    return EXIT_FAILURE;
+  }
+
+  bool interleaveChains = settings.GetOptionAsBool(
+      "SAMPLER_INTERLEAVE_CHAINS",
+      madai::Defaults::SAMPLER_INTERLEAVE_CHAINS );
+
+  int randomSeed = settings.GetOptionAsInt(
+      "SAMPLER_RANDOM_SEED",
+      madai::Defaults::SAMPLER_RANDOM_SEED );
+
+  int scanStartIndex = settings.GetOptionAsInt(
+      "SAMPLER_SCAN_START_INDEX",
+      madai::Defaults::SAMPLER_SCAN_START_INDEX );
+
+  int scanEndIndex = settings.GetOptionAsInt(
+      "SAMPLER_SCAN_END_INDEX",
+      madai::Defaults::SAMPLER_SCAN_END_INDEX );
+
+  bool resume = settings.GetOptionAsBool(
+      "SAMPLER_RESUME",
+      madai::Defaults::SAMPLER_RESUME );
+
+  int checkpointInterval = settings.GetOptionAsInt(
+      "SAMPLER_CHECKPOINT_INTERVAL",
+      madai::Defaults::SAMPLER_CHECKPOINT_INTERVAL );
+
+  double targetEffectiveSampleSize = settings.GetOptionAsDouble(
+      "SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE",
+      madai::Defaults::SAMPLER_TARGET_EFFECTIVE_SAMPLE_SIZE );
+
+  double rHatThreshold = settings.GetOptionAsDouble(
+      "SAMPLER_R_HAT_THRESHOLD",
+      madai::Defaults::SAMPLER_R_HAT_THRESHOLD );
+
+  bool automaticBurnIn = settings.GetOptionAsBool(
+      "MCMC_AUTOMATIC_BURN_IN",
+      madai::Defaults::MCMC_AUTOMATIC_BURN_IN );
+
+  std::string warmStart = madai::LowerCase( settings.GetOption(
+      "SAMPLER_WARM_START",
+      madai::Defaults::SAMPLER_WARM_START ) );
+
+  std::string warmStartTrace = settings.GetOption(
+      "SAMPLER_WARM_START_TRACE",
+      madai::Defaults::SAMPLER_WARM_START_TRACE );
+
+  if ( warmStart != "none" && warmStart != "best" &&
+       warmStart != "last" && warmStart != "map" ) {
+    std::cerr << "SAMPLER_WARM_START must be none, best, last or map.\n";
+    return EXIT_FAILURE;
+  }
+  if ( ( warmStart == "best" || warmStart == "last" ) &&
+       warmStartTrace == "" ) {
+    std::cerr << "SAMPLER_WARM_START " << warmStart << " needs the "
+              << "SAMPLER_WARM_START_TRACE to start from.\n";
+    return EXIT_FAILURE;
+  }
+
+  bool scan =( samplerType == "PercentileGrid" || samplerType == "Sobol" );
+  if ( !scan && ( scanStartIndex != 0 || scanEndIndex != 0 ) ) {
+    std::cerr << "SAMPLER_SCAN_START_INDEX and SAMPLER_SCAN_END_INDEX "
+              << "apply to the PercentileGrid and Sobol samplers only.\n";
+    return EXIT_FAILURE;
+  }
+  if ( scan && warmStart != "none" ) {
+    std::cerr << "SAMPLER_WARM_START does not apply to the "
+              << samplerType << " sampler.\n";
+    return EXIT_FAILURE;
+  }
+  if ( samplerType == "Sobol" && randomSeed == 0 &&
+       ( scanStartIndex != 0 || scanEndIndex != 0 || resume ) ) {
+    // The scramble is drawn from the seed, and a clock seed differs
+    // between processes.
+    std::cerr << "Shards of a Sobol scan, and a resumed one, must be "
+              << "scrambled alike, so they need a nonzero "
+              << "SAMPLER_RANDOM_SEED.\n";
+    return EXIT_FAILURE;
+  }
+  if ( scan ) {
+    // A scan resumes from its trace file alone.
+    checkpointInterval = 0;
+  }
+  if ( scan && numberOfChains > 1 ) {
+    // Shards of one scan split it better than chains.
+    std::cerr << "Ignoring SAMPLER_NUMBER_OF_CHAINS for the "
+              << samplerType << " sampler.\n";
+    numberOfChains = 1;
+  }
+
   madai::ExternalModel externalModel;
   madai::GaussianProcessEmulatedModel gpem;
 
+  if ( samplerType == "DelayedAcceptance" && executable == "" ) {
+    std::cerr << "The DelayedAcceptance sampler screens the proposals to "
+              << "an EXTERNAL_MODEL_EXECUTABLE with the emulator, so it "
+              << "needs one.\n";
+    return EXIT_FAILURE;
+  }
+
   madai::Model * model;
-  if ( executable == "" ) { // Use emulator
+  bool useEmulator = ( executable == "" || samplerType == "DelayedAcceptance" );
+  if ( useEmulator ) {
+    // Load the emulator, to sample or to screen the proposals
     bool useModelError = settings.GetOptionAsBool(
         "PCA_USE_MODEL_ERROR", madai::Defaults::PCA_USE_MODEL_ERROR );
-    madai::GaussianProcessEmulator gpe(useModelError);
+    boost::shared_ptr< madai::GaussianProcessEmulator > gpe(
+      new madai::GaussianProcessEmulator( useModelError ) );
     madai::GaussianProcessEmulatorDirectoryFormatIO directoryReader;
-    if ( !directoryReader.LoadTrainingData( &gpe,
+    if ( !directoryReader.LoadTrainingData( gpe.get(),
                                             modelOutputDirectory,
                                             statisticsDirectory,
                                             experimentalResultsFile ) ) {
       std::cerr << "Error loading training data from the directory structure.\n";
       return EXIT_FAILURE;
     }
-    if ( !directoryReader.LoadPCA( &gpe, statisticsDirectory ) ) {
+    if ( !directoryReader.LoadPCA( gpe.get(), statisticsDirectory ) ) {
       std::cerr << "Error loading the PCA decomposition data. Did you "
                 << "run madai_pca_decompose?\n";
       return EXIT_FAILURE;
     }
-    if ( !directoryReader.LoadEmulator( &gpe, statisticsDirectory ) ) {
+    if ( !directoryReader.LoadEmulator( gpe.get(), statisticsDirectory ) ) {
       std::cerr << "Error loading emulator data. Did you run "
                 << "madai_train_emulator?\n";
       return EXIT_FAILURE;
     }
 
+    // Hand the emulator to the model rather than copying it. The
+    // model holds the only reference, so that conditioning it below
+    // frees the unconditioned emulator.
     gpem.SetGaussianProcessEmulator( gpe );
+  }
 
+  if ( executable == "" ) { // Use emulator
     model = &gpem;
 
     if ( verbose ) {
@@ -199,82 +503,571 @@ int main(int argc, char ** argv) {
   }
   experimentalResults.close();
 
-  madai::Sampler * sampler;
+  if ( samplerType == "DelayedAcceptance" ) {
+    std::ifstream surrogateResults( experimentalResultsFile.c_str() );
+    if ( madai::Model::NO_ERROR !=
+         madai::LoadObservations( &gpem, surrogateResults ) ) {
+      std::cerr << "Error loading observations into the emulator.\n";
+      externalModel.StopProcess();
+      return EXIT_FAILURE;
+    }
+    gpem.SetUseModelCovarianceToCalulateLogLikelihood( useModelError );
+    if ( gpem.GetNumberOfParameters() != model->GetNumberOfParameters() ) {
+      std::cerr << "The emulator and the external model have different "
+                << "parameters.\n";
+      externalModel.StopProcess();
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Each chain gets its own Sampler, with its own stream of one master
+  // generator so that the chains are independent. A fixed seed
+  // repeats the run.
+  madai::Random masterGenerator;
+  if ( randomSeed != 0 ) {
+    masterGenerator.Reseed( static_cast< unsigned long int >( randomSeed ) );
+  }
+  std::vector< boost::shared_ptr< madai::Sampler > > samplers;
+  madai::PercentileGridSampler * pgs = NULL;
+  madai::SobolSampler * ss = NULL;
+  for ( int chain = 0; chain < numberOfChains; ++chain ) {
+    madai::Sampler * sampler;
+    if ( samplerType == "PercentileGrid" ) {
+      pgs = new madai::PercentileGridSampler;
+      pgs->SetModel( model );
 
-  madai::PercentileGridSampler pgs;
-  madai::MetropolisHastingsSampler mhs;
-  if ( samplerType == "PercentileGrid" ) {
-    pgs.SetModel( model );
+      // Burn-in samples don't exist for a percentile grid sampling
+      numberOfBurnInSamples = 0;
 
-    // Burn-in samples don't exist for a percentile grid sampling
-    numberOfBurnInSamples = 0;
+      sampler = pgs;
+    } else if ( samplerType == "Sobol" ) {
+      ss = new madai::SobolSampler;
+      ss->SetRandomNumberStream( masterGenerator, chain );
+      ss->SetModel( model );
 
-    sampler = &pgs;
+      // The points cover the prior from the first one on.
+      numberOfBurnInSamples = 0;
 
-    if ( verbose ) {
-      std::cout << "Using PercentileGridSampler for sampling\n";
+      sampler = ss;
+    } else if ( samplerType == "AdaptiveMetropolis" ) {
+      madai::AdaptiveMetropolisSampler * ams =
+        new madai::AdaptiveMetropolisSampler;
+      ams->SetRandomNumberStream( masterGenerator, chain );
+      ams->SetModel( model );
+      ams->SetStepSize( stepSize );
+      // Learn the proposal during burn-in only.
+      ams->SetNumberOfAdaptationSamples( numberOfBurnInSamples );
+      ams->SetTargetAcceptanceRate( targetAcceptanceRate );
+
+      sampler = ams;
+    } else if ( samplerType == "MetropolisWithinGibbs" ) {
+      madai::MetropolisWithinGibbsSampler * mwgs =
+        new madai::MetropolisWithinGibbsSampler;
+      mwgs->SetRandomNumberStream( masterGenerator, chain );
+      mwgs->SetModel( model );
+      mwgs->SetStepSize( stepSize );
+      // Tune the step size of each parameter during burn-in only.
+      mwgs->SetNumberOfAdaptationSamples( numberOfBurnInSamples );
+      mwgs->SetTargetAcceptanceRate( gibbsTargetAcceptanceRate );
+
+      sampler = mwgs;
+    } else if ( samplerType == "MetropolisAdjustedLangevin" ) {
+      madai::MetropolisAdjustedLangevinSampler * malas =
+        new madai::MetropolisAdjustedLangevinSampler;
+      malas->SetRandomNumberStream( masterGenerator, chain );
+      malas->SetModel( model );
+      malas->SetStepSize( stepSize );
+      // Tune the step size during burn-in only.
+      malas->SetNumberOfAdaptationSamples( numberOfBurnInSamples );
+      malas->SetTargetAcceptanceRate( malaTargetAcceptanceRate );
+
+      sampler = malas;
+    } else if ( samplerType == "HamiltonianMonteCarlo" ||
+                samplerType == "NoUTurn" ) {
+      madai::HamiltonianMonteCarloSampler * hmcs =
+        new madai::HamiltonianMonteCarloSampler;
+      hmcs->SetRandomNumberStream( masterGenerator, chain );
+      hmcs->SetModel( model );
+      hmcs->SetStepSize( stepSize );
+      hmcs->SetUseNoUTurn( samplerType == "NoUTurn" );
+      hmcs->SetNumberOfLeapfrogSteps(
+        static_cast< unsigned int >( std::max( numberOfLeapfrogSteps, 1 ) ) );
+      hmcs->SetMaximumTreeDepth(
+        static_cast< unsigned int >( std::max( maximumTreeDepth, 1 ) ) );
+      // Tune the step size and mass matrix during burn-in only.
+      hmcs->SetNumberOfAdaptationSamples( numberOfBurnInSamples );
+      hmcs->SetTargetAcceptanceRate( hmcTargetAcceptanceRate );
+
+      sampler = hmcs;
+    } else if ( samplerType == "Ensemble" ) {
+      madai::EnsembleSampler * es = new madai::EnsembleSampler;
+      es->SetRandomNumberStream( masterGenerator, chain );
+      es->SetModel( model );
+      es->SetNumberOfWalkers(
+        static_cast< unsigned int >( std::max( numberOfWalkers, 0 ) ) );
+      es->SetStretchScale( stretchScale );
+
+      sampler = es;
+    } else if ( samplerType == "DifferentialEvolution" ) {
+      madai::DifferentialEvolutionSampler * des =
+        new madai::DifferentialEvolutionSampler;
+      des->SetRandomNumberStream( masterGenerator, chain );
+      des->SetModel( model );
+      des->SetNumberOfWalkers( static_cast< unsigned int >(
+        std::max( numberOfDifferentialEvolutionChains, 0 ) ) );
+      des->SetCrossoverProbability( crossoverProbability );
+
+      sampler = des;
+    } else if ( samplerType == "ParallelTempering" ) {
+      madai::ParallelTemperingSampler * pts =
+        new madai::ParallelTemperingSampler;
+      pts->SetRandomNumberStream( masterGenerator, chain );
+      pts->SetModel( model );
+      pts->SetNumberOfTemperatures(
+        static_cast< unsigned int >( std::max( numberOfTemperatures, 2 ) ) );
+      pts->SetMaximumTemperature( maximumTemperature );
+      pts->SetStepSize( stepSize );
+      pts->SetSwapInterval(
+        static_cast< unsigned int >( std::max( swapInterval, 1 ) ) );
+      // Tune the step sizes and the ladder during burn-in only.
+      pts->SetNumberOfAdaptationSamples( numberOfBurnInSamples );
+      pts->SetTargetAcceptanceRate( targetAcceptanceRate );
+
+      sampler = pts;
+    } else if ( samplerType == "SequentialMonteCarlo" ) {
+      madai::SequentialMonteCarloSampler * smcs =
+        new madai::SequentialMonteCarloSampler;
+      smcs->SetRandomNumberStream( masterGenerator, chain );
+      smcs->SetModel( model );
+      smcs->SetNumberOfParticles(
+        static_cast< unsigned int >( std::max( numberOfParticles, 2 ) ) );
+      smcs->SetNumberOfMoveSteps(
+        static_cast< unsigned int >( std::max( numberOfMoveSteps, 1 ) ) );
+      smcs->SetTargetEffectiveSampleFraction( targetEffectiveSampleFraction );
+
+      // The particles reach the posterior before the first sample.
+      numberOfBurnInSamples = 0;
+
+      sampler = smcs;
+    } else if ( samplerType == "DelayedAcceptance" ) {
+      madai::DelayedAcceptanceSampler * das =
+        new madai::DelayedAcceptanceSampler;
+      das->SetRandomNumberStream( masterGenerator, chain );
+      das->SetModel( model );
+      das->SetSurrogateModel( &gpem );
+      das->SetStepSize( stepSize );
+
+      sampler = das;
+    } else { // Default to Metropolis Hastings
+      madai::MetropolisHastingsSampler * mhs =
+        new madai::MetropolisHastingsSampler;
+      mhs->SetRandomNumberStream( masterGenerator, chain );
+      mhs->SetModel( model );
+      mhs->SetStepSize( stepSize );
+      mhs->SetSpeculativeDepth(
+        static_cast< unsigned int >( std::max( speculativeDepth, 1 ) ) );
+
+      sampler = mhs;
     }
-  } else { // Default to Metropolis Hastings
-    mhs.SetModel( model );
-    mhs.SetStepSize( stepSize );
+    samplers.push_back( boost::shared_ptr< madai::Sampler >( sampler ) );
 
-    sampler = &mhs;
+    // Potentially set some parameters to inactive
+    std::string samplerInactiveParametersFile =
+      madai::GetInactiveParametersFile( statisticsDirectory, settings );
+    if ( samplerInactiveParametersFile != "" ) {
+      if ( ! madai::SetInactiveParameters( samplerInactiveParametersFile,
+                                           *sampler, verbose && chain == 0 ) ) {
+        std::cerr << "Error when setting inactive parameters from file '"
+                  << samplerInactiveParametersFile << "'.\n";
+        return EXIT_FAILURE;
+      }
 
-    if ( verbose ) {
-      std::cout << "Using MetropolisHastingsSampler for sampling\n";
+      // Fold the fixed parameters into the emulator so that it only
+      // has to evaluate the active dimensions.
+      if ( chain == 0 && useEmulator && gpem.ConditionOnFixedParameters(
+             sampler->GetActiveParametersByIndex(),
+             sampler->GetCurrentParameters() ) != madai::Model::NO_ERROR ) {
+        std::cerr << "Error when conditioning the emulator on the inactive "
+                  << "parameters.\n";
+        return EXIT_FAILURE;
+      }
     }
   }
 
-  // Potentially set some parameters to inactive
-  std::string samplerInactiveParametersFile =
-    madai::GetInactiveParametersFile( statisticsDirectory, settings );
-  if ( samplerInactiveParametersFile != "" ) {
-    if ( ! madai::SetInactiveParameters( samplerInactiveParametersFile,
-                                         *sampler, verbose ) ) {
-      std::cerr << "Error when setting inactive parameters from file '"
-                << samplerInactiveParametersFile << "'.\n";
-      return EXIT_FAILURE;
+  if ( verbose ) {
+    if ( samplerType == "PercentileGrid" ) {
+      std::cout << "Using PercentileGridSampler for sampling\n";
+    } else if ( samplerType == "Sobol" ) {
+      std::cout << "Using SobolSampler for sampling\n";
+    } else if ( samplerType == "AdaptiveMetropolis" ) {
+      std::cout << "Using AdaptiveMetropolisSampler for sampling\n";
+    } else if ( samplerType == "MetropolisWithinGibbs" ) {
+      std::cout << "Using MetropolisWithinGibbsSampler for sampling\n";
+    } else if ( samplerType == "MetropolisAdjustedLangevin" ) {
+      std::cout << "Using MetropolisAdjustedLangevinSampler for sampling\n";
+    } else if ( samplerType == "HamiltonianMonteCarlo" ) {
+      std::cout << "Using HamiltonianMonteCarloSampler for sampling\n";
+    } else if ( samplerType == "NoUTurn" ) {
+      std::cout << "Using HamiltonianMonteCarloSampler with the No-U-Turn "
+                << "criterion for sampling\n";
+    } else if ( samplerType == "Ensemble" ) {
+      std::cout << "Using EnsembleSampler with "
+                << samplers[0]->GetNumberOfParameters() << " parameters and "
+                << static_cast< madai::EnsembleSampler * >( samplers[0].get() )
+                     ->GetNumberOfWalkers()
+                << " walkers for sampling\n";
+    } else if ( samplerType == "DifferentialEvolution" ) {
+      std::cout << "Using DifferentialEvolutionSampler with "
+                << static_cast< madai::DifferentialEvolutionSampler * >(
+                     samplers[0].get() )->GetNumberOfWalkers()
+                << " chains for sampling\n";
+    } else if ( samplerType == "ParallelTempering" ) {
+      std::cout << "Using ParallelTemperingSampler with "
+                << static_cast< madai::ParallelTemperingSampler * >(
+                     samplers[0].get() )->GetNumberOfTemperatures()
+                << " temperatures for sampling\n";
+    } else if ( samplerType == "DelayedAcceptance" ) {
+      std::cout << "Using DelayedAcceptanceSampler with the emulator "
+                << "screening the external model for sampling\n";
+    } else if ( samplerType == "SequentialMonteCarlo" ) {
+      std::cout << "Using SequentialMonteCarloSampler with "
+                << static_cast< madai::SequentialMonteCarloSampler * >(
+                     samplers[0].get() )->GetNumberOfParticles()
+                << " particles for sampling\n";
+    } else {
+      std::cout << "Using MetropolisHastingsSampler for sampling\n";
     }
+    if ( numberOfChains > 1 ) {
+      std::cout << "Running " << numberOfChains << " chains\n";
+    }
+  }
+
+  if ( samplerType == "Sobol" &&
+       samplers[0]->GetNumberOfActiveParameters() >
+       madai::SobolSampler::GetMaximumNumberOfDimensions() ) {
+    std::cerr << "The Sobol sampler supports at most "
+              << madai::SobolSampler::GetMaximumNumberOfDimensions()
+              << " active parameters.\n";
+    return EXIT_FAILURE;
   }
 
-  if ( samplerType == "PercentileGrid" ) {
-    assert( pgs.GetModel() != NULL );
-    pgs.SetNumberOfSamples(numberOfSamples);
-    numberOfSamples = pgs.GetNumberOfSamples();
+  if ( pgs != NULL ) {
+    pgs->SetNumberOfSamples(numberOfSamples);
+    numberOfSamples = pgs->GetNumberOfSamples();
     if ( verbose ) {
       std::cout << "Number of grid samples: " << numberOfSamples << "\n";
     }
   }
 
+  // Start the chains from a maximum of the posterior or from the
+  // samples of a previous trace rather than from the prior. A
+  // checkpoint, if the run resumes from one, takes precedence.
+  if ( warmStart != "none" ) {
+    std::vector< madai::Sample > startingPoints;
+    if ( warmStart == "map" ) {
+      model->SetUseModelCovarianceToCalulateLogLikelihood( useModelError );
+      madai::LBFGSOptimizer optimizer;
+      optimizer.SetModel( model );
+      const std::vector< double > & current =
+        samplers[0]->GetCurrentParameters();
+      for ( unsigned int i = 0; i < current.size(); ++i ) {
+        if ( !samplers[0]->IsParameterActive( i ) ) {
+          optimizer.SetParameterValue( i, current[i] );
+          optimizer.DeactivateParameter( i );
+        }
+      }
+      optimizer.SetParameterValues( current );
+      startingPoints.push_back( optimizer.FindMaximum(
+        static_cast< unsigned int >(
+          madai::Defaults::OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS ) ) );
+      if ( verbose && !optimizer.HasConverged() ) {
+        std::cerr << "The search for the maximum of the posterior did not "
+                  << "converge; starting from where it stopped.\n";
+      }
+    } else {
+      // The trace may be one file, or one file per chain.
+      std::vector< std::string > traceFiles;
+      if ( madaisys::SystemTools::FileExists( warmStartTrace.c_str() ) ) {
+        traceFiles.push_back( warmStartTrace );
+      } else {
+        for ( int chain = 1; madaisys::SystemTools::FileExists(
+                madai::GetChainFileName( warmStartTrace, chain ).c_str() );
+              ++chain ) {
+          traceFiles.push_back(
+            madai::GetChainFileName( warmStartTrace, chain ) );
+        }
+      }
+      if ( traceFiles.empty() ) {
+        std::cerr << "Could not find SAMPLER_WARM_START_TRACE '"
+                  << warmStartTrace << "'.\n";
+        return EXIT_FAILURE;
+      }
+
+      std::vector< madai::Sample > traceSamples;
+      for ( size_t i = 0; i < traceFiles.size(); ++i ) {
+        std::vector< madai::Sample > samples;
+        if ( !madai::ReadTraceSamples( traceFiles[i],
+                                       samplers[0]->GetParameters(),
+                                       samples ) || samples.empty() ) {
+          std::cerr << "Could not read the samples of trace file '"
+                    << traceFiles[i] << "'.\n";
+          return EXIT_FAILURE;
+        }
+        if ( warmStart == "last" ) {
+          // The last sample of each file, or of each interleaved chain.
+          size_t count = ( traceFiles.size() == 1 ) ?
+            std::min( samples.size(),
+                      static_cast< size_t >( numberOfChains ) ) : 1;
+          samples.erase( samples.begin(), samples.end() - count );
+        }
+        traceSamples.insert( traceSamples.end(),
+                             samples.begin(), samples.end() );
+      }
+
+      if ( warmStart == "best" ) {
+        // The distinct samples of highest log likelihood, one per chain.
+        std::sort( traceSamples.begin(), traceSamples.end() );
+        for ( size_t i = traceSamples.size();
+              i > 0 && startingPoints.size() <
+                static_cast< size_t >( numberOfChains ); --i ) {
+          const madai::Sample & sample = traceSamples[i - 1];
+          if ( startingPoints.empty() ||
+               sample.m_ParameterValues !=
+               startingPoints.back().m_ParameterValues ) {
+            startingPoints.push_back( sample );
+          }
+        }
+      } else {
+        startingPoints = traceSamples;
+      }
+    }
+
+    for ( int chain = 0; chain < numberOfChains; ++chain ) {
+      const madai::Sample & start =
+        startingPoints[ chain % startingPoints.size() ];
+      std::vector< double > values( samplers[chain]->GetCurrentParameters() );
+      for ( unsigned int i = 0; i < values.size(); ++i ) {
+        if ( samplers[chain]->IsParameterActive( i ) ) {
+          values[i] = start.m_ParameterValues[i];
+        }
+      }
+      samplers[chain]->SetParameterValues( values );
+    }
+    if ( verbose ) {
+      if ( warmStart == "map" ) {
+        std::cout << "Starting from the maximum of the posterior, log "
+                  << "likelihood " << startingPoints[0].m_LogLikelihood << "\n";
+      } else {
+        std::cout << "Starting from " << startingPoints.size()
+                  << " samples of trace '" << warmStartTrace << "'\n";
+      }
+    }
+  }
+
+  // The range of indices of the scan this run evaluates, less what a
+  // previous run of it already wrote.
   std::string outputFilePath( argv[2] );
-  std::ofstream outFile(outputFilePath.c_str(), std::ios_base::out | std::ios_base::binary);
-  if ( !outFile.good() ) {
-    std::cerr << "Could not open trace file '" << outputFilePath << "' for writing.\n";
-    return EXIT_FAILURE;
+  bool appendToTrace = false;
+  if ( scan ) {
+    if ( scanEndIndex <= 0 || scanEndIndex > numberOfSamples ) {
+      scanEndIndex = numberOfSamples;
+    }
+    if ( scanStartIndex < 0 || scanStartIndex > scanEndIndex ) {
+      std::cerr << "SAMPLER_SCAN_START_INDEX must be between 0 and "
+                << scanEndIndex << ".\n";
+      return EXIT_FAILURE;
+    }
+
+    int numberOfCompletedSamples = 0;
+    if ( resume && madaisys::SystemTools::FileExists( outputFilePath.c_str() ) ) {
+      if ( compressed ) {
+        std::cerr << "Compressed trace files cannot be resumed.\n";
+        return EXIT_FAILURE;
+      }
+      int numberOfLines = madai::TruncateTraceToCompleteLines( outputFilePath );
+      if ( numberOfLines < 0 ) {
+        std::cerr << "Could not read trace file '" << outputFilePath
+                  << "' to resume it.\n";
+        return EXIT_FAILURE;
+      }
+      appendToTrace = ( numberOfLines > 0 );
+      numberOfCompletedSamples = std::min( std::max( numberOfLines - 1, 0 ),
+                                           scanEndIndex - scanStartIndex );
+    }
+
+    unsigned long int index =
+      static_cast< unsigned long int >( scanStartIndex + numberOfCompletedSamples );
+    if ( pgs != NULL ) {
+      pgs->SetIndex( index );
+    } else {
+      ss->SetIndex( index );
+      ss->SetEndIndex( static_cast< unsigned long int >( scanEndIndex ) );
+    }
+    numberOfSamples = scanEndIndex - scanStartIndex - numberOfCompletedSamples;
+    if ( verbose ) {
+      std::cout << "Evaluating indices " << index << " to " << scanEndIndex
+                << " of the scan\n";
+    }
+  }
+
+  // One trace file per chain unless the chains are interleaved.
+  std::vector< std::string > outputFilePaths;
+  if ( numberOfChains == 1 || interleaveChains ) {
+    outputFilePaths.push_back( outputFilePath );
+  } else {
+    for ( int chain = 0; chain < numberOfChains; ++chain ) {
+      outputFilePaths.push_back(
+        madai::GetChainFileName( outputFilePath, chain + 1 ) );
+    }
+  }
+
+  // Convergence diagnostics of the chains, which also decide when to
+  // stop. A scan is not a chain.
+  madai::ConvergenceMonitor convergenceMonitor;
+  convergenceMonitor.SetTargetEffectiveSampleSize( targetEffectiveSampleSize );
+  convergenceMonitor.SetPotentialScaleReductionThreshold( rHatThreshold );
+  convergenceMonitor.SetDetectEndOfBurnIn( automaticBurnIn );
+  madai::ConvergenceMonitor * monitor = scan ? NULL : &convergenceMonitor;
+
+  // Restore the Samplers from the last checkpoint, and drop the
+  // Samples written after it.
+  std::string checkpointFile = outputFilePath + ".checkpoint";
+  int numberOfCompletedSamples = 0;
+  if ( !scan && resume &&
+       madaisys::SystemTools::FileExists( checkpointFile.c_str() ) ) {
+    if ( compressed ) {
+      std::cerr << "Compressed trace files cannot be resumed.\n";
+      return EXIT_FAILURE;
+    }
+    std::vector< madai::Sampler * > samplerPointers;
+    for ( int chain = 0; chain < numberOfChains; ++chain ) {
+      samplers[chain]->SetModel( model );
+      samplerPointers.push_back( samplers[chain].get() );
+    }
+    std::ifstream checkpoint( checkpointFile.c_str() );
+    if ( !madai::SamplerCSVWriter::ReadCheckpoint(
+           checkpoint, samplerPointers, numberOfCompletedSamples, monitor ) ) {
+      std::cerr << "Could not restore the samplers from checkpoint file '"
+                << checkpointFile << "'. Was it written with other "
+                << "settings?\n";
+      return EXIT_FAILURE;
+    }
+
+    int numberOfWrittenSamples = std::min(
+      std::max( numberOfCompletedSamples - numberOfBurnInSamples, 0 ),
+      numberOfSamples );
+    if ( outputFilePaths.size() == 1 ) {
+      numberOfWrittenSamples *= numberOfChains;
+    }
+    for ( size_t i = 0; i < outputFilePaths.size(); ++i ) {
+      int numberOfLines =
+        ( numberOfWrittenSamples > 0 ) ? numberOfWrittenSamples + 1 : 0;
+      if ( !madai::TruncateTraceToLines( outputFilePaths[i], numberOfLines ) ) {
+        std::cerr << "Trace file '" << outputFilePaths[i] << "' has fewer "
+                  << "samples than checkpoint file '" << checkpointFile
+                  << "'.\n";
+        return EXIT_FAILURE;
+      }
+    }
+    appendToTrace = true;
+    if ( verbose ) {
+      std::cout << "Resuming after " << numberOfCompletedSamples
+                << " samples from checkpoint file '" << checkpointFile
+                << "'\n";
+    }
   }
-  boost::iostreams::filtering_streambuf<boost::iostreams::output> outbuf;
-  if( compressed ) {
-      outbuf.push(boost::iostreams::gzip_compressor());
+  if ( checkpointInterval <= 0 ) {
+    checkpointFile = "";
+  }
+
+  std::vector< boost::shared_ptr< TraceFile > > traceFiles;
+  std::vector< std::ostream * > outFileStreams;
+  for ( size_t i = 0; i < outputFilePaths.size(); ++i ) {
+    boost::shared_ptr< TraceFile > traceFile(
+      new TraceFile( outputFilePaths[i], compressed, appendToTrace ) );
+    if ( !traceFile->m_File.good() ) {
+      std::cerr << "Could not open trace file '" << outputFilePaths[i]
+                << "' for writing.\n";
+      return EXIT_FAILURE;
+    }
+    traceFiles.push_back( traceFile );
+    outFileStreams.push_back( &traceFile->m_Stream );
   }
-  outbuf.push(outFile);
-  std::ostream outFileStream(&outbuf);
 
   std::ostream * progressStream = verbose ? (& std::cerr) : NULL;
-  int returnCode = madai::SamplerCSVWriter::GenerateSamplesAndSaveToFile(
-      *sampler,
+  int returnCode;
+  if ( numberOfChains == 1 ) {
+    returnCode = madai::SamplerCSVWriter::GenerateSamplesAndSaveToFile(
+      *samplers[0],
+      *model,
+      *outFileStreams[0],
+      numberOfSamples,
+      numberOfBurnInSamples,
+      useModelError,
+      writeLogLikelihoodGradients,
+      progressStream,
+      !( scan && appendToTrace ),
+      numberOfCompletedSamples,
+      checkpointFile,
+      checkpointInterval,
+      monitor);
+  } else {
+    std::vector< madai::Sampler * > samplerPointers;
+    for ( int chain = 0; chain < numberOfChains; ++chain ) {
+      samplerPointers.push_back( samplers[chain].get() );
+    }
+    returnCode = madai::SamplerCSVWriter::GenerateSamplesAndSaveToFiles(
+      samplerPointers,
       *model,
-      outFileStream,
+      outFileStreams,
       numberOfSamples,
       numberOfBurnInSamples,
       useModelError,
       writeLogLikelihoodGradients,
-      progressStream);
+      progressStream,
+      numberOfCompletedSamples,
+      checkpointFile,
+      checkpointInterval,
+      monitor);
+  }
+  traceFiles.clear();
 
   if ( verbose ) {
-    if ( returnCode == EXIT_SUCCESS ) {
-      std::cout << "Succeeded writing trace file '" << outputFilePath << "'.\n";
-    } else {
-      std::cerr << "Could not write trace file '" << outputFilePath << "'.\n";
+    for ( size_t i = 0; i < outputFilePaths.size(); ++i ) {
+      if ( returnCode == EXIT_SUCCESS ) {
+        std::cout << "Succeeded writing trace file '" << outputFilePaths[i] << "'.\n";
+      } else {
+        std::cerr << "Could not write trace file '" << outputFilePaths[i] << "'.\n";
+      }
+    }
+    if ( monitor != NULL && returnCode == EXIT_SUCCESS ) {
+      std::vector< std::string > activeParameterNames;
+      const std::vector< madai::Parameter > & parameters = model->GetParameters();
+      for ( size_t i = 0; i < parameters.size(); ++i ) {
+        if ( samplers[0]->IsParameterActive( static_cast< unsigned int >( i ) ) ) {
+          activeParameterNames.push_back( parameters[i].m_Name );
+        }
+      }
+      std::cout << "Convergence diagnostics after "
+                << monitor->GetNumberOfSamples() << " samples per chain:\n";
+      monitor->WriteReport( std::cout, activeParameterNames );
+    }
+    if ( samplerType == "SequentialMonteCarlo" ) {
+      for ( int chain = 0; chain < numberOfChains; ++chain ) {
+        std::cout << "Log evidence of chain " << chain + 1 << ": "
+                  << static_cast< madai::SequentialMonteCarloSampler * >(
+                       samplers[chain].get() )->GetLogEvidence() << "\n";
+      }
+    }
+    if ( samplerType == "DelayedAcceptance" ) {
+      for ( int chain = 0; chain < numberOfChains; ++chain ) {
+        madai::DelayedAcceptanceSampler * das =
+          static_cast< madai::DelayedAcceptanceSampler * >(
+            samplers[chain].get() );
+        std::cout << "Chain " << chain + 1 << " ran the external model for "
+                  << das->GetNumberOfModelEvaluations() << " of "
+                  << das->GetNumberOfProposals() << " proposals\n";
+      }
     }
   }
 
@@ -0,0 +1,274 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <iomanip>
+#include <boost/shared_ptr.hpp>
+
+#include "ApplicationUtilities.h"
+#include "Defaults.h"
+#include "ExternalModel.h"
+#include "GaussianProcessEmulator.h"
+#include "GaussianProcessEmulatorDirectoryFormatIO.h"
+#include "GaussianProcessEmulatedModel.h"
+#include "LaplaceApproximationSampler.h"
+#include "Paths.h"
+#include "RuntimeParameterFileReader.h"
+#include "SamplerCSVWriter.h"
+
+
+int main(int argc, char ** argv) {
+
+  if (argc < 3) {
+    std::cerr
+      << "Usage:\n"
+      << "    " << argv[0] << " <StatisticsDirectory> <OutputFileName>\n"
+      << "\n"
+      << "This program approximates the posterior distribution with a \n"
+      << "Gaussian centered at its maximum, whose covariance is the inverse \n"
+      << "of the negative Hessian of the log likelihood there. The model is \n"
+      << "either defined in an external process or a trained emulator. The \n"
+      << "program madai_pca_decompose must have been run on \n"
+      << "<StatisticsDirectory> prior to running this program and if no \n"
+      << "EXTERNAL_MODEL_EXECUTABLE is specified in the settings file, \n"
+      << "madai_train_emulator must have been run as well.\n"
+      << "\n"
+      << "<StatisticsDirectory> is the directory in which all \n"
+      << "statistics data are stored. It contains the parameter file "
+      << madai::Paths::RUNTIME_PARAMETER_FILE << "\n"
+      << "\n"
+      << "<OutputFileName> is the name of the comma-separated value-format \n"
+      << "file in which SAMPLER_NUMBER_OF_SAMPLES independent samples from \n"
+      << "the approximation will be written, in the format of a trace. \n"
+      << "The mean and covariance are written to standard output.\n"
+      << "\n"
+      << "Format of entries in " << madai::Paths::RUNTIME_PARAMETER_FILE
+      << ":\n\n"
+      << "MODEL_OUTPUT_DIRECTORY <value> (default: "
+      << madai::Defaults::MODEL_OUTPUT_DIRECTORY << ")\n"
+      << "EXPERIMENTAL_RESULTS_FILE <value> (default: "
+      << madai::Defaults::EXPERIMENTAL_RESULTS_FILE << ")\n"
+      << "SAMPLER_INACTIVE_PARAMETERS_FILE <value> (default: "
+      << madai::Defaults::SAMPLER_INACTIVE_PARAMETERS_FILE << ")\n"
+      << "MCMC_USE_MODEL_ERROR <value> (default: "
+      << madai::Defaults::MCMC_USE_MODEL_ERROR << ")\n"
+      << "SAMPLER_NUMBER_OF_SAMPLES <value> (default: "
+      << madai::Defaults::SAMPLER_NUMBER_OF_SAMPLES << ")\n"
+      << "OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS <value> (default: "
+      << madai::Defaults::OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS << ")\n"
+      << "EXTERNAL_MODEL_EXECUTABLE <value> (default: \""
+      << madai::Defaults::EXTERNAL_MODEL_EXECUTABLE << "\")\n"
+      << "EXTERNAL_MODEL_ARGUMENTS <Argument1> <Argument2> ... <LastArgument>\n"
+      << "VERBOSE <value> (default: "
+      << madai::Defaults::VERBOSE << ")\n";
+
+    return EXIT_FAILURE;
+  }
+  std::string statisticsDirectory( argv[1] );
+  madai::EnsurePathSeparatorAtEnd( statisticsDirectory );
+
+  madai::RuntimeParameterFileReader settings;
+  std::string settingsFile = statisticsDirectory + madai::Paths::RUNTIME_PARAMETER_FILE;
+  if ( !settings.ParseFile( settingsFile ) ) {
+    std::cerr << "Could not open runtime parameter file '" << settingsFile << "'\n";
+    return EXIT_FAILURE;
+  }
+
+  std::string modelOutputDirectory =
+    madai::GetModelOutputDirectory( statisticsDirectory, settings );
+  std::string experimentalResultsFile =
+    madai::GetExperimentalResultsFile( statisticsDirectory, settings );
+
+  bool useModelError = settings.GetOptionAsBool(
+      "MCMC_USE_MODEL_ERROR",
+      madai::Defaults::MCMC_USE_MODEL_ERROR);
+
+  int numberOfSamples = settings.GetOptionAsInt(
+      "SAMPLER_NUMBER_OF_SAMPLES",
+      madai::Defaults::SAMPLER_NUMBER_OF_SAMPLES);
+
+  int maximumNumberOfIterations = settings.GetOptionAsInt(
+      "OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS",
+      madai::Defaults::OPTIMIZER_MAXIMUM_NUMBER_OF_ITERATIONS );
+
+  std::string executable = settings.GetOption(
+      "EXTERNAL_MODEL_EXECUTABLE",
+      madai::Defaults::EXTERNAL_MODEL_EXECUTABLE);
+
+  bool verbose = settings.GetOptionAsBool( "VERBOSE", madai::Defaults::VERBOSE );
+
+  madai::ExternalModel externalModel;
+  madai::GaussianProcessEmulatedModel gpem;
+
+  madai::Model * model;
+  if ( executable == "" ) { // Use emulator
+    bool pcaUseModelError = settings.GetOptionAsBool(
+        "PCA_USE_MODEL_ERROR", madai::Defaults::PCA_USE_MODEL_ERROR );
+    boost::shared_ptr< madai::GaussianProcessEmulator > gpe(
+      new madai::GaussianProcessEmulator( pcaUseModelError ) );
+    madai::GaussianProcessEmulatorDirectoryFormatIO directoryReader;
+    if ( !directoryReader.LoadTrainingData( gpe.get(),
+                                            modelOutputDirectory,
+                                            statisticsDirectory,
+                                            experimentalResultsFile ) ) {
+      std::cerr << "Error loading training data from the directory structure.\n";
+      return EXIT_FAILURE;
+    }
+    if ( !directoryReader.LoadPCA( gpe.get(), statisticsDirectory ) ) {
+      std::cerr << "Error loading the PCA decomposition data. Did you "
+                << "run madai_pca_decompose?\n";
+      return EXIT_FAILURE;
+    }
+    if ( !directoryReader.LoadEmulator( gpe.get(), statisticsDirectory ) ) {
+      std::cerr << "Error loading emulator data. Did you run "
+                << "madai_train_emulator?\n";
+      return EXIT_FAILURE;
+    }
+    gpem.SetGaussianProcessEmulator( gpe );
+    model = &gpem;
+
+    if ( verbose ) {
+      std::cout << "Using emulator to approximate the posterior.\n";
+    }
+  } else { // Use external model
+
+    // Split arguments into vector of strings
+    std::vector< std::string > arguments;
+    if ( settings.HasOption( "EXTERNAL_MODEL_ARGUMENTS" ) ) {
+      std::string argumentsString =
+        settings.GetOption( "EXTERNAL_MODEL_ARGUMENTS" );
+      arguments = madai::SplitString( argumentsString, ' ' );
+    }
+
+    if ( verbose ) {
+      std::cout << "Using external model executable '" << executable << "'.\n";
+    }
+
+    externalModel.StartProcess( executable, arguments );
+    if (! externalModel.IsReady()) {
+      std::cerr << "Something is wrong with the external model\n";
+      return EXIT_FAILURE;
+    }
+
+    model = &externalModel;
+  }
+
+  std::ifstream experimentalResults(experimentalResultsFile.c_str());
+  if ( madai::Model::NO_ERROR !=
+       madai::LoadObservations( model, experimentalResults ) ) {
+    std::cerr << "Error loading observations.\n";
+    externalModel.StopProcess();
+    return EXIT_FAILURE;
+  }
+  experimentalResults.close();
+  model->SetUseModelCovarianceToCalulateLogLikelihood( useModelError );
+
+  madai::LaplaceApproximationSampler sampler;
+  sampler.SetModel( model );
+  sampler.SetMaximumNumberOfIterations(
+    static_cast< unsigned int >( std::max( maximumNumberOfIterations, 0 ) ) );
+
+  std::string samplerInactiveParametersFile =
+    madai::GetInactiveParametersFile( statisticsDirectory, settings );
+  if ( ! madai::SetInactiveParameters( samplerInactiveParametersFile,
+                                       sampler, verbose ) ) {
+    std::cerr << "Error when setting inactive parameters from file '"
+              << samplerInactiveParametersFile << "'.\n";
+    externalModel.StopProcess();
+    return EXIT_FAILURE;
+  }
+
+  if ( !sampler.ComputeApproximation() ) {
+    std::cerr << "Warning: the search for the maximum did not converge or "
+              << "the log likelihood is not concave there.\n";
+  }
+  if ( verbose ) {
+    std::cout << "Found the maximum and its Hessian with "
+              << sampler.GetNumberOfModelEvaluations()
+              << " model evaluations\n";
+  }
+
+  const std::vector< madai::Parameter > & parameters = sampler.GetParameters();
+  const std::vector< double > & mean = sampler.GetMean();
+  Eigen::MatrixXd covariance = sampler.GetCovariance();
+  std::cout << std::setw(14) << "parameter";
+  std::cout << std::setw(14) << "mean";
+  std::cout << std::setw(14) << "std.dev.";
+  std::cout << '\n';
+  for ( unsigned int i = 0; i < parameters.size(); ++i ) {
+    std::cout
+      << std::setw(14) << parameters[i].m_Name
+      << std::setw(14) << mean[i]
+      << std::setw(14) << std::sqrt( covariance( i, i ) )
+      << '\n';
+  }
+
+  std::cout << "\nlog likelihood at the maximum\n";
+  std::cout << std::setw(14) << sampler.GetMaximum().m_LogLikelihood << "\n";
+
+  std::cout << "\ncovariance:\n";
+  std::cout << std::setw(14) << "";
+  for ( unsigned int j = 0; j < parameters.size(); ++j )
+    std::cout << std::setw(14) << parameters[j].m_Name;
+  std::cout << "\n";
+  for ( unsigned int i = 0; i < parameters.size(); ++i ) {
+    std::cout << std::setw(14) << parameters[i].m_Name;
+    for ( unsigned int j = 0; j < parameters.size(); ++j )
+      std::cout << std::setw(14) << covariance( i, j );
+    std::cout << "\n";
+  }
+
+  std::string outputFileName( argv[2] );
+  std::ofstream outFile( outputFileName.c_str() );
+  if ( !outFile.good() ) {
+    std::cerr << "Could not open trace file '" << outputFileName
+              << "' for writing.\n";
+    externalModel.StopProcess();
+    return EXIT_FAILURE;
+  }
+
+  // The samples are independent, so there is no burn-in.
+  std::ostream * progressStream = verbose ? (& std::cerr) : NULL;
+  int returnCode = madai::SamplerCSVWriter::GenerateSamplesAndSaveToFile(
+    sampler,
+    *model,
+    outFile,
+    numberOfSamples,
+    0,
+    useModelError,
+    false,
+    progressStream);
+  outFile.close();
+  externalModel.StopProcess();
+
+  if ( verbose ) {
+    if ( returnCode == EXIT_SUCCESS ) {
+      std::cout << "Succeeded writing trace file '" << outputFileName << "'.\n";
+    } else {
+      std::cerr << "Could not write trace file '" << outputFileName << "'.\n";
+    }
+  }
+
+  return returnCode;
+}
@@ -0,0 +1,111 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cstdlib> // EXIT_SUCCESS
+#include <iostream> // std::cout
+#include <fstream> // std::ifstream
+#include <string> // std::string
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+
+#include "ApplicationUtilities.h"
+#include "System.h"
+
+int main(int argc, char ** argv) {
+  if (argc < 3) {
+    std::cerr
+      << "Usage:\n"
+      << "    " << argv[0] << " <OutputFile> <TraceFile1> <TraceFile2> ...\n"
+      << "\n"
+      << "This program joins trace files with the same header, such as \n"
+      << "the shards of a scan written by madai_generate_trace with \n"
+      << "different ranges of SAMPLER_SCAN_START_INDEX and \n"
+      << "SAMPLER_SCAN_END_INDEX, into one trace file in the order given. \n"
+      << "The trace files may be compressed; <OutputFile> is not.\n";
+    return EXIT_FAILURE;
+  }
+
+  std::string outputFile( argv[1] );
+  for ( int i = 2; i < argc; ++i ) {
+    if ( outputFile == argv[i] ) {
+      std::cerr << "The output file '" << outputFile
+                << "' must not be one of the trace files.\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::ofstream output( outputFile.c_str(),
+                        std::ios_base::out | std::ios_base::binary );
+  if ( !output.good() ) {
+    std::cerr << "Could not open '" << outputFile << "' for writing.\n";
+    return EXIT_FAILURE;
+  }
+
+  std::string firstHeader;
+  long lineCount = 0;
+  for ( int i = 2; i < argc; ++i ) {
+    std::string traceFile( argv[i] );
+    if ( !madai::System::IsFile( traceFile ) ) {
+      std::cerr << "Trace file '" << traceFile
+                << "' does not exist or is a directory.\n";
+      return EXIT_FAILURE;
+    }
+
+    std::ifstream file( traceFile.c_str(),
+                        std::ios_base::in | std::ios_base::binary );
+    if ( !file.good() ) {
+      std::cerr << "Error reading trace file '" << traceFile << "'.\n";
+      return EXIT_FAILURE;
+    }
+    boost::iostreams::filtering_streambuf<boost::iostreams::input> inbuf;
+    if( madai::IsTraceCompressed(traceFile) ) {
+      inbuf.push(boost::iostreams::gzip_decompressor());
+    }
+    inbuf.push(file);
+    std::istream trace(&inbuf);
+
+    std::string header;
+    if ( !std::getline( trace, header ) ) {
+      // An empty shard adds nothing.
+      continue;
+    }
+    if ( firstHeader.empty() ) {
+      firstHeader = header;
+      output << header << '\n';
+    } else if ( header != firstHeader ) {
+      std::cerr << "The header of trace file '" << traceFile
+                << "' differs from the header of the first trace file.\n";
+      return EXIT_FAILURE;
+    }
+
+    std::string line;
+    while ( std::getline( trace, line ) ) {
+      output << line << '\n';
+      ++lineCount;
+    }
+  }
+
+  output.close();
+  if ( !output ) {
+    std::cerr << "Error writing '" << outputFile << "'.\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "Wrote " << lineCount << " samples to '" << outputFile << "'.\n";
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,310 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "AdaptiveMetropolisSampler.h"
+
+#include <cassert>
+#include <cmath>
+
+
+namespace {
+
+/** Replace the lower-triangular factor L of A = L L^T by the factor
+ * of A + x x^T. */
+void CholeskyRankOneUpdate( Eigen::MatrixXd & L, Eigen::VectorXd x )
+{
+  int n = static_cast< int >( x.size() );
+  for ( int k = 0; k < n; ++k ) {
+    double r = std::sqrt( L( k, k ) * L( k, k ) + x( k ) * x( k ) );
+    double c = r / L( k, k );
+    double s = x( k ) / L( k, k );
+    L( k, k ) = r;
+    for ( int i = k + 1; i < n; ++i ) {
+      L( i, k ) = ( L( i, k ) + s * x( i ) ) / c;
+      x( i ) = c * x( i ) - s * L( i, k );
+    }
+  }
+}
+
+} // end anonymous namespace
+
+
+namespace madai {
+
+
+AdaptiveMetropolisSampler
+::AdaptiveMetropolisSampler() :
+  MetropolisHastingsSampler(),
+  m_NumberOfAdaptationSamples( 0 ),
+  m_TargetAcceptanceRate( 0.234 ),
+  m_NumberOfAdaptedSamples( 0 ),
+  m_LogScale( 0.0 )
+{
+}
+
+
+AdaptiveMetropolisSampler
+::~AdaptiveMetropolisSampler()
+{
+}
+
+
+void
+AdaptiveMetropolisSampler
+::Initialize( const Model * model )
+{
+  MetropolisHastingsSampler::Initialize( model );
+  this->ResetAdaptation();
+}
+
+
+void
+AdaptiveMetropolisSampler
+::ParameterSetExternally()
+{
+  MetropolisHastingsSampler::ParameterSetExternally();
+  // Sampler::Initialize() gets here before the step scales are set.
+  if ( m_Model != NULL &&
+       m_StepScales.size() == m_CurrentParameters.size() ) {
+    this->ResetAdaptation();
+  }
+}
+
+
+void
+AdaptiveMetropolisSampler
+::SetStepSize( double stepSize )
+{
+  MetropolisHastingsSampler::SetStepSize( stepSize );
+  if ( m_Model != NULL ) {
+    this->ResetAdaptation();
+  }
+}
+
+
+void
+AdaptiveMetropolisSampler
+::SetNumberOfAdaptationSamples( unsigned int numberOfSamples )
+{
+  m_NumberOfAdaptationSamples = numberOfSamples;
+}
+
+
+unsigned int
+AdaptiveMetropolisSampler
+::GetNumberOfAdaptationSamples() const
+{
+  return m_NumberOfAdaptationSamples;
+}
+
+
+void
+AdaptiveMetropolisSampler
+::SetTargetAcceptanceRate( double rate )
+{
+  m_TargetAcceptanceRate = rate;
+}
+
+
+double
+AdaptiveMetropolisSampler
+::GetTargetAcceptanceRate() const
+{
+  return m_TargetAcceptanceRate;
+}
+
+
+bool
+AdaptiveMetropolisSampler
+::IsAdapting() const
+{
+  return ( !m_AdaptationEnded &&
+           m_NumberOfAdaptedSamples < m_NumberOfAdaptationSamples );
+}
+
+
+Eigen::MatrixXd
+AdaptiveMetropolisSampler
+::GetProposalCovariance() const
+{
+  return std::exp( 2.0 * m_LogScale ) *
+    m_ProposalCholesky * m_ProposalCholesky.transpose();
+}
+
+
+void
+AdaptiveMetropolisSampler
+::ResetAdaptation()
+{
+  assert( m_Model != NULL );
+  m_AdaptedParameterIndices.clear();
+  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      m_AdaptedParameterIndices.push_back( i );
+    }
+  }
+
+  // Start from the proposal of MetropolisHastingsSampler.
+  int d = static_cast< int >( m_AdaptedParameterIndices.size() );
+  m_Mean.resize( d );
+  m_ProposalCholesky = Eigen::MatrixXd::Zero( d, d );
+  for ( int k = 0; k < d; ++k ) {
+    unsigned int i = m_AdaptedParameterIndices[k];
+    m_Mean( k ) = m_CurrentParameters[i];
+    m_ProposalCholesky( k, k ) = m_StepSize * m_StepScales[i];
+  }
+  m_LogScale = 0.0;
+  m_NumberOfAdaptedSamples = 0;
+}
+
+
+void
+AdaptiveMetropolisSampler
+::WriteState( std::ostream & o ) const
+{
+  MetropolisHastingsSampler::WriteState( o );
+  WriteTag( o, "AdaptiveMetropolisSampler" );
+  o << m_NumberOfAdaptedSamples << '\n';
+  WriteIntegers( o, m_AdaptedParameterIndices );
+  WriteMatrix( o, m_Mean );
+  WriteMatrix( o, m_ProposalCholesky );
+  WriteValue( o, m_LogScale );
+  o << '\n';
+}
+
+
+bool
+AdaptiveMetropolisSampler
+::ReadState( std::istream & i )
+{
+  return ( MetropolisHastingsSampler::ReadState( i ) &&
+           ReadTag( i, "AdaptiveMetropolisSampler" ) &&
+           ( i >> m_NumberOfAdaptedSamples ) &&
+           ReadIntegers( i, m_AdaptedParameterIndices ) &&
+           ReadMatrix( i, m_Mean ) &&
+           ReadMatrix( i, m_ProposalCholesky ) &&
+           ReadValue( i, m_LogScale ) );
+}
+
+
+void
+AdaptiveMetropolisSampler
+::Adapt( double acceptanceProbability )
+{
+  // Robbins-Monro update of the global scale.
+  double n = static_cast< double >( m_NumberOfAdaptedSamples + 1 );
+  m_LogScale += std::pow( n, -0.6 ) *
+    ( acceptanceProbability - m_TargetAcceptanceRate );
+
+  // Running mean and covariance, where the estimate so far stands for
+  // m_NumberOfAdaptedSamples + 1 samples including the initial
+  // pseudo-sample:
+  //   C_n = (n-1)/n C_{n-1} + (n-1)/n^2 delta delta^T
+  // The proposal covariance is 2.38^2/d C_n.
+  int d = static_cast< int >( m_AdaptedParameterIndices.size() );
+  if ( d == 0 ) {
+    return;
+  }
+  Eigen::VectorXd x( d );
+  for ( int k = 0; k < d; ++k ) {
+    x( k ) = m_CurrentParameters[ m_AdaptedParameterIndices[k] ];
+  }
+  n += 1.0;
+  Eigen::VectorXd delta = x - m_Mean;
+  m_Mean += delta / n;
+
+  static const double OPTIMAL_SCALE = 2.38;
+  double scale = OPTIMAL_SCALE * OPTIMAL_SCALE / d;
+  m_ProposalCholesky *= std::sqrt( ( n - 1.0 ) / n );
+  CholeskyRankOneUpdate( m_ProposalCholesky,
+                         delta * ( std::sqrt( scale * ( n - 1.0 ) ) / n ) );
+}
+
+
+bool
+AdaptiveMetropolisSampler
+::IsSpeculative() const
+{
+  return false;
+}
+
+
+bool
+AdaptiveMetropolisSampler
+::Step()
+{
+  unsigned int numberOfOutputs = m_Model->GetNumberOfScalarOutputs();
+
+  // Start over if the set of active parameters has changed.
+  if ( this->ActiveIndicesChanged( m_AdaptedParameterIndices ) ) {
+    this->ResetAdaptation();
+  }
+
+  int d = static_cast< int >( m_AdaptedParameterIndices.size() );
+  Eigen::VectorXd & z = m_StandardNormalDraws;
+  Eigen::VectorXd & step = m_ProposalStep;
+  z.resize( d );
+  for ( int k = 0; k < d; ++k ) {
+    z( k ) = m_Random.Gaussian();
+  }
+  step.noalias() = m_ProposalCholesky.triangularView< Eigen::Lower >() * z;
+  step *= std::exp( m_LogScale );
+
+  // xc is x_candidate
+  std::vector< double > & xc = m_CandidateParameters;
+  xc = m_CurrentParameters;
+  for ( int k = 0; k < d; ++k ) {
+    xc[ m_AdaptedParameterIndices[k] ] += step( k );
+  }
+  m_CandidateOutputs.resize( numberOfOutputs );
+  m_CandidateLogLikelihoodValueGradient.resize( numberOfOutputs );
+  m_CandidateLogLikelihoodErrorGradient.resize( numberOfOutputs );
+  double ll; // ll is new_log_likelihood
+  m_Model->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
+    xc, m_CandidateOutputs, ll,
+    m_CandidateLogLikelihoodValueGradient,
+    m_CandidateLogLikelihoodErrorGradient );
+
+  // Check for NaN
+  assert( ll == ll );
+
+  double delta_logLikelihood = ll - m_CurrentLogLikelihood;
+  double acceptanceProbability =
+    ( delta_logLikelihood > 0 ) ? 1.0 : std::exp( delta_logLikelihood );
+
+  bool accepted = ( ( delta_logLikelihood > 0 ) ||
+                    ( acceptanceProbability > m_Random.Uniform() ) );
+  if ( accepted ) {
+    m_CurrentLogLikelihood = ll;
+    m_CurrentParameters.swap( xc );
+    m_CurrentOutputs.swap( m_CandidateOutputs );
+    m_CurrentLogLikelihoodValueGradient.swap(
+      m_CandidateLogLikelihoodValueGradient );
+    m_CurrentLogLikelihoodErrorGradient.swap(
+      m_CandidateLogLikelihoodErrorGradient );
+  }
+
+  if ( this->IsAdapting() ) {
+    this->Adapt( acceptanceProbability );
+    ++m_NumberOfAdaptedSamples;
+  }
+
+  return accepted;
+}
+
+} // end namespace madai
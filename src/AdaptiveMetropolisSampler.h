@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_AdaptiveMetropolisSampler_h_included
+#define madai_AdaptiveMetropolisSampler_h_included
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "MetropolisHastingsSampler.h"
+
+
+namespace madai {
+
+/**
+ * \class AdaptiveMetropolisSampler
+ *
+ * Metropolis sampler that learns its proposal distribution (Haario,
+ * Saksman and Tamminen, 2001).
+ *
+ * Steps are drawn from a multivariate Gaussian over the active
+ * parameters. During the first NumberOfAdaptationSamples steps, the
+ * covariance of the proposal is set to
+ * \f$ \frac{2.38^2}{d} \f$ times a running estimate of the covariance
+ * of the chain, and a global scale is tuned by Robbins-Monro
+ * stochastic approximation so that the acceptance rate approaches
+ * TargetAcceptanceRate. The covariance is kept as a Cholesky factor
+ * that is updated by one rank-one update per sample. Afterwards the
+ * proposal is frozen and the sampler is an ordinary Metropolis
+ * sampler, so the adaptation should be done during burn-in.
+ *
+ * Before any samples are seen, the proposal is the one of
+ * MetropolisHastingsSampler with the same StepSize. That proposal
+ * also enters the covariance estimate as one pseudo-sample, which
+ * keeps the estimate positive definite.
+ */
+class AdaptiveMetropolisSampler : public MetropolisHastingsSampler {
+public:
+  AdaptiveMetropolisSampler();
+  virtual ~AdaptiveMetropolisSampler();
+
+  /** Set the StepSize of the initial proposal. Restarts the
+   * adaptation. */
+  virtual void SetStepSize( double stepSize );
+
+  //@{
+  /** Set/Get the number of steps during which the proposal is
+   * adapted. Usually the number of burn-in samples. */
+  void SetNumberOfAdaptationSamples( unsigned int numberOfSamples );
+  unsigned int GetNumberOfAdaptationSamples() const;
+  //@}
+
+  //@{
+  /** Set/Get the acceptance rate that the global scale is tuned
+   * toward. Defaults to 0.234. */
+  void SetTargetAcceptanceRate( double rate );
+  double GetTargetAcceptanceRate() const;
+  //@}
+
+  /** Returns true while the proposal is being adapted. */
+  bool IsAdapting() const;
+
+  /** Get the covariance matrix of the current proposal. Rows and
+   * columns correspond to the active parameters in order. */
+  Eigen::MatrixXd GetProposalCovariance() const;
+
+  /** Discard what has been learned and start adapting again from
+   * the initial proposal. */
+  void ResetAdaptation();
+
+  //@{
+  /** The state includes the adapted proposal. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Evaluates the Model at the new point and restarts the
+   * adaptation, since the chain so far no longer leads to it. */
+  virtual void ParameterSetExternally();
+
+  /** The proposal is adapted one step at a time, so no steps are
+   * taken ahead. */
+  virtual bool IsSpeculative() const;
+
+  /** Take a step with the adapted proposal, and adapt it further
+   * while IsAdapting(). */
+  virtual bool Step();
+
+  /** Update the proposal after a step that was accepted with the
+   * given probability. */
+  void Adapt( double acceptanceProbability );
+
+  /** Number of steps with adaptation. */
+  unsigned int m_NumberOfAdaptationSamples;
+
+  /** Acceptance rate targeted by the scale adaptation. */
+  double m_TargetAcceptanceRate;
+
+  /** Number of samples the proposal has been adapted to. */
+  unsigned int m_NumberOfAdaptedSamples;
+
+  /** Indices of the parameters the proposal was built for. */
+  std::vector< unsigned int > m_AdaptedParameterIndices;
+
+  /** Running mean of the chain over the active parameters. */
+  Eigen::VectorXd m_Mean;
+
+  /** Lower-triangular Cholesky factor of the unscaled proposal
+   * covariance. */
+  Eigen::MatrixXd m_ProposalCholesky;
+
+  /** Logarithm of the global scale of the proposal. */
+  double m_LogScale;
+
+  /** Scratch vectors for building a proposal, kept to avoid
+   * allocating them at every step. */
+  Eigen::VectorXd m_StandardNormalDraws;
+  Eigen::VectorXd m_ProposalStep;
+
+}; // end class AdaptiveMetropolisSampler
+
+} // end namespace madai
+
+#endif // madai_AdaptiveMetropolisSampler_h_included
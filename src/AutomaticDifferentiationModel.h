@@ -0,0 +1,243 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_AutomaticDifferentiationModel_h_included
+#define madai_AutomaticDifferentiationModel_h_included
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "DualNumber.h"
+#include "Model.h"
+
+
+namespace madai {
+
+/** \class AutomaticDifferentiationModel
+ *
+ * Helper base class for Models written in C++ that provides exact
+ * gradients by forward-mode automatic differentiation.
+ *
+ * Subclasses pass themselves as the template argument and implement
+ * their forward model once, templated on the scalar type:
+ *
+ * \code
+ * class MyModel : public madai::AutomaticDifferentiationModel< MyModel > {
+ * public:
+ *   template< class TScalar >
+ *   ErrorType EvaluateScalarOutputs( const std::vector< TScalar > & parameters,
+ *                                    std::vector< TScalar > & scalars ) const;
+ * };
+ * \endcode
+ *
+ * GetScalarOutputs() instantiates the forward model with double.
+ * GetScalarAndGradientOutputs() instantiates it with DualNumber and
+ * obtains the Jacobian of the outputs with respect to all active
+ * parameters in one evaluation, instead of the 2p evaluations of the
+ * central finite differences in Model. The gradient of the log
+ * likelihood (including the log prior) is then assembled from the
+ * Jacobian exactly as Model::GetScalarOutputsAndLogLikelihood()
+ * assembles the log likelihood from the outputs.
+ * GetScalarOutputsAndLogLikelihoodAndGradient() takes the log
+ * likelihood from the values of the same evaluation.
+ *
+ * When the Model is set to use the model covariance in the log
+ * likelihood, the covariance may depend on the parameters in a way
+ * this class cannot see, so it falls back to the finite differences
+ * in Model. */
+template< class TModel >
+class AutomaticDifferentiationModel : public Model {
+public:
+  AutomaticDifferentiationModel() {}
+  virtual ~AutomaticDifferentiationModel() {}
+
+  /** Evaluates the forward model with double scalars. */
+  virtual ErrorType GetScalarOutputs( const std::vector< double > & parameters,
+                                      std::vector< double > & scalars ) const
+  {
+    return static_cast< const TModel * >( this )->EvaluateScalarOutputs(
+      parameters, scalars );
+  }
+
+  /** Get the scalar outputs and the Jacobian of the scalar outputs
+   * with respect to the active parameters.
+   *
+   * \param parameters Point in parameter space where the Model should
+   * be evaluated.
+   * \param activeParameters List of parameters for which the
+   * derivatives should be computed.
+   * \param scalars Output argument that will contain the scalars.
+   * \param jacobian Output argument that will contain the t-by-a
+   * Jacobian, where t is the number of scalar outputs and a is the
+   * number of active parameters. */
+  ErrorType GetScalarOutputsAndJacobian(
+    const std::vector< double > & parameters,
+    const std::vector< bool > & activeParameters,
+    std::vector< double > & scalars,
+    Eigen::MatrixXd & jacobian ) const
+  {
+    unsigned int numberOfParameters = this->GetNumberOfParameters();
+    if ( static_cast< unsigned int >( activeParameters.size() ) !=
+         numberOfParameters ) {
+      return INVALID_ACTIVE_PARAMETERS;
+    }
+    if ( static_cast< unsigned int >( parameters.size() ) !=
+         numberOfParameters ) {
+      return WRONG_VECTOR_LENGTH;
+    }
+
+    unsigned int numberOfActiveParameters = 0;
+    for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+      if ( activeParameters[i] ) {
+        ++numberOfActiveParameters;
+      }
+    }
+
+    // Seed one derivative direction per active parameter.
+    std::vector< DualNumber > dualParameters;
+    dualParameters.reserve( numberOfParameters );
+    unsigned int activeIndex = 0;
+    for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+      if ( activeParameters[i] ) {
+        dualParameters.push_back(
+          DualNumber( parameters[i], numberOfActiveParameters, activeIndex++ ) );
+      } else {
+        dualParameters.push_back( DualNumber( parameters[i] ) );
+      }
+    }
+
+    std::vector< DualNumber > dualScalars;
+    ErrorType error = static_cast< const TModel * >( this )->EvaluateScalarOutputs(
+      dualParameters, dualScalars );
+    if ( error != NO_ERROR ) {
+      return error;
+    }
+
+    unsigned int t = this->GetNumberOfScalarOutputs();
+    if ( static_cast< unsigned int >( dualScalars.size() ) != t ) {
+      return OTHER_ERROR;
+    }
+
+    scalars.resize( t );
+    jacobian = Eigen::MatrixXd::Zero( t, numberOfActiveParameters );
+    for ( unsigned int j = 0; j < t; ++j ) {
+      scalars[j] = dualScalars[j].GetValue();
+      if ( !dualScalars[j].IsConstant() ) {
+        jacobian.row( j ) = dualScalars[j].GetDerivatives().transpose();
+      }
+    }
+
+    return NO_ERROR;
+  }
+
+  /** Get both scalar outputs and the exact gradient of the log
+   * likelihood with respect to the active parameters. */
+  virtual ErrorType GetScalarAndGradientOutputs(
+    const std::vector< double > & parameters,
+    const std::vector< bool > & activeParameters,
+    std::vector< double > & scalars,
+    std::vector< double > & gradient ) const
+  {
+    if ( m_UseModelCovarianceToCalulateLogLikelihood ) {
+      return this->Model::GetScalarAndGradientOutputs(
+        parameters, activeParameters, scalars, gradient );
+    }
+
+    gradient.clear();
+    Eigen::MatrixXd jacobian;
+    ErrorType error = this->GetScalarOutputsAndJacobian(
+      parameters, activeParameters, scalars, jacobian );
+    if ( error != NO_ERROR ) {
+      return error;
+    }
+
+    Eigen::VectorXd logLikelihoodGradient;
+    if ( m_LogLikelihoodObservable > -1 ) {
+      // The model computes its own log likelihood.
+      logLikelihoodGradient = jacobian.row( m_LogLikelihoodObservable ).transpose();
+    } else {
+      unsigned int t = this->GetNumberOfScalarOutputs();
+      Eigen::VectorXd difference( t );
+      for ( unsigned int j = 0; j < t; ++j ) {
+        difference( j ) = scalars[j];
+        if ( m_ObservedScalarValues.size() > 0 ) {
+          difference( j ) -= m_ObservedScalarValues[j];
+        }
+      }
+
+      std::vector< double > constantCovariance;
+      if ( !this->GetConstantCovariance( constantCovariance ) ) {
+        std::cerr << "Error getting the constant covariance matrix from the model\n";
+        return OTHER_ERROR;
+      }
+
+      // d/dx of -0.5 * diff^T C^-1 diff is -J^T C^-1 diff.
+      if ( constantCovariance.size() == 0 ) {
+        // Unit variance, as in Model::GetScalarOutputsAndLogLikelihood().
+        logLikelihoodGradient = -jacobian.transpose() * difference;
+      } else {
+        Eigen::Map< Eigen::MatrixXd > covariance( &( constantCovariance[0] ), t, t );
+        Eigen::VectorXd weightedDifference =
+          covariance.colPivHouseholderQr().solve( difference );
+        logLikelihoodGradient = -jacobian.transpose() * weightedDifference;
+      }
+    }
+
+    std::vector< double > priorGradient;
+    this->GetGradientOfLogPriorLikelihood( parameters, priorGradient );
+    unsigned int activeIndex = 0;
+    for ( unsigned int i = 0; i < this->GetNumberOfParameters(); ++i ) {
+      if ( activeParameters[i] ) {
+        gradient.push_back( logLikelihoodGradient( activeIndex++ ) +
+                            priorGradient[i] );
+      }
+    }
+
+    return NO_ERROR;
+  }
+
+  /** Get the scalar outputs, the log likelihood and its exact
+   * gradient from one evaluation of the forward model, the outputs
+   * being the values of its DualNumber outputs. */
+  virtual ErrorType GetScalarOutputsAndLogLikelihoodAndGradient(
+    const std::vector< double > & parameters,
+    const std::vector< bool > & activeParameters,
+    std::vector< double > & scalars,
+    double & logLikelihood,
+    std::vector< double > & gradient ) const
+  {
+    if ( m_UseModelCovarianceToCalulateLogLikelihood ) {
+      return this->Model::GetScalarOutputsAndLogLikelihoodAndGradient(
+        parameters, activeParameters, scalars, logLikelihood, gradient );
+    }
+
+    ErrorType error = this->GetScalarAndGradientOutputs(
+      parameters, activeParameters, scalars, gradient );
+    if ( error != NO_ERROR ) {
+      return error;
+    }
+    return this->GetLogLikelihoodOfScalarOutputs(
+      parameters, scalars, std::vector< double >(), logLikelihood );
+  }
+
+}; // end AutomaticDifferentiationModel
+
+} // end namespace madai
+
+#endif // madai_AutomaticDifferentiationModel_h_included
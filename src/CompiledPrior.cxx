@@ -0,0 +1,257 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "CompiledPrior.h"
+
+#include <cmath>
+#include <limits>
+
+#include "GaussianDistribution.h"
+#include "UniformDistribution.h"
+
+
+namespace {
+
+/** Returns the first index if the indices are consecutive, -1
+ * otherwise. */
+int ConsecutiveOffset( const std::vector< unsigned int > & indices )
+{
+  if ( indices.empty() ) {
+    return -1;
+  }
+  for ( size_t k = 1; k < indices.size(); ++k ) {
+    if ( indices[k] != indices[0] + k ) {
+      return -1;
+    }
+  }
+  return static_cast< int >( indices[0] );
+}
+
+} // end anonymous namespace
+
+
+namespace madai {
+
+CompiledPrior
+::CompiledPrior() :
+  m_NumberOfParameters( 0 ),
+  m_UniformOffset( -1 ),
+  m_UniformLogDensity( 0.0 ),
+  m_GaussianOffset( -1 ),
+  m_GaussianLogNormalization( 0.0 )
+{
+}
+
+
+CompiledPrior
+::~CompiledPrior()
+{
+}
+
+
+void
+CompiledPrior
+::SetParameters( const std::vector< Parameter > & parameters )
+{
+  m_NumberOfParameters = static_cast< unsigned int >( parameters.size() );
+  m_PriorDistributions.resize( m_NumberOfParameters );
+  m_PriorIdentifiers.resize( m_NumberOfParameters );
+  for ( unsigned int i = 0; i < m_NumberOfParameters; ++i ) {
+    m_PriorDistributions[i] = parameters[i].GetPriorDistribution();
+    m_PriorIdentifiers[i] = parameters[i].GetPriorIdentifier();
+  }
+  m_UniformIndices.clear();
+  m_GaussianIndices.clear();
+  m_OtherIndices.clear();
+  m_OtherParameters.clear();
+
+  std::vector< double > uniformMinimums;
+  std::vector< double > uniformMaximums;
+  std::vector< double > gaussianMeans;
+  std::vector< double > gaussianInverseVariances;
+  m_UniformLogDensity = 0.0;
+  m_GaussianLogNormalization = 0.0;
+
+  for ( unsigned int i = 0; i < m_NumberOfParameters; ++i ) {
+    const Distribution * distribution = parameters[i].GetPriorDistribution();
+    const UniformDistribution * uniform =
+      dynamic_cast< const UniformDistribution * >( distribution );
+    const GaussianDistribution * gaussian =
+      dynamic_cast< const GaussianDistribution * >( distribution );
+
+    if ( uniform ) {
+      m_UniformIndices.push_back( i );
+      uniformMinimums.push_back( uniform->GetMinimum() );
+      uniformMaximums.push_back( uniform->GetMaximum() );
+      m_UniformLogDensity -=
+        std::log( uniform->GetMaximum() - uniform->GetMinimum() );
+    } else if ( gaussian ) {
+      double variance =
+        gaussian->GetStandardDeviation() * gaussian->GetStandardDeviation();
+      m_GaussianIndices.push_back( i );
+      gaussianMeans.push_back( gaussian->GetMean() );
+      gaussianInverseVariances.push_back( 1.0 / variance );
+      m_GaussianLogNormalization -= 0.5 * std::log( 2.0 * M_PI * variance );
+    } else {
+      m_OtherIndices.push_back( i );
+      m_OtherParameters.push_back( parameters[i] );
+    }
+  }
+
+  m_UniformOffset = ConsecutiveOffset( m_UniformIndices );
+  m_UniformMinimums = Eigen::Map< Eigen::ArrayXd >(
+    uniformMinimums.empty() ? NULL : &uniformMinimums[0],
+    uniformMinimums.size() );
+  m_UniformMaximums = Eigen::Map< Eigen::ArrayXd >(
+    uniformMaximums.empty() ? NULL : &uniformMaximums[0],
+    uniformMaximums.size() );
+
+  m_GaussianOffset = ConsecutiveOffset( m_GaussianIndices );
+  m_GaussianMeans = Eigen::Map< Eigen::ArrayXd >(
+    gaussianMeans.empty() ? NULL : &gaussianMeans[0],
+    gaussianMeans.size() );
+  m_GaussianInverseVariances = Eigen::Map< Eigen::ArrayXd >(
+    gaussianInverseVariances.empty() ? NULL : &gaussianInverseVariances[0],
+    gaussianInverseVariances.size() );
+}
+
+
+unsigned int
+CompiledPrior
+::GetNumberOfParameters() const
+{
+  return m_NumberOfParameters;
+}
+
+
+bool
+CompiledPrior
+::IsCompiledFrom( const std::vector< Parameter > & parameters ) const
+{
+  if ( parameters.size() != m_NumberOfParameters ) {
+    return false;
+  }
+  for ( unsigned int i = 0; i < m_NumberOfParameters; ++i ) {
+    if ( parameters[i].GetPriorDistribution() != m_PriorDistributions[i] ||
+         parameters[i].GetPriorIdentifier() != m_PriorIdentifiers[i] ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+double
+CompiledPrior
+::GetLogPriorLikelihood( const double * x ) const
+{
+  double logPriorLikelihood = 0.0;
+
+  size_t numberOfUniform = m_UniformIndices.size();
+  if ( numberOfUniform > 0 ) {
+    bool inRange = true;
+    if ( m_UniformOffset >= 0 ) {
+      Eigen::Map< const Eigen::ArrayXd > values( x + m_UniformOffset,
+                                                 numberOfUniform );
+      inRange = ( values >= m_UniformMinimums ).all() &&
+        ( values <= m_UniformMaximums ).all();
+    } else {
+      for ( size_t k = 0; k < numberOfUniform; ++k ) {
+        double value = x[ m_UniformIndices[k] ];
+        inRange &= ( value >= m_UniformMinimums( k ) ) &
+          ( value <= m_UniformMaximums( k ) );
+      }
+    }
+    if ( !inRange ) {
+      return -std::numeric_limits< double >::infinity();
+    }
+    logPriorLikelihood += m_UniformLogDensity;
+  }
+
+  size_t numberOfGaussian = m_GaussianIndices.size();
+  if ( numberOfGaussian > 0 ) {
+    double sum = 0.0;
+    if ( m_GaussianOffset >= 0 ) {
+      Eigen::Map< const Eigen::ArrayXd > values( x + m_GaussianOffset,
+                                                 numberOfGaussian );
+      sum = ( ( values - m_GaussianMeans ).square() *
+              m_GaussianInverseVariances ).sum();
+    } else {
+      for ( size_t k = 0; k < numberOfGaussian; ++k ) {
+        double difference = x[ m_GaussianIndices[k] ] - m_GaussianMeans( k );
+        sum += difference * difference * m_GaussianInverseVariances( k );
+      }
+    }
+    logPriorLikelihood += m_GaussianLogNormalization - 0.5 * sum;
+  }
+
+  for ( size_t k = 0; k < m_OtherIndices.size(); ++k ) {
+    logPriorLikelihood += m_OtherParameters[k].GetPriorDistribution()->
+      GetLogProbabilityDensity( x[ m_OtherIndices[k] ] );
+  }
+
+  return logPriorLikelihood;
+}
+
+
+void
+CompiledPrior
+::GetGradientOfLogPriorLikelihood( const double * x,
+                                   double * gradient ) const
+{
+  // Uniform priors have zero gradient.
+  for ( size_t k = 0; k < m_UniformIndices.size(); ++k ) {
+    gradient[ m_UniformIndices[k] ] = 0.0;
+  }
+
+  size_t numberOfGaussian = m_GaussianIndices.size();
+  if ( m_GaussianOffset >= 0 ) {
+    Eigen::Map< const Eigen::ArrayXd > values( x + m_GaussianOffset,
+                                               numberOfGaussian );
+    Eigen::Map< Eigen::ArrayXd > gaussianGradient( gradient + m_GaussianOffset,
+                                                   numberOfGaussian );
+    gaussianGradient = ( m_GaussianMeans - values ) * m_GaussianInverseVariances;
+  } else {
+    for ( size_t k = 0; k < numberOfGaussian; ++k ) {
+      unsigned int i = m_GaussianIndices[k];
+      gradient[i] = ( m_GaussianMeans( k ) - x[i] ) *
+        m_GaussianInverseVariances( k );
+    }
+  }
+
+  for ( size_t k = 0; k < m_OtherIndices.size(); ++k ) {
+    unsigned int i = m_OtherIndices[k];
+    gradient[i] = m_OtherParameters[k].GetPriorDistribution()->
+      GetGradientLogProbabilityDensity( x[i] );
+  }
+}
+
+
+void
+CompiledPrior
+::GetLogPriorLikelihoods( const double * points,
+                          unsigned int numberOfPoints,
+                          double * logPriorLikelihoods ) const
+{
+  for ( unsigned int j = 0; j < numberOfPoints; ++j ) {
+    logPriorLikelihoods[j] =
+      this->GetLogPriorLikelihood( points + j * m_NumberOfParameters );
+  }
+}
+
+} // end namespace madai
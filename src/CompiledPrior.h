@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_CompiledPrior_h_included
+#define madai_CompiledPrior_h_included
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Parameter.h"
+
+
+namespace madai {
+
+/** \class CompiledPrior
+ *
+ * The joint prior distribution of a set of Parameters, arranged for
+ * fast evaluation.
+ *
+ * The parameters are grouped by the type of their prior
+ * distribution. Uniform priors are stored as arrays of bounds and
+ * Gaussian priors as arrays of means and inverse variances, so the
+ * log density and its gradient are computed in tight loops without a
+ * virtual call per parameter. Parameters with any other prior
+ * distribution fall back to the Distribution interface.
+ *
+ * Points are passed as arrays of length GetNumberOfParameters(), and
+ * results are written to buffers supplied by the caller. */
+class CompiledPrior {
+public:
+  CompiledPrior();
+  virtual ~CompiledPrior();
+
+  /** Build the compiled prior from the prior distributions of a set
+   * of parameters. */
+  void SetParameters( const std::vector< Parameter > & parameters );
+
+  /** Get the number of parameters. */
+  unsigned int GetNumberOfParameters() const;
+
+  /** Returns true if this was built from the current priors of the
+   * parameters, false if any has been added, removed or replaced
+   * since. A prior modified in place is not noticed. */
+  bool IsCompiledFrom( const std::vector< Parameter > & parameters ) const;
+
+  /** Get the log of the joint prior density at a point.
+   *
+   * \param x Array of GetNumberOfParameters() parameter values. */
+  double GetLogPriorLikelihood( const double * x ) const;
+
+  /** Get the gradient of the log of the joint prior density at a
+   * point.
+   *
+   * \param x Array of GetNumberOfParameters() parameter values.
+   * \param gradient Array of GetNumberOfParameters() values that
+   * receives the gradient. */
+  void GetGradientOfLogPriorLikelihood( const double * x,
+                                        double * gradient ) const;
+
+  /** Get the log of the joint prior density at a batch of points.
+   *
+   * \param points Array of numberOfPoints points stored one after the
+   * other, each GetNumberOfParameters() values long.
+   * \param numberOfPoints Number of points.
+   * \param logPriorLikelihoods Array of numberOfPoints values that
+   * receives the log prior densities. */
+  void GetLogPriorLikelihoods( const double * points,
+                               unsigned int numberOfPoints,
+                               double * logPriorLikelihoods ) const;
+
+protected:
+  /** Number of parameters. */
+  unsigned int m_NumberOfParameters;
+
+  //@{
+  /** The prior distributions this was built from. */
+  std::vector< const Distribution * > m_PriorDistributions;
+  std::vector< long >                 m_PriorIdentifiers;
+  //@}
+
+  //@{
+  /** Parameters with uniform priors. m_UniformOffset is the index of
+   * the first one if their indices are consecutive, -1 otherwise. */
+  std::vector< unsigned int > m_UniformIndices;
+  int                         m_UniformOffset;
+  Eigen::ArrayXd              m_UniformMinimums;
+  Eigen::ArrayXd              m_UniformMaximums;
+  double                      m_UniformLogDensity;
+  //@}
+
+  //@{
+  /** Parameters with Gaussian priors. m_GaussianOffset is the index
+   * of the first one if their indices are consecutive, -1
+   * otherwise. */
+  std::vector< unsigned int > m_GaussianIndices;
+  int                         m_GaussianOffset;
+  Eigen::ArrayXd              m_GaussianMeans;
+  Eigen::ArrayXd              m_GaussianInverseVariances;
+  double                      m_GaussianLogNormalization;
+  //@}
+
+  //@{
+  /** Parameters with any other prior distribution. */
+  std::vector< unsigned int > m_OtherIndices;
+  std::vector< Parameter >    m_OtherParameters;
+  //@}
+
+}; // end CompiledPrior
+
+} // end namespace madai
+
+#endif // madai_CompiledPrior_h_included
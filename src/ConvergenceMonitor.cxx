@@ -0,0 +1,601 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm> // std::min
+#include <cassert>
+#include <cmath> // std::sqrt
+#include <iomanip> // std::setw
+#include <iostream>
+#include <limits>
+
+#include "ConvergenceMonitor.h"
+
+
+namespace madai {
+
+/** The number of batches of a chain stays between this and twice
+ * this. */
+static const unsigned int MINIMUM_NUMBER_OF_BATCHES = 32;
+
+
+void
+ConvergenceMonitor::Batch
+::Merge( const Batch & other )
+{
+  if ( other.m_Count == 0 ) {
+    return;
+  }
+  if ( m_Count == 0 ) {
+    *this = other;
+    return;
+  }
+  double count = static_cast< double >( m_Count + other.m_Count );
+  double weight = static_cast< double >( m_Count ) *
+    static_cast< double >( other.m_Count ) / count;
+  for ( size_t p = 0; p < m_Means.size(); ++p ) {
+    double delta = other.m_Means[p] - m_Means[p];
+    m_Means[p] += delta * static_cast< double >( other.m_Count ) / count;
+    m_SumsOfSquares[p] += other.m_SumsOfSquares[p] + delta * delta * weight;
+  }
+  m_Count += other.m_Count;
+}
+
+
+ConvergenceMonitor
+::ConvergenceMonitor() :
+  m_NumberOfParameters( 0 ),
+  m_TargetEffectiveSampleSize( 0.0 ),
+  m_PotentialScaleReductionThreshold( 0.0 ),
+  m_MinimumNumberOfSamples( 100 ),
+  m_DetectEndOfBurnIn( false )
+{
+}
+
+
+ConvergenceMonitor
+::~ConvergenceMonitor()
+{
+}
+
+
+void
+ConvergenceMonitor
+::Initialize( unsigned int numberOfChains,
+              unsigned int numberOfParameters )
+{
+  m_NumberOfParameters = numberOfParameters;
+  Chain chain;
+  chain.m_BatchSize = 1;
+  chain.m_Current.m_Count = 0;
+  chain.m_Current.m_Means.assign( numberOfParameters, 0.0 );
+  chain.m_Current.m_SumsOfSquares.assign( numberOfParameters, 0.0 );
+  m_Chains.assign( numberOfChains, chain );
+}
+
+
+void
+ConvergenceMonitor
+::AddSample( unsigned int chainIndex, const std::vector< double > & values )
+{
+  assert( chainIndex < m_Chains.size() );
+  assert( values.size() == m_NumberOfParameters );
+  Chain & chain = m_Chains[chainIndex];
+  Batch & current = chain.m_Current;
+
+  ++current.m_Count;
+  double count = static_cast< double >( current.m_Count );
+  for ( unsigned int p = 0; p < m_NumberOfParameters; ++p ) {
+    double delta = values[p] - current.m_Means[p];
+    current.m_Means[p] += delta / count;
+    current.m_SumsOfSquares[p] += delta * ( values[p] - current.m_Means[p] );
+  }
+  if ( current.m_Count < chain.m_BatchSize ) {
+    return;
+  }
+
+  chain.m_Batches.push_back( current );
+  current.m_Count = 0;
+  current.m_Means.assign( m_NumberOfParameters, 0.0 );
+  current.m_SumsOfSquares.assign( m_NumberOfParameters, 0.0 );
+
+  if ( chain.m_Batches.size() == 2 * MINIMUM_NUMBER_OF_BATCHES ) {
+    for ( unsigned int i = 0; i < MINIMUM_NUMBER_OF_BATCHES; ++i ) {
+      chain.m_Batches[i] = chain.m_Batches[2 * i];
+      chain.m_Batches[i].Merge( chain.m_Batches[2 * i + 1] );
+    }
+    chain.m_Batches.resize( MINIMUM_NUMBER_OF_BATCHES );
+    chain.m_BatchSize *= 2;
+  }
+}
+
+
+unsigned int
+ConvergenceMonitor
+::GetNumberOfChains() const
+{
+  return static_cast< unsigned int >( m_Chains.size() );
+}
+
+
+unsigned int
+ConvergenceMonitor
+::GetNumberOfParameters() const
+{
+  return m_NumberOfParameters;
+}
+
+
+unsigned long int
+ConvergenceMonitor
+::GetNumberOfSamples() const
+{
+  if ( m_Chains.empty() ) {
+    return 0;
+  }
+  unsigned long int numberOfSamples = std::numeric_limits< unsigned long int >::max();
+  for ( size_t c = 0; c < m_Chains.size(); ++c ) {
+    const Chain & chain = m_Chains[c];
+    numberOfSamples = std::min( numberOfSamples,
+                                chain.m_Batches.size() * chain.m_BatchSize +
+                                chain.m_Current.m_Count );
+  }
+  return numberOfSamples;
+}
+
+
+double
+ConvergenceMonitor
+::GetEffectiveSampleSize( unsigned int parameter ) const
+{
+  assert( parameter < m_NumberOfParameters );
+  if ( m_Chains.empty() || this->GetNumberOfCompleteBatches() < 4 ) {
+    return 0.0;
+  }
+
+  double effectiveSampleSize = 0.0;
+  for ( size_t c = 0; c < m_Chains.size(); ++c ) {
+    const Chain & chain = m_Chains[c];
+    Batch all = this->MergeBatches(
+      chain, 0, static_cast< unsigned int >( chain.m_Batches.size() ) );
+    double count = static_cast< double >( all.m_Count );
+    double variance = all.m_SumsOfSquares[parameter] / ( count - 1.0 );
+    double batchMeansVariance = this->GetBatchMeansVariance( chain, parameter );
+    if ( batchMeansVariance > 0.0 ) {
+      effectiveSampleSize += count * variance / batchMeansVariance;
+    } else if ( variance > 0.0 ) {
+      effectiveSampleSize += count;
+    }
+  }
+  return effectiveSampleSize;
+}
+
+
+double
+ConvergenceMonitor
+::GetPotentialScaleReduction( unsigned int parameter ) const
+{
+  assert( parameter < m_NumberOfParameters );
+  unsigned int half = this->GetNumberOfCompleteBatches() / 2;
+  if ( m_Chains.empty() || half == 0 ) {
+    return std::numeric_limits< double >::infinity();
+  }
+
+  // The first and second halves of every chain are the sequences.
+  std::vector< double > means;
+  std::vector< double > variances;
+  double count = std::numeric_limits< double >::infinity();
+  for ( size_t c = 0; c < m_Chains.size(); ++c ) {
+    Batch halves[2] = {
+      this->MergeBatches( m_Chains[c], 0, half ),
+      this->MergeBatches( m_Chains[c], half, 2 * half ) };
+    for ( int h = 0; h < 2; ++h ) {
+      double n = static_cast< double >( halves[h].m_Count );
+      if ( n < 2.0 ) {
+        return std::numeric_limits< double >::infinity();
+      }
+      count = std::min( count, n );
+      means.push_back( halves[h].m_Means[parameter] );
+      variances.push_back( halves[h].m_SumsOfSquares[parameter] / ( n - 1.0 ) );
+    }
+  }
+
+  double numberOfSequences = static_cast< double >( means.size() );
+  double meanOfMeans = 0.0;
+  double within = 0.0;
+  for ( size_t s = 0; s < means.size(); ++s ) {
+    meanOfMeans += means[s];
+    within += variances[s];
+  }
+  meanOfMeans /= numberOfSequences;
+  within /= numberOfSequences;
+  double betweenOverCount = 0.0;
+  for ( size_t s = 0; s < means.size(); ++s ) {
+    betweenOverCount += ( means[s] - meanOfMeans ) * ( means[s] - meanOfMeans );
+  }
+  betweenOverCount /= ( numberOfSequences - 1.0 );
+
+  if ( !( within > 0.0 ) ) {
+    return ( betweenOverCount > 0.0 ) ?
+      std::numeric_limits< double >::infinity() : 1.0;
+  }
+  double pooled = ( count - 1.0 ) / count * within + betweenOverCount;
+  return std::sqrt( pooled / within );
+}
+
+
+double
+ConvergenceMonitor
+::GetGewekeZ( unsigned int parameter ) const
+{
+  assert( parameter < m_NumberOfParameters );
+  unsigned int numberOfBatches = this->GetNumberOfCompleteBatches();
+  if ( m_Chains.empty() || numberOfBatches < 10 ) {
+    return 0.0;
+  }
+
+  double largest = 0.0;
+  for ( size_t c = 0; c < m_Chains.size(); ++c ) {
+    const Chain & chain = m_Chains[c];
+    Batch first = this->MergeBatches( chain, 0, numberOfBatches / 10 );
+    Batch last = this->MergeBatches(
+      chain, numberOfBatches - numberOfBatches / 2, numberOfBatches );
+    double difference = first.m_Means[parameter] - last.m_Means[parameter];
+    double variance = this->GetBatchMeansVariance( chain, parameter ) *
+      ( 1.0 / static_cast< double >( first.m_Count ) +
+        1.0 / static_cast< double >( last.m_Count ) );
+    double z;
+    if ( variance > 0.0 ) {
+      z = difference / std::sqrt( variance );
+    } else if ( difference != 0.0 ) {
+      z = ( difference > 0.0 ? 1.0 : -1.0 ) *
+        std::numeric_limits< double >::infinity();
+    } else {
+      z = 0.0;
+    }
+    if ( std::fabs( z ) > std::fabs( largest ) ) {
+      largest = z;
+    }
+  }
+  return largest;
+}
+
+
+double
+ConvergenceMonitor
+::GetMinimumEffectiveSampleSize() const
+{
+  if ( m_NumberOfParameters == 0 ) {
+    return 0.0;
+  }
+  double minimum = std::numeric_limits< double >::infinity();
+  for ( unsigned int p = 0; p < m_NumberOfParameters; ++p ) {
+    minimum = std::min( minimum, this->GetEffectiveSampleSize( p ) );
+  }
+  return minimum;
+}
+
+
+double
+ConvergenceMonitor
+::GetMaximumPotentialScaleReduction() const
+{
+  double maximum = 0.0;
+  for ( unsigned int p = 0; p < m_NumberOfParameters; ++p ) {
+    maximum = std::max( maximum, this->GetPotentialScaleReduction( p ) );
+  }
+  return maximum;
+}
+
+
+void
+ConvergenceMonitor
+::SetTargetEffectiveSampleSize( double size )
+{
+  m_TargetEffectiveSampleSize = size;
+}
+
+
+double
+ConvergenceMonitor
+::GetTargetEffectiveSampleSize() const
+{
+  return m_TargetEffectiveSampleSize;
+}
+
+
+void
+ConvergenceMonitor
+::SetPotentialScaleReductionThreshold( double threshold )
+{
+  m_PotentialScaleReductionThreshold = threshold;
+}
+
+
+double
+ConvergenceMonitor
+::GetPotentialScaleReductionThreshold() const
+{
+  return m_PotentialScaleReductionThreshold;
+}
+
+
+void
+ConvergenceMonitor
+::SetMinimumNumberOfSamples( unsigned long int numberOfSamples )
+{
+  m_MinimumNumberOfSamples = numberOfSamples;
+}
+
+
+unsigned long int
+ConvergenceMonitor
+::GetMinimumNumberOfSamples() const
+{
+  return m_MinimumNumberOfSamples;
+}
+
+
+void
+ConvergenceMonitor
+::SetDetectEndOfBurnIn( bool detect )
+{
+  m_DetectEndOfBurnIn = detect;
+}
+
+
+bool
+ConvergenceMonitor
+::GetDetectEndOfBurnIn() const
+{
+  return m_DetectEndOfBurnIn;
+}
+
+
+bool
+ConvergenceMonitor
+::IsStationary( const std::vector< std::vector< double > > & sequences )
+{
+  if ( sequences.empty() ) {
+    return false;
+  }
+  size_t length = sequences[0].size();
+  for ( size_t s = 1; s < sequences.size(); ++s ) {
+    length = std::min( length, sequences[s].size() );
+  }
+  if ( length < 100 ) {
+    return false;
+  }
+
+  ConvergenceMonitor monitor;
+  monitor.Initialize( static_cast< unsigned int >( sequences.size() ), 1 );
+  std::vector< double > value( 1 );
+  for ( size_t s = 0; s < sequences.size(); ++s ) {
+    for ( size_t i = sequences[s].size() - length; i < sequences[s].size(); ++i ) {
+      value[0] = sequences[s][i];
+      monitor.AddSample( static_cast< unsigned int >( s ), value );
+    }
+  }
+  return ( std::fabs( monitor.GetGewekeZ( 0 ) ) <= 3.0 &&
+           monitor.GetPotentialScaleReduction( 0 ) <= 1.1 );
+}
+
+
+bool
+ConvergenceMonitor
+::HasStoppingCriteria() const
+{
+  return ( m_TargetEffectiveSampleSize > 0.0 ||
+           m_PotentialScaleReductionThreshold > 0.0 );
+}
+
+
+bool
+ConvergenceMonitor
+::HasConverged() const
+{
+  if ( !this->HasStoppingCriteria() ||
+       this->GetNumberOfSamples() < m_MinimumNumberOfSamples ) {
+    return false;
+  }
+  if ( m_TargetEffectiveSampleSize > 0.0 &&
+       this->GetMinimumEffectiveSampleSize() < m_TargetEffectiveSampleSize ) {
+    return false;
+  }
+  if ( m_PotentialScaleReductionThreshold > 0.0 &&
+       !( this->GetMaximumPotentialScaleReduction() <=
+          m_PotentialScaleReductionThreshold ) ) {
+    return false;
+  }
+  return true;
+}
+
+
+void
+ConvergenceMonitor
+::WriteReport( std::ostream & o,
+               const std::vector< std::string > & parameterNames ) const
+{
+  o << std::setw(14) << "parameter";
+  o << std::setw(14) << "ESS";
+  o << std::setw(14) << "split R-hat";
+  o << std::setw(14) << "Geweke z";
+  o << '\n';
+  for ( unsigned int p = 0; p < m_NumberOfParameters; ++p ) {
+    o << std::setw(14) << ( p < parameterNames.size() ? parameterNames[p] : "" )
+      << std::setw(14) << this->GetEffectiveSampleSize( p )
+      << std::setw(14) << this->GetPotentialScaleReduction( p )
+      << std::setw(14) << this->GetGewekeZ( p )
+      << '\n';
+  }
+}
+
+
+/** Write the count, means and sums of squares of a Batch. */
+static void WriteBatch( std::ostream & o,
+                        unsigned long int count,
+                        const std::vector< double > & means,
+                        const std::vector< double > & sumsOfSquares )
+{
+  o << count;
+  for ( size_t p = 0; p < means.size(); ++p ) {
+    o << ' ' << means[p] << ' ' << sumsOfSquares[p];
+  }
+  o << '\n';
+}
+
+
+/** Read what WriteBatch() wrote. */
+static bool ReadBatch( std::istream & i,
+                       unsigned int numberOfParameters,
+                       unsigned long int & count,
+                       std::vector< double > & means,
+                       std::vector< double > & sumsOfSquares )
+{
+  means.assign( numberOfParameters, 0.0 );
+  sumsOfSquares.assign( numberOfParameters, 0.0 );
+  if ( !( i >> count ) ) {
+    return false;
+  }
+  for ( unsigned int p = 0; p < numberOfParameters; ++p ) {
+    if ( !( i >> means[p] >> sumsOfSquares[p] ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+void
+ConvergenceMonitor
+::WriteState( std::ostream & o ) const
+{
+  std::streamsize precision =
+    o.precision( std::numeric_limits< double >::digits10 + 2 );
+  o << "ConvergenceMonitor " << m_Chains.size() << ' '
+    << m_NumberOfParameters << '\n';
+  for ( size_t c = 0; c < m_Chains.size(); ++c ) {
+    const Chain & chain = m_Chains[c];
+    o << chain.m_BatchSize << ' ' << chain.m_Batches.size() << '\n';
+    for ( size_t b = 0; b < chain.m_Batches.size(); ++b ) {
+      WriteBatch( o, chain.m_Batches[b].m_Count, chain.m_Batches[b].m_Means,
+                  chain.m_Batches[b].m_SumsOfSquares );
+    }
+    WriteBatch( o, chain.m_Current.m_Count, chain.m_Current.m_Means,
+                chain.m_Current.m_SumsOfSquares );
+  }
+  o.precision( precision );
+}
+
+
+bool
+ConvergenceMonitor
+::ReadState( std::istream & i )
+{
+  std::string tag;
+  size_t numberOfChains;
+  unsigned int numberOfParameters;
+  if ( !( i >> tag >> numberOfChains >> numberOfParameters ) ||
+       tag != "ConvergenceMonitor" ) {
+    return false;
+  }
+
+  std::vector< Chain > chains( numberOfChains );
+  for ( size_t c = 0; c < numberOfChains; ++c ) {
+    Chain & chain = chains[c];
+    size_t numberOfBatches;
+    if ( !( i >> chain.m_BatchSize >> numberOfBatches ) ||
+         chain.m_BatchSize == 0 ||
+         numberOfBatches >= 2 * MINIMUM_NUMBER_OF_BATCHES ) {
+      return false;
+    }
+    chain.m_Batches.resize( numberOfBatches );
+    for ( size_t b = 0; b < numberOfBatches; ++b ) {
+      Batch & batch = chain.m_Batches[b];
+      if ( !ReadBatch( i, numberOfParameters, batch.m_Count,
+                       batch.m_Means, batch.m_SumsOfSquares ) ||
+           batch.m_Count != chain.m_BatchSize ) {
+        return false;
+      }
+    }
+    if ( !ReadBatch( i, numberOfParameters, chain.m_Current.m_Count,
+                     chain.m_Current.m_Means, chain.m_Current.m_SumsOfSquares ) ||
+         chain.m_Current.m_Count >= chain.m_BatchSize ) {
+      return false;
+    }
+  }
+
+  m_NumberOfParameters = numberOfParameters;
+  m_Chains.swap( chains );
+  return true;
+}
+
+
+ConvergenceMonitor::Batch
+ConvergenceMonitor
+::MergeBatches( const Chain & chain,
+                unsigned int first, unsigned int last ) const
+{
+  Batch merged;
+  merged.m_Count = 0;
+  merged.m_Means.assign( m_NumberOfParameters, 0.0 );
+  merged.m_SumsOfSquares.assign( m_NumberOfParameters, 0.0 );
+  for ( unsigned int b = first; b < last; ++b ) {
+    merged.Merge( chain.m_Batches[b] );
+  }
+  return merged;
+}
+
+
+unsigned int
+ConvergenceMonitor
+::GetNumberOfCompleteBatches() const
+{
+  if ( m_Chains.empty() ) {
+    return 0;
+  }
+  size_t numberOfBatches = m_Chains[0].m_Batches.size();
+  for ( size_t c = 1; c < m_Chains.size(); ++c ) {
+    numberOfBatches = std::min( numberOfBatches, m_Chains[c].m_Batches.size() );
+  }
+  return static_cast< unsigned int >( numberOfBatches );
+}
+
+
+double
+ConvergenceMonitor
+::GetBatchMeansVariance( const Chain & chain, unsigned int parameter ) const
+{
+  size_t numberOfBatches = chain.m_Batches.size();
+  if ( numberOfBatches < 2 ) {
+    return 0.0;
+  }
+  double mean = 0.0;
+  for ( size_t b = 0; b < numberOfBatches; ++b ) {
+    mean += chain.m_Batches[b].m_Means[parameter];
+  }
+  mean /= static_cast< double >( numberOfBatches );
+  double sumOfSquares = 0.0;
+  for ( size_t b = 0; b < numberOfBatches; ++b ) {
+    double delta = chain.m_Batches[b].m_Means[parameter] - mean;
+    sumOfSquares += delta * delta;
+  }
+  return static_cast< double >( chain.m_BatchSize ) * sumOfSquares /
+    static_cast< double >( numberOfBatches - 1 );
+}
+
+} // end namespace madai
@@ -0,0 +1,198 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_ConvergenceMonitor_h_included
+#define madai_ConvergenceMonitor_h_included
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+namespace madai {
+
+/** \class ConvergenceMonitor
+ *
+ * Computes convergence diagnostics of one or more chains while they
+ * are sampled, without keeping the Samples.
+ *
+ * Each chain is summarized by between 32 and 63 batches of
+ * consecutive values; when there are 64, neighbouring batches are
+ * merged and the batch size doubles. From the means and variances of
+ * the batches it computes for each parameter
+ *
+ * - the effective sample size by batch means, summed over the chains,
+ * - the split potential scale reduction R-hat of Gelman et al., from
+ *   the first and second halves of every chain, and
+ * - the Geweke z-score comparing the first 10% of each chain with the
+ *   last 50%, the one of largest magnitude over the chains.
+ *
+ * Only complete batches enter the diagnostics, so they lag the last
+ * Samples by less than one batch. SamplerCSVWriter feeds a
+ * ConvergenceMonitor the active parameters of the Samples it writes
+ * and stops early once HasConverged(). If GetDetectEndOfBurnIn(), it
+ * also ends the burn-in as soon as the log likelihoods of the chains
+ * are stationary by IsStationary().
+ */
+class ConvergenceMonitor {
+public:
+  ConvergenceMonitor();
+  virtual ~ConvergenceMonitor();
+
+  /** Forget all values and prepare for the given numbers of chains
+   * and parameters. */
+  void Initialize( unsigned int numberOfChains,
+                   unsigned int numberOfParameters );
+
+  /** Add the next values of the parameters of a chain. */
+  void AddSample( unsigned int chain, const std::vector< double > & values );
+
+  unsigned int GetNumberOfChains() const;
+  unsigned int GetNumberOfParameters() const;
+
+  /** Smallest number of values added to any chain. */
+  unsigned long int GetNumberOfSamples() const;
+
+  /** Effective sample size of a parameter over all chains. Zero until
+   * every chain has four complete batches. */
+  double GetEffectiveSampleSize( unsigned int parameter ) const;
+
+  /** Split R-hat of a parameter. Infinite until every chain has two
+   * complete batches, and if the chains are stuck at different
+   * values. */
+  double GetPotentialScaleReduction( unsigned int parameter ) const;
+
+  /** Geweke z-score of a parameter. Zero until every chain has ten
+   * complete batches. */
+  double GetGewekeZ( unsigned int parameter ) const;
+
+  /** Smallest effective sample size over the parameters. */
+  double GetMinimumEffectiveSampleSize() const;
+
+  /** Largest split R-hat over the parameters. */
+  double GetMaximumPotentialScaleReduction() const;
+
+  //@{
+  /** Set/Get the effective sample size that every parameter must
+   * reach for HasConverged(). Zero, the default, disables the
+   * criterion. */
+  void SetTargetEffectiveSampleSize( double size );
+  double GetTargetEffectiveSampleSize() const;
+  //@}
+
+  //@{
+  /** Set/Get the split R-hat that no parameter may exceed for
+   * HasConverged(). Zero, the default, disables the criterion. */
+  void SetPotentialScaleReductionThreshold( double threshold );
+  double GetPotentialScaleReductionThreshold() const;
+  //@}
+
+  //@{
+  /** Set/Get the number of values every chain must have before
+   * HasConverged() can be true. Defaults to 100. */
+  void SetMinimumNumberOfSamples( unsigned long int numberOfSamples );
+  unsigned long int GetMinimumNumberOfSamples() const;
+  //@}
+
+  //@{
+  /** Set/Get whether the burn-in ends as soon as the log likelihoods
+   * of the chains are stationary. Defaults to false. */
+  void SetDetectEndOfBurnIn( bool detect );
+  bool GetDetectEndOfBurnIn() const;
+  //@}
+
+  /** Returns true if the sequences, such as the log likelihoods of
+   * the chains over the second half of the burn-in so far, look
+   * stationary: each has at least 100 values, the Geweke z-score of
+   * the last values of the same number in every sequence is at most 3
+   * in magnitude, and their split R-hat is at most 1.1. */
+  static bool IsStationary( const std::vector< std::vector< double > > & sequences );
+
+  /** Returns true if a stopping criterion is set. */
+  bool HasStoppingCriteria() const;
+
+  /** Returns true if a stopping criterion is set and all that are set
+   * are met. */
+  bool HasConverged() const;
+
+  /** Write a table of the diagnostics, one line per parameter. */
+  void WriteReport( std::ostream & o,
+                    const std::vector< std::string > & parameterNames ) const;
+
+  //@{
+  /** Write and read the batches, so that the diagnostics continue
+   * after a checkpoint. ReadState() returns false and leaves the
+   * ConvergenceMonitor unchanged if the state cannot be read. The
+   * stopping criteria are not part of the state. */
+  void WriteState( std::ostream & o ) const;
+  bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  /** Summary of consecutive values of one chain: their number, and the
+   * mean and sum of squared deviations of each parameter. */
+  struct Batch {
+    Batch() : m_Count( 0 ) {}
+
+    unsigned long int m_Count;
+    std::vector< double > m_Means;
+    std::vector< double > m_SumsOfSquares;
+
+    /** Add the values of another Batch. */
+    void Merge( const Batch & other );
+  };
+
+  /** Summaries of a chain: its complete batches, all of m_BatchSize
+   * values, and the batch it is filling. */
+  struct Chain {
+    Chain() : m_BatchSize( 1 ) {}
+
+    unsigned long int m_BatchSize;
+    std::vector< Batch > m_Batches;
+    Batch m_Current;
+  };
+
+  /** Merge the complete batches from first up to last. */
+  Batch MergeBatches( const Chain & chain,
+                      unsigned int first, unsigned int last ) const;
+
+  /** Smallest number of complete batches of any chain. */
+  unsigned int GetNumberOfCompleteBatches() const;
+
+  /** Batch-means estimate of the variance of the mean of a parameter
+   * of a chain, times its number of values. */
+  double GetBatchMeansVariance( const Chain & chain,
+                                unsigned int parameter ) const;
+
+  unsigned int m_NumberOfParameters;
+
+  std::vector< Chain > m_Chains;
+
+  double m_TargetEffectiveSampleSize;
+
+  double m_PotentialScaleReductionThreshold;
+
+  unsigned long int m_MinimumNumberOfSamples;
+
+  bool m_DetectEndOfBurnIn;
+
+}; // end class ConvergenceMonitor
+
+} // end namespace madai
+
+#endif // madai_ConvergenceMonitor_h_included
@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "DelayedAcceptanceSampler.h"
+
+#include <cassert>
+#include <cmath>
+
+
+namespace madai {
+
+
+DelayedAcceptanceSampler
+::DelayedAcceptanceSampler() :
+  MetropolisHastingsSampler(),
+  m_SurrogateModel( NULL ),
+  m_CurrentSurrogateLogLikelihood( 0.0 ),
+  m_NumberOfProposals( 0 ),
+  m_NumberOfModelEvaluations( 0 )
+{
+}
+
+
+DelayedAcceptanceSampler
+::~DelayedAcceptanceSampler()
+{
+}
+
+
+void
+DelayedAcceptanceSampler
+::SetSurrogateModel( const Model * surrogate )
+{
+  m_SurrogateModel = surrogate;
+  this->UpdateSurrogateLogLikelihood();
+}
+
+
+const Model *
+DelayedAcceptanceSampler
+::GetSurrogateModel() const
+{
+  return m_SurrogateModel;
+}
+
+
+unsigned long int
+DelayedAcceptanceSampler
+::GetNumberOfProposals() const
+{
+  return m_NumberOfProposals;
+}
+
+
+unsigned long int
+DelayedAcceptanceSampler
+::GetNumberOfModelEvaluations() const
+{
+  return m_NumberOfModelEvaluations;
+}
+
+
+void
+DelayedAcceptanceSampler
+::WriteProgress( std::ostream & progress ) const
+{
+  if ( m_NumberOfProposals == 0 ) {
+    return;
+  }
+  double screened = 1.0 - static_cast< double >( m_NumberOfModelEvaluations ) /
+    static_cast< double >( m_NumberOfProposals );
+  progress << "  Screened out: " << static_cast< int >( 100.0 * screened + 0.5 )
+           << '%';
+}
+
+
+void
+DelayedAcceptanceSampler
+::WriteState( std::ostream & o ) const
+{
+  MetropolisHastingsSampler::WriteState( o );
+  WriteTag( o, "DelayedAcceptanceSampler" );
+  WriteValue( o, m_CurrentSurrogateLogLikelihood );
+  o << ' ' << m_NumberOfProposals << ' ' << m_NumberOfModelEvaluations << '\n';
+}
+
+
+bool
+DelayedAcceptanceSampler
+::ReadState( std::istream & i )
+{
+  return ( MetropolisHastingsSampler::ReadState( i ) &&
+           ReadTag( i, "DelayedAcceptanceSampler" ) &&
+           ReadValue( i, m_CurrentSurrogateLogLikelihood ) &&
+           ( i >> m_NumberOfProposals >> m_NumberOfModelEvaluations ) );
+}
+
+
+void
+DelayedAcceptanceSampler
+::Initialize( const Model * model )
+{
+  MetropolisHastingsSampler::Initialize( model );
+  m_NumberOfProposals = 0;
+  m_NumberOfModelEvaluations = 0;
+  this->UpdateSurrogateLogLikelihood();
+}
+
+
+void
+DelayedAcceptanceSampler
+::ParameterSetExternally()
+{
+  MetropolisHastingsSampler::ParameterSetExternally();
+  this->UpdateSurrogateLogLikelihood();
+}
+
+
+void
+DelayedAcceptanceSampler
+::UpdateSurrogateLogLikelihood()
+{
+  if ( m_SurrogateModel == NULL || m_Model == NULL ||
+       m_CurrentParameters.size() != m_SurrogateModel->GetNumberOfParameters() ) {
+    return;
+  }
+  std::vector< double > outputs;
+  Model::ErrorType error = m_SurrogateModel->GetScalarOutputsAndLogLikelihood(
+    m_CurrentParameters, outputs, m_CurrentSurrogateLogLikelihood );
+  assert( error == Model::NO_ERROR );
+  (void) error;
+}
+
+
+bool
+DelayedAcceptanceSampler
+::IsSpeculative() const
+{
+  return ( m_SurrogateModel == NULL &&
+           MetropolisHastingsSampler::IsSpeculative() );
+}
+
+
+bool
+DelayedAcceptanceSampler
+::Step()
+{
+  if ( m_SurrogateModel == NULL ) {
+    return MetropolisHastingsSampler::Step();
+  }
+  assert( m_SurrogateModel->GetNumberOfParameters() ==
+          m_Model->GetNumberOfParameters() );
+
+  this->DrawStep( m_Step );
+  std::vector< double > & xc = m_CandidateParameters;
+  xc = m_CurrentParameters;
+  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); i++ ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      xc[i] += m_Step[i];
+    }
+  }
+  ++m_NumberOfProposals;
+
+  // First stage: screen the proposal with the surrogate.
+  double surrogateLogLikelihood;
+  m_SurrogateModel->GetScalarOutputsAndLogLikelihood(
+    xc, m_SurrogateOutputs, surrogateLogLikelihood );
+  double surrogateDelta = surrogateLogLikelihood - m_CurrentSurrogateLogLikelihood;
+  if ( ( surrogateDelta > 0 ) ||
+       ( std::exp( surrogateDelta ) > m_Random.Uniform() ) ) {
+
+    // Second stage: correct with the Model, dividing out the ratio
+    // that the surrogate accepted with.
+    unsigned int numberOfOutputs = m_Model->GetNumberOfScalarOutputs();
+    m_CandidateOutputs.resize( numberOfOutputs );
+    m_CandidateLogLikelihoodValueGradient.resize( numberOfOutputs );
+    m_CandidateLogLikelihoodErrorGradient.resize( numberOfOutputs );
+    double ll;
+    m_Model->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
+      xc, m_CandidateOutputs, ll,
+      m_CandidateLogLikelihoodValueGradient,
+      m_CandidateLogLikelihoodErrorGradient );
+    ++m_NumberOfModelEvaluations;
+
+    double delta = ( ll - m_CurrentLogLikelihood ) - surrogateDelta;
+    if ( ( delta > 0 ) || ( std::exp( delta ) > m_Random.Uniform() ) ) {
+      m_CurrentLogLikelihood = ll;
+      m_CurrentSurrogateLogLikelihood = surrogateLogLikelihood;
+      m_CurrentParameters.swap( xc );
+      m_CurrentOutputs.swap( m_CandidateOutputs );
+      m_CurrentLogLikelihoodValueGradient.swap(
+        m_CandidateLogLikelihoodValueGradient );
+      m_CurrentLogLikelihoodErrorGradient.swap(
+        m_CandidateLogLikelihoodErrorGradient );
+      return true;
+    }
+  }
+  return false;
+}
+
+} // end namespace madai
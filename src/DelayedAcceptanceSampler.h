@@ -0,0 +1,106 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_DelayedAcceptanceSampler_h_included
+#define madai_DelayedAcceptanceSampler_h_included
+
+#include "MetropolisHastingsSampler.h"
+
+
+namespace madai {
+
+/**
+ * \class DelayedAcceptanceSampler
+ *
+ * Two-stage delayed-acceptance Metropolis-Hastings sampler (Christen
+ * and Fox, 2005). Each proposal is first accepted or rejected with the
+ * log likelihood of a cheap surrogate Model, such as a
+ * GaussianProcessEmulatedModel trained on the expensive one. Only
+ * proposals that survive the first stage are evaluated with the Model
+ * set with SetModel(), and are then accepted with probability
+ * \f[ \min\left(1, \frac{\pi(y) \tilde\pi(x)}{\pi(x) \tilde\pi(y)}\right) \f]
+ * where \f$ \pi \f$ is the posterior of the Model and
+ * \f$ \tilde\pi \f$ that of the surrogate. The chain samples the
+ * posterior of the Model exactly, whatever the surrogate; a good
+ * surrogate only saves the Model evaluations of the proposals it
+ * rejects.
+ *
+ * The surrogate must have the same parameters as the Model and its
+ * observations must be loaded. Without a surrogate, the sampler is a
+ * plain MetropolisHastingsSampler. The SpeculativeDepth is not used.
+ */
+class DelayedAcceptanceSampler : public MetropolisHastingsSampler {
+public:
+  DelayedAcceptanceSampler();
+  virtual ~DelayedAcceptanceSampler();
+
+  //@{
+  /** Set/Get the cheap Model that screens the proposals. */
+  void SetSurrogateModel( const Model * surrogate );
+  const Model * GetSurrogateModel() const;
+  //@}
+
+  /** Number of proposals so far. */
+  unsigned long int GetNumberOfProposals() const;
+
+  /** Number of proposals that were evaluated with the Model, which
+   * are those that passed the surrogate. */
+  unsigned long int GetNumberOfModelEvaluations() const;
+
+  /** Write the fraction of proposals rejected by the surrogate. */
+  virtual void WriteProgress( std::ostream & progress ) const;
+
+  //@{
+  /** The state includes the surrogate log likelihood at the current
+   * point and the counts of evaluations. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Also evaluates the surrogate at the new point. */
+  virtual void ParameterSetExternally();
+
+  /** Evaluate the surrogate log likelihood at the current point. */
+  void UpdateSurrogateLogLikelihood();
+
+  /** Speculates only without a surrogate. */
+  virtual bool IsSpeculative() const;
+
+  /** Take a step screened by the surrogate. */
+  virtual bool Step();
+
+  const Model * m_SurrogateModel;
+
+  /** Storage for the outputs of the surrogate at a proposal. */
+  std::vector< double > m_SurrogateOutputs;
+
+  /** Log likelihood of the surrogate at the current point. */
+  double m_CurrentSurrogateLogLikelihood;
+
+  unsigned long int m_NumberOfProposals;
+
+  unsigned long int m_NumberOfModelEvaluations;
+
+}; // end class DelayedAcceptanceSampler
+
+} // end namespace madai
+
+#endif // madai_DelayedAcceptanceSampler_h_included
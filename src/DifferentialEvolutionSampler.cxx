@@ -0,0 +1,203 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "DifferentialEvolutionSampler.h"
+
+#include <cassert>
+#include <cmath>
+
+
+namespace madai {
+
+
+DifferentialEvolutionSampler
+::DifferentialEvolutionSampler() :
+  EnsembleSampler(),
+  m_CrossoverProbability( 1.0 ),
+  m_JitterScale( 1.0e-6 ),
+  m_NumberOfMoves( 0 )
+{
+}
+
+
+DifferentialEvolutionSampler
+::~DifferentialEvolutionSampler()
+{
+}
+
+
+void
+DifferentialEvolutionSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+
+  const std::vector< Parameter > & params = model->GetParameters();
+  m_StepScales.resize( model->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < model->GetNumberOfParameters(); ++i ) {
+    const Distribution * priorDist = params[i].GetPriorDistribution();
+    m_StepScales[i] =
+      priorDist->GetPercentile( 0.75 ) - priorDist->GetPercentile( 0.25 );
+  }
+  m_NumberOfMoves = 0;
+
+  EnsembleSampler::Initialize( model );
+}
+
+
+void
+DifferentialEvolutionSampler
+::SetCrossoverProbability( double probability )
+{
+  if ( probability > 0.0 && probability <= 1.0 ) {
+    m_CrossoverProbability = probability;
+  }
+}
+
+
+double
+DifferentialEvolutionSampler
+::GetCrossoverProbability() const
+{
+  return m_CrossoverProbability;
+}
+
+
+void
+DifferentialEvolutionSampler
+::SetJitterScale( double scale )
+{
+  m_JitterScale = scale;
+}
+
+
+double
+DifferentialEvolutionSampler
+::GetJitterScale() const
+{
+  return m_JitterScale;
+}
+
+
+void
+DifferentialEvolutionSampler
+::WriteState( std::ostream & o ) const
+{
+  EnsembleSampler::WriteState( o );
+  WriteTag( o, "DifferentialEvolutionSampler" );
+  o << m_NumberOfMoves << '\n';
+}
+
+
+bool
+DifferentialEvolutionSampler
+::ReadState( std::istream & i )
+{
+  return ( EnsembleSampler::ReadState( i ) &&
+           ReadTag( i, "DifferentialEvolutionSampler" ) &&
+           ( i >> m_NumberOfMoves ) );
+}
+
+
+void
+DifferentialEvolutionSampler
+::UpdateHalf( unsigned int half )
+{
+  unsigned int halfSize =
+    static_cast< unsigned int >( m_WalkerParameters.size() / 2 );
+  unsigned int first = half * halfSize;
+  unsigned int other = ( 1 - half ) * halfSize;
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+
+  std::vector< unsigned int > active;
+  for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      active.push_back( i );
+    }
+  }
+  if ( active.empty() ) {
+    return;
+  }
+
+  // Every tenth move takes the full difference, which lets chains
+  // jump between modes.
+  bool fullJump = ( m_NumberOfMoves % 10 == 9 );
+  ++m_NumberOfMoves;
+
+  // Draw all proposals of this half first, so that they can be
+  // evaluated together.
+  std::vector< std::vector< double > > proposals( halfSize );
+  std::vector< bool > moved( active.size() );
+  for ( unsigned int k = 0; k < halfSize; ++k ) {
+    const std::vector< double > & x = m_WalkerParameters[ first + k ];
+    unsigned int a = static_cast< unsigned int >( m_Random.Integer( halfSize ) );
+    unsigned int b =
+      static_cast< unsigned int >( m_Random.Integer( halfSize - 1 ) );
+    if ( b >= a ) {
+      ++b;
+    }
+    const std::vector< double > & xa = m_WalkerParameters[ other + a ];
+    const std::vector< double > & xb = m_WalkerParameters[ other + b ];
+
+    unsigned int numberMoved = 0;
+    for ( unsigned int j = 0; j < active.size(); ++j ) {
+      moved[j] = ( m_CrossoverProbability >= 1.0 ||
+                   m_Random.Uniform() < m_CrossoverProbability );
+      if ( moved[j] ) {
+        ++numberMoved;
+      }
+    }
+    if ( numberMoved == 0 ) {
+      moved[ m_Random.Integer( static_cast< long >( active.size() ) ) ] = true;
+      numberMoved = 1;
+    }
+    double gamma = fullJump ? 1.0 : 2.38 / std::sqrt( 2.0 * numberMoved );
+
+    proposals[k] = x;
+    for ( unsigned int j = 0; j < active.size(); ++j ) {
+      if ( moved[j] ) {
+        unsigned int i = active[j];
+        proposals[k][i] += gamma * ( xa[i] - xb[i] ) +
+          m_JitterScale * m_StepScales[i] * m_Random.Gaussian();
+      }
+    }
+  }
+
+  std::vector< std::vector< double > > outputs;
+  std::vector< double > logLikelihoods;
+  m_Model->GetScalarOutputsAndLogLikelihoods(
+    proposals, outputs, logLikelihoods );
+
+  for ( unsigned int k = 0; k < halfSize; ++k ) {
+    unsigned int w = first + k;
+    ++m_NumberOfProposals;
+    if ( logLikelihoods[k] != logLikelihoods[k] ) {
+      continue;
+    }
+    double logAcceptance = logLikelihoods[k] - m_WalkerLogLikelihoods[w];
+    if ( logAcceptance >= 0.0 ||
+         std::log( m_Random.Uniform() ) < logAcceptance ) {
+      m_WalkerParameters[w] = proposals[k];
+      m_WalkerOutputs[w] = outputs[k];
+      m_WalkerLogLikelihoods[w] = logLikelihoods[k];
+      ++m_NumberOfAcceptedProposals;
+    }
+  }
+}
+
+} // end namespace madai
@@ -0,0 +1,101 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_DifferentialEvolutionSampler_h_included
+#define madai_DifferentialEvolutionSampler_h_included
+
+#include <vector>
+
+#include "EnsembleSampler.h"
+
+
+namespace madai {
+
+/**
+ * \class DifferentialEvolutionSampler
+ *
+ * Differential evolution Markov chain sampler (ter Braak, 2006) with
+ * the subspace crossover of DREAM (Vrugt et al., 2009).
+ *
+ * The sampler keeps a population of chains, which are the walkers of
+ * EnsembleSampler and are returned by NextSample() in the same way.
+ * Each chain of one half of the population proposes
+ * \f[ x + \gamma (x_a - x_b) + e \f]
+ * where \f$ x_a \f$ and \f$ x_b \f$ are two different chains of the
+ * other half and \f$ e \f$ is a tiny Gaussian jitter. The difference
+ * of two chains has the scale and correlation of the posterior, so
+ * the proposal needs no step size. With crossover, each active
+ * parameter is only moved with probability CrossoverProbability,
+ * which helps in many dimensions. \f$ \gamma \f$ is
+ * \f$ 2.38 / \sqrt{2 d} \f$ for d moved parameters, except on every
+ * tenth move where it is 1, so that chains can jump between modes.
+ *
+ * As in EnsembleSampler, the proposals of one half are evaluated as
+ * one batch, in parallel threads when the Model allows it. The
+ * stretch scale of EnsembleSampler is not used.
+ */
+class DifferentialEvolutionSampler : public EnsembleSampler {
+public:
+  DifferentialEvolutionSampler();
+  virtual ~DifferentialEvolutionSampler();
+
+  //@{
+  /** Set/Get the probability with which each active parameter is
+   * moved by a proposal. Defaults to 1, which moves all of them as
+   * in plain DE-MC. At least one parameter is always moved. */
+  void SetCrossoverProbability( double probability );
+  double GetCrossoverProbability() const;
+  //@}
+
+  //@{
+  /** Set/Get the standard deviation of the jitter added to each
+   * proposal, in units of the interquartile range of the priors.
+   * Defaults to 1e-6. */
+  void SetJitterScale( double scale );
+  double GetJitterScale() const;
+  //@}
+
+  //@{
+  /** The state includes the number of moves, which decides when the
+   * jumps between modes are made. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Move one half of the population with differential evolution
+   * proposals built from the other half. */
+  virtual void UpdateHalf( unsigned int half );
+
+  double m_CrossoverProbability;
+
+  double m_JitterScale;
+
+  /** Interquartile ranges of the priors. */
+  std::vector< double > m_StepScales;
+
+  /** Number of half-population moves so far. */
+  unsigned long int m_NumberOfMoves;
+
+}; // end class DifferentialEvolutionSampler
+
+} // end namespace madai
+
+#endif // madai_DifferentialEvolutionSampler_h_included
@@ -0,0 +1,343 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_DualNumber_h_included
+#define madai_DualNumber_h_included
+
+#include <cmath>
+#include <iostream>
+
+#include <Eigen/Dense>
+
+
+namespace madai {
+
+/** \class DualNumber
+ *
+ * Scalar type for forward-mode automatic differentiation.
+ *
+ * A DualNumber carries a value together with the partial derivatives
+ * of that value with respect to a set of independent variables. All
+ * arithmetic operators and the common math functions propagate the
+ * derivatives by the chain rule, so a function written as a template
+ * on its scalar type computes its exact gradient in a single pass
+ * when instantiated with DualNumber.
+ *
+ * Constants carry an empty derivative vector, which is treated as a
+ * vector of zeros. This keeps mixed constant/variable arithmetic
+ * cheap.
+ *
+ * Templated code should call the math functions unqualified (for
+ * example, "using std::exp; y = exp( x );") so that the overloads in
+ * this header are found by argument-dependent lookup. */
+class DualNumber {
+public:
+  /** Construct the constant zero. */
+  DualNumber() :
+    m_Value( 0.0 )
+  {
+  }
+
+  /** Construct a constant. Implicit so that doubles mix freely with
+   * DualNumbers in expressions. */
+  DualNumber( double value ) :
+    m_Value( value )
+  {
+  }
+
+  /** Construct the independent variable with the given index out of
+   * numberOfDerivatives independent variables. */
+  DualNumber( double value,
+              unsigned int numberOfDerivatives,
+              unsigned int index ) :
+    m_Value( value ),
+    m_Derivatives( Eigen::VectorXd::Zero( numberOfDerivatives ) )
+  {
+    m_Derivatives( index ) = 1.0;
+  }
+
+  /** Construct from a value and its partial derivatives. */
+  DualNumber( double value, const Eigen::VectorXd & derivatives ) :
+    m_Value( value ),
+    m_Derivatives( derivatives )
+  {
+  }
+
+  /** Get the value. */
+  double GetValue() const
+  {
+    return m_Value;
+  }
+
+  /** Get the partial derivatives. An empty vector means that all
+   * partial derivatives are zero. */
+  const Eigen::VectorXd & GetDerivatives() const
+  {
+    return m_Derivatives;
+  }
+
+  /** Get a single partial derivative. */
+  double GetDerivative( unsigned int index ) const
+  {
+    if ( index < static_cast< unsigned int >( m_Derivatives.size() ) ) {
+      return m_Derivatives( index );
+    }
+    return 0.0;
+  }
+
+  /** Is this a constant, i.e., are all partial derivatives zero? */
+  bool IsConstant() const
+  {
+    return ( m_Derivatives.size() == 0 );
+  }
+
+  /** Combine two numbers by the chain rule. Returns a DualNumber with
+   * the given value and derivatives aScale * a' + bScale * b'. */
+  static DualNumber Chain( double value,
+                           double aScale, const DualNumber & a,
+                           double bScale, const DualNumber & b )
+  {
+    if ( a.IsConstant() ) {
+      if ( b.IsConstant() ) {
+        return DualNumber( value );
+      }
+      return DualNumber( value, bScale * b.m_Derivatives );
+    }
+    if ( b.IsConstant() ) {
+      return DualNumber( value, aScale * a.m_Derivatives );
+    }
+    return DualNumber( value,
+                       aScale * a.m_Derivatives + bScale * b.m_Derivatives );
+  }
+
+  /** Apply a unary function with the given value and first
+   * derivative to this number. */
+  DualNumber Chain( double value, double derivative ) const
+  {
+    if ( this->IsConstant() ) {
+      return DualNumber( value );
+    }
+    return DualNumber( value, derivative * m_Derivatives );
+  }
+
+  DualNumber & operator+=( const DualNumber & other )
+  {
+    *this = Chain( m_Value + other.m_Value, 1.0, *this, 1.0, other );
+    return *this;
+  }
+
+  DualNumber & operator-=( const DualNumber & other )
+  {
+    *this = Chain( m_Value - other.m_Value, 1.0, *this, -1.0, other );
+    return *this;
+  }
+
+  DualNumber & operator*=( const DualNumber & other )
+  {
+    *this = Chain( m_Value * other.m_Value,
+                   other.m_Value, *this, m_Value, other );
+    return *this;
+  }
+
+  DualNumber & operator/=( const DualNumber & other )
+  {
+    double inverse = 1.0 / other.m_Value;
+    *this = Chain( m_Value * inverse,
+                   inverse, *this, -m_Value * inverse * inverse, other );
+    return *this;
+  }
+
+private:
+  /** The value. */
+  double m_Value;
+
+  /** Partial derivatives of the value. Empty if all are zero. */
+  Eigen::VectorXd m_Derivatives;
+
+}; // end DualNumber
+
+
+/** Get the value of a scalar. Useful for branching in templated code. */
+inline double GetValue( double x )
+{
+  return x;
+}
+
+inline double GetValue( const DualNumber & x )
+{
+  return x.GetValue();
+}
+
+
+inline DualNumber operator+( const DualNumber & a )
+{
+  return a;
+}
+
+inline DualNumber operator-( const DualNumber & a )
+{
+  return a.Chain( -a.GetValue(), -1.0 );
+}
+
+inline DualNumber operator+( const DualNumber & a, const DualNumber & b )
+{
+  DualNumber result( a );
+  result += b;
+  return result;
+}
+
+inline DualNumber operator-( const DualNumber & a, const DualNumber & b )
+{
+  DualNumber result( a );
+  result -= b;
+  return result;
+}
+
+inline DualNumber operator*( const DualNumber & a, const DualNumber & b )
+{
+  DualNumber result( a );
+  result *= b;
+  return result;
+}
+
+inline DualNumber operator/( const DualNumber & a, const DualNumber & b )
+{
+  DualNumber result( a );
+  result /= b;
+  return result;
+}
+
+// Comparisons act on the value only.
+inline bool operator<( const DualNumber & a, const DualNumber & b )
+{
+  return a.GetValue() < b.GetValue();
+}
+
+inline bool operator>( const DualNumber & a, const DualNumber & b )
+{
+  return a.GetValue() > b.GetValue();
+}
+
+inline bool operator<=( const DualNumber & a, const DualNumber & b )
+{
+  return a.GetValue() <= b.GetValue();
+}
+
+inline bool operator>=( const DualNumber & a, const DualNumber & b )
+{
+  return a.GetValue() >= b.GetValue();
+}
+
+inline bool operator==( const DualNumber & a, const DualNumber & b )
+{
+  return a.GetValue() == b.GetValue();
+}
+
+inline bool operator!=( const DualNumber & a, const DualNumber & b )
+{
+  return a.GetValue() != b.GetValue();
+}
+
+
+inline DualNumber exp( const DualNumber & a )
+{
+  double value = std::exp( a.GetValue() );
+  return a.Chain( value, value );
+}
+
+inline DualNumber log( const DualNumber & a )
+{
+  return a.Chain( std::log( a.GetValue() ), 1.0 / a.GetValue() );
+}
+
+inline DualNumber sqrt( const DualNumber & a )
+{
+  double value = std::sqrt( a.GetValue() );
+  return a.Chain( value, 0.5 / value );
+}
+
+inline DualNumber pow( const DualNumber & a, double b )
+{
+  return a.Chain( std::pow( a.GetValue(), b ),
+                  b * std::pow( a.GetValue(), b - 1.0 ) );
+}
+
+inline DualNumber pow( double a, const DualNumber & b )
+{
+  double value = std::pow( a, b.GetValue() );
+  return b.Chain( value, value * std::log( a ) );
+}
+
+inline DualNumber pow( const DualNumber & a, const DualNumber & b )
+{
+  double value = std::pow( a.GetValue(), b.GetValue() );
+  double aScale = b.GetValue() * std::pow( a.GetValue(), b.GetValue() - 1.0 );
+  double bScale = b.IsConstant() ? 0.0 : value * std::log( a.GetValue() );
+  return DualNumber::Chain( value, aScale, a, bScale, b );
+}
+
+inline DualNumber sin( const DualNumber & a )
+{
+  return a.Chain( std::sin( a.GetValue() ), std::cos( a.GetValue() ) );
+}
+
+inline DualNumber cos( const DualNumber & a )
+{
+  return a.Chain( std::cos( a.GetValue() ), -std::sin( a.GetValue() ) );
+}
+
+inline DualNumber tan( const DualNumber & a )
+{
+  double value = std::tan( a.GetValue() );
+  return a.Chain( value, 1.0 + value * value );
+}
+
+inline DualNumber atan( const DualNumber & a )
+{
+  return a.Chain( std::atan( a.GetValue() ),
+                  1.0 / ( 1.0 + a.GetValue() * a.GetValue() ) );
+}
+
+inline DualNumber tanh( const DualNumber & a )
+{
+  double value = std::tanh( a.GetValue() );
+  return a.Chain( value, 1.0 - value * value );
+}
+
+inline DualNumber fabs( const DualNumber & a )
+{
+  return ( a.GetValue() < 0.0 ) ? -a : a;
+}
+
+inline DualNumber abs( const DualNumber & a )
+{
+  return fabs( a );
+}
+
+inline std::ostream & operator<<( std::ostream & os, const DualNumber & a )
+{
+  os << a.GetValue();
+  if ( !a.IsConstant() ) {
+    os << " [" << a.GetDerivatives().transpose() << "]";
+  }
+  return os;
+}
+
+} // end namespace madai
+
+#endif // madai_DualNumber_h_included
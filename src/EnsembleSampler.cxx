@@ -0,0 +1,328 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "EnsembleSampler.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+
+namespace madai {
+
+
+EnsembleSampler
+::EnsembleSampler() :
+  Sampler(),
+  m_RequestedNumberOfWalkers( 0 ),
+  m_StretchScale( 2.0 ),
+  m_CurrentWalker( 0 ),
+  m_NumberOfProposals( 0 ),
+  m_NumberOfAcceptedProposals( 0 )
+{
+}
+
+
+EnsembleSampler
+::~EnsembleSampler()
+{
+}
+
+
+void
+EnsembleSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+
+  // No walkers yet, so that Sampler::Initialize() does not move them.
+  m_WalkerParameters.clear();
+  Sampler::Initialize( model );
+
+  this->InitializeWalkersFromPriors();
+}
+
+
+void
+EnsembleSampler
+::SetNumberOfWalkers( unsigned int numberOfWalkers )
+{
+  m_RequestedNumberOfWalkers = numberOfWalkers;
+  if ( m_Model != NULL ) {
+    this->InitializeWalkersFromPriors();
+  }
+}
+
+
+unsigned int
+EnsembleSampler
+::GetNumberOfWalkers() const
+{
+  return static_cast< unsigned int >( m_WalkerParameters.size() );
+}
+
+
+void
+EnsembleSampler
+::SetStretchScale( double scale )
+{
+  m_StretchScale = scale;
+}
+
+
+double
+EnsembleSampler
+::GetStretchScale() const
+{
+  return m_StretchScale;
+}
+
+
+double
+EnsembleSampler
+::GetAcceptanceFraction() const
+{
+  if ( m_NumberOfProposals == 0 ) {
+    return 0.0;
+  }
+  return static_cast< double >( m_NumberOfAcceptedProposals ) /
+    static_cast< double >( m_NumberOfProposals );
+}
+
+
+void
+EnsembleSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "EnsembleSampler" );
+  o << m_WalkerParameters.size() << ' ' << m_CurrentWalker << ' '
+    << m_NumberOfProposals << ' ' << m_NumberOfAcceptedProposals << '\n';
+  for ( size_t walker = 0; walker < m_WalkerParameters.size(); ++walker ) {
+    WriteValues( o, m_WalkerParameters[ walker ] );
+    WriteValues( o, m_WalkerOutputs[ walker ] );
+  }
+  WriteValues( o, m_WalkerLogLikelihoods );
+}
+
+
+bool
+EnsembleSampler
+::ReadState( std::istream & i )
+{
+  size_t numberOfWalkers;
+  if ( !Sampler::ReadState( i ) ||
+       !ReadTag( i, "EnsembleSampler" ) ||
+       !( i >> numberOfWalkers >> m_CurrentWalker
+            >> m_NumberOfProposals >> m_NumberOfAcceptedProposals ) ) {
+    return false;
+  }
+  m_WalkerParameters.resize( numberOfWalkers );
+  m_WalkerOutputs.resize( numberOfWalkers );
+  for ( size_t walker = 0; walker < numberOfWalkers; ++walker ) {
+    if ( !ReadValues( i, m_WalkerParameters[ walker ] ) ||
+         !ReadValues( i, m_WalkerOutputs[ walker ] ) ) {
+      return false;
+    }
+  }
+  return ( ReadValues( i, m_WalkerLogLikelihoods ) &&
+           m_WalkerLogLikelihoods.size() == numberOfWalkers );
+}
+
+
+void
+EnsembleSampler
+::InitializeWalkersFromPriors()
+{
+  unsigned int numberOfWalkers = m_RequestedNumberOfWalkers;
+  if ( numberOfWalkers == 0 ) {
+    numberOfWalkers = 2 * m_Model->GetNumberOfParameters() + 2;
+  }
+  numberOfWalkers += numberOfWalkers % 2;
+  if ( numberOfWalkers < 4 ) {
+    numberOfWalkers = 4;
+  }
+
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  m_WalkerParameters.assign( numberOfWalkers, m_CurrentParameters );
+  for ( unsigned int w = 0; w < numberOfWalkers; ++w ) {
+    for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+      if ( m_ActiveParameterIndices[i] ) {
+        m_WalkerParameters[w][i] =
+          params[i].GetPriorDistribution()->GetSample( m_Random );
+      }
+    }
+  }
+  this->EvaluateWalkers();
+
+  // The first call to NextSample() moves the ensemble.
+  this->SetCurrentWalker( numberOfWalkers - 1 );
+}
+
+
+void
+EnsembleSampler
+::ParameterSetExternally()
+{
+  if ( m_Model == NULL || m_WalkerParameters.empty() ) {
+    return;
+  }
+
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+  const std::vector< double > & walker = m_WalkerParameters[ m_CurrentWalker ];
+  bool activeParameterChanged = false;
+  for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+    if ( m_ActiveParameterIndices[i] && m_CurrentParameters[i] != walker[i] ) {
+      activeParameterChanged = true;
+    }
+  }
+
+  if ( activeParameterChanged ) {
+    // Restart in a ball around the new point, a thousandth of the
+    // interquartile range of the priors across.
+    const std::vector< Parameter > & params = m_Model->GetParameters();
+    for ( unsigned int w = 0; w < m_WalkerParameters.size(); ++w ) {
+      m_WalkerParameters[w] = m_CurrentParameters;
+      if ( w == m_CurrentWalker ) {
+        continue;
+      }
+      for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+        if ( m_ActiveParameterIndices[i] ) {
+          const Distribution * priorDist = params[i].GetPriorDistribution();
+          double scale =
+            priorDist->GetPercentile( 0.75 ) - priorDist->GetPercentile( 0.25 );
+          m_WalkerParameters[w][i] += 1.0e-3 * scale * m_Random.Gaussian();
+        }
+      }
+    }
+  } else {
+    for ( unsigned int w = 0; w < m_WalkerParameters.size(); ++w ) {
+      for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+        if ( !m_ActiveParameterIndices[i] ) {
+          m_WalkerParameters[w][i] = m_CurrentParameters[i];
+        }
+      }
+    }
+  }
+
+  this->EvaluateWalkers();
+  this->SetCurrentWalker( m_CurrentWalker );
+}
+
+
+void
+EnsembleSampler
+::EvaluateWalkers()
+{
+  m_Model->GetScalarOutputsAndLogLikelihoods(
+    m_WalkerParameters, m_WalkerOutputs, m_WalkerLogLikelihoods );
+  for ( unsigned int w = 0; w < m_WalkerLogLikelihoods.size(); ++w ) {
+    // Points where the Model fails are never moved to.
+    if ( m_WalkerLogLikelihoods[w] != m_WalkerLogLikelihoods[w] ) {
+      m_WalkerLogLikelihoods[w] = -std::numeric_limits< double >::infinity();
+    }
+  }
+}
+
+
+void
+EnsembleSampler
+::UpdateHalf( unsigned int half )
+{
+  unsigned int halfSize =
+    static_cast< unsigned int >( m_WalkerParameters.size() / 2 );
+  unsigned int first = half * halfSize;
+  unsigned int other = ( 1 - half ) * halfSize;
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+  double a = m_StretchScale;
+
+  // Draw all proposals of this half first, so that they can be
+  // evaluated together.
+  std::vector< std::vector< double > > proposals( halfSize );
+  std::vector< double > stretchFactors( halfSize );
+  for ( unsigned int k = 0; k < halfSize; ++k ) {
+    const std::vector< double > & x = m_WalkerParameters[ first + k ];
+    const std::vector< double > & partner =
+      m_WalkerParameters[ other + m_Random.Integer( halfSize ) ];
+    double u = ( a - 1.0 ) * m_Random.Uniform() + 1.0;
+    double z = u * u / a;
+    stretchFactors[k] = z;
+    proposals[k] = x;
+    for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+      if ( m_ActiveParameterIndices[i] ) {
+        proposals[k][i] = partner[i] + z * ( x[i] - partner[i] );
+      }
+    }
+  }
+
+  std::vector< std::vector< double > > outputs;
+  std::vector< double > logLikelihoods;
+  m_Model->GetScalarOutputsAndLogLikelihoods(
+    proposals, outputs, logLikelihoods );
+
+  double dimensionTerm =
+    static_cast< double >( this->GetNumberOfActiveParameters() ) - 1.0;
+  for ( unsigned int k = 0; k < halfSize; ++k ) {
+    unsigned int w = first + k;
+    ++m_NumberOfProposals;
+    if ( logLikelihoods[k] != logLikelihoods[k] ) {
+      continue;
+    }
+    double logAcceptance = dimensionTerm * std::log( stretchFactors[k] ) +
+      logLikelihoods[k] - m_WalkerLogLikelihoods[w];
+    if ( logAcceptance >= 0.0 ||
+         std::log( m_Random.Uniform() ) < logAcceptance ) {
+      m_WalkerParameters[w] = proposals[k];
+      m_WalkerOutputs[w] = outputs[k];
+      m_WalkerLogLikelihoods[w] = logLikelihoods[k];
+      ++m_NumberOfAcceptedProposals;
+    }
+  }
+}
+
+
+void
+EnsembleSampler
+::SetCurrentWalker( unsigned int walker )
+{
+  m_CurrentWalker = walker;
+  m_CurrentParameters = m_WalkerParameters[ walker ];
+  m_CurrentOutputs = m_WalkerOutputs[ walker ];
+  m_CurrentLogLikelihood = m_WalkerLogLikelihoods[ walker ];
+}
+
+
+Sample
+EnsembleSampler
+::NextSample()
+{
+  unsigned int walker = m_CurrentWalker + 1;
+  if ( walker >= m_WalkerParameters.size() ) {
+    this->UpdateHalf( 0 );
+    this->UpdateHalf( 1 );
+    walker = 0;
+  }
+  this->SetCurrentWalker( walker );
+
+  return Sample( m_CurrentParameters,
+                 m_CurrentOutputs,
+                 m_CurrentLogLikelihood );
+}
+
+} // end namespace madai
@@ -0,0 +1,133 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_EnsembleSampler_h_included
+#define madai_EnsembleSampler_h_included
+
+#include <vector>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/**
+ * \class EnsembleSampler
+ *
+ * Affine-invariant ensemble sampler with the stretch move of Goodman
+ * and Weare (2010), as in emcee.
+ *
+ * The sampler keeps an ensemble of walkers. The ensemble is split in
+ * two halves, and every walker of one half proposes a point on the
+ * line through itself and a random walker of the other half. The
+ * proposals of a half do not depend on each other, so they are
+ * evaluated as one batch with Model::GetScalarOutputsAndLogLikelihoods(),
+ * which uses parallel threads when the Model allows it.
+ *
+ * NextSample() returns the walkers in turn, and moves the whole
+ * ensemble after the last one. A trace of N samples therefore holds
+ * N / NumberOfWalkers steps of the ensemble. The move is invariant
+ * to linear transformations of the parameters, so it needs no step
+ * size and handles correlated posteriors.
+ *
+ * The walkers start out as samples from the priors. Setting the
+ * value of an active parameter restarts them in a small ball around
+ * the current point. Setting the value of an inactive parameter sets
+ * it in every walker.
+ */
+class EnsembleSampler : public Sampler {
+public:
+  EnsembleSampler();
+  virtual ~EnsembleSampler();
+
+  /** Get the next Sample from the distribution. */
+  virtual Sample NextSample();
+
+  //@{
+  /** Set/Get the number of walkers. It must be even and at least 4,
+   * and should be more than twice the number of active parameters.
+   * Zero, the default, means twice the number of parameters plus
+   * two. Setting it draws a new ensemble from the priors. */
+  void SetNumberOfWalkers( unsigned int numberOfWalkers );
+  unsigned int GetNumberOfWalkers() const;
+  //@}
+
+  //@{
+  /** Set/Get the scale a of the stretch move. The stretch factor is
+   * drawn between 1/a and a. Defaults to 2. */
+  void SetStretchScale( double scale );
+  double GetStretchScale() const;
+  //@}
+
+  /** Get the fraction of proposals accepted so far. */
+  double GetAcceptanceFraction() const;
+
+  //@{
+  /** The state includes every walker. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Copies inactive parameter values into the walkers, or restarts
+   * the ensemble around the current point if an active parameter was
+   * set. */
+  virtual void ParameterSetExternally();
+
+  /** Place the walkers at samples from the priors. */
+  void InitializeWalkersFromPriors();
+
+  /** Evaluate the Model at every walker. */
+  void EvaluateWalkers();
+
+  /** Move one half of the ensemble using the other half. Subclasses
+   * override this to use other moves. */
+  virtual void UpdateHalf( unsigned int half );
+
+  /** Make the given walker the current state. */
+  void SetCurrentWalker( unsigned int walker );
+
+  /** Requested number of walkers, or zero. */
+  unsigned int m_RequestedNumberOfWalkers;
+
+  /** Scale of the stretch move. */
+  double m_StretchScale;
+
+  //@{
+  /** State of each walker. */
+  std::vector< std::vector< double > > m_WalkerParameters;
+  std::vector< std::vector< double > > m_WalkerOutputs;
+  std::vector< double >                m_WalkerLogLikelihoods;
+  //@}
+
+  /** Index of the walker returned by the last NextSample(). */
+  unsigned int m_CurrentWalker;
+
+  //@{
+  /** Counts of proposals and accepted proposals. */
+  unsigned long int m_NumberOfProposals;
+  unsigned long int m_NumberOfAcceptedProposals;
+  //@}
+
+}; // end class EnsembleSampler
+
+} // end namespace madai
+
+#endif // madai_EnsembleSampler_h_included
@@ -24,6 +24,7 @@
 #include <string> // std::string
 #include <cstring> // std::strcmp
 
+#include "Configuration.h"
 #include "ExternalModel.h"
 #include "GaussianDistribution.h"
 #include "UniformDistribution.h"
@@ -373,7 +374,33 @@ ExternalModel
   if (parameters.size() != this->GetNumberOfParameters())
     return WRONG_VECTOR_LENGTH;
 
-  ProcessPipe & proc = (const_cast< ExternalModel * >(this))->m_Process;
+  // The process answers one query at a time, so concurrent callers
+  // take turns.
+  ErrorType error;
+#if defined( OPENMP_FOUND )
+  #pragma omp critical ( madai_ExternalModel_Query )
+#endif // OPENMP_FOUND
+  error = this->QueryProcess( parameters, scalars, scalarCovariance );
+  return error;
+}
+
+
+bool
+ExternalModel
+::SupportsConcurrentEvaluation() const
+{
+  return false;
+}
+
+
+ExternalModel::ErrorType
+ExternalModel
+::QueryProcess(
+      const std::vector< double > & parameters,
+      std::vector< double > & scalars,
+      std::vector< double > & scalarCovariance) const
+{
+  const ProcessPipe & proc = m_Process;
 
   for ( std::vector< double >::const_iterator par_it = parameters.begin();
        par_it < parameters.end(); par_it++ ) {
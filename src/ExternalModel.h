@@ -74,7 +74,17 @@ public:
   virtual ErrorType GetScalarOutputs( const std::vector< double > & parameters,
                                       std::vector< double > & scalars ) const;
 
+  /** Always false: the external process answers one query at a
+   * time. Concurrent calls are serialized rather than run in
+   * parallel. */
+  virtual bool SupportsConcurrentEvaluation() const;
+
 private:
+  /** Send one point to the external process and read its answer. */
+  ErrorType QueryProcess( const std::vector< double > & parameters,
+                          std::vector< double > & scalars,
+                          std::vector< double > & scalarCovariance ) const;
+
   /** Container for process-related information */
   ProcessPipe m_Process;
 
@@ -17,12 +17,38 @@
  *=========================================================================*/
 
 #include <iostream>
+#include <limits>
 
 #include "GaussianProcessEmulatedModel.h"
 #include "GaussianProcessEmulator.h"
 
 namespace madai {
 
+namespace {
+
+/** Scaled squared distances between the point of the last evaluation
+ * and the training points, for each retained principal component. */
+class DistancesCache : public Model::EvaluationCache {
+public:
+  std::vector< double > m_Parameters;
+  std::vector< Eigen::VectorXd > m_DistancesSquared;
+};
+
+
+/** Copy an emulator, with its PCA decomposed models referring to the
+ * copy. */
+GaussianProcessEmulator *
+CopyEmulator( const GaussianProcessEmulator & gpe )
+{
+  GaussianProcessEmulator * copy = new GaussianProcessEmulator( gpe );
+  for ( size_t i = 0; i < copy->m_PCADecomposedModels.size(); ++i ) {
+    copy->m_PCADecomposedModels[i].m_Parent = copy;
+  }
+  return copy;
+}
+
+} // anonymous namespace
+
 
 GaussianProcessEmulatedModel
 ::GaussianProcessEmulatedModel() :
@@ -34,7 +60,6 @@ GaussianProcessEmulatedModel
 GaussianProcessEmulatedModel
 ::~GaussianProcessEmulatedModel()
 {
-  delete m_GPE;
 }
 
 /**
@@ -45,21 +70,40 @@ GaussianProcessEmulatedModel
 ::SetGaussianProcessEmulator(
   GaussianProcessEmulator & gpe )
 {
-  *m_GPE = gpe; // Copy entire object, not pointer.  Makes tracking ownership easy.
-  if ( m_GPE->m_Status != GaussianProcessEmulator::READY )
+  return this->SetGaussianProcessEmulator(
+    boost::shared_ptr< const GaussianProcessEmulator >( CopyEmulator( gpe ) ) );
+}
+
+/**
+ * Set the gaussian process emulator without copying it
+ */
+Model::ErrorType
+GaussianProcessEmulatedModel
+::SetGaussianProcessEmulator(
+  const boost::shared_ptr< const GaussianProcessEmulator > & gpe )
+{
+  if ( !gpe || gpe->m_Status != GaussianProcessEmulator::READY )
     return Model::OTHER_ERROR;
-  m_StateFlag = READY;
 
-  // Change the parent of the PCA decomposed models
-  for ( size_t i = 0; i < m_GPE->m_PCADecomposedModels.size(); ++i ) {
-    m_GPE->m_PCADecomposedModels[i].m_Parent = m_GPE;
+  // A copied emulator still refers to the original through its PCA
+  // decomposed models.
+  for ( size_t i = 0; i < gpe->m_PCADecomposedModels.size(); ++i ) {
+    if ( gpe->m_PCADecomposedModels[i].m_Parent != gpe.get() ) {
+      std::cerr << "Error: PCA decomposed model " << i << " does not belong "
+                << "to the shared emulator.\n";
+      return Model::OTHER_ERROR;
+    }
   }
 
+  m_GPE = gpe;
+  m_StateFlag = READY;
+
   m_Parameters = m_GPE->m_Parameters;
+  this->UpdateCompiledPrior();
 
   // We add these one by one so that each is checked for being the log likelihood
   m_ScalarOutputNames.clear();
-  for ( std::vector< std::string >::iterator it = m_GPE->m_OutputNames.begin(); it != m_GPE->m_OutputNames.end(); it++ ) {
+  for ( std::vector< std::string >::const_iterator it = m_GPE->m_OutputNames.begin(); it != m_GPE->m_OutputNames.end(); it++ ) {
     AddScalarOutputName(*it);
   }
 
@@ -71,6 +115,26 @@ GaussianProcessEmulatedModel
   return Model::NO_ERROR;
 }
 
+/**
+ * Condition a copy of the emulator on the fixed parameters
+ */
+Model::ErrorType
+GaussianProcessEmulatedModel
+::ConditionOnFixedParameters(
+  const std::vector< bool > & activeParameters,
+  const std::vector< double > & values )
+{
+  if ( m_StateFlag != READY )
+    return Model::OTHER_ERROR;
+
+  boost::shared_ptr< GaussianProcessEmulator > copy( CopyEmulator( *m_GPE ) );
+  if ( !copy->ConditionOnFixedParameters( activeParameters, values ) )
+    return Model::OTHER_ERROR;
+
+  m_GPE = copy;
+  return Model::NO_ERROR;
+}
+
 /**
    Returns a const reference to internal data for debugging purposes. */
 const GaussianProcessEmulator &
@@ -80,6 +144,77 @@ GaussianProcessEmulatedModel
   return *m_GPE;
 }
 
+
+boost::shared_ptr< const GaussianProcessEmulator >
+GaussianProcessEmulatedModel
+::GetSharedGaussianProcessEmulator() const
+{
+  return m_GPE;
+}
+
+
+bool
+GaussianProcessEmulatedModel
+::SupportsConcurrentEvaluation() const
+{
+  return true;
+}
+
+
+Model::EvaluationCache *
+GaussianProcessEmulatedModel
+::NewEvaluationCache() const
+{
+  return new DistancesCache;
+}
+
+
+Model::ErrorType
+GaussianProcessEmulatedModel
+::GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+  const std::vector< double > & parameters,
+  const std::vector< unsigned int > & changedParameters,
+  const EvaluationCache * previous,
+  EvaluationCache * current,
+  std::vector< double > & scalars,
+  double & logLikelihood ) const
+{
+  const DistancesCache * previousDistances =
+    dynamic_cast< const DistancesCache * >( previous );
+  DistancesCache * currentDistances =
+    dynamic_cast< DistancesCache * >( current );
+  if ( currentDistances == NULL || m_UseModelCovarianceToCalulateLogLikelihood ) {
+    if ( currentDistances != NULL ) {
+      // The distances are not kept up to date on this path.
+      currentDistances->m_Parameters.clear();
+    }
+    return this->GetScalarOutputsAndLogLikelihood(
+      parameters, scalars, logLikelihood );
+  }
+
+  if ( m_GPE->m_Status != GaussianProcessEmulator::READY ||
+       this->GetNumberOfParameters() != parameters.size() ) {
+    return Model::OTHER_ERROR;
+  }
+
+  if ( previousDistances == NULL ) {
+    currentDistances->m_Parameters.clear();
+  } else if ( previousDistances != currentDistances ) {
+    currentDistances->m_Parameters = previousDistances->m_Parameters;
+    currentDistances->m_DistancesSquared = previousDistances->m_DistancesSquared;
+  }
+  if ( !m_GPE->GetEmulatorOutputsOfPartialUpdate(
+         parameters, currentDistances->m_Parameters, changedParameters,
+         currentDistances->m_DistancesSquared, scalars ) ) {
+    currentDistances->m_Parameters.clear();
+    return Model::OTHER_ERROR;
+  }
+  currentDistances->m_Parameters = parameters;
+
+  return this->GetLogLikelihoodOfScalarOutputs(
+    parameters, scalars, std::vector< double >(), logLikelihood );
+}
+
 /**
  * Get the scalar outputs from the model evaluated at x.  If an
  * error happens, the scalar output array will be left incomplete.
@@ -135,6 +270,28 @@ GaussianProcessEmulatedModel
   std::vector< double > & scalars,
   std::vector< double > & gradient ) const
 {
+  double logLikelihood;
+  return this->GetScalarOutputsAndLogLikelihoodAndGradient(
+    parameters, activeParameters, scalars, logLikelihood, gradient );
+}
+
+
+// The log likelihood falls out of the gradient computation.
+Model::ErrorType
+GaussianProcessEmulatedModel
+::GetScalarOutputsAndLogLikelihoodAndGradient(
+  const std::vector< double > & parameters,
+  const std::vector< bool > & activeParameters,
+  std::vector< double > & scalars,
+  double & logLikelihood,
+  std::vector< double > & gradient ) const
+{
+  if ( m_LogLikelihoodObservable > -1 ) {
+    return this->Model::GetScalarOutputsAndLogLikelihoodAndGradient(
+      parameters, activeParameters, scalars, logLikelihood, gradient );
+  }
+  logLikelihood = std::numeric_limits< double >::signaling_NaN();
+
   if ( static_cast< unsigned int >( activeParameters.size() ) !=
       this->GetNumberOfParameters() ) {
     return INVALID_ACTIVE_PARAMETERS;
@@ -225,8 +382,8 @@ GaussianProcessEmulatedModel
   }
 
   // Get gradient of the log prior likelihood
-  std::vector< double > LPGradient
-  = this->GetGradientOfLogPriorLikelihood( parameters );
+  std::vector< double > LPGradient;
+  this->GetGradientOfLogPriorLikelihood( parameters, LPGradient );
 
   Eigen::Map< Eigen::VectorXd > diff(&(scalarDifferences[0]),t);
   Eigen::Map< Eigen::MatrixXd > cov(&(covariance[0]),t,t);
@@ -245,6 +402,9 @@ GaussianProcessEmulatedModel
     t1 = cov.colPivHouseholderQr().solve(diff);
   }
 
+  logLikelihood = -0.5 * t1.dot( diff ) +
+    this->GetLogPriorLikelihood( parameters );
+
   LLGrad = -MGrads.transpose()*t1;
   if ( scalarCovariance.size() == 0 ) {
     // emulator error not used, do nothing
@@ -252,7 +412,7 @@ GaussianProcessEmulatedModel
     // Need to include derivative of covariance matrix
     for ( int i = 0; i < p; i++ ) {
       if ( activeParameters[i] ) {
-        LLGrad(i) += -0.5*t1.dot(covarianceGradients[i]*t1);
+        LLGrad(i) += 0.5*t1.dot(covarianceGradients[i]*t1);
       }
     }
   }
@@ -24,6 +24,8 @@
 #include <string>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 namespace madai {
 
 class GaussianProcessEmulator;
@@ -31,7 +33,11 @@ class GaussianProcessEmulator;
 /** \class GaussianProcessEmulatedModel
  *
  * This class presents the GaussianProcessEmulator class as a Model
- * that can be used by instances of the Sample class. */
+ * that can be used by instances of the Sample class.
+ *
+ * The emulator is held through a reference-counted handle to a const
+ * GaussianProcessEmulator, so many models (and the chains and threads
+ * using them) can share one emulator without copying it. */
 class GaussianProcessEmulatedModel : public Model {
   public:
 
@@ -41,17 +47,56 @@ class GaussianProcessEmulatedModel : public Model {
   /**
    * Set the gaussian process emulator.
    *
+   * The emulator is copied. Prefer the overload taking a shared
+   * handle to avoid the copy.
+   *
    * \param gpe The instance of the GaussianProcessEmulator this
    *            object adapts.
    */
   virtual ErrorType SetGaussianProcessEmulator( GaussianProcessEmulator & gpe );
 
+  /**
+   * Set the gaussian process emulator without copying it.
+   *
+   * The emulator must be READY (MakeCache() has succeeded) and must
+   * not be modified while this model refers to it.
+   *
+   * \param gpe Shared handle to the GaussianProcessEmulator this
+   *            object adapts.
+   */
+  virtual ErrorType SetGaussianProcessEmulator(
+    const boost::shared_ptr< const GaussianProcessEmulator > & gpe );
+
+  /**
+   * Condition the emulator on the values of the fixed parameters, as
+   * GaussianProcessEmulator::ConditionOnFixedParameters() does. A
+   * shared emulator must not be modified, so this model switches to
+   * a conditioned copy of its own and other models are unaffected.
+   * The unconditioned emulator is freed if nothing else refers to
+   * it, so hand this model the only reference to avoid keeping two.
+   *
+   * \param activeParameters Which parameters vary. The others are
+   * fixed.
+   * \param values Point in parameter space holding the values of the
+   * fixed parameters.
+   */
+  ErrorType ConditionOnFixedParameters(
+    const std::vector< bool > & activeParameters,
+    const std::vector< double > & values );
+
   /**
    *  Returns a const reference to internal data for debugging
    *  purposes.
    */
   const GaussianProcessEmulator & GetGaussianProcessEmulator() const;
 
+  /**
+   * Returns the shared handle to the emulator so that other models
+   * can share it.
+   */
+  boost::shared_ptr< const GaussianProcessEmulator >
+  GetSharedGaussianProcessEmulator() const;
+
   /**
    * Get the scalar outputs from the model evaluated at point
    * \c parameters.
@@ -101,6 +146,36 @@ class GaussianProcessEmulatedModel : public Model {
     std::vector< double > & scalars,
     std::vector< double > & gradient ) const;
 
+  /** Get the scalar outputs, the log likelihood and the analytic
+   * gradient of the log likelihood from one evaluation of the
+   * emulator. */
+  virtual ErrorType GetScalarOutputsAndLogLikelihoodAndGradient(
+    const std::vector< double > & parameters,
+    const std::vector< bool > & activeParameters,
+    std::vector< double > & scalars,
+    double & logLikelihood,
+    std::vector< double > & gradient ) const;
+
+  /** Returns true: evaluating the emulator does not modify it. */
+  virtual bool SupportsConcurrentEvaluation() const;
+
+  /** Create a cache of the distances between a point and the
+   * training points. */
+  virtual EvaluationCache * NewEvaluationCache() const;
+
+  /** Update the distances to the training points in the cache along
+   * the changed parameters only, instead of along all of them. The
+   * emulator covariance is not sped up, so with
+   * UseModelCovarianceToCalulateLogLikelihood this is a full
+   * evaluation. */
+  virtual ErrorType GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+    const std::vector< double > & parameters,
+    const std::vector< unsigned int > & changedParameters,
+    const EvaluationCache * previous,
+    EvaluationCache * current,
+    std::vector< double > & scalars,
+    double & logLikelihood ) const;
+
 #if 0
   /**
    * Returns the combined training and observed covariance at point \c
@@ -118,7 +193,7 @@ protected:
 
 private:
   /** The Gaussian process emulator. */
-  GaussianProcessEmulator * m_GPE;
+  boost::shared_ptr< const GaussianProcessEmulator > m_GPE;
 
 }; // end GaussianProcessEmulatedModel
 
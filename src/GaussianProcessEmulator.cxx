@@ -295,7 +295,6 @@ static void setThetasByScale(
 double GaussianProcessEmulator::SingleModel::CovarianceCalc(
     const Eigen::VectorXd & v1, const Eigen::VectorXd & v2) const
 {
-  static const double EPSILON = 1e-10;
   int p = m_Parent->m_NumberParameters;
   int offset = ThetaOffset(m_CovarianceFunction);
   assert(offset != -1);
@@ -304,10 +303,6 @@ double GaussianProcessEmulator::SingleModel::CovarianceCalc(
     // Only if assertions are disabled
     return 0.0; // we should throw an exception.
   }
-  assert(offset >= 2);
-  const double & amplitude = m_Thetas(0);
-  const double & nugget = m_Thetas(1);
-  double nug = 0.0;
 
   double distanceSquared = 0.0;
   for (int i = 0; i < p; i++) {
@@ -315,6 +310,18 @@ double GaussianProcessEmulator::SingleModel::CovarianceCalc(
     double l = m_Thetas(i + offset);
     distanceSquared += std::pow( (d / l), 2);
   }
+  return this->CovarianceFromDistanceSquared(distanceSquared);
+}
+
+
+double GaussianProcessEmulator::SingleModel::CovarianceFromDistanceSquared(
+    double distanceSquared) const
+{
+  static const double EPSILON = 1e-10;
+  assert(ThetaOffset(m_CovarianceFunction) >= 2);
+  const double & amplitude = m_Thetas(0);
+  const double & nugget = m_Thetas(1);
+  double nug = 0.0;
   if (distanceSquared < EPSILON) {
     nug = nugget;
   }
@@ -353,6 +360,97 @@ double GaussianProcessEmulator::SingleModel::CovarianceCalc(
 }
 
 
+void GaussianProcessEmulator::SingleModel::GetTrainingPointCovariances(
+    const Eigen::VectorXd & point,
+    Eigen::VectorXd & kplus) const
+{
+  Eigen::VectorXd distancesSquared;
+  this->GetTrainingPointDistancesSquared(point, distancesSquared);
+  this->GetTrainingPointCovariancesFromDistancesSquared(distancesSquared, kplus);
+}
+
+
+void GaussianProcessEmulator::SingleModel::GetTrainingPointDistancesSquared(
+    const Eigen::VectorXd & point,
+    Eigen::VectorXd & distancesSquared) const
+{
+  int N = m_Parent->m_NumberTrainingPoints;
+  int p = m_Parent->m_NumberParameters;
+  int offset = ThetaOffset(m_CovarianceFunction);
+  const Eigen::MatrixXd & X = m_Parent->m_TrainingParameterValues;
+  assert((X.rows() == N) && (X.cols() == p));
+  assert(m_Thetas.size() == (p + offset));
+  distancesSquared.resize(N);
+
+  if ((m_FixedDistancesSquared.size() == N) &&
+      m_Parent->MatchesFixedParameters(point)) {
+    // Only the active dimensions change from one point to the next.
+    const std::vector< int > & active
+      = m_Parent->m_ConditionedActiveParameterIndices;
+    int a = static_cast< int >(active.size());
+    for (int j = 0; j < N; ++j) {
+      double distanceSquared = m_FixedDistancesSquared(j);
+      for (int k = 0; k < a; ++k) {
+        int i = active[k];
+        double d = (X(j,i) - point(i)) / m_Thetas(i + offset);
+        distanceSquared += d * d;
+      }
+      distancesSquared(j) = distanceSquared;
+    }
+    return;
+  }
+
+  for (int j = 0; j < N; ++j) {
+    double distanceSquared = 0.0;
+    for (int i = 0; i < p; ++i) {
+      double d = (X(j,i) - point(i)) / m_Thetas(i + offset);
+      distanceSquared += d * d;
+    }
+    distancesSquared(j) = distanceSquared;
+  }
+}
+
+
+void GaussianProcessEmulator::SingleModel::UpdateTrainingPointDistancesSquared(
+    const Eigen::VectorXd & point,
+    const Eigen::VectorXd & previousPoint,
+    const std::vector< unsigned int > & changedParameters,
+    Eigen::VectorXd & distancesSquared) const
+{
+  int N = m_Parent->m_NumberTrainingPoints;
+  int offset = ThetaOffset(m_CovarianceFunction);
+  const Eigen::MatrixXd & X = m_Parent->m_TrainingParameterValues;
+  assert(distancesSquared.size() == N);
+  int c = static_cast< int >(changedParameters.size());
+  for (int j = 0; j < N; ++j) {
+    double distanceSquared = distancesSquared(j);
+    for (int k = 0; k < c; ++k) {
+      int i = static_cast< int >(changedParameters[k]);
+      double l = m_Thetas(i + offset);
+      double d = (X(j,i) - point(i)) / l;
+      double previousD = (X(j,i) - previousPoint(i)) / l;
+      distanceSquared += d * d - previousD * previousD;
+    }
+    // Rounding must not make the distance negative.
+    distancesSquared(j) = std::max(distanceSquared, 0.0);
+  }
+}
+
+
+void GaussianProcessEmulator::SingleModel
+::GetTrainingPointCovariancesFromDistancesSquared(
+    const Eigen::VectorXd & distancesSquared,
+    Eigen::VectorXd & kplus) const
+{
+  int N = static_cast< int >(distancesSquared.size());
+  kplus.resize(N);
+  for (int j = 0; j < N; ++j) {
+    double cov = this->CovarianceFromDistanceSquared(distancesSquared(j));
+    kplus(j) = (cov < 1e-10) ? 0.0 : cov;
+  }
+}
+
+
 bool GaussianProcessEmulator::SingleModel::GetGradientOfCovarianceCalc(
     const Eigen::VectorXd & v1, const Eigen::VectorXd & v2,
     Eigen::VectorXd & gradient) const
@@ -469,6 +567,10 @@ GaussianProcessEmulator::CheckStatus() {
     m_ObservedValues
       = Eigen::VectorXd::Constant(m_NumberOutputs,0.0);
   }
+  if((m_UncertaintyScales.size() != m_NumberOutputs) &&
+     (m_ObservedVariances.size() == m_NumberOutputs)) {
+    this->BuildUncertaintyScales();
+  }
   m_Status = UNTRAINED;
   if(m_NumberPCAOutputs < 1)
     return m_Status;
@@ -566,11 +668,8 @@ bool GaussianProcessEmulator::GetUncertaintyScales(
     std::vector< double > & x) const
 {
   if(m_UncertaintyScales.size() != m_NumberOutputs) {
-    GaussianProcessEmulator * nonConstGPE = const_cast< GaussianProcessEmulator * >( this );
-    if ( !nonConstGPE->BuildUncertaintyScales() ) {
-      x.clear();
-      return false;
-    }
+    x.clear();
+    return false;
   }
 
   x.resize(m_NumberOutputs);
@@ -587,10 +686,7 @@ bool GaussianProcessEmulator::GetUncertaintyScalesAsCovariance(
   x.clear();
   int t = m_NumberOutputs;
   if( m_UncertaintyScales.size() != t ) {
-    GaussianProcessEmulator * nonConstGPE = const_cast< GaussianProcessEmulator * >( this );
-    if ( !nonConstGPE->BuildUncertaintyScales() ) {
-      return false;
-    }
+    return false;
   }
 
   x.resize(t*t);
@@ -658,6 +754,10 @@ bool GaussianProcessEmulator::BuildZVectors() {
     return false;
   }
 
+  if ( m_UncertaintyScales.size() != m_NumberOutputs &&
+       !this->BuildUncertaintyScales() ) {
+    return false;
+  }
   std::vector< double > uncertaintyScales;
   if ( !this->GetUncertaintyScales( uncertaintyScales ) ) {
     return false;
@@ -685,6 +785,15 @@ bool GaussianProcessEmulator::MakeCache() {
     return false;
   }
   assert(m_NumberPCAOutputs == static_cast<int>(m_PCADecomposedModels.size()));
+  // The precomputed distances depend on the hyperparameters.
+  this->ClearFixedParameters();
+  // Everything the const evaluation methods need is built here so
+  // that they never have to modify the emulator.
+  if ( m_UncertaintyScales.size() != m_NumberOutputs &&
+       !this->BuildUncertaintyScales() ) {
+    std::cerr << "ERROR in " __FILE__ ":" << __LINE__ << "\n";
+    return false;
+  }
   bool errorflag = false;
 #if defined( OPENMP_FOUND )
   #pragma omp parallel for
@@ -702,6 +811,87 @@ bool GaussianProcessEmulator::MakeCache() {
   return true;
 }
 
+bool GaussianProcessEmulator::ConditionOnFixedParameters(
+    const std::vector< bool > & activeParameters,
+    const std::vector< double > & values) {
+  if (m_Status != READY) {
+    std::cerr << "ConditionOnFixedParameters ERROR."
+      " GaussianProcessEmulator is not ready.\n";
+    return false;
+  }
+  int p = m_NumberParameters;
+  if ((static_cast< int >(activeParameters.size()) != p) ||
+      (static_cast< int >(values.size()) != p)) {
+    std::cerr << "ConditionOnFixedParameters ERROR."
+      " Expected vectors of length " << p << ".\n";
+    return false;
+  }
+  this->ClearFixedParameters();
+
+  std::vector< double > fixedValues;
+  for (int i = 0; i < p; ++i) {
+    if (activeParameters[i]) {
+      m_ConditionedActiveParameterIndices.push_back(i);
+    } else {
+      m_FixedParameterIndices.push_back(i);
+      fixedValues.push_back(values[i]);
+    }
+  }
+  if (m_FixedParameterIndices.empty()) {
+    // Nothing to fold in.
+    m_ConditionedActiveParameterIndices.clear();
+    return true;
+  }
+  int f = static_cast< int >(fixedValues.size());
+  m_FixedParameterValues = Eigen::Map< Eigen::VectorXd >(&(fixedValues[0]), f);
+
+  int N = m_NumberTrainingPoints;
+  const Eigen::MatrixXd & X = m_TrainingParameterValues;
+  for (int m = 0; m < m_NumberPCAOutputs; ++m) {
+    SingleModel & model = m_PCADecomposedModels[m];
+    int offset = ThetaOffset(model.m_CovarianceFunction);
+    assert(model.m_Thetas.size() == (p + offset));
+    model.m_FixedDistancesSquared = Eigen::VectorXd::Zero(N);
+    for (int j = 0; j < N; ++j) {
+      double distanceSquared = 0.0;
+      for (int k = 0; k < f; ++k) {
+        int i = m_FixedParameterIndices[k];
+        double d = (X(j,i) - m_FixedParameterValues(k)) / model.m_Thetas(i + offset);
+        distanceSquared += d * d;
+      }
+      model.m_FixedDistancesSquared(j) = distanceSquared;
+    }
+  }
+  return true;
+}
+
+void GaussianProcessEmulator::ClearFixedParameters() {
+  m_FixedParameterIndices.clear();
+  m_FixedParameterValues.resize(0);
+  m_ConditionedActiveParameterIndices.clear();
+  for (size_t m = 0; m < m_PCADecomposedModels.size(); ++m) {
+    m_PCADecomposedModels[m].m_FixedDistancesSquared.resize(0);
+  }
+}
+
+bool GaussianProcessEmulator::IsConditionedOnFixedParameters() const {
+  return !m_FixedParameterIndices.empty();
+}
+
+bool GaussianProcessEmulator::MatchesFixedParameters(
+    const Eigen::VectorXd & point) const {
+  if (m_FixedParameterIndices.empty() ||
+      (point.size() != m_NumberParameters)) {
+    return false;
+  }
+  for (size_t k = 0; k < m_FixedParameterIndices.size(); ++k) {
+    if (point(m_FixedParameterIndices[k]) != m_FixedParameterValues(k)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool GaussianProcessEmulator::SingleModel::MakeCache() {
   int N = m_Parent->m_NumberTrainingPoints;
   int p = m_Parent->m_NumberParameters;
@@ -942,6 +1132,10 @@ bool GaussianProcessEmulator::PrincipalComponentDecompose()
   int t = m_NumberOutputs;
   int N = m_NumberTrainingPoints;
 
+  if ( m_UncertaintyScales.size() != m_NumberOutputs &&
+       !this->BuildUncertaintyScales() ) {
+    return false;
+  }
   std::vector< double > uncertaintyScales;
   if ( !this->GetUncertaintyScales( uncertaintyScales ) ) {
     return false;
@@ -983,24 +1177,18 @@ bool GaussianProcessEmulator::SingleModel::GetEmulatorOutputs (
   assert(m_RegressionOrder >= 0);
   // copy the point from vector<double> into VectorXd
   Eigen::VectorXd point = Eigen::Map<const Eigen::VectorXd>(&(x[0]),x.size());
-  int N = m_Parent->m_NumberTrainingPoints;
+  assert(m_Parent->m_NumberParameters > 0);
+  Eigen::VectorXd kplus; // kplus is C(x,D)
+  this->GetTrainingPointCovariances(point, kplus);
+  mean = this->GetEmulatorMean(point, kplus);
+  return true;
+}
+
+double GaussianProcessEmulator::SingleModel::GetEmulatorMean (
+    const Eigen::VectorXd & point,
+    const Eigen::VectorXd & kplus) const {
   int p = m_Parent->m_NumberParameters;
-  assert(p > 0);
   int F = 1 + (m_RegressionOrder * p);
-  const Eigen::MatrixXd & X = m_Parent->m_TrainingParameterValues;
-  Eigen::VectorXd kplus(N); // kplus is C(x,D)
-  assert((X.rows() == N) && (X.cols() == p));
-  for (int j = 0; j < N; ++j) {
-    Eigen::VectorXd xrow(p);
-    for (int k = 0; k < p; ++k) {
-      xrow(k) = X(j,k);
-    }
-    // Eigen::VectorXd xrow = X.row(j); /* is buggy? */
-    double cov = this->CovarianceCalc(xrow, point);
-    if(cov < 1e-10)
-      cov = 0.0;
-    kplus(j) = cov;
-  }
   Eigen::VectorXd h_vector(F);
   MakeHVector(point,h_vector,m_RegressionOrder);
 
@@ -1014,8 +1202,7 @@ bool GaussianProcessEmulator::SingleModel::GetEmulatorOutputs (
   // m_BetaVector
   //      = m_RegressionMatrix1 * HMatrix.transpose() * m_CInverse * m_ZValues;
   // m_GammaVector = m_CInverse * (m_ZValues - (HMatrix * m_BetaVector));
-  mean = h_vector.dot(m_BetaVector) + kplus.dot(m_GammaVector);
-  return true;
+  return h_vector.dot(m_BetaVector) + kplus.dot(m_GammaVector);
 }
 
 bool GaussianProcessEmulator::SingleModel::GetGradientOfEmulatorOutputs(
@@ -1079,6 +1266,54 @@ bool GaussianProcessEmulator::GetEmulatorOutputs (
   return true;
 }
 
+bool GaussianProcessEmulator::GetEmulatorOutputsOfPartialUpdate (
+    const std::vector< double > & x,
+    const std::vector< double > & previousX,
+    const std::vector< unsigned int > & changedParameters,
+    std::vector< Eigen::VectorXd > & distancesSquared,
+    std::vector< double > & y) const
+{
+  if (m_Status != READY) {
+    std::cerr << "GetEmulatorOutputsOfPartialUpdate ERROR."
+      " GaussianProcessEmulator is not ready.\n";
+    return false;
+  }
+  Eigen::Map<const Eigen::VectorXd> point(&(x[0]),x.size());
+  bool fromScratch = (previousX.size() != x.size()) ||
+    (static_cast< int >(distancesSquared.size()) != m_NumberPCAOutputs);
+  for (size_t i = 0; !fromScratch && i < distancesSquared.size(); ++i) {
+    fromScratch = (distancesSquared[i].size() != m_NumberTrainingPoints);
+  }
+  if (fromScratch) {
+    distancesSquared.resize(m_NumberPCAOutputs);
+  }
+
+  Eigen::VectorXd mean_pca(m_NumberPCAOutputs);
+#if defined( OPENMP_FOUND )
+  #pragma omp parallel for
+#endif // OPENMP_FOUND
+  for (int i = 0; i < m_NumberPCAOutputs; ++i) {
+    const SingleModel & model = m_PCADecomposedModels[i];
+    if (fromScratch) {
+      model.GetTrainingPointDistancesSquared(point, distancesSquared[i]);
+    } else {
+      Eigen::Map<const Eigen::VectorXd> previousPoint(
+        &(previousX[0]), previousX.size());
+      model.UpdateTrainingPointDistancesSquared(
+        point, previousPoint, changedParameters, distancesSquared[i]);
+    }
+    Eigen::VectorXd kplus;
+    model.GetTrainingPointCovariancesFromDistancesSquared(
+      distancesSquared[i], kplus);
+    mean_pca(i) = model.GetEmulatorMean(point, kplus);
+  }
+  y.resize(m_NumberOutputs);
+  Eigen::Map< Eigen::VectorXd > mean(&(y[0]),m_NumberOutputs);
+  mean = m_TrainingOutputMeans +
+    m_UncertaintyScales.cwiseProduct(m_RetainedPCAEigenvectors * mean_pca);
+  return true;
+}
+
 bool GaussianProcessEmulator::GetGradientOfEmulatorOutputs(
     const std::vector< double > & x,
     std::vector< double > & gradients ) const
@@ -1116,20 +1351,12 @@ bool GaussianProcessEmulator::SingleModel
     double & variance) const {
   assert(m_RegressionOrder >= 0);
   Eigen::VectorXd point = Eigen::Map<const Eigen::VectorXd>(&(x[0]),x.size());
-  int N = m_Parent->m_NumberTrainingPoints;
   int p = m_Parent->m_NumberParameters;
   assert(p > 0);
   int F = 1 + (m_RegressionOrder * p);
-  const Eigen::MatrixXd & X = m_Parent->m_TrainingParameterValues;
-  Eigen::VectorXd kplus(N);
+  Eigen::VectorXd kplus;
   // kplus is C(x,D)
-  for (int j = 0; j < N; ++j) {
-    Eigen::VectorXd xrow = X.row(j);
-    double cov = this->CovarianceCalc(xrow, point);
-    if(cov < 1e-10)
-      cov = 0.0;
-    kplus(j) = cov;
-  }
+  this->GetTrainingPointCovariances(point, kplus);
   Eigen::VectorXd h_vector(F);
   MakeHVector(point,h_vector,m_RegressionOrder);
   // m_CInverse = CMatrix.ldlt().solve(Eigen::MatrixXd::Identity(N,N));
@@ -1178,13 +1405,8 @@ bool GaussianProcessEmulator::SingleModel
     this->GetGradientOfCovarianceCalc( point, X.row(i), Grad  );
     cov_grad.col(i) = Grad;
   }
-  Eigen::VectorXd kplus(N);
-  for (int j = 0; j < N; ++j) {
-    double cov = this->CovarianceCalc( X.row(j), point);
-    if(cov < 1e-10)
-      cov = 0.0;
-    kplus(j) = cov;
-  }
+  Eigen::VectorXd kplus;
+  this->GetTrainingPointCovariances(point, kplus);
   // Get gradients of h_vector
   Eigen::MatrixXd h_v_Grad; // p,(1+ro*p)
   GetGradientOfHVector(point, h_v_Grad, m_RegressionOrder);
@@ -48,7 +48,11 @@ namespace madai {
  * process. These hyperparameters influence a covariance function that
  * specifies the covariance of the outputs. Currently, training
  * involves setting each of the weights proportional to the absolute
- * difference of the interquartile range. */
+ * difference of the interquartile range.
+ *
+ * Once MakeCache() has succeeded, the const methods do not modify the
+ * emulator, so a single emulator may be evaluated from several
+ * threads at once. */
 class GaussianProcessEmulator
 {
 
@@ -182,6 +186,33 @@ public:
     const std::vector< double > & x,
     std::vector< double > & y) const;
 
+  /**
+   * Execute the model at an input point x that differs from the
+   * point previousX only in some parameters.
+   *
+   * The covariance functions depend on the scaled squared distances
+   * between x and the training points, which are sums over the
+   * parameter dimensions. Given the distances at previousX, only the
+   * terms of the changed parameters have to be recomputed.
+   *
+   * \param x Point in parameter space where emulator should be
+   * evaluated.
+   * \param previousX Point at which distancesSquared were computed.
+   * \param changedParameters Indices of the parameters in which x and
+   * previousX differ.
+   * \param distancesSquared The distances to the training points for
+   * each retained principal component, at previousX on entry and at x
+   * on return. If they do not have the right sizes, for instance
+   * because they are empty, they are computed from scratch.
+   * \param y Function value at x.
+   */
+  bool GetEmulatorOutputsOfPartialUpdate (
+    const std::vector< double > & x,
+    const std::vector< double > & previousX,
+    const std::vector< unsigned int > & changedParameters,
+    std::vector< Eigen::VectorXd > & distancesSquared,
+    std::vector< double > & y) const;
+
   /**
    * Execute the model at an input point x.
    *
@@ -219,6 +250,41 @@ public:
     const std::vector< double > & x,
     std::vector< Eigen::MatrixXd > & gradients) const;
 
+  /**
+   * Condition the emulator on fixed values of some of the parameters.
+   *
+   * The covariance functions depend on the scaled squared distance
+   * between two points, which is a sum over the parameter
+   * dimensions. The contribution of the fixed dimensions to the
+   * distance to each training point is computed once here, so that
+   * evaluating the emulator only loops over the active
+   * dimensions. Points whose fixed coordinates differ from the
+   * conditioned values are evaluated without the shortcut.
+   *
+   * This modifies the emulator, so it must not be called while other
+   * threads are evaluating it. MakeCache() clears the conditioning.
+   *
+   * \param activeParameters Which parameters vary. The others are
+   * fixed.
+   * \param values Point in parameter space holding the values of the
+   * fixed parameters.
+   * \return False if the emulator is not ready or a vector has the
+   * wrong length, true otherwise.
+   */
+  bool ConditionOnFixedParameters(
+    const std::vector< bool > & activeParameters,
+    const std::vector< double > & values);
+
+  /**
+   * Remove the conditioning set by ConditionOnFixedParameters().
+   */
+  void ClearFixedParameters();
+
+  /**
+   * \return True if ConditionOnFixedParameters() is in effect.
+   */
+  bool IsConditionedOnFixedParameters() const;
+
   /**
    * Check status of the emulator.
    *
@@ -244,8 +310,12 @@ public:
    * principal component analysis.  They are the sum of the training
    * output variances squared and the observed variances squared.
    *
+   * The scales are built by PrincipalComponentDecompose(),
+   * BuildZVectors() or MakeCache(), or are read with the PCA
+   * decomposition.
+   *
    * \param x Storage for the uncertainty scales.
-   * \return False if uncertainty scales could not be computed, true otherwise.
+   * \return False if uncertainty scales have not been built, true otherwise.
    */
   bool GetUncertaintyScales(std::vector< double > & x) const;
 
@@ -380,6 +450,17 @@ public:
   Eigen::MatrixXd m_PCAEigenvectors;
   //@}
 
+  //@{
+  /**
+   * Indices and values of the parameters fixed by
+   * ConditionOnFixedParameters(), and indices of the remaining active
+   * parameters. Empty when the emulator is not conditioned.
+   */
+  std::vector< int > m_FixedParameterIndices;
+  Eigen::VectorXd m_FixedParameterValues;
+  std::vector< int > m_ConditionedActiveParameterIndices;
+  //@}
+
 protected:
 
   /**
@@ -388,6 +469,12 @@ protected:
    */
   bool BuildUncertaintyScales();
 
+  /**
+   * Check whether the fixed coordinates of a point match the values
+   * given to ConditionOnFixedParameters().
+   */
+  bool MatchesFixedParameters(const Eigen::VectorXd & point) const;
+
 public:
 
   /**
@@ -408,6 +495,51 @@ public:
         const Eigen::VectorXd & v1,
         const Eigen::VectorXd & v2) const;
 
+    /**
+     * Calulate the covariance between two points from their scaled
+     * squared distance, using m_Thetas and m_CovarianceFunction.
+     */
+    double CovarianceFromDistanceSquared(double distanceSquared) const;
+
+    /**
+     * Calculate the covariance between a point and each of the
+     * training points, C(x,D). Uses m_FixedDistancesSquared when the
+     * emulator is conditioned on fixed values that match the point.
+     *
+     * \param point Point in parameter space.
+     * \param kplus Storage for the m_NumberTrainingPoints covariances.
+     */
+    void GetTrainingPointCovariances(
+        const Eigen::VectorXd & point,
+        Eigen::VectorXd & kplus) const;
+
+    /**
+     * Calculate the scaled squared distance between a point and each
+     * of the training points. Uses m_FixedDistancesSquared when the
+     * emulator is conditioned on fixed values that match the point.
+     */
+    void GetTrainingPointDistancesSquared(
+        const Eigen::VectorXd & point,
+        Eigen::VectorXd & distancesSquared) const;
+
+    /**
+     * Update the scaled squared distances to the training points from
+     * previousPoint to point, which differ only in changedParameters.
+     */
+    void UpdateTrainingPointDistancesSquared(
+        const Eigen::VectorXd & point,
+        const Eigen::VectorXd & previousPoint,
+        const std::vector< unsigned int > & changedParameters,
+        Eigen::VectorXd & distancesSquared) const;
+
+    /**
+     * Calculate C(x,D) from the scaled squared distances between x
+     * and the training points.
+     */
+    void GetTrainingPointCovariancesFromDistancesSquared(
+        const Eigen::VectorXd & distancesSquared,
+        Eigen::VectorXd & kplus) const;
+
     /**
      * Get the gradient of the covariance function between two points
      * in parametespace using m_Thetas and m_CovarianceFunction.
@@ -473,6 +605,14 @@ public:
         const std::vector< double > & x,
         double & mean) const;
 
+    /**
+     * Get the output mean at a point from the covariances between the
+     * point and the training points, C(x,D).
+     */
+    double GetEmulatorMean(
+        const Eigen::VectorXd & point,
+        const Eigen::VectorXd & kplus) const;
+
     /**
      * Get the gradient of the model outputs at an input point x.
      */
@@ -539,6 +679,14 @@ public:
     //  [N]  m_GammaVector
     //        = m_CInverse * (m_ZValues - (HMatrix * m_BetaVector));
     //@}
+
+    /**
+     * Contribution of the parameters fixed by
+     * GaussianProcessEmulator::ConditionOnFixedParameters() to the
+     * scaled squared distance between the fixed values and each
+     * training point. Empty when the emulator is not conditioned.
+     */
+    Eigen::VectorXd m_FixedDistancesSquared;
   };
 
   /**
@@ -0,0 +1,749 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "HamiltonianMonteCarloSampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+/** Trajectories whose energy grows by more than this have diverged. */
+const double MAXIMUM_ENERGY_ERROR = 1000.0;
+
+//@{
+/** Dual averaging constants recommended by Hoffman and Gelman. */
+const double DUAL_AVERAGING_GAMMA = 0.05;
+const double DUAL_AVERAGING_T0 = 10.0;
+const double DUAL_AVERAGING_KAPPA = 0.75;
+//@}
+
+//@{
+/** Mass matrix windows: samples before the first window, samples
+ * after the last window, and size of the first window. */
+const unsigned int INITIAL_BUFFER = 75;
+const unsigned int TERMINAL_BUFFER = 50;
+const unsigned int BASE_WINDOW = 25;
+//@}
+
+inline bool IsFinite( double x )
+{
+  return ( std::fabs( x ) <= std::numeric_limits< double >::max() );
+}
+
+} // end anonymous namespace
+
+
+namespace madai {
+
+
+HamiltonianMonteCarloSampler
+::HamiltonianMonteCarloSampler() :
+  Sampler(),
+  m_NumberOfAdaptationSamples( 0 ),
+  m_NumberOfAdaptedSamples( 0 ),
+  m_TargetAcceptanceRate( 0.8 ),
+  m_StepSize( 0.1 ),
+  m_NumberOfLeapfrogSteps( 20 ),
+  m_UseNoUTurn( true ),
+  m_MaximumTreeDepth( 10 ),
+  m_DualAveragingMu( 0.0 ),
+  m_DualAveragingHBar( 0.0 ),
+  m_LogStepSizeBar( 0.0 ),
+  m_DualAveragingCount( 0 ),
+  m_WindowCount( 0 ),
+  m_WindowEnd( 0 ),
+  m_WindowSize( 0 ),
+  m_LastWindowEnd( 0 ),
+  m_NumberOfDivergences( 0 ),
+  m_NumberOfStepsInLastSample( 0 )
+{
+}
+
+
+HamiltonianMonteCarloSampler
+::~HamiltonianMonteCarloSampler()
+{
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+
+  Sampler::Initialize( model );
+
+  unsigned int numberOfParameters = model->GetNumberOfParameters();
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  m_InverseMassMatrix.resize( numberOfParameters );
+  for ( unsigned int i = 0; i < numberOfParameters; i++ ) {
+    const Distribution * priorDist = params[i].GetPriorDistribution();
+    // Random initial starting point
+    m_CurrentParameters[i] = priorDist->GetSample( m_Random );
+    double scale =
+      priorDist->GetPercentile( 0.75 ) - priorDist->GetPercentile( 0.25 );
+    m_InverseMassMatrix[i] = scale * scale;
+  }
+  m_InitialInverseMassMatrix = m_InverseMassMatrix;
+  m_NumberOfAdaptedSamples = 0;
+  m_NumberOfDivergences = 0;
+
+  this->ParameterSetExternally();
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::ParameterSetExternally()
+{
+  if ( m_Model == NULL ||
+       m_CurrentParameters.size() != m_Model->GetNumberOfParameters() ) {
+    return;
+  }
+
+  m_ActiveIndices.clear();
+  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      m_ActiveIndices.push_back( i );
+    }
+  }
+
+  PhasePoint point;
+  point.m_Parameters = m_CurrentParameters;
+  this->Evaluate( point );
+  this->SetCurrentPhasePoint( point );
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::SetStepSize( double stepSize )
+{
+  m_StepSize = stepSize;
+}
+
+
+double
+HamiltonianMonteCarloSampler
+::GetStepSize() const
+{
+  return m_StepSize;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::SetNumberOfLeapfrogSteps( unsigned int numberOfSteps )
+{
+  m_NumberOfLeapfrogSteps = std::max( numberOfSteps, 1u );
+}
+
+
+unsigned int
+HamiltonianMonteCarloSampler
+::GetNumberOfLeapfrogSteps() const
+{
+  return m_NumberOfLeapfrogSteps;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::SetUseNoUTurn( bool useNoUTurn )
+{
+  m_UseNoUTurn = useNoUTurn;
+}
+
+
+bool
+HamiltonianMonteCarloSampler
+::GetUseNoUTurn() const
+{
+  return m_UseNoUTurn;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::SetMaximumTreeDepth( unsigned int depth )
+{
+  m_MaximumTreeDepth = depth;
+}
+
+
+unsigned int
+HamiltonianMonteCarloSampler
+::GetMaximumTreeDepth() const
+{
+  return m_MaximumTreeDepth;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::SetNumberOfAdaptationSamples( unsigned int numberOfSamples )
+{
+  m_NumberOfAdaptationSamples = numberOfSamples;
+}
+
+
+unsigned int
+HamiltonianMonteCarloSampler
+::GetNumberOfAdaptationSamples() const
+{
+  return m_NumberOfAdaptationSamples;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::SetTargetAcceptanceRate( double rate )
+{
+  m_TargetAcceptanceRate = rate;
+}
+
+
+double
+HamiltonianMonteCarloSampler
+::GetTargetAcceptanceRate() const
+{
+  return m_TargetAcceptanceRate;
+}
+
+
+bool
+HamiltonianMonteCarloSampler
+::IsAdapting() const
+{
+  return ( !m_AdaptationEnded &&
+           m_NumberOfAdaptedSamples < m_NumberOfAdaptationSamples );
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::EndAdaptation()
+{
+  // Keep the averaged step size, as at the end of the adaptation. A
+  // variance window still open is dropped.
+  if ( this->IsAdapting() && m_NumberOfAdaptedSamples > 0 ) {
+    m_StepSize = std::exp( m_LogStepSizeBar );
+  }
+  Sampler::EndAdaptation();
+}
+
+
+const std::vector< double > &
+HamiltonianMonteCarloSampler
+::GetInverseMassMatrix() const
+{
+  return m_InverseMassMatrix;
+}
+
+
+unsigned int
+HamiltonianMonteCarloSampler
+::GetNumberOfDivergences() const
+{
+  return m_NumberOfDivergences;
+}
+
+
+unsigned int
+HamiltonianMonteCarloSampler
+::GetNumberOfStepsInLastSample() const
+{
+  return m_NumberOfStepsInLastSample;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "HamiltonianMonteCarloSampler" );
+  o << m_NumberOfAdaptedSamples << ' ';
+  WriteValue( o, m_StepSize );
+  o << '\n';
+  WriteValues( o, m_InverseMassMatrix );
+  WriteIntegers( o, m_ActiveIndices );
+  WriteMatrix( o, m_CurrentGradient );
+  WriteValue( o, m_DualAveragingMu );
+  o << ' ';
+  WriteValue( o, m_DualAveragingHBar );
+  o << ' ';
+  WriteValue( o, m_LogStepSizeBar );
+  o << ' ' << m_DualAveragingCount << '\n';
+  WriteValues( o, m_WindowMean );
+  WriteValues( o, m_WindowSumOfSquares );
+  o << m_WindowCount << ' ' << m_WindowEnd << ' ' << m_WindowSize << ' '
+    << m_LastWindowEnd << ' ' << m_NumberOfDivergences << ' '
+    << m_NumberOfStepsInLastSample << '\n';
+}
+
+
+bool
+HamiltonianMonteCarloSampler
+::ReadState( std::istream & i )
+{
+  return ( Sampler::ReadState( i ) &&
+           ReadTag( i, "HamiltonianMonteCarloSampler" ) &&
+           ( i >> m_NumberOfAdaptedSamples ) &&
+           ReadValue( i, m_StepSize ) &&
+           ReadValues( i, m_InverseMassMatrix ) &&
+           ReadIntegers( i, m_ActiveIndices ) &&
+           ReadMatrix( i, m_CurrentGradient ) &&
+           ReadValue( i, m_DualAveragingMu ) &&
+           ReadValue( i, m_DualAveragingHBar ) &&
+           ReadValue( i, m_LogStepSizeBar ) &&
+           ( i >> m_DualAveragingCount ) &&
+           ReadValues( i, m_WindowMean ) &&
+           ReadValues( i, m_WindowSumOfSquares ) &&
+           ( i >> m_WindowCount >> m_WindowEnd >> m_WindowSize
+               >> m_LastWindowEnd >> m_NumberOfDivergences
+               >> m_NumberOfStepsInLastSample ) &&
+           m_InverseMassMatrix.size() == m_CurrentParameters.size() );
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::GetCurrentPhasePoint( PhasePoint & point ) const
+{
+  point.m_Parameters = m_CurrentParameters;
+  point.m_Outputs = m_CurrentOutputs;
+  point.m_LogLikelihood = m_CurrentLogLikelihood;
+  point.m_Gradient = m_CurrentGradient;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::SetCurrentPhasePoint( const PhasePoint & point )
+{
+  m_CurrentParameters = point.m_Parameters;
+  m_CurrentOutputs = point.m_Outputs;
+  m_CurrentLogLikelihood = point.m_LogLikelihood;
+  m_CurrentGradient = point.m_Gradient;
+}
+
+
+bool
+HamiltonianMonteCarloSampler
+::Evaluate( PhasePoint & point ) const
+{
+  std::vector< double > gradient;
+  Model::ErrorType error = m_Model->GetScalarOutputsAndLogLikelihoodAndGradient(
+    point.m_Parameters, m_ActiveParameterIndices, point.m_Outputs,
+    point.m_LogLikelihood, gradient );
+
+  int d = static_cast< int >( m_ActiveIndices.size() );
+  point.m_Gradient = Eigen::VectorXd::Zero( d );
+  if ( error != Model::NO_ERROR ||
+       static_cast< int >( gradient.size() ) != d ||
+       !IsFinite( point.m_LogLikelihood ) ) {
+    point.m_LogLikelihood = -std::numeric_limits< double >::infinity();
+    return false;
+  }
+  for ( int k = 0; k < d; ++k ) {
+    if ( !IsFinite( gradient[k] ) ) {
+      return false;
+    }
+    point.m_Gradient( k ) = gradient[k];
+  }
+  return true;
+}
+
+
+bool
+HamiltonianMonteCarloSampler
+::Leapfrog( PhasePoint & point, double stepSize ) const
+{
+  point.m_Momentum += ( 0.5 * stepSize ) * point.m_Gradient;
+  for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+    unsigned int i = m_ActiveIndices[k];
+    point.m_Parameters[i] +=
+      stepSize * m_InverseMassMatrix[i] * point.m_Momentum( k );
+  }
+  if ( !this->Evaluate( point ) ) {
+    return false;
+  }
+  point.m_Momentum += ( 0.5 * stepSize ) * point.m_Gradient;
+  return true;
+}
+
+
+double
+HamiltonianMonteCarloSampler
+::GetHamiltonian( const PhasePoint & point ) const
+{
+  double kineticEnergy = 0.0;
+  for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+    double r = point.m_Momentum( k );
+    kineticEnergy += 0.5 * m_InverseMassMatrix[ m_ActiveIndices[k] ] * r * r;
+  }
+  return kineticEnergy - point.m_LogLikelihood;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::DrawMomentum( PhasePoint & point )
+{
+  int d = static_cast< int >( m_ActiveIndices.size() );
+  point.m_Momentum.resize( d );
+  for ( int k = 0; k < d; ++k ) {
+    point.m_Momentum( k ) = m_Random.Gaussian() /
+      std::sqrt( m_InverseMassMatrix[ m_ActiveIndices[k] ] );
+  }
+}
+
+
+bool
+HamiltonianMonteCarloSampler
+::IsNotUTurn( const PhasePoint & minus, const PhasePoint & plus ) const
+{
+  // The criterion uses velocities, so it is invariant to the scales
+  // of the parameters.
+  double minusProduct = 0.0;
+  double plusProduct = 0.0;
+  for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+    unsigned int i = m_ActiveIndices[k];
+    double span = plus.m_Parameters[i] - minus.m_Parameters[i];
+    minusProduct += span * m_InverseMassMatrix[i] * minus.m_Momentum( k );
+    plusProduct += span * m_InverseMassMatrix[i] * plus.m_Momentum( k );
+  }
+  return ( minusProduct >= 0.0 && plusProduct >= 0.0 );
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::BuildTree( const PhasePoint & start, double logSlice, int direction,
+             unsigned int depth, double initialHamiltonian,
+             Tree & tree )
+{
+  if ( depth == 0 ) {
+    // Base case: one leapfrog step.
+    tree.m_Minus = start;
+    bool valid = this->Leapfrog( tree.m_Minus, direction * m_StepSize );
+    double hamiltonian = valid ? this->GetHamiltonian( tree.m_Minus ) :
+      std::numeric_limits< double >::infinity();
+    tree.m_NumberOfValidPoints =
+      ( valid && logSlice <= -hamiltonian ) ? 1.0 : 0.0;
+    tree.m_Continue =
+      ( valid && logSlice < MAXIMUM_ENERGY_ERROR - hamiltonian );
+    if ( !tree.m_Continue ) {
+      ++m_NumberOfDivergences;
+    }
+    tree.m_SumAcceptance = valid ?
+      std::min( 1.0, std::exp( initialHamiltonian - hamiltonian ) ) : 0.0;
+    tree.m_NumberOfSteps = 1;
+    tree.m_Plus = tree.m_Minus;
+    tree.m_Proposal = tree.m_Minus;
+    return;
+  }
+
+  // Build the first half, then the second half from its far end.
+  this->BuildTree( start, logSlice, direction, depth - 1,
+                   initialHamiltonian, tree );
+  if ( !tree.m_Continue ) {
+    return;
+  }
+
+  Tree subtree;
+  this->BuildTree( ( direction < 0 ) ? tree.m_Minus : tree.m_Plus,
+                   logSlice, direction, depth - 1, initialHamiltonian,
+                   subtree );
+  if ( direction < 0 ) {
+    tree.m_Minus = subtree.m_Minus;
+  } else {
+    tree.m_Plus = subtree.m_Plus;
+  }
+
+  double numberOfValidPoints =
+    tree.m_NumberOfValidPoints + subtree.m_NumberOfValidPoints;
+  if ( numberOfValidPoints > 0.0 &&
+       m_Random.Uniform() <
+       subtree.m_NumberOfValidPoints / numberOfValidPoints ) {
+    tree.m_Proposal = subtree.m_Proposal;
+  }
+  tree.m_NumberOfValidPoints = numberOfValidPoints;
+  tree.m_SumAcceptance += subtree.m_SumAcceptance;
+  tree.m_NumberOfSteps += subtree.m_NumberOfSteps;
+  tree.m_Continue = subtree.m_Continue &&
+    this->IsNotUTurn( tree.m_Minus, tree.m_Plus );
+}
+
+
+double
+HamiltonianMonteCarloSampler
+::StaticTrajectory( PhasePoint & current )
+{
+  this->DrawMomentum( current );
+  double initialHamiltonian = this->GetHamiltonian( current );
+
+  // Jitter the step size so that a fixed number of steps does not
+  // keep landing on the same part of a periodic orbit.
+  double stepSize = m_StepSize * ( 0.8 + 0.4 * m_Random.Uniform() );
+
+  PhasePoint candidate( current );
+  m_NumberOfStepsInLastSample = 0;
+  for ( unsigned int step = 0; step < m_NumberOfLeapfrogSteps; ++step ) {
+    ++m_NumberOfStepsInLastSample;
+    if ( !this->Leapfrog( candidate, stepSize ) ) {
+      ++m_NumberOfDivergences;
+      return 0.0;
+    }
+  }
+
+  double acceptance = std::min(
+    1.0, std::exp( initialHamiltonian - this->GetHamiltonian( candidate ) ) );
+  if ( acceptance > m_Random.Uniform() ) {
+    current = candidate;
+  }
+  return acceptance;
+}
+
+
+double
+HamiltonianMonteCarloSampler
+::NoUTurnTrajectory( PhasePoint & current )
+{
+  this->DrawMomentum( current );
+  double initialHamiltonian = this->GetHamiltonian( current );
+  double logSlice = std::log( m_Random.Uniform() ) - initialHamiltonian;
+
+  PhasePoint minus( current );
+  PhasePoint plus( current );
+  double numberOfValidPoints = 1.0;
+  double sumAcceptance = 0.0;
+  m_NumberOfStepsInLastSample = 0;
+
+  bool keepGoing = true;
+  for ( unsigned int depth = 0;
+        keepGoing && depth < m_MaximumTreeDepth; ++depth ) {
+    int direction = ( m_Random.Uniform() < 0.5 ) ? -1 : 1;
+    Tree tree;
+    if ( direction < 0 ) {
+      this->BuildTree( minus, logSlice, direction, depth,
+                       initialHamiltonian, tree );
+      minus = tree.m_Minus;
+    } else {
+      this->BuildTree( plus, logSlice, direction, depth,
+                       initialHamiltonian, tree );
+      plus = tree.m_Plus;
+    }
+    sumAcceptance += tree.m_SumAcceptance;
+    m_NumberOfStepsInLastSample += tree.m_NumberOfSteps;
+
+    if ( tree.m_Continue &&
+         m_Random.Uniform() < tree.m_NumberOfValidPoints / numberOfValidPoints ) {
+      current = tree.m_Proposal;
+    }
+    numberOfValidPoints += tree.m_NumberOfValidPoints;
+    keepGoing = tree.m_Continue && this->IsNotUTurn( minus, plus );
+  }
+
+  return sumAcceptance / m_NumberOfStepsInLastSample;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::FindReasonableStepSize()
+{
+  // Algorithm 4 of Hoffman and Gelman: double or halve the step size
+  // until the acceptance probability of one step crosses 1/2.
+  PhasePoint current;
+  this->GetCurrentPhasePoint( current );
+  this->DrawMomentum( current );
+  double initialHamiltonian = this->GetHamiltonian( current );
+  static const double LOG_HALF = std::log( 0.5 );
+
+  int direction = 0;
+  for ( int iteration = 0; iteration < 100; ++iteration ) {
+    PhasePoint point( current );
+    double logAcceptance = -std::numeric_limits< double >::infinity();
+    if ( this->Leapfrog( point, m_StepSize ) ) {
+      logAcceptance = initialHamiltonian - this->GetHamiltonian( point );
+    }
+    if ( direction == 0 ) {
+      direction = ( logAcceptance > LOG_HALF ) ? 1 : -1;
+    }
+    if ( ( direction > 0 && !( logAcceptance > LOG_HALF ) ) ||
+         ( direction < 0 && !( logAcceptance < LOG_HALF ) ) ) {
+      break;
+    }
+    m_StepSize *= ( direction > 0 ) ? 2.0 : 0.5;
+  }
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::RestartStepSizeAdaptation()
+{
+  m_DualAveragingMu = std::log( 10.0 * m_StepSize );
+  m_DualAveragingHBar = 0.0;
+  m_LogStepSizeBar = std::log( m_StepSize );
+  m_DualAveragingCount = 0;
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::StartAdaptation()
+{
+  // Windows as in Stan: a buffer for the chain to reach the typical
+  // set, windows that double in size for the variance, and a buffer
+  // to tune the step size to the final mass matrix.
+  unsigned int initialBuffer = INITIAL_BUFFER;
+  unsigned int terminalBuffer = TERMINAL_BUFFER;
+  unsigned int baseWindow = BASE_WINDOW;
+  if ( m_NumberOfAdaptationSamples < 20 ) {
+    // Too short to estimate a variance.
+    initialBuffer = m_NumberOfAdaptationSamples;
+    terminalBuffer = 0;
+    baseWindow = 0;
+  } else if ( initialBuffer + terminalBuffer + baseWindow >
+              m_NumberOfAdaptationSamples ) {
+    initialBuffer = static_cast< unsigned int >( 0.15 * m_NumberOfAdaptationSamples );
+    terminalBuffer = static_cast< unsigned int >( 0.1 * m_NumberOfAdaptationSamples );
+    baseWindow = m_NumberOfAdaptationSamples - initialBuffer - terminalBuffer;
+  }
+  m_WindowSize = baseWindow;
+  m_WindowEnd = initialBuffer + baseWindow;
+  m_LastWindowEnd = m_NumberOfAdaptationSamples - terminalBuffer;
+
+  m_WindowMean.assign( m_Model->GetNumberOfParameters(), 0.0 );
+  m_WindowSumOfSquares.assign( m_Model->GetNumberOfParameters(), 0.0 );
+  m_WindowCount = 0;
+
+  this->FindReasonableStepSize();
+  this->RestartStepSizeAdaptation();
+}
+
+
+void
+HamiltonianMonteCarloSampler
+::Adapt( double acceptanceStatistic )
+{
+  unsigned int index = m_NumberOfAdaptedSamples++;
+
+  // Dual averaging of the log step size.
+  ++m_DualAveragingCount;
+  double count = static_cast< double >( m_DualAveragingCount );
+  double eta = 1.0 / ( count + DUAL_AVERAGING_T0 );
+  m_DualAveragingHBar = ( 1.0 - eta ) * m_DualAveragingHBar +
+    eta * ( m_TargetAcceptanceRate - acceptanceStatistic );
+  double logStepSize = m_DualAveragingMu -
+    std::sqrt( count ) / DUAL_AVERAGING_GAMMA * m_DualAveragingHBar;
+  double weight = std::pow( count, -DUAL_AVERAGING_KAPPA );
+  m_LogStepSizeBar = weight * logStepSize + ( 1.0 - weight ) * m_LogStepSizeBar;
+  m_StepSize = std::exp( logStepSize );
+
+  // Accumulate the variance of the chain inside a window.
+  if ( m_WindowSize > 0 && index < m_WindowEnd &&
+       index + m_WindowSize >= m_WindowEnd ) {
+    ++m_WindowCount;
+    for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+      unsigned int i = m_ActiveIndices[k];
+      double delta = m_CurrentParameters[i] - m_WindowMean[i];
+      m_WindowMean[i] += delta / m_WindowCount;
+      m_WindowSumOfSquares[i] +=
+        delta * ( m_CurrentParameters[i] - m_WindowMean[i] );
+    }
+
+    if ( index + 1 == m_WindowEnd ) {
+      // Shrink the estimate toward the initial mass matrix, which
+      // matters for short windows.
+      double n = static_cast< double >( m_WindowCount );
+      for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+        unsigned int i = m_ActiveIndices[k];
+        double variance = m_WindowSumOfSquares[i] / ( n - 1.0 );
+        m_InverseMassMatrix[i] = ( n / ( n + 5.0 ) ) * variance +
+          1.0e-3 * ( 5.0 / ( n + 5.0 ) ) * m_InitialInverseMassMatrix[i];
+      }
+      m_WindowMean.assign( m_WindowMean.size(), 0.0 );
+      m_WindowSumOfSquares.assign( m_WindowSumOfSquares.size(), 0.0 );
+      m_WindowCount = 0;
+
+      // The next window is twice as large, unless the one after it
+      // would not fit, in which case it runs to the last window end.
+      if ( m_WindowEnd >= m_LastWindowEnd ) {
+        m_WindowSize = 0;
+      } else {
+        unsigned int nextEnd = m_WindowEnd + 2 * m_WindowSize;
+        if ( nextEnd + 4 * m_WindowSize > m_LastWindowEnd ) {
+          nextEnd = m_LastWindowEnd;
+        }
+        m_WindowSize = nextEnd - m_WindowEnd;
+        m_WindowEnd = nextEnd;
+      }
+
+      this->FindReasonableStepSize();
+      this->RestartStepSizeAdaptation();
+    }
+  }
+
+  if ( !this->IsAdapting() ) {
+    m_StepSize = std::exp( m_LogStepSizeBar );
+  }
+}
+
+
+Sample
+HamiltonianMonteCarloSampler
+::NextSample()
+{
+  // Start over if the set of active parameters has changed.
+  if ( this->ActiveIndicesChanged( m_ActiveIndices ) ) {
+    this->ParameterSetExternally();
+  }
+
+  if ( this->IsAdapting() && m_NumberOfAdaptedSamples == 0 ) {
+    this->StartAdaptation();
+  }
+
+  PhasePoint current;
+  this->GetCurrentPhasePoint( current );
+  double acceptanceStatistic = m_UseNoUTurn ?
+    this->NoUTurnTrajectory( current ) : this->StaticTrajectory( current );
+  this->SetCurrentPhasePoint( current );
+
+  // Check for NaN
+  assert( m_CurrentLogLikelihood == m_CurrentLogLikelihood );
+
+  if ( this->IsAdapting() ) {
+    this->Adapt( acceptanceStatistic );
+  }
+
+  return Sample( m_CurrentParameters,
+                 m_CurrentOutputs,
+                 m_CurrentLogLikelihood );
+}
+
+} // end namespace madai
@@ -0,0 +1,290 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_HamiltonianMonteCarloSampler_h_included
+#define madai_HamiltonianMonteCarloSampler_h_included
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/**
+ * \class HamiltonianMonteCarloSampler
+ *
+ * Hamiltonian Monte Carlo sampler that follows the gradient of the
+ * log likelihood from Model::GetScalarOutputsAndLogLikelihoodAndGradient().
+ *
+ * Each call to NextSample() draws a momentum and integrates
+ * Hamilton's equations with the leapfrog method. With UseNoUTurn off,
+ * the trajectory has NumberOfLeapfrogSteps steps of a randomly
+ * jittered size and its end point is accepted or rejected by the
+ * Metropolis rule. With UseNoUTurn on
+ * (the default), the No-U-Turn sampler of Hoffman and Gelman (2014)
+ * doubles the trajectory until it turns back on itself or reaches
+ * MaximumTreeDepth doublings, and picks the sample among its points.
+ *
+ * During the first NumberOfAdaptationSamples calls to NextSample(),
+ * the step size is tuned by dual averaging so that the mean
+ * acceptance statistic approaches TargetAcceptanceRate, and a
+ * diagonal mass matrix is estimated from the variance of the chain
+ * in a series of growing windows. Afterwards both are fixed, so the
+ * adaptation should be done during burn-in.
+ *
+ * Only the active parameters move. The mass matrix starts out from
+ * the interquartile ranges of the priors.
+ */
+class HamiltonianMonteCarloSampler : public Sampler {
+public:
+  HamiltonianMonteCarloSampler();
+  virtual ~HamiltonianMonteCarloSampler();
+
+  /** Get the next Sample from the distribution. */
+  virtual Sample NextSample();
+
+  //@{
+  /** Set/Get the leapfrog step size. The step size is measured in
+   * units of the interquartile ranges of the priors before the mass
+   * matrix is adapted. The adaptation starts from this value. */
+  void SetStepSize( double stepSize );
+  double GetStepSize() const;
+  //@}
+
+  //@{
+  /** Set/Get the number of leapfrog steps per sample when UseNoUTurn
+   * is off. Defaults to 20. */
+  void SetNumberOfLeapfrogSteps( unsigned int numberOfSteps );
+  unsigned int GetNumberOfLeapfrogSteps() const;
+  //@}
+
+  //@{
+  /** Set/Get whether the trajectory length is chosen by the No-U-Turn
+   * criterion. Defaults to true. */
+  void SetUseNoUTurn( bool useNoUTurn );
+  bool GetUseNoUTurn() const;
+  //@}
+
+  //@{
+  /** Set/Get the maximum number of trajectory doublings of the
+   * No-U-Turn sampler. Defaults to 10. */
+  void SetMaximumTreeDepth( unsigned int depth );
+  unsigned int GetMaximumTreeDepth() const;
+  //@}
+
+  //@{
+  /** Set/Get the number of calls to NextSample() during which the
+   * step size and mass matrix are adapted. Usually the number of
+   * burn-in samples. */
+  void SetNumberOfAdaptationSamples( unsigned int numberOfSamples );
+  unsigned int GetNumberOfAdaptationSamples() const;
+  //@}
+
+  //@{
+  /** Set/Get the mean acceptance statistic that the step size is
+   * tuned toward. Defaults to 0.8. */
+  void SetTargetAcceptanceRate( double rate );
+  double GetTargetAcceptanceRate() const;
+  //@}
+
+  /** Returns true while the step size and mass matrix are being
+   * adapted. */
+  bool IsAdapting() const;
+
+  /** Freeze the mass matrix and take the averaged step size of the
+   * adaptation so far. */
+  virtual void EndAdaptation();
+
+  /** Get the diagonal of the inverse mass matrix, one entry per
+   * parameter. */
+  const std::vector< double > & GetInverseMassMatrix() const;
+
+  /** Get the number of trajectories that diverged since the Model
+   * was set. Many divergences after burn-in mean that the samples are
+   * not to be trusted. */
+  unsigned int GetNumberOfDivergences() const;
+
+  /** Get the number of leapfrog steps, and so Model evaluations,
+   * used by the last call to NextSample(). */
+  unsigned int GetNumberOfStepsInLastSample() const;
+
+  //@{
+  /** The state includes the adapted step size and mass matrix, and
+   * the state of their adaptation. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  /** A point in phase space together with the Model evaluated at its
+   * position. Vectors over the active parameters are Eigen vectors. */
+  struct PhasePoint {
+    std::vector< double > m_Parameters;
+    std::vector< double > m_Outputs;
+    double                m_LogLikelihood;
+    Eigen::VectorXd       m_Gradient;
+    Eigen::VectorXd       m_Momentum;
+  };
+
+  /** A subtree of the No-U-Turn sampler. */
+  struct Tree {
+    PhasePoint m_Minus;
+    PhasePoint m_Plus;
+    PhasePoint m_Proposal;
+
+    /** Number of points inside the slice. */
+    double m_NumberOfValidPoints;
+
+    /** False once the tree has made a U-turn or diverged. */
+    bool m_Continue;
+
+    /** Sum of the acceptance statistics of the points. */
+    double m_SumAcceptance;
+
+    /** Number of leapfrog steps in the tree. */
+    unsigned int m_NumberOfSteps;
+  };
+
+  virtual void Initialize( const Model * model );
+
+  /** Evaluates the Model and the gradient at the new point. */
+  virtual void ParameterSetExternally();
+
+  /** Copy the current state of the Sampler into a point. */
+  void GetCurrentPhasePoint( PhasePoint & point ) const;
+
+  /** Make the position of the point the current state. */
+  void SetCurrentPhasePoint( const PhasePoint & point );
+
+  /** Evaluate the Model at the position of the point. Returns false
+   * if the log likelihood or the gradient is not finite. */
+  bool Evaluate( PhasePoint & point ) const;
+
+  /** Take one leapfrog step. Returns false if the Model cannot be
+   * evaluated at the new position. */
+  bool Leapfrog( PhasePoint & point, double stepSize ) const;
+
+  /** Negative log likelihood plus kinetic energy. */
+  double GetHamiltonian( const PhasePoint & point ) const;
+
+  /** Draw a momentum from the Gaussian with the mass matrix as
+   * covariance. */
+  void DrawMomentum( PhasePoint & point );
+
+  /** Returns true unless the trajectory between the two points has
+   * started to turn back. */
+  bool IsNotUTurn( const PhasePoint & minus, const PhasePoint & plus ) const;
+
+  /** Recursively build a subtree of 2^depth leapfrog steps from
+   * start in the given direction. */
+  void BuildTree( const PhasePoint & start, double logSlice, int direction,
+                  unsigned int depth, double initialHamiltonian,
+                  Tree & tree );
+
+  /** One step of static HMC. Returns the acceptance statistic. */
+  double StaticTrajectory( PhasePoint & current );
+
+  /** One step of the No-U-Turn sampler. Returns the acceptance
+   * statistic. */
+  double NoUTurnTrajectory( PhasePoint & current );
+
+  /** Set up the adaptation windows and the initial step size. */
+  void StartAdaptation();
+
+  /** Find a step size for which one leapfrog step is accepted with
+   * probability about one half. */
+  void FindReasonableStepSize();
+
+  /** Restart the dual averaging from the current step size. */
+  void RestartStepSizeAdaptation();
+
+  /** Update the step size and mass matrix after a sample. */
+  void Adapt( double acceptanceStatistic );
+
+  /** Number of calls to NextSample() with adaptation. */
+  unsigned int m_NumberOfAdaptationSamples;
+
+  /** Number of samples adapted to so far. */
+  unsigned int m_NumberOfAdaptedSamples;
+
+  /** Acceptance statistic targeted by the step size adaptation. */
+  double m_TargetAcceptanceRate;
+
+  /** Leapfrog step size. */
+  double m_StepSize;
+
+  /** Number of leapfrog steps of static HMC. */
+  unsigned int m_NumberOfLeapfrogSteps;
+
+  /** Use the No-U-Turn sampler? */
+  bool m_UseNoUTurn;
+
+  /** Maximum number of doublings of the No-U-Turn sampler. */
+  unsigned int m_MaximumTreeDepth;
+
+  /** Diagonal of the inverse mass matrix over all parameters. */
+  std::vector< double > m_InverseMassMatrix;
+
+  /** Initial inverse mass matrix, used to regularize the estimate. */
+  std::vector< double > m_InitialInverseMassMatrix;
+
+  /** Indices of the active parameters. */
+  std::vector< unsigned int > m_ActiveIndices;
+
+  /** Gradient of the log likelihood at the current point. */
+  Eigen::VectorXd m_CurrentGradient;
+
+  //@{
+  /** Dual averaging state (Hoffman and Gelman 2014, section 3.2). */
+  double m_DualAveragingMu;
+  double m_DualAveragingHBar;
+  double m_LogStepSizeBar;
+  unsigned int m_DualAveragingCount;
+  //@}
+
+  //@{
+  /** Running mean and sum of squared deviations of the parameters in
+   * the current mass matrix window. */
+  std::vector< double > m_WindowMean;
+  std::vector< double > m_WindowSumOfSquares;
+  unsigned int m_WindowCount;
+  //@}
+
+  /** Sample index at which the current mass matrix window ends. */
+  unsigned int m_WindowEnd;
+
+  /** Size of the current mass matrix window. */
+  unsigned int m_WindowSize;
+
+  /** Sample index after which mass matrix windows stop. */
+  unsigned int m_LastWindowEnd;
+
+  /** Number of divergent trajectories. */
+  unsigned int m_NumberOfDivergences;
+
+  /** Number of leapfrog steps of the last sample. */
+  unsigned int m_NumberOfStepsInLastSample;
+
+}; // end class HamiltonianMonteCarloSampler
+
+} // end namespace madai
+
+#endif // madai_HamiltonianMonteCarloSampler_h_included
@@ -0,0 +1,412 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "LBFGSOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "UniformDistribution.h"
+
+
+namespace {
+
+inline bool IsFinite( double x )
+{
+  return ( std::fabs( x ) <= std::numeric_limits< double >::max() );
+}
+
+/** Sufficient decrease constant of the Armijo condition. */
+const double ARMIJO_CONSTANT = 1e-4;
+
+/** Maximum number of halvings of the step in one line search. */
+const unsigned int MAXIMUM_NUMBER_OF_BACKTRACKS = 40;
+
+} // end anonymous namespace
+
+
+namespace madai {
+
+
+LBFGSOptimizer
+::LBFGSOptimizer() :
+  Sampler(),
+  m_MemorySize( 10 ),
+  m_GradientTolerance( 1e-6 ),
+  m_Converged( false ),
+  m_NumberOfIterations( 0 ),
+  m_NumberOfModelEvaluations( 0 )
+{
+}
+
+
+LBFGSOptimizer
+::~LBFGSOptimizer()
+{
+}
+
+
+void
+LBFGSOptimizer
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+
+  unsigned int numberOfParameters = model->GetNumberOfParameters();
+  const std::vector< Parameter > & params = model->GetParameters();
+  m_LowerBounds.assign( numberOfParameters,
+                        -std::numeric_limits< double >::infinity() );
+  m_UpperBounds.assign( numberOfParameters,
+                        std::numeric_limits< double >::infinity() );
+  m_Scales.resize( numberOfParameters );
+  for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+    const Distribution * priorDist = params[i].GetPriorDistribution();
+    const UniformDistribution * uniform =
+      dynamic_cast< const UniformDistribution * >( priorDist );
+    if ( uniform != NULL ) {
+      m_LowerBounds[i] = uniform->GetMinimum();
+      m_UpperBounds[i] = uniform->GetMaximum();
+    }
+    m_Scales[i] =
+      priorDist->GetPercentile( 0.75 ) - priorDist->GetPercentile( 0.25 );
+  }
+
+  // Starts from the medians of the priors.
+  Sampler::Initialize( model );
+}
+
+
+void
+LBFGSOptimizer
+::ParameterSetExternally()
+{
+  if ( m_Model == NULL ||
+       m_CurrentParameters.size() != m_Model->GetNumberOfParameters() ||
+       m_Scales.size() != m_Model->GetNumberOfParameters() ) {
+    return;
+  }
+
+  m_ActiveIndices.clear();
+  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      m_ActiveIndices.push_back( i );
+    }
+  }
+
+  m_Steps.clear();
+  m_GradientChanges.clear();
+  m_Rho.clear();
+  m_Converged = false;
+  m_NumberOfIterations = 0;
+  m_NumberOfModelEvaluations = 0;
+  this->Evaluate( m_CurrentParameters, m_CurrentOutputs,
+                  m_CurrentLogLikelihood, m_CurrentGradient );
+}
+
+
+void
+LBFGSOptimizer
+::SetMemorySize( unsigned int memorySize )
+{
+  m_MemorySize = std::max( memorySize, 1u );
+}
+
+
+unsigned int
+LBFGSOptimizer
+::GetMemorySize() const
+{
+  return m_MemorySize;
+}
+
+
+void
+LBFGSOptimizer
+::SetGradientTolerance( double tolerance )
+{
+  m_GradientTolerance = tolerance;
+}
+
+
+double
+LBFGSOptimizer
+::GetGradientTolerance() const
+{
+  return m_GradientTolerance;
+}
+
+
+bool
+LBFGSOptimizer
+::HasConverged() const
+{
+  return m_Converged;
+}
+
+
+unsigned int
+LBFGSOptimizer
+::GetNumberOfIterations() const
+{
+  return m_NumberOfIterations;
+}
+
+
+unsigned long int
+LBFGSOptimizer
+::GetNumberOfModelEvaluations() const
+{
+  return m_NumberOfModelEvaluations;
+}
+
+
+bool
+LBFGSOptimizer
+::Evaluate( const std::vector< double > & parameters,
+            std::vector< double > & outputs,
+            double & logLikelihood,
+            std::vector< double > & gradient )
+{
+  ++m_NumberOfModelEvaluations;
+  std::vector< double > modelGradient;
+  Model::ErrorType error = m_Model->GetScalarOutputsAndLogLikelihoodAndGradient(
+    parameters, m_ActiveParameterIndices, outputs, logLikelihood,
+    modelGradient );
+
+  gradient.assign( m_ActiveIndices.size(), 0.0 );
+  if ( error != Model::NO_ERROR ||
+       modelGradient.size() != m_ActiveIndices.size() ||
+       !IsFinite( logLikelihood ) ) {
+    logLikelihood = -std::numeric_limits< double >::infinity();
+    return false;
+  }
+  for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+    if ( !IsFinite( modelGradient[k] ) ) {
+      logLikelihood = -std::numeric_limits< double >::infinity();
+      return false;
+    }
+    gradient[k] = -modelGradient[k] * m_Scales[ m_ActiveIndices[k] ];
+  }
+  return true;
+}
+
+
+void
+LBFGSOptimizer
+::GetSearchDirection( const std::vector< double > & projectedGradient,
+                      const std::vector< bool > & free,
+                      std::vector< double > & direction ) const
+{
+  unsigned int d = static_cast< unsigned int >( projectedGradient.size() );
+  unsigned int m = static_cast< unsigned int >( m_Steps.size() );
+
+  // Two-loop recursion, restricted to the free components.
+  std::vector< double > q( projectedGradient );
+  std::vector< double > alpha( m, 0.0 );
+  for ( int j = static_cast< int >( m ) - 1; j >= 0; --j ) {
+    double sq = 0.0;
+    for ( unsigned int k = 0; k < d; ++k ) {
+      if ( free[k] ) {
+        sq += m_Steps[j][k] * q[k];
+      }
+    }
+    alpha[j] = m_Rho[j] * sq;
+    for ( unsigned int k = 0; k < d; ++k ) {
+      if ( free[k] ) {
+        q[k] -= alpha[j] * m_GradientChanges[j][k];
+      }
+    }
+  }
+
+  double gamma = 1.0;
+  if ( m > 0 ) {
+    double yy = 0.0;
+    for ( unsigned int k = 0; k < d; ++k ) {
+      yy += m_GradientChanges[m - 1][k] * m_GradientChanges[m - 1][k];
+    }
+    gamma = 1.0 / ( m_Rho[m - 1] * yy );
+  } else {
+    // Without curvature information, start with a step of at most one
+    // interquartile range.
+    double norm = 0.0;
+    for ( unsigned int k = 0; k < d; ++k ) {
+      norm += q[k] * q[k];
+    }
+    gamma = 1.0 / std::max( 1.0, std::sqrt( norm ) );
+  }
+  for ( unsigned int k = 0; k < d; ++k ) {
+    q[k] *= gamma;
+  }
+
+  for ( unsigned int j = 0; j < m; ++j ) {
+    double yr = 0.0;
+    for ( unsigned int k = 0; k < d; ++k ) {
+      if ( free[k] ) {
+        yr += m_GradientChanges[j][k] * q[k];
+      }
+    }
+    double beta = m_Rho[j] * yr;
+    for ( unsigned int k = 0; k < d; ++k ) {
+      if ( free[k] ) {
+        q[k] += m_Steps[j][k] * ( alpha[j] - beta );
+      }
+    }
+  }
+
+  direction.resize( d );
+  for ( unsigned int k = 0; k < d; ++k ) {
+    direction[k] = free[k] ? -q[k] : 0.0;
+  }
+}
+
+
+Sample
+LBFGSOptimizer
+::NextSample()
+{
+  if ( this->ActiveIndicesChanged( m_ActiveIndices ) ) {
+    this->ParameterSetExternally();
+  }
+  unsigned int d = static_cast< unsigned int >( m_ActiveIndices.size() );
+
+  if ( !m_Converged && !IsFinite( m_CurrentLogLikelihood ) ) {
+    // No gradient to follow outside the support of the posterior.
+    m_Converged = true;
+  }
+
+  // Leave out the parameters that the gradient pushes against a bound.
+  std::vector< bool > free( d, true );
+  std::vector< double > projectedGradient( m_CurrentGradient );
+  double largestComponent = 0.0;
+  for ( unsigned int k = 0; k < d && !m_Converged; ++k ) {
+    unsigned int i = m_ActiveIndices[k];
+    if ( ( m_CurrentParameters[i] <= m_LowerBounds[i] && m_CurrentGradient[k] > 0.0 ) ||
+         ( m_CurrentParameters[i] >= m_UpperBounds[i] && m_CurrentGradient[k] < 0.0 ) ) {
+      free[k] = false;
+      projectedGradient[k] = 0.0;
+    }
+    largestComponent = std::max( largestComponent,
+                                 std::fabs( projectedGradient[k] ) );
+  }
+  if ( largestComponent < m_GradientTolerance ) {
+    m_Converged = true;
+  }
+
+  if ( !m_Converged ) {
+    std::vector< double > direction;
+    this->GetSearchDirection( projectedGradient, free, direction );
+    double slope = 0.0;
+    for ( unsigned int k = 0; k < d; ++k ) {
+      slope += direction[k] * projectedGradient[k];
+    }
+    if ( !( slope < 0.0 ) ) {
+      // The curvature information is stale, so start over from the
+      // gradient.
+      m_Steps.clear();
+      m_GradientChanges.clear();
+      m_Rho.clear();
+      this->GetSearchDirection( projectedGradient, free, direction );
+    }
+
+    // Backtracking line search along the projected path.
+    std::vector< double > parameters;
+    std::vector< double > outputs;
+    double logLikelihood = 0.0;
+    std::vector< double > gradient;
+    std::vector< double > step( d, 0.0 );
+    bool accepted = false;
+    double alpha = 1.0;
+    for ( unsigned int b = 0; b < MAXIMUM_NUMBER_OF_BACKTRACKS && !accepted;
+          ++b, alpha *= 0.5 ) {
+      parameters = m_CurrentParameters;
+      double predictedChange = 0.0;
+      for ( unsigned int k = 0; k < d; ++k ) {
+        unsigned int i = m_ActiveIndices[k];
+        double x = m_CurrentParameters[i] + alpha * direction[k] * m_Scales[i];
+        parameters[i] = std::min( std::max( x, m_LowerBounds[i] ), m_UpperBounds[i] );
+        step[k] = ( parameters[i] - m_CurrentParameters[i] ) / m_Scales[i];
+        predictedChange += m_CurrentGradient[k] * step[k];
+      }
+      if ( !( predictedChange < 0.0 ) ) {
+        continue;
+      }
+      if ( this->Evaluate( parameters, outputs, logLikelihood, gradient ) &&
+           -logLikelihood <= -m_CurrentLogLikelihood +
+             ARMIJO_CONSTANT * predictedChange ) {
+        accepted = true;
+      }
+    }
+
+    if ( !accepted ) {
+      m_Converged = true;
+    } else {
+      // Keep the step if it carries positive curvature information.
+      std::vector< double > gradientChange( d );
+      double sy = 0.0;
+      double yy = 0.0;
+      for ( unsigned int k = 0; k < d; ++k ) {
+        gradientChange[k] = gradient[k] - m_CurrentGradient[k];
+        sy += step[k] * gradientChange[k];
+        yy += gradientChange[k] * gradientChange[k];
+      }
+      if ( sy > 1e-10 * yy ) {
+        m_Steps.push_back( step );
+        m_GradientChanges.push_back( gradientChange );
+        m_Rho.push_back( 1.0 / sy );
+        if ( m_Steps.size() > m_MemorySize ) {
+          m_Steps.pop_front();
+          m_GradientChanges.pop_front();
+          m_Rho.pop_front();
+        }
+      }
+
+      double improvement = logLikelihood - m_CurrentLogLikelihood;
+      m_CurrentParameters = parameters;
+      m_CurrentOutputs = outputs;
+      m_CurrentLogLikelihood = logLikelihood;
+      m_CurrentGradient = gradient;
+      ++m_NumberOfIterations;
+
+      if ( improvement <= std::numeric_limits< double >::epsilon() *
+           std::max( 1.0, std::fabs( logLikelihood ) ) ) {
+        m_Converged = true;
+      }
+    }
+  }
+
+  return Sample( m_CurrentParameters,
+                 m_CurrentOutputs,
+                 m_CurrentLogLikelihood );
+}
+
+
+Sample
+LBFGSOptimizer
+::FindMaximum( unsigned int maximumNumberOfIterations )
+{
+  Sample sample( m_CurrentParameters, m_CurrentOutputs, m_CurrentLogLikelihood );
+  for ( unsigned int i = 0; i < maximumNumberOfIterations && !m_Converged; ++i ) {
+    sample = this->NextSample();
+  }
+  return sample;
+}
+
+} // end namespace madai
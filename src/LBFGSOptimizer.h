@@ -0,0 +1,147 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_LBFGSOptimizer_h_included
+#define madai_LBFGSOptimizer_h_included
+
+#include <deque>
+#include <vector>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/** \class LBFGSOptimizer
+ *
+ * Finds the maximum of the log likelihood of a Model, including the
+ * log prior, with the limited-memory BFGS method. Like
+ * RegularStepGradientAscentSampler, it is a Sampler whose samples
+ * climb toward the maximum, so parameters can be set and deactivated
+ * in the same way; FindMaximum() iterates until convergence.
+ *
+ * Each iteration evaluates the Model with
+ * Model::GetScalarOutputsAndLogLikelihoodAndGradient(), once unless
+ * the backtracking line search has to shorten the step. Parameters
+ * whose priors are uniform are kept inside the prior support by
+ * projecting the steps onto it; parameters held at a bound by the
+ * gradient are left out of the search direction. The search works in
+ * units of the interquartile ranges of the priors.
+ *
+ * The optimizer starts from the current parameters, which are the
+ * medians of the priors after SetModel().
+ */
+class LBFGSOptimizer : public Sampler {
+public:
+  LBFGSOptimizer();
+  virtual ~LBFGSOptimizer();
+
+  /** Take one iteration and return the Sample at the new point. Once
+   * converged, returns the maximum. */
+  virtual Sample NextSample();
+
+  /** Iterate until converged or until maximumNumberOfIterations
+   * further iterations have been taken, and return the best Sample. */
+  Sample FindMaximum( unsigned int maximumNumberOfIterations );
+
+  //@{
+  /** Set/Get the number of previous steps used to approximate the
+   * inverse Hessian. Defaults to 10. */
+  void SetMemorySize( unsigned int memorySize );
+  unsigned int GetMemorySize() const;
+  //@}
+
+  //@{
+  /** Set/Get the tolerance on the largest component of the projected
+   * gradient of the log likelihood, in units of the interquartile
+   * ranges of the priors. Defaults to 1e-6. */
+  void SetGradientTolerance( double tolerance );
+  double GetGradientTolerance() const;
+  //@}
+
+  /** Returns true once the projected gradient is below the tolerance
+   * or the line search cannot improve the log likelihood any more. */
+  bool HasConverged() const;
+
+  /** Number of iterations since the Model or the parameters were
+   * set. */
+  unsigned int GetNumberOfIterations() const;
+
+  /** Number of Model evaluations since the Model or the parameters
+   * were set. */
+  unsigned long int GetNumberOfModelEvaluations() const;
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Evaluates the Model and the gradient at the new point and
+   * forgets the previous steps. */
+  virtual void ParameterSetExternally();
+
+  /** Evaluate the Model at a point. The gradient is that of the
+   * negative log likelihood with respect to the scaled active
+   * parameters. Returns false if the log likelihood or the gradient
+   * is not finite. */
+  bool Evaluate( const std::vector< double > & parameters,
+                 std::vector< double > & outputs,
+                 double & logLikelihood,
+                 std::vector< double > & gradient );
+
+  /** Compute the search direction from the stored steps, over the
+   * components that are free to move. */
+  void GetSearchDirection( const std::vector< double > & projectedGradient,
+                           const std::vector< bool > & free,
+                           std::vector< double > & direction ) const;
+
+  unsigned int m_MemorySize;
+
+  double m_GradientTolerance;
+
+  /** Bounds of the priors, infinite where the prior is not uniform. */
+  std::vector< double > m_LowerBounds;
+  std::vector< double > m_UpperBounds;
+
+  /** Interquartile ranges of the priors. */
+  std::vector< double > m_Scales;
+
+  /** Indices of the active parameters. */
+  std::vector< unsigned int > m_ActiveIndices;
+
+  /** Gradient of the negative log likelihood at the current point,
+   * with respect to the scaled active parameters. */
+  std::vector< double > m_CurrentGradient;
+
+  //@{
+  /** Previous steps and gradient changes in scaled coordinates, and
+   * the reciprocals of their inner products. */
+  std::deque< std::vector< double > > m_Steps;
+  std::deque< std::vector< double > > m_GradientChanges;
+  std::deque< double > m_Rho;
+  //@}
+
+  bool m_Converged;
+
+  unsigned int m_NumberOfIterations;
+
+  unsigned long int m_NumberOfModelEvaluations;
+
+}; // end class LBFGSOptimizer
+
+} // end namespace madai
+
+#endif // madai_LBFGSOptimizer_h_included
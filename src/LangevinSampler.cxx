@@ -72,15 +72,13 @@ Sample
 LangevinSampler
 ::NextSample()
 {
-  Model * m = const_cast< Model * >(m_Model);
-  
   assert( static_cast<unsigned int> (
               std::count( m_ActiveParameterIndices.begin(),
                           m_ActiveParameterIndices.end(), true ))
           == this->GetNumberOfActiveParameters());
           
   // Get the gradient of the log likelihood at the current point
-  std::vector< double > CurrentGradient = this->GetGradient( m_CurrentParameters, m );
+  std::vector< double > CurrentGradient = this->GetGradient( m_CurrentParameters, m_Model );
   
   // Scale parameters by parameterspace
   for ( unsigned int i = 0; i < m_CurrentParameters.size(); i++ ) {
@@ -94,7 +92,7 @@ LangevinSampler
     NewParameters[i] = NewParameters[i] * ( m_UpperLimit[i] - m_LowerLimit[i] ) + m_LowerLimit[i];
   }
   // Get Gradient of LL at the new point
-  std::vector< double > NewGradient = this->GetGradient( NewParameters, m );
+  std::vector< double > NewGradient = this->GetGradient( NewParameters, m_Model );
   
   // Take final step and scale back to original units
   for ( unsigned int i = 0; i < m_CurrentParameters.size(); i++ ) {
@@ -112,7 +110,7 @@ LangevinSampler
   }
   
   // Get loglikelihood at the new parameters
-  m->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
+  m_Model->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
     m_CurrentParameters, m_CurrentOutputs, m_CurrentLogLikelihood, 
     m_CurrentLogLikelihoodValueGradient, m_CurrentLogLikelihoodErrorGradient);
     
@@ -127,6 +125,37 @@ LangevinSampler
 }
 
 
+void
+LangevinSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "LangevinSampler" );
+  WriteValue( o, m_LargestGradient );
+  o << ' ';
+  WriteValue( o, m_AverageGradient );
+  o << ' ';
+  WriteValue( o, m_GaussianWidth );
+  o << ' ';
+  WriteValue( o, m_StepSize );
+  o << ' ' << m_NumberOfElementsInAverage << '\n';
+}
+
+
+bool
+LangevinSampler
+::ReadState( std::istream & i )
+{
+  return ( Sampler::ReadState( i ) &&
+           ReadTag( i, "LangevinSampler" ) &&
+           ReadValue( i, m_LargestGradient ) &&
+           ReadValue( i, m_AverageGradient ) &&
+           ReadValue( i, m_GaussianWidth ) &&
+           ReadValue( i, m_StepSize ) &&
+           ( i >> m_NumberOfElementsInAverage ) );
+}
+
+
 std::vector< double >
 LangevinSampler
 ::GetGradient( const std::vector< double > Parameters, const Model * m) 
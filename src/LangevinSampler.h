@@ -31,7 +31,9 @@ namespace madai {
  * It considers the gradient of the likelihood at a point, and
  * moves according to the Langevin equation.
  *
- * \warning This class is experimental.
+ * \warning This class is experimental. It does not accept or reject
+ * its steps, so its samples do not follow the posterior. Use
+ * MetropolisAdjustedLangevinSampler to sample the posterior.
  */
 
 class LangevinSampler : public Sampler {
@@ -47,7 +49,13 @@ public:
    *
    * \return A new Sample. */
   virtual Sample NextSample();
-  
+
+  //@{
+  /** The state includes the adapted step size and noise width. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
 protected:
   /** Record of the largest gradient size. */
   double m_LargestGradient;
@@ -76,11 +84,6 @@ protected:
   /** Get the gradient of the LL at a point and update above parameters if necessary. */
   std::vector< double > GetGradient( const std::vector< double > Parameters, const Model * m );
 
-private:
-
-  /** Instance of a random number generator. */
-  madai::Random m_Random;
-
 }; // end class LangevinSampler
 
 } // end namespace madai
@@ -0,0 +1,342 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "LaplaceApproximationSampler.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "LBFGSOptimizer.h"
+
+
+namespace {
+
+inline bool IsFinite( double x )
+{
+  return ( std::fabs( x ) <= std::numeric_limits< double >::max() );
+}
+
+/** Finite difference step in units of the interquartile range of the
+ * prior. */
+const double RELATIVE_DIFFERENCE_STEP = 1e-4;
+
+/** Interquartile range of a unit Gaussian. */
+const double GAUSSIAN_INTERQUARTILE_RANGE = 1.3489795003921634;
+
+/** Number of draws before a sample outside the prior support is
+ * accepted anyway. */
+const unsigned int MAXIMUM_NUMBER_OF_DRAWS = 1000;
+
+} // end anonymous namespace
+
+
+namespace madai {
+
+
+LaplaceApproximationSampler
+::LaplaceApproximationSampler() :
+  Sampler(),
+  m_MaximumNumberOfIterations( 1000 ),
+  m_ApproximationComputed( false ),
+  m_ApproximationValid( false ),
+  m_NumberOfModelEvaluations( 0 )
+{
+}
+
+
+LaplaceApproximationSampler
+::~LaplaceApproximationSampler()
+{
+}
+
+
+void
+LaplaceApproximationSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+
+  // Starts from the medians of the priors.
+  Sampler::Initialize( model );
+}
+
+
+void
+LaplaceApproximationSampler
+::ParameterSetExternally()
+{
+  m_ApproximationComputed = false;
+  m_ApproximationValid = false;
+}
+
+
+void
+LaplaceApproximationSampler
+::SetMaximumNumberOfIterations( unsigned int numberOfIterations )
+{
+  m_MaximumNumberOfIterations = numberOfIterations;
+}
+
+
+unsigned int
+LaplaceApproximationSampler
+::GetMaximumNumberOfIterations() const
+{
+  return m_MaximumNumberOfIterations;
+}
+
+
+const std::vector< double > &
+LaplaceApproximationSampler
+::GetMean() const
+{
+  return m_Maximum.m_ParameterValues;
+}
+
+
+Eigen::MatrixXd
+LaplaceApproximationSampler
+::GetCovariance() const
+{
+  unsigned int numberOfParameters =
+    static_cast< unsigned int >( m_Maximum.m_ParameterValues.size() );
+  Eigen::MatrixXd covariance =
+    Eigen::MatrixXd::Zero( numberOfParameters, numberOfParameters );
+  for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+    for ( unsigned int l = 0; l < m_ActiveIndices.size(); ++l ) {
+      covariance( m_ActiveIndices[k], m_ActiveIndices[l] ) = m_Covariance( k, l );
+    }
+  }
+  return covariance;
+}
+
+
+const Sample &
+LaplaceApproximationSampler
+::GetMaximum() const
+{
+  return m_Maximum;
+}
+
+
+bool
+LaplaceApproximationSampler
+::IsApproximationValid() const
+{
+  return m_ApproximationValid;
+}
+
+
+unsigned long int
+LaplaceApproximationSampler
+::GetNumberOfModelEvaluations() const
+{
+  return m_NumberOfModelEvaluations;
+}
+
+
+void
+LaplaceApproximationSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "LaplaceApproximationSampler" );
+  o << m_ApproximationComputed << ' ' << m_ApproximationValid << ' '
+    << m_NumberOfModelEvaluations << '\n';
+  WriteIntegers( o, m_ActiveIndices );
+  WriteSample( o, m_Maximum );
+  WriteMatrix( o, m_Covariance );
+  WriteMatrix( o, m_CovarianceCholesky );
+}
+
+
+bool
+LaplaceApproximationSampler
+::ReadState( std::istream & i )
+{
+  return ( Sampler::ReadState( i ) &&
+           ReadTag( i, "LaplaceApproximationSampler" ) &&
+           ( i >> m_ApproximationComputed >> m_ApproximationValid
+               >> m_NumberOfModelEvaluations ) &&
+           ReadIntegers( i, m_ActiveIndices ) &&
+           ReadSample( i, m_Maximum ) &&
+           ReadMatrix( i, m_Covariance ) &&
+           ReadMatrix( i, m_CovarianceCholesky ) );
+}
+
+
+bool
+LaplaceApproximationSampler
+::ComputeApproximation()
+{
+  assert( m_Model != NULL );
+
+  m_ActiveIndices.clear();
+  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      m_ActiveIndices.push_back( i );
+    }
+  }
+  int numberOfActive = static_cast< int >( m_ActiveIndices.size() );
+
+  // Find the maximum with the same active parameters.
+  LBFGSOptimizer optimizer;
+  optimizer.SetModel( m_Model );
+  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+    if ( !m_ActiveParameterIndices[i] ) {
+      optimizer.DeactivateParameter( i );
+    }
+  }
+  optimizer.SetParameterValues( m_CurrentParameters );
+  m_Maximum = optimizer.FindMaximum( m_MaximumNumberOfIterations );
+  m_NumberOfModelEvaluations = optimizer.GetNumberOfModelEvaluations();
+  m_ApproximationValid = optimizer.HasConverged();
+
+  // Gradients on either side of the maximum along each active
+  // parameter, stepping only inside the support of the priors.
+  const std::vector< double > & maximum = m_Maximum.m_ParameterValues;
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  std::vector< double > steps( numberOfActive );
+  std::vector< std::vector< double > > points;
+  for ( int k = 0; k < numberOfActive; ++k ) {
+    const Distribution * priorDist =
+      params[ m_ActiveIndices[k] ].GetPriorDistribution();
+    steps[k] = RELATIVE_DIFFERENCE_STEP *
+      ( priorDist->GetPercentile( 0.75 ) - priorDist->GetPercentile( 0.25 ) );
+    for ( int side = -1; side <= 1; side += 2 ) {
+      std::vector< double > point( maximum );
+      point[ m_ActiveIndices[k] ] += side * steps[k];
+      if ( !IsFinite( m_Model->GetLogPriorLikelihood( point ) ) ) {
+        point = maximum;
+      }
+      points.push_back( point );
+    }
+  }
+
+  int numberOfPoints = static_cast< int >( points.size() );
+  std::vector< std::vector< double > > gradients( numberOfPoints );
+  std::vector< Model::ErrorType > errors( numberOfPoints, Model::NO_ERROR );
+  bool concurrent = m_Model->SupportsConcurrentEvaluation();
+  (void)concurrent; // only used by OpenMP
+#if defined( OPENMP_FOUND )
+  #pragma omp parallel for if ( concurrent )
+#endif // OPENMP_FOUND
+  for ( int n = 0; n < numberOfPoints; ++n ) {
+    std::vector< double > outputs;
+    double logLikelihood;
+    errors[n] = m_Model->GetScalarOutputsAndLogLikelihoodAndGradient(
+      points[n], m_ActiveParameterIndices, outputs, logLikelihood,
+      gradients[n] );
+  }
+  m_NumberOfModelEvaluations += numberOfPoints;
+
+  // Negative Hessian, symmetrized.
+  Eigen::MatrixXd precision( numberOfActive, numberOfActive );
+  bool finite = true;
+  for ( int k = 0; k < numberOfActive; ++k ) {
+    const std::vector< double > & below = gradients[ 2 * k ];
+    const std::vector< double > & above = gradients[ 2 * k + 1 ];
+    double distance = points[ 2 * k + 1 ][ m_ActiveIndices[k] ] -
+      points[ 2 * k ][ m_ActiveIndices[k] ];
+    finite = finite && errors[ 2 * k ] == Model::NO_ERROR &&
+      errors[ 2 * k + 1 ] == Model::NO_ERROR &&
+      below.size() == m_ActiveIndices.size() &&
+      above.size() == m_ActiveIndices.size() && distance > 0.0;
+    for ( int l = 0; l < numberOfActive; ++l ) {
+      precision( l, k ) = finite ? -( above[l] - below[l] ) / distance : 0.0;
+      finite = finite && IsFinite( precision( l, k ) );
+    }
+  }
+  precision = 0.5 * ( precision + precision.transpose() ).eval();
+
+  Eigen::LLT< Eigen::MatrixXd > precisionCholesky( precision );
+  if ( finite && precisionCholesky.info() == Eigen::Success ) {
+    m_Covariance = precisionCholesky.solve(
+      Eigen::MatrixXd::Identity( numberOfActive, numberOfActive ) );
+  } else {
+    // Independent Gaussians, as wide as the curvature allows, or as
+    // the priors where the log likelihood is not concave.
+    m_ApproximationValid = false;
+    m_Covariance = Eigen::MatrixXd::Zero( numberOfActive, numberOfActive );
+    for ( int k = 0; k < numberOfActive; ++k ) {
+      if ( finite && precision( k, k ) > 0.0 ) {
+        m_Covariance( k, k ) = 1.0 / precision( k, k );
+      } else {
+        double deviation = steps[k] /
+          ( RELATIVE_DIFFERENCE_STEP * GAUSSIAN_INTERQUARTILE_RANGE );
+        m_Covariance( k, k ) = deviation * deviation;
+      }
+    }
+  }
+  m_CovarianceCholesky = m_Covariance.llt().matrixL();
+
+  m_CurrentParameters = maximum;
+  m_CurrentOutputs = m_Maximum.m_OutputValues;
+  m_CurrentLogLikelihood = m_Maximum.m_LogLikelihood;
+  m_ApproximationComputed = true;
+  return m_ApproximationValid;
+}
+
+
+Sample
+LaplaceApproximationSampler
+::NextSample()
+{
+  if ( !m_ApproximationComputed ||
+       this->ActiveIndicesChanged( m_ActiveIndices ) ) {
+    this->ComputeApproximation();
+  }
+
+  const std::vector< double > & mean = m_Maximum.m_ParameterValues;
+  unsigned int numberOfActive =
+    static_cast< unsigned int >( m_ActiveIndices.size() );
+  std::vector< double > draw( mean );
+  Eigen::VectorXd z( numberOfActive );
+  bool inSupport = false;
+  for ( unsigned int tries = 0;
+        tries < MAXIMUM_NUMBER_OF_DRAWS && !inSupport; ++tries ) {
+    for ( unsigned int k = 0; k < numberOfActive; ++k ) {
+      z( k ) = m_Random.Gaussian();
+    }
+    Eigen::VectorXd offset = m_CovarianceCholesky * z;
+    for ( unsigned int k = 0; k < numberOfActive; ++k ) {
+      draw[ m_ActiveIndices[k] ] = mean[ m_ActiveIndices[k] ] + offset( k );
+    }
+    inSupport = IsFinite( m_Model->GetLogPriorLikelihood( draw ) );
+  }
+
+  if ( inSupport ) {
+    m_CurrentParameters = draw;
+    m_Model->GetScalarOutputsAndLogLikelihood(
+      m_CurrentParameters, m_CurrentOutputs, m_CurrentLogLikelihood );
+  } else {
+    // The approximation lies almost all outside the support, so
+    // record the maximum rather than a point of zero posterior.
+    m_CurrentParameters = mean;
+    m_CurrentOutputs = m_Maximum.m_OutputValues;
+    m_CurrentLogLikelihood = m_Maximum.m_LogLikelihood;
+  }
+
+  return Sample( m_CurrentParameters,
+                 m_CurrentOutputs,
+                 m_CurrentLogLikelihood );
+}
+
+} // end namespace madai
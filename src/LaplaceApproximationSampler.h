@@ -0,0 +1,127 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_LaplaceApproximationSampler_h_included
+#define madai_LaplaceApproximationSampler_h_included
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/** \class LaplaceApproximationSampler
+ *
+ * Draws independent samples from a Gaussian approximation of the
+ * posterior. The mean of the Gaussian is the maximum of the log
+ * likelihood, found with LBFGSOptimizer from the current parameters,
+ * and its covariance is the inverse of the negative Hessian of the log
+ * likelihood there.
+ *
+ * The Hessian is computed by central differences of the gradients
+ * from Model::GetScalarOutputsAndLogLikelihoodAndGradient(), one pair
+ * of evaluations per active parameter, which run in parallel when the
+ * Model supports concurrent evaluation. Differences are one-sided for
+ * parameters at a bound of their prior. Draws outside the support of
+ * the priors are redrawn, and if none of many draws falls inside it,
+ * the sample is the maximum.
+ *
+ * The approximation is computed by ComputeApproximation(), or by the
+ * first call to NextSample(). Setting parameters or changing the
+ * active parameters invalidates it.
+ */
+class LaplaceApproximationSampler : public Sampler {
+public:
+  LaplaceApproximationSampler();
+  virtual ~LaplaceApproximationSampler();
+
+  /** Draw a sample from the Gaussian approximation, and evaluate the
+   * Model there. */
+  virtual Sample NextSample();
+
+  /** Find the maximum and compute the covariance there. Returns false
+   * if the search did not converge or the negative Hessian is not
+   * positive definite. In the latter case the parameters are drawn
+   * independently, with the variances from the diagonal of the
+   * Hessian where it is negative and from the priors elsewhere. */
+  bool ComputeApproximation();
+
+  //@{
+  /** Set/Get the maximum number of iterations of the search for the
+   * maximum. Defaults to 1000. */
+  void SetMaximumNumberOfIterations( unsigned int numberOfIterations );
+  unsigned int GetMaximumNumberOfIterations() const;
+  //@}
+
+  /** Returns the mean of the approximation, with the values of the
+   * inactive parameters. */
+  const std::vector< double > & GetMean() const;
+
+  /** Returns the covariance of the approximation over all parameters.
+   * Rows and columns of inactive parameters are zero. */
+  Eigen::MatrixXd GetCovariance() const;
+
+  /** Returns the Sample at the maximum. */
+  const Sample & GetMaximum() const;
+
+  /** Returns false if the search for the maximum did not converge or
+   * the Hessian was not negative definite. */
+  bool IsApproximationValid() const;
+
+  /** Number of Model evaluations used to compute the approximation. */
+  unsigned long int GetNumberOfModelEvaluations() const;
+
+  //@{
+  /** The state includes the approximation, once it is computed. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Forgets the approximation. */
+  virtual void ParameterSetExternally();
+
+  unsigned int m_MaximumNumberOfIterations;
+
+  /** Indices of the active parameters when the approximation was
+   * computed. */
+  std::vector< unsigned int > m_ActiveIndices;
+
+  Sample m_Maximum;
+
+  /** Covariance and its Cholesky factor over the active
+   * parameters. */
+  Eigen::MatrixXd m_Covariance;
+  Eigen::MatrixXd m_CovarianceCholesky;
+
+  bool m_ApproximationComputed;
+
+  bool m_ApproximationValid;
+
+  unsigned long int m_NumberOfModelEvaluations;
+
+}; // end class LaplaceApproximationSampler
+
+} // end namespace madai
+
+#endif // madai_LaplaceApproximationSampler_h_included
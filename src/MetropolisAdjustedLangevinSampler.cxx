@@ -0,0 +1,306 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "MetropolisAdjustedLangevinSampler.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+inline bool IsFinite( double x )
+{
+  return ( std::fabs( x ) <= std::numeric_limits< double >::max() );
+}
+
+} // end anonymous namespace
+
+
+namespace madai {
+
+
+MetropolisAdjustedLangevinSampler
+::MetropolisAdjustedLangevinSampler() :
+  Sampler(),
+  m_StepSize( 0.1 ),
+  m_NumberOfAdaptationSamples( 0 ),
+  m_TargetAcceptanceRate( 0.574 ),
+  m_NumberOfSamples( 0 ),
+  m_NumberOfAcceptedProposals( 0 )
+{
+}
+
+
+MetropolisAdjustedLangevinSampler
+::~MetropolisAdjustedLangevinSampler()
+{
+}
+
+
+void
+MetropolisAdjustedLangevinSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+
+  Sampler::Initialize( model );
+
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  m_Preconditioner.resize( model->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < model->GetNumberOfParameters(); ++i ) {
+    const Distribution * priorDist = params[i].GetPriorDistribution();
+    // Random initial starting point
+    m_CurrentParameters[i] = priorDist->GetSample( m_Random );
+    double scale =
+      priorDist->GetPercentile( 0.75 ) - priorDist->GetPercentile( 0.25 );
+    m_Preconditioner[i] = scale * scale;
+  }
+  m_NumberOfSamples = 0;
+  m_NumberOfAcceptedProposals = 0;
+
+  this->ParameterSetExternally();
+}
+
+
+void
+MetropolisAdjustedLangevinSampler
+::ParameterSetExternally()
+{
+  if ( m_Model == NULL ||
+       m_CurrentParameters.size() != m_Model->GetNumberOfParameters() ) {
+    return;
+  }
+
+  m_ActiveIndices.clear();
+  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      m_ActiveIndices.push_back( i );
+    }
+  }
+
+  this->Evaluate( m_CurrentParameters, m_CurrentOutputs,
+                  m_CurrentLogLikelihood, m_CurrentGradient );
+}
+
+
+void
+MetropolisAdjustedLangevinSampler
+::SetStepSize( double stepSize )
+{
+  if ( stepSize > 0.0 ) {
+    m_StepSize = stepSize;
+  }
+}
+
+
+double
+MetropolisAdjustedLangevinSampler
+::GetStepSize() const
+{
+  return m_StepSize;
+}
+
+
+void
+MetropolisAdjustedLangevinSampler
+::SetNumberOfAdaptationSamples( unsigned int numberOfSamples )
+{
+  m_NumberOfAdaptationSamples = numberOfSamples;
+}
+
+
+unsigned int
+MetropolisAdjustedLangevinSampler
+::GetNumberOfAdaptationSamples() const
+{
+  return m_NumberOfAdaptationSamples;
+}
+
+
+void
+MetropolisAdjustedLangevinSampler
+::SetTargetAcceptanceRate( double rate )
+{
+  if ( rate > 0.0 && rate < 1.0 ) {
+    m_TargetAcceptanceRate = rate;
+  }
+}
+
+
+double
+MetropolisAdjustedLangevinSampler
+::GetTargetAcceptanceRate() const
+{
+  return m_TargetAcceptanceRate;
+}
+
+
+double
+MetropolisAdjustedLangevinSampler
+::GetAcceptanceRate() const
+{
+  if ( m_NumberOfSamples == 0 ) {
+    return 0.0;
+  }
+  return static_cast< double >( m_NumberOfAcceptedProposals ) /
+    static_cast< double >( m_NumberOfSamples );
+}
+
+
+void
+MetropolisAdjustedLangevinSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "MetropolisAdjustedLangevinSampler" );
+  WriteValue( o, m_StepSize );
+  o << '\n';
+  WriteIntegers( o, m_ActiveIndices );
+  WriteValues( o, m_CurrentGradient );
+  o << m_NumberOfSamples << ' ' << m_NumberOfAcceptedProposals << '\n';
+}
+
+
+bool
+MetropolisAdjustedLangevinSampler
+::ReadState( std::istream & i )
+{
+  return ( Sampler::ReadState( i ) &&
+           ReadTag( i, "MetropolisAdjustedLangevinSampler" ) &&
+           ReadValue( i, m_StepSize ) &&
+           ReadIntegers( i, m_ActiveIndices ) &&
+           ReadValues( i, m_CurrentGradient ) &&
+           ( i >> m_NumberOfSamples >> m_NumberOfAcceptedProposals ) );
+}
+
+
+bool
+MetropolisAdjustedLangevinSampler
+::Evaluate( const std::vector< double > & parameters,
+            std::vector< double > & outputs,
+            double & logLikelihood,
+            std::vector< double > & gradient ) const
+{
+  Model::ErrorType error = m_Model->GetScalarOutputsAndLogLikelihoodAndGradient(
+    parameters, m_ActiveParameterIndices, outputs, logLikelihood, gradient );
+
+  bool valid = ( error == Model::NO_ERROR &&
+                 gradient.size() == m_ActiveIndices.size() &&
+                 IsFinite( logLikelihood ) );
+  for ( unsigned int k = 0; valid && k < gradient.size(); ++k ) {
+    valid = IsFinite( gradient[k] );
+  }
+  if ( !valid ) {
+    logLikelihood = -std::numeric_limits< double >::infinity();
+    gradient.assign( m_ActiveIndices.size(), 0.0 );
+  }
+  return valid;
+}
+
+
+void
+MetropolisAdjustedLangevinSampler
+::GetDriftedPoint( const std::vector< double > & parameters,
+                   const std::vector< double > & gradient,
+                   std::vector< double > & drifted ) const
+{
+  drifted = parameters;
+  double halfStepSquared = 0.5 * m_StepSize * m_StepSize;
+  for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+    unsigned int i = m_ActiveIndices[k];
+    drifted[i] += halfStepSquared * m_Preconditioner[i] * gradient[k];
+  }
+}
+
+
+double
+MetropolisAdjustedLangevinSampler
+::GetLogProposalDensity( const std::vector< double > & to,
+                         const std::vector< double > & drifted ) const
+{
+  double sum = 0.0;
+  for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+    unsigned int i = m_ActiveIndices[k];
+    double difference = to[i] - drifted[i];
+    sum += difference * difference / m_Preconditioner[i];
+  }
+  return -0.5 * sum / ( m_StepSize * m_StepSize );
+}
+
+
+Sample
+MetropolisAdjustedLangevinSampler
+::NextSample()
+{
+  // The cached gradient covers the parameters that were active when
+  // it was computed.
+  if ( this->ActiveIndicesChanged( m_ActiveIndices ) ) {
+    this->ParameterSetExternally();
+  }
+
+  // Langevin step from the cached gradient.
+  std::vector< double > drifted;
+  this->GetDriftedPoint( m_CurrentParameters, m_CurrentGradient, drifted );
+  std::vector< double > proposal( drifted );
+  for ( unsigned int k = 0; k < m_ActiveIndices.size(); ++k ) {
+    unsigned int i = m_ActiveIndices[k];
+    proposal[i] += m_StepSize * std::sqrt( m_Preconditioner[i] ) *
+      m_Random.Gaussian();
+  }
+
+  std::vector< double > outputs;
+  double logLikelihood;
+  std::vector< double > gradient;
+  double acceptanceProbability = 0.0;
+  if ( this->Evaluate( proposal, outputs, logLikelihood, gradient ) ) {
+    // The proposal is not symmetric, so correct with the density of
+    // the reverse step.
+    std::vector< double > reverseDrifted;
+    this->GetDriftedPoint( proposal, gradient, reverseDrifted );
+    double delta = ( logLikelihood - m_CurrentLogLikelihood )
+      + this->GetLogProposalDensity( m_CurrentParameters, reverseDrifted )
+      - this->GetLogProposalDensity( proposal, drifted );
+    if ( delta == delta ) {
+      acceptanceProbability = ( delta >= 0.0 ) ? 1.0 : std::exp( delta );
+    }
+  }
+
+  if ( acceptanceProbability >= 1.0 ||
+       m_Random.Uniform() < acceptanceProbability ) {
+    m_CurrentParameters = proposal;
+    m_CurrentOutputs = outputs;
+    m_CurrentLogLikelihood = logLikelihood;
+    m_CurrentGradient = gradient;
+    ++m_NumberOfAcceptedProposals;
+  }
+
+  if ( !m_AdaptationEnded && m_NumberOfSamples < m_NumberOfAdaptationSamples ) {
+    double gain = std::pow( static_cast< double >( m_NumberOfSamples + 1 ), -0.6 );
+    m_StepSize *= std::exp( gain * ( acceptanceProbability - m_TargetAcceptanceRate ) );
+  }
+  ++m_NumberOfSamples;
+
+  return Sample( m_CurrentParameters,
+                 m_CurrentOutputs,
+                 m_CurrentLogLikelihood );
+}
+
+} // end namespace madai
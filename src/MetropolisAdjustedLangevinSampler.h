@@ -0,0 +1,142 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_MetropolisAdjustedLangevinSampler_h_included
+#define madai_MetropolisAdjustedLangevinSampler_h_included
+
+#include <vector>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/**
+ * \class MetropolisAdjustedLangevinSampler
+ *
+ * Metropolis-adjusted Langevin algorithm (Roberts and Tweedie, 1996).
+ * Each proposal takes a Langevin step
+ * \f[ y = x + \frac{\epsilon^2}{2} M \nabla \log \pi(x) + \epsilon M^{1/2} z \f]
+ * with \f$ z \f$ standard normal and \f$ M \f$ the diagonal matrix of
+ * the squared interquartile ranges of the priors, and is accepted or
+ * rejected by the Metropolis-Hastings rule, so that the chain samples
+ * the posterior exactly.
+ *
+ * The outputs, log likelihood and gradient at the current point are
+ * kept, so each call to NextSample() evaluates the Model once, with
+ * Model::GetScalarOutputsAndLogLikelihoodAndGradient(), at the
+ * proposal only.
+ *
+ * During the first NumberOfAdaptationSamples calls to NextSample(),
+ * the step size \f$ \epsilon \f$ is tuned by Robbins-Monro
+ * stochastic approximation so that the acceptance rate approaches
+ * TargetAcceptanceRate. Afterwards it is fixed, so the adaptation
+ * should be done during burn-in.
+ */
+class MetropolisAdjustedLangevinSampler : public Sampler {
+public:
+  MetropolisAdjustedLangevinSampler();
+  virtual ~MetropolisAdjustedLangevinSampler();
+
+  /** Get the next Sample from the distribution. */
+  virtual Sample NextSample();
+
+  //@{
+  /** Set/Get the step size, in units of the interquartile ranges of
+   * the priors. The adaptation starts from this value. Defaults to
+   * 0.1. */
+  void SetStepSize( double stepSize );
+  double GetStepSize() const;
+  //@}
+
+  //@{
+  /** Set/Get the number of calls to NextSample() during which the
+   * step size is adapted. Usually the number of burn-in samples. */
+  void SetNumberOfAdaptationSamples( unsigned int numberOfSamples );
+  unsigned int GetNumberOfAdaptationSamples() const;
+  //@}
+
+  //@{
+  /** Set/Get the acceptance rate that the step size is tuned toward.
+   * Defaults to 0.574, the optimum for MALA in many dimensions. */
+  void SetTargetAcceptanceRate( double rate );
+  double GetTargetAcceptanceRate() const;
+  //@}
+
+  /** Get the fraction of the proposals that were accepted. */
+  double GetAcceptanceRate() const;
+
+  //@{
+  /** The state includes the adapted step size and the gradient at
+   * the current point. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Evaluates the Model and the gradient at the new point. */
+  virtual void ParameterSetExternally();
+
+  /** Evaluate the Model and the gradient at a point. Returns false
+   * if the log likelihood or the gradient is not finite. */
+  bool Evaluate( const std::vector< double > & parameters,
+                 std::vector< double > & outputs,
+                 double & logLikelihood,
+                 std::vector< double > & gradient ) const;
+
+  /** Get the mean of the Langevin step from a point with the given
+   * gradient. */
+  void GetDriftedPoint( const std::vector< double > & parameters,
+                        const std::vector< double > & gradient,
+                        std::vector< double > & drifted ) const;
+
+  /** Log density, up to a constant, of proposing to within the
+   * Gaussian centered at the drifted point. */
+  double GetLogProposalDensity( const std::vector< double > & to,
+                                const std::vector< double > & drifted ) const;
+
+  /** Step size. */
+  double m_StepSize;
+
+  /** Number of calls to NextSample() with adaptation. */
+  unsigned int m_NumberOfAdaptationSamples;
+
+  double m_TargetAcceptanceRate;
+
+  /** Squared interquartile ranges of the priors. */
+  std::vector< double > m_Preconditioner;
+
+  /** Indices of the active parameters. */
+  std::vector< unsigned int > m_ActiveIndices;
+
+  /** Gradient of the log likelihood at the current point, over the
+   * active parameters. */
+  std::vector< double > m_CurrentGradient;
+
+  /** Number of calls to NextSample() so far. */
+  unsigned int m_NumberOfSamples;
+
+  unsigned long int m_NumberOfAcceptedProposals;
+
+}; // end class MetropolisAdjustedLangevinSampler
+
+} // end namespace madai
+
+#endif // madai_MetropolisAdjustedLangevinSampler_h_included
@@ -22,13 +22,16 @@
 #include <cmath> // std::exp
 #include <algorithm> // std::count
 
+#include "Configuration.h"
+
 namespace madai {
 
 
 MetropolisHastingsSampler
 ::MetropolisHastingsSampler() :
   Sampler(),
-  m_StepSize( 1.0e-2 )
+  m_StepSize( 1.0e-2 ),
+  m_SpeculativeDepth( 1 )
 {
 }
 
@@ -58,9 +61,8 @@ MetropolisHastingsSampler
       = priorDist->GetPercentile(0.75) - priorDist->GetPercentile(0.25);
     // set step scales
   }
-  Model * m = const_cast< Model * >(m_Model);
   m_CurrentOutputs.resize( model->GetNumberOfScalarOutputs() );
-  Model::ErrorType error = m->GetScalarOutputsAndLogLikelihood(
+  Model::ErrorType error = m_Model->GetScalarOutputsAndLogLikelihood(
     m_CurrentParameters, m_CurrentOutputs, m_CurrentLogLikelihood);
   // initial starting point LogLikelihood.
   #ifdef NDEBUG
@@ -75,61 +77,336 @@ void MetropolisHastingsSampler
 ::SetStepSize( double stepSize )
 {
   m_StepSize = stepSize;
+  m_PrefetchedSamples.clear();
+  m_PrefetchedAcceptances.clear();
 }
 
-Sample
+
+void
 MetropolisHastingsSampler
-::NextSample()
+::SetSpeculativeDepth( unsigned int depth )
 {
-  // xc is x_candidate
-  Model * m = const_cast< Model * >(m_Model);
+  m_SpeculativeDepth = std::min( std::max( depth, 1u ), 10u );
+  m_PrefetchedSamples.clear();
+  m_PrefetchedAcceptances.clear();
+}
 
-  std::vector< double > xc( m_Model->GetNumberOfParameters(), 0.0 );
-  std::vector< double > yc( m_Model->GetNumberOfScalarOutputs(), 0.0 );
-  std::vector< double > dl_dy( m_Model->GetNumberOfScalarOutputs(), 0.0 );
-  std::vector< double > ydl_dsigmay( m_Model->GetNumberOfScalarOutputs(), 0.0 );
 
-  assert( static_cast<unsigned int>(
-              std::count( m_ActiveParameterIndices.begin(),
-                          m_ActiveParameterIndices.end(), true ))
-          == ( this->GetNumberOfActiveParameters() ) );
+unsigned int
+MetropolisHastingsSampler
+::GetSpeculativeDepth() const
+{
+  return m_SpeculativeDepth;
+}
+
+
+void
+MetropolisHastingsSampler
+::ParameterSetExternally()
+{
+  m_PrefetchedSamples.clear();
+  m_PrefetchedAcceptances.clear();
+  if ( m_Model == NULL ||
+       m_CurrentParameters.size() != m_Model->GetNumberOfParameters() ) {
+    return;
+  }
+  unsigned int numberOfOutputs = m_Model->GetNumberOfScalarOutputs();
+  m_CurrentOutputs.resize( numberOfOutputs );
+  m_CurrentLogLikelihoodValueGradient.resize( numberOfOutputs );
+  m_CurrentLogLikelihoodErrorGradient.resize( numberOfOutputs );
+  Model::ErrorType error =
+    m_Model->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
+      m_CurrentParameters, m_CurrentOutputs, m_CurrentLogLikelihood,
+      m_CurrentLogLikelihoodValueGradient,
+      m_CurrentLogLikelihoodErrorGradient );
+  assert( error == Model::NO_ERROR );
+  (void) error;
+}
+
+
+void
+MetropolisHastingsSampler
+::DrawStep( std::vector< double > & step )
+{
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+  unsigned int numberOfActive = static_cast< unsigned int >(
+    std::count( m_ActiveParameterIndices.begin(),
+                m_ActiveParameterIndices.end(), true ) );
+  step.assign( numberOfParameters, 0.0 );
+  if ( numberOfActive == 0 ) {
+    return;
+  }
 
-  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); i++ ) {
+  // Draw the random directions in one go into the front of step,
+  // then spread them over the active parameters from the back.
+  m_Random.FillGaussian( &step[0], numberOfActive );
+  unsigned int j = numberOfActive;
+  for ( unsigned int i = numberOfParameters; i-- > 0; ) {
     if ( m_ActiveParameterIndices[i] ) {
-      double step
+      step[i]
         = (m_StepSize   // scale each step by this variable
-           * m_Random.Gaussian() // random direction, length
+           * step[--j] // random direction, length
            * m_StepScales[i]); // scaled by parameter domain size
-      xc[i] = m_CurrentParameters[i] + step;
     } else {
-      xc[i] = m_CurrentParameters[i];
+      step[i] = 0.0;
+    }
+  }
+}
+
+
+void
+MetropolisHastingsSampler
+::PrefetchSamples()
+{
+  unsigned int depth = m_SpeculativeDepth;
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+  unsigned int numberOfOutputs = m_Model->GetNumberOfScalarOutputs();
+
+  // Draw the random numbers in the order of the serial chain.
+  std::vector< std::vector< double > > & steps = m_PrefetchSteps;
+  std::vector< double > & uniforms = m_PrefetchUniforms;
+  steps.resize( depth );
+  uniforms.resize( depth );
+  for ( unsigned int j = 0; j < depth; ++j ) {
+    this->DrawStep( steps[j] );
+    uniforms[j] = m_Random.Uniform();
+  }
+
+  // Node p of level j, at index 2^j - 1 + p, is the proposal of step
+  // j after the decisions in the bits of p, the last decision in the
+  // lowest bit. Its parent's state is the current state if that
+  // proposal was rejected, and the parent's proposal otherwise.
+  int numberOfNodes = ( 1 << depth ) - 1;
+  std::vector< std::vector< double > > & proposals = m_PrefetchProposals;
+  std::vector< std::vector< double > > & bases = m_PrefetchBases;
+  proposals.resize( numberOfNodes );
+  bases.resize( numberOfNodes );
+  bases[0] = m_CurrentParameters;
+  for ( unsigned int j = 0; j < depth; ++j ) {
+    unsigned int first = ( 1u << j ) - 1;
+    for ( unsigned int p = 0; p < ( 1u << j ); ++p ) {
+      unsigned int n = first + p;
+      if ( j > 0 ) {
+        unsigned int parent = ( first - 1 ) / 2 + p / 2;
+        bases[n] = ( p & 1 ) ? proposals[ parent ] : bases[ parent ];
+      }
+      std::vector< double > & xc = proposals[n];
+      xc.resize( numberOfParameters );
+      for ( unsigned int i = 0; i < numberOfParameters; i++ ) {
+        xc[i] = m_ActiveParameterIndices[i] ?
+          bases[n][i] + steps[j][i] : bases[n][i];
+      }
     }
   }
+
+  std::vector< std::vector< double > > & outputs = m_PrefetchOutputs;
+  std::vector< double > & logLikelihoods = m_PrefetchLogLikelihoods;
+  std::vector< std::vector< double > > & valueGradients =
+    m_PrefetchValueGradients;
+  std::vector< std::vector< double > > & errorGradients =
+    m_PrefetchErrorGradients;
+  outputs.resize( numberOfNodes );
+  logLikelihoods.resize( numberOfNodes );
+  valueGradients.resize( numberOfNodes );
+  errorGradients.resize( numberOfNodes );
+  for ( int n = 0; n < numberOfNodes; ++n ) {
+    outputs[n].assign( numberOfOutputs, 0.0 );
+    valueGradients[n].assign( numberOfOutputs, 0.0 );
+    errorGradients[n].assign( numberOfOutputs, 0.0 );
+  }
+  bool concurrent = m_Model->SupportsConcurrentEvaluation();
+  (void)concurrent; // only used by OpenMP
+#if defined( OPENMP_FOUND )
+  #pragma omp parallel for if ( concurrent )
+#endif // OPENMP_FOUND
+  for ( int n = 0; n < numberOfNodes; ++n ) {
+    m_Model->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
+      proposals[n], outputs[n], logLikelihoods[n],
+      valueGradients[n], errorGradients[n] );
+  }
+
+  // Walk down the tree, deciding as the serial chain would.
+  unsigned int p = 0;
+  for ( unsigned int j = 0; j < depth; ++j ) {
+    unsigned int n = ( 1u << j ) - 1 + p;
+    double ll = logLikelihoods[n];
+
+    // Check for NaN
+    assert( ll == ll );
+
+    double delta_logLikelihood = ll - m_CurrentLogLikelihood;
+    bool accepted = ( (delta_logLikelihood > 0) ||
+                      (std::exp(delta_logLikelihood) > uniforms[j]) );
+    if ( accepted ) {
+      m_CurrentLogLikelihood = ll;
+      m_CurrentParameters = proposals[n];
+      m_CurrentOutputs = outputs[n];
+      m_CurrentLogLikelihoodValueGradient = valueGradients[n];
+      m_CurrentLogLikelihoodErrorGradient = errorGradients[n];
+      p = 2 * p + 1;
+    } else {
+      p = 2 * p;
+    }
+    m_PrefetchedAcceptances.push_back( accepted );
+    m_PrefetchedSamples.push_back(
+      Sample( m_CurrentParameters,
+              m_CurrentOutputs,
+              m_CurrentLogLikelihood,
+              m_CurrentLogLikelihoodValueGradient,
+              m_CurrentLogLikelihoodErrorGradient ) );
+  }
+}
+
+
+void
+MetropolisHastingsSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "MetropolisHastingsSampler" );
+  o << m_PrefetchedSamples.size() << '\n';
+  for ( size_t k = 0; k < m_PrefetchedSamples.size(); ++k ) {
+    WriteSample( o, m_PrefetchedSamples[k] );
+    o << m_PrefetchedAcceptances[k] << '\n';
+  }
+}
+
+
+bool
+MetropolisHastingsSampler
+::ReadState( std::istream & i )
+{
+  size_t numberOfSamples;
+  if ( !Sampler::ReadState( i ) ||
+       !ReadTag( i, "MetropolisHastingsSampler" ) ||
+       !( i >> numberOfSamples ) ) {
+    return false;
+  }
+  std::deque< Sample > samples( numberOfSamples );
+  std::deque< bool > acceptances( numberOfSamples );
+  for ( size_t k = 0; k < numberOfSamples; ++k ) {
+    bool accepted;
+    if ( !ReadSample( i, samples[k] ) || !( i >> accepted ) ) {
+      return false;
+    }
+    acceptances[k] = accepted;
+  }
+  m_PrefetchedSamples.swap( samples );
+  m_PrefetchedAcceptances.swap( acceptances );
+  return true;
+}
+
+
+bool
+MetropolisHastingsSampler
+::IsSpeculative() const
+{
+  return ( m_SpeculativeDepth > 1 );
+}
+
+
+bool
+MetropolisHastingsSampler
+::Step()
+{
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+  unsigned int numberOfOutputs = m_Model->GetNumberOfScalarOutputs();
+
+  // xc is x_candidate
+  std::vector< double > & xc = m_CandidateParameters;
+  xc.resize( numberOfParameters );
+  m_CandidateOutputs.resize( numberOfOutputs );
+  m_CandidateLogLikelihoodValueGradient.resize( numberOfOutputs );
+  m_CandidateLogLikelihoodErrorGradient.resize( numberOfOutputs );
+
+  this->DrawStep( m_Step );
+  for ( unsigned int i = 0; i < numberOfParameters; i++ ) {
+    xc[i] = m_ActiveParameterIndices[i] ?
+      m_CurrentParameters[i] + m_Step[i] : m_CurrentParameters[i];
+  }
   double ll; // ll is new_log_likelihood
-  m->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(xc,yc,ll,dl_dy,ydl_dsigmay);
+  m_Model->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
+    xc, m_CandidateOutputs, ll,
+    m_CandidateLogLikelihoodValueGradient,
+    m_CandidateLogLikelihoodErrorGradient );
 
   // Check for NaN
   assert( ll == ll );
 
+  // The uniform is drawn even when it is not needed, so that every
+  // step uses the same random numbers, which PrefetchSamples() relies on.
+  double uniform = m_Random.Uniform();
   double delta_logLikelihood = ll - m_CurrentLogLikelihood;
 
   if ((delta_logLikelihood > 0) ||
-      (std::exp(delta_logLikelihood) > m_Random.Uniform())) {
+      (std::exp(delta_logLikelihood) > uniform)) {
     m_CurrentLogLikelihood = ll;
-    m_CurrentParameters = xc;
-    m_CurrentOutputs = yc;
-    m_CurrentLogLikelihoodValueGradient = dl_dy;
-    m_CurrentLogLikelihoodErrorGradient = ydl_dsigmay;
-    return Sample( xc, yc, ll, dl_dy, ydl_dsigmay);
+    m_CurrentParameters.swap( xc );
+    m_CurrentOutputs.swap( m_CandidateOutputs );
+    m_CurrentLogLikelihoodValueGradient.swap(
+      m_CandidateLogLikelihoodValueGradient );
+    m_CurrentLogLikelihoodErrorGradient.swap(
+      m_CandidateLogLikelihoodErrorGradient );
+    return true;
   }
 
   // Stay at this point in parameter space
+  return false;
+}
+
+
+Sample
+MetropolisHastingsSampler
+::NextSample()
+{
+  assert( static_cast<unsigned int>(
+              std::count( m_ActiveParameterIndices.begin(),
+                          m_ActiveParameterIndices.end(), true ))
+          == ( this->GetNumberOfActiveParameters() ) );
+
+  if ( this->IsSpeculative() ) {
+    if ( m_PrefetchedSamples.empty() ) {
+      this->PrefetchSamples();
+    }
+    Sample sample = m_PrefetchedSamples.front();
+    m_PrefetchedSamples.pop_front();
+    m_PrefetchedAcceptances.pop_front();
+    return sample;
+  }
+
+  this->Step();
   return Sample( m_CurrentParameters,
                  m_CurrentOutputs,
-                 m_CurrentLogLikelihood, 
+                 m_CurrentLogLikelihood,
                  m_CurrentLogLikelihoodValueGradient,
-                 m_CurrentLogLikelihoodErrorGradient);
+                 m_CurrentLogLikelihoodErrorGradient );
+}
+
 
+void
+MetropolisHastingsSampler
+::NextSamples( unsigned int numberOfSamples, SampleBlock & block )
+{
+  block.Resize( numberOfSamples, m_Model->GetNumberOfParameters(),
+                m_Model->GetNumberOfScalarOutputs() );
+  bool speculative = this->IsSpeculative();
+  for ( unsigned int i = 0; i < numberOfSamples; ++i ) {
+    if ( speculative ) {
+      if ( m_PrefetchedSamples.empty() ) {
+        this->PrefetchSamples();
+      }
+      block.SetSample( i, m_PrefetchedSamples.front(),
+                       m_PrefetchedAcceptances.front() );
+      m_PrefetchedSamples.pop_front();
+      m_PrefetchedAcceptances.pop_front();
+    } else {
+      bool accepted = this->Step();
+      block.SetSample( i, m_CurrentParameters, m_CurrentOutputs,
+                       m_CurrentLogLikelihood,
+                       m_CurrentLogLikelihoodValueGradient,
+                       m_CurrentLogLikelihoodErrorGradient, accepted );
+    }
+  }
 }
 
 } // end namespace madai
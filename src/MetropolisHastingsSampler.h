@@ -19,6 +19,7 @@
 #ifndef madai_MetropolisHastingsSampler_h_included
 #define madai_MetropolisHastingsSampler_h_included
 
+#include <deque>
 
 #include "Sampler.h"
 
@@ -30,6 +31,19 @@ namespace madai {
  *
  * This is an implementation of the Metropolis-Hastings
  * sampling algorithm.
+ *
+ * With a SpeculativeDepth k above 1, the sampler prefetches k steps
+ * at a time. It draws the random numbers of the next k steps, builds
+ * the tree of the \f$ 2^k - 1 \f$ proposals that the accept/reject
+ * decisions could lead to, and evaluates all of them at once, in
+ * parallel threads if the Model supports concurrent evaluation. The
+ * decisions are then made along the tree. The chain is identical to
+ * the one of the serial sampler with the same seed, but advances k
+ * steps in the wall-clock time of one Model evaluation when enough
+ * cores are idle. Setting a parameter value or the step size in the
+ * middle of a block drops the rest of the block, whose random numbers
+ * are already drawn, so the chains only stay equal when that happens
+ * between blocks.
  */
 class MetropolisHastingsSampler : public Sampler {
 public:
@@ -39,6 +53,10 @@ public:
   /** Get the next Sample from the distribution. */
   virtual Sample NextSample();
 
+  /** Get the next Samples into a block, taking the acceptance of each
+   * step from the accept/reject decision. */
+  virtual void NextSamples( unsigned int numberOfSamples, SampleBlock & block );
+
   //@{
   /** Set/Get the StepSize, which controls the average distance in Parameter
    *  space to move.
@@ -54,6 +72,22 @@ public:
   virtual double GetStepSize() { return this->m_StepSize; }
   //@}
 
+  //@{
+  /** Set/Get the number of steps evaluated together. 1, the default,
+   * evaluates one step at a time. Each block of k steps costs
+   * \f$ 2^k - 1 \f$ Model evaluations, so k should be small enough
+   * for that many evaluations to run in parallel. At most 10. */
+  void SetSpeculativeDepth( unsigned int depth );
+  unsigned int GetSpeculativeDepth() const;
+  //@}
+
+  //@{
+  /** The state includes the Samples of a prefetched block that have
+   * not been returned yet. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
 protected:
   /**
      Maximum distance in Parameter space to move, under euclidean L2
@@ -64,13 +98,60 @@ protected:
 protected:
   virtual void Initialize( const Model * model );
 
+  /** Evaluates the Model at the new point and drops prefetched
+   * samples. */
+  virtual void ParameterSetExternally();
+
+  /** Draw a random step. Inactive parameters get a zero step. */
+  void DrawStep( std::vector< double > & step );
+
+  /** Take SpeculativeDepth steps and queue their samples. */
+  void PrefetchSamples();
+
+  /** Returns true if the Samples come from PrefetchSamples() rather
+   * than Step(). Subclasses that override Step() without a
+   * speculative version of it override this to return false. */
+  virtual bool IsSpeculative() const;
+
+  /** Take one step of the chain from the current point, and return
+   * true if the proposal was accepted. The proposal is built in the
+   * candidate members, which are swapped with the current point on
+   * acceptance, so that a step allocates nothing. */
+  virtual bool Step();
+
   /** based on the length scales of the parameter space */
   std::vector< double > m_StepScales;
 
-private:
+  /** Number of steps evaluated together. */
+  unsigned int m_SpeculativeDepth;
+
+  /** Samples computed ahead by PrefetchSamples(). */
+  std::deque< Sample > m_PrefetchedSamples;
+
+  /** Whether the steps of m_PrefetchedSamples were accepted. */
+  std::deque< bool > m_PrefetchedAcceptances;
 
-  /** Random number object */
-  madai::Random m_Random;
+  //@{
+  /** Storage of Step() for the step and the proposed point. */
+  std::vector< double > m_Step;
+  std::vector< double > m_CandidateParameters;
+  std::vector< double > m_CandidateOutputs;
+  std::vector< double > m_CandidateLogLikelihoodValueGradient;
+  std::vector< double > m_CandidateLogLikelihoodErrorGradient;
+  //@}
+
+  //@{
+  /** Storage of PrefetchSamples() for the steps and the tree of
+   * proposals, kept to avoid allocating them at every call. */
+  std::vector< std::vector< double > > m_PrefetchSteps;
+  std::vector< double > m_PrefetchUniforms;
+  std::vector< std::vector< double > > m_PrefetchProposals;
+  std::vector< std::vector< double > > m_PrefetchBases;
+  std::vector< std::vector< double > > m_PrefetchOutputs;
+  std::vector< double > m_PrefetchLogLikelihoods;
+  std::vector< std::vector< double > > m_PrefetchValueGradients;
+  std::vector< std::vector< double > > m_PrefetchErrorGradients;
+  //@}
 }; // end class MetropolisHastingsSampler
 
 } // end namespace madai
@@ -0,0 +1,334 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "MetropolisWithinGibbsSampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+namespace madai {
+
+
+MetropolisWithinGibbsSampler
+::MetropolisWithinGibbsSampler() :
+  Sampler(),
+  m_StepSize( 0.1 ),
+  m_NumberOfAdaptationSamples( 0 ),
+  m_TargetAcceptanceRate( 0.44 ),
+  m_NumberOfSweeps( 0 ),
+  m_NumberOfProposals( 0 ),
+  m_NumberOfAcceptedProposals( 0 )
+{
+}
+
+
+MetropolisWithinGibbsSampler
+::~MetropolisWithinGibbsSampler()
+{
+}
+
+
+void
+MetropolisWithinGibbsSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+  m_CurrentCache.reset( model->NewEvaluationCache() );
+  m_ProposalCache.reset( model->NewEvaluationCache() );
+
+  Sampler::Initialize( model );
+
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  m_StepScales.resize( model->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < model->GetNumberOfParameters(); ++i ) {
+    const Distribution * priorDist = params[i].GetPriorDistribution();
+    m_CurrentParameters[i] = priorDist->GetSample( m_Random );
+    m_StepScales[i] =
+      priorDist->GetPercentile( 0.75 ) - priorDist->GetPercentile( 0.25 );
+  }
+  m_LogStepSizes.assign( model->GetNumberOfParameters(),
+                         std::log( m_StepSize ) );
+  m_ParameterBlocks.clear();
+  m_NumberOfSweeps = 0;
+  m_NumberOfProposals = 0;
+  m_NumberOfAcceptedProposals = 0;
+  this->ParameterSetExternally();
+}
+
+
+void
+MetropolisWithinGibbsSampler
+::ParameterSetExternally()
+{
+  if ( m_Model == NULL ||
+       m_CurrentParameters.size() != m_Model->GetNumberOfParameters() ) {
+    return;
+  }
+  std::vector< unsigned int > allParameters( m_CurrentParameters.size() );
+  for ( unsigned int i = 0; i < allParameters.size(); ++i ) {
+    allParameters[i] = i;
+  }
+  Model::ErrorType error =
+    m_Model->GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+      m_CurrentParameters, allParameters, NULL, m_CurrentCache.get(),
+      m_CurrentOutputs, m_CurrentLogLikelihood );
+  assert( error == Model::NO_ERROR );
+  (void) error;
+}
+
+
+void
+MetropolisWithinGibbsSampler
+::SetStepSize( double stepSize )
+{
+  if ( stepSize > 0.0 ) {
+    m_StepSize = stepSize;
+    m_LogStepSizes.assign( m_LogStepSizes.size(), std::log( m_StepSize ) );
+  }
+}
+
+
+double
+MetropolisWithinGibbsSampler
+::GetStepSize() const
+{
+  return m_StepSize;
+}
+
+
+double
+MetropolisWithinGibbsSampler
+::GetParameterStepSize( unsigned int parameterIndex ) const
+{
+  if ( parameterIndex >= m_LogStepSizes.size() ) {
+    return 0.0;
+  }
+  return std::exp( m_LogStepSizes[ parameterIndex ] );
+}
+
+
+Sampler::ErrorType
+MetropolisWithinGibbsSampler
+::AddParameterBlock( const std::vector< std::string > & parameterNames )
+{
+  std::vector< unsigned int > block;
+  for ( unsigned int i = 0; i < parameterNames.size(); ++i ) {
+    unsigned int index = this->GetParameterIndex( parameterNames[i] );
+    if ( index == static_cast< unsigned int >( -1 ) ) {
+      return INVALID_PARAMETER_INDEX_ERROR;
+    }
+    for ( unsigned int b = 0; b < m_ParameterBlocks.size(); ++b ) {
+      if ( std::find( m_ParameterBlocks[b].begin(), m_ParameterBlocks[b].end(),
+                      index ) != m_ParameterBlocks[b].end() ) {
+        return INVALID_PARAMETER_INDEX_ERROR;
+      }
+    }
+    if ( std::find( block.begin(), block.end(), index ) == block.end() ) {
+      block.push_back( index );
+    }
+  }
+  if ( !block.empty() ) {
+    m_ParameterBlocks.push_back( block );
+  }
+  return NO_ERROR;
+}
+
+
+void
+MetropolisWithinGibbsSampler
+::ClearParameterBlocks()
+{
+  m_ParameterBlocks.clear();
+}
+
+
+void
+MetropolisWithinGibbsSampler
+::SetNumberOfAdaptationSamples( unsigned int numberOfSamples )
+{
+  m_NumberOfAdaptationSamples = numberOfSamples;
+}
+
+
+unsigned int
+MetropolisWithinGibbsSampler
+::GetNumberOfAdaptationSamples() const
+{
+  return m_NumberOfAdaptationSamples;
+}
+
+
+void
+MetropolisWithinGibbsSampler
+::SetTargetAcceptanceRate( double rate )
+{
+  if ( rate > 0.0 && rate < 1.0 ) {
+    m_TargetAcceptanceRate = rate;
+  }
+}
+
+
+double
+MetropolisWithinGibbsSampler
+::GetTargetAcceptanceRate() const
+{
+  return m_TargetAcceptanceRate;
+}
+
+
+double
+MetropolisWithinGibbsSampler
+::GetAcceptanceRate() const
+{
+  if ( m_NumberOfProposals == 0 ) {
+    return 0.0;
+  }
+  return static_cast< double >( m_NumberOfAcceptedProposals ) /
+    static_cast< double >( m_NumberOfProposals );
+}
+
+
+void
+MetropolisWithinGibbsSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "MetropolisWithinGibbsSampler" );
+  WriteValues( o, m_LogStepSizes );
+  o << m_NumberOfSweeps << ' ' << m_NumberOfProposals << ' '
+    << m_NumberOfAcceptedProposals << '\n';
+}
+
+
+bool
+MetropolisWithinGibbsSampler
+::ReadState( std::istream & i )
+{
+  if ( !Sampler::ReadState( i ) ||
+       !ReadTag( i, "MetropolisWithinGibbsSampler" ) ||
+       !ReadValues( i, m_LogStepSizes ) ||
+       !( i >> m_NumberOfSweeps >> m_NumberOfProposals
+            >> m_NumberOfAcceptedProposals ) ) {
+    return false;
+  }
+
+  // Rebuild the cache of the partial updates at the restored point,
+  // keeping the restored outputs.
+  std::vector< unsigned int > allParameters( m_CurrentParameters.size() );
+  for ( unsigned int k = 0; k < allParameters.size(); ++k ) {
+    allParameters[k] = k;
+  }
+  std::vector< double > outputs;
+  double logLikelihood;
+  return ( m_Model->GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+             m_CurrentParameters, allParameters, NULL, m_CurrentCache.get(),
+             outputs, logLikelihood ) == Model::NO_ERROR );
+}
+
+
+std::vector< std::vector< unsigned int > >
+MetropolisWithinGibbsSampler
+::GetActiveBlocks() const
+{
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+  std::vector< bool > inBlock( numberOfParameters, false );
+  std::vector< std::vector< unsigned int > > blocks;
+  for ( unsigned int b = 0; b < m_ParameterBlocks.size(); ++b ) {
+    std::vector< unsigned int > block;
+    for ( unsigned int k = 0; k < m_ParameterBlocks[b].size(); ++k ) {
+      unsigned int i = m_ParameterBlocks[b][k];
+      inBlock[i] = true;
+      if ( m_ActiveParameterIndices[i] ) {
+        block.push_back( i );
+      }
+    }
+    if ( !block.empty() ) {
+      blocks.push_back( block );
+    }
+  }
+  for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+    if ( m_ActiveParameterIndices[i] && !inBlock[i] ) {
+      blocks.push_back( std::vector< unsigned int >( 1, i ) );
+    }
+  }
+  return blocks;
+}
+
+
+void
+MetropolisWithinGibbsSampler
+::UpdateBlock( const std::vector< unsigned int > & block )
+{
+  std::vector< double > proposal( m_CurrentParameters );
+  for ( unsigned int k = 0; k < block.size(); ++k ) {
+    unsigned int i = block[k];
+    proposal[i] += std::exp( m_LogStepSizes[i] ) * m_StepScales[i] *
+      m_Random.Gaussian();
+  }
+
+  std::vector< double > outputs;
+  double logLikelihood;
+  Model::ErrorType error =
+    m_Model->GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+      proposal, block, m_CurrentCache.get(), m_ProposalCache.get(),
+      outputs, logLikelihood );
+
+  double delta = logLikelihood - m_CurrentLogLikelihood;
+  double acceptanceProbability = 0.0;
+  if ( error == Model::NO_ERROR && delta == delta ) {
+    acceptanceProbability = ( delta >= 0.0 ) ? 1.0 : std::exp( delta );
+  }
+  ++m_NumberOfProposals;
+  if ( acceptanceProbability >= 1.0 ||
+       m_Random.Uniform() < acceptanceProbability ) {
+    m_CurrentParameters = proposal;
+    m_CurrentOutputs = outputs;
+    m_CurrentLogLikelihood = logLikelihood;
+    std::swap( m_CurrentCache, m_ProposalCache );
+    ++m_NumberOfAcceptedProposals;
+  }
+
+  if ( !m_AdaptationEnded && m_NumberOfSweeps < m_NumberOfAdaptationSamples ) {
+    double gain = std::pow( static_cast< double >( m_NumberOfSweeps + 1 ), -0.6 );
+    for ( unsigned int k = 0; k < block.size(); ++k ) {
+      m_LogStepSizes[ block[k] ] +=
+        gain * ( acceptanceProbability - m_TargetAcceptanceRate );
+    }
+  }
+}
+
+
+Sample
+MetropolisWithinGibbsSampler
+::NextSample()
+{
+  std::vector< std::vector< unsigned int > > blocks = this->GetActiveBlocks();
+  for ( unsigned int b = 0; b < blocks.size(); ++b ) {
+    this->UpdateBlock( blocks[b] );
+  }
+  ++m_NumberOfSweeps;
+
+  return Sample( m_CurrentParameters,
+                 m_CurrentOutputs,
+                 m_CurrentLogLikelihood );
+}
+
+} // end namespace madai
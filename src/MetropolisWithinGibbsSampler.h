@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_MetropolisWithinGibbsSampler_h_included
+#define madai_MetropolisWithinGibbsSampler_h_included
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/**
+ * \class MetropolisWithinGibbsSampler
+ *
+ * Component-wise Metropolis sampler. Each call to NextSample() sweeps
+ * over the blocks of active parameters in turn and updates each block
+ * with a Metropolis step that moves only the parameters of that
+ * block. By default every active parameter is a block of its own;
+ * parameters that are strongly correlated can be grouped with
+ * AddParameterBlock().
+ *
+ * Every parameter has its own step size, in units of the
+ * interquartile range of its prior. During the first
+ * NumberOfAdaptationSamples sweeps, the step sizes of a block are
+ * tuned by Robbins-Monro stochastic approximation so that the
+ * acceptance rate of the block approaches TargetAcceptanceRate. This
+ * mixes much better than one global step size when the posterior is
+ * narrow in some parameters and wide in others. Afterwards the step
+ * sizes are frozen, so the adaptation should be done during burn-in.
+ *
+ * The Model is evaluated through
+ * Model::GetScalarOutputsAndLogLikelihoodOfPartialUpdate() with the
+ * indices of the parameters of the block, so that Models that keep
+ * an EvaluationCache can skip the work that depends only on the
+ * unchanged parameters.
+ */
+class MetropolisWithinGibbsSampler : public Sampler {
+public:
+  MetropolisWithinGibbsSampler();
+  virtual ~MetropolisWithinGibbsSampler();
+
+  /** Update each block once and return the resulting Sample. */
+  virtual Sample NextSample();
+
+  //@{
+  /** Set/Get the initial step size of each parameter, in units of the
+   * interquartile range of its prior. Resets the step sizes of all
+   * parameters. Defaults to 0.1. */
+  void SetStepSize( double stepSize );
+  double GetStepSize() const;
+  //@}
+
+  /** Get the current step size of a parameter, in units of the
+   * interquartile range of its prior. */
+  double GetParameterStepSize( unsigned int parameterIndex ) const;
+
+  /** Update the named parameters together. A parameter can belong to
+   * one block only. Parameters in no block are updated one at a
+   * time. */
+  ErrorType AddParameterBlock( const std::vector< std::string > & parameterNames );
+
+  /** Update every parameter on its own again. */
+  void ClearParameterBlocks();
+
+  //@{
+  /** Set/Get the number of calls to NextSample() during which the
+   * step sizes are adapted. Usually the number of burn-in samples. */
+  void SetNumberOfAdaptationSamples( unsigned int numberOfSamples );
+  unsigned int GetNumberOfAdaptationSamples() const;
+  //@}
+
+  //@{
+  /** Set/Get the acceptance rate of each block that the step sizes
+   * are tuned toward. Defaults to 0.44, the optimum for updates of
+   * one parameter. */
+  void SetTargetAcceptanceRate( double rate );
+  double GetTargetAcceptanceRate() const;
+  //@}
+
+  /** Get the fraction of the block updates that were accepted. */
+  double GetAcceptanceRate() const;
+
+  //@{
+  /** The state includes the adapted step sizes. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Evaluates the Model at the new point from scratch. */
+  virtual void ParameterSetExternally();
+
+  /** Get the blocks of active parameters, as indices. */
+  std::vector< std::vector< unsigned int > > GetActiveBlocks() const;
+
+  /** Propose a move of one block and accept or reject it. */
+  void UpdateBlock( const std::vector< unsigned int > & block );
+
+  /** Initial step size. */
+  double m_StepSize;
+
+  /** Interquartile ranges of the priors. */
+  std::vector< double > m_StepScales;
+
+  /** Logarithms of the step sizes of the parameters. */
+  std::vector< double > m_LogStepSizes;
+
+  /** Blocks given to AddParameterBlock(), as indices. */
+  std::vector< std::vector< unsigned int > > m_ParameterBlocks;
+
+  unsigned int m_NumberOfAdaptationSamples;
+
+  double m_TargetAcceptanceRate;
+
+  /** Number of sweeps so far. */
+  unsigned int m_NumberOfSweeps;
+
+  unsigned long int m_NumberOfProposals;
+
+  unsigned long int m_NumberOfAcceptedProposals;
+
+  /** Model caches at the current point and at the proposal. */
+  boost::shared_ptr< Model::EvaluationCache > m_CurrentCache;
+  boost::shared_ptr< Model::EvaluationCache > m_ProposalCache;
+
+}; // end class MetropolisWithinGibbsSampler
+
+} // end namespace madai
+
+#endif // madai_MetropolisWithinGibbsSampler_h_included
@@ -17,6 +17,7 @@
  *=========================================================================*/
 
 #include "Model.h"
+#include "Configuration.h"
 
 #include <Eigen/Dense>
 
@@ -53,6 +54,12 @@ Model
 }
 
 
+Model::EvaluationCache
+::~EvaluationCache()
+{
+}
+
+
 bool
 Model
 ::IsReady() const
@@ -61,6 +68,14 @@ Model
 }
 
 
+bool
+Model
+::SupportsConcurrentEvaluation() const
+{
+  return false;
+}
+
+
 unsigned int
 Model
 ::GetNumberOfParameters() const
@@ -179,6 +194,27 @@ Model
   return NO_ERROR;
 }
 
+
+Model::ErrorType
+Model
+::GetScalarOutputsAndLogLikelihoodAndGradient(
+  const std::vector< double > & parameters,
+  const std::vector< bool > & activeParameters,
+  std::vector< double > & scalars,
+  double & logLikelihood,
+  std::vector< double > & gradient) const
+{
+  Model::ErrorType error = this->GetScalarAndGradientOutputs(
+    parameters, activeParameters, scalars, gradient );
+  if ( error != NO_ERROR ) {
+    return error;
+  }
+
+  return this->GetScalarOutputsAndLogLikelihood(
+    parameters, scalars, logLikelihood );
+}
+
+
 void
 Model
 ::SetGradientEstimateStepSize( double stepSize )
@@ -238,7 +274,7 @@ Model
 
 bool
 Model
-::GetUseModelCovarianceToCalulateLogLikelihood()
+::GetUseModelCovarianceToCalulateLogLikelihood() const
 {
   return m_UseModelCovarianceToCalulateLogLikelihood;
 }
@@ -259,6 +295,23 @@ Model
 {
   m_Parameters.push_back(
     Parameter(name, priorDistribution) );
+  this->UpdateCompiledPrior();
+}
+
+
+void
+Model
+::UpdateCompiledPrior()
+{
+  m_CompiledPrior.SetParameters( m_Parameters );
+}
+
+
+const CompiledPrior &
+Model
+::GetCompiledPrior() const
+{
+  return m_CompiledPrior;
 }
 
 
@@ -345,11 +398,7 @@ Model
 
 
   logLikelihood = std::numeric_limits< double >::signaling_NaN();
-  double logPriorLikelihood
-    = this->GetLogPriorLikelihood(parameters);
 
-  size_t t = this->GetNumberOfScalarOutputs();
-  assert(t > 0);
   std::vector< double > scalarCovariance;
   // initially scalarCovariance is a empty vector
   Model::ErrorType result;
@@ -362,6 +411,25 @@ Model
   }
   if (result != NO_ERROR)
     return result;
+  return this->GetLogLikelihoodOfScalarOutputs(
+    parameters, scalars, scalarCovariance, logLikelihood);
+}
+
+
+Model::ErrorType
+Model
+::GetLogLikelihoodOfScalarOutputs(
+    const std::vector< double > & parameters,
+    const std::vector< double > & scalars,
+    const std::vector< double > & scalarCovariance,
+    double & logLikelihood) const
+{
+  logLikelihood = std::numeric_limits< double >::signaling_NaN();
+  double logPriorLikelihood
+    = this->GetLogPriorLikelihood(parameters);
+
+  size_t t = this->GetNumberOfScalarOutputs();
+  assert(t > 0);
   if (scalars.size() != t)
     return OTHER_ERROR;
 
@@ -531,6 +599,60 @@ Model
 }
 
 
+Model::ErrorType
+Model
+::GetScalarOutputsAndLogLikelihoods(
+  const std::vector< std::vector< double > > & parameters,
+  std::vector< std::vector< double > > & scalars,
+  std::vector< double > & logLikelihoods) const
+{
+  int numberOfPoints = static_cast< int >( parameters.size() );
+  scalars.resize( numberOfPoints );
+  logLikelihoods.resize( numberOfPoints );
+  std::vector< ErrorType > errors( numberOfPoints, NO_ERROR );
+
+  bool concurrent = this->SupportsConcurrentEvaluation();
+  (void)concurrent; // only used by OpenMP
+#if defined( OPENMP_FOUND )
+  #pragma omp parallel for if ( concurrent )
+#endif // OPENMP_FOUND
+  for ( int i = 0; i < numberOfPoints; ++i ) {
+    errors[i] = this->GetScalarOutputsAndLogLikelihood(
+      parameters[i], scalars[i], logLikelihoods[i] );
+  }
+
+  for ( int i = 0; i < numberOfPoints; ++i ) {
+    if ( errors[i] != NO_ERROR ) {
+      return errors[i];
+    }
+  }
+  return NO_ERROR;
+}
+
+
+Model::EvaluationCache *
+Model
+::NewEvaluationCache() const
+{
+  return NULL;
+}
+
+
+Model::ErrorType
+Model
+::GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+  const std::vector< double > & parameters,
+  const std::vector< unsigned int > & /* changedParameters */,
+  const EvaluationCache * /* previous */,
+  EvaluationCache * /* current */,
+  std::vector< double > & scalars,
+  double & logLikelihood) const
+{
+  return this->GetScalarOutputsAndLogLikelihood(
+    parameters, scalars, logLikelihood );
+}
+
+
 /** return the sum of the LogPriorLikelihood for each x[i] */
 double
 Model
@@ -538,6 +660,9 @@ Model
 {
   const std::vector< Parameter > & params = this->GetParameters();
   assert(x.size() == params.size());
+  if ( !x.empty() && m_CompiledPrior.IsCompiledFrom( params ) ) {
+    return m_CompiledPrior.GetLogPriorLikelihood( &x[0] );
+  }
   double logPriorLikelihood = 0.0;
   for ( size_t i = 0; i < params.size(); ++i ) {
     logPriorLikelihood +=
@@ -552,15 +677,30 @@ std::vector< double >
 Model
 ::GetGradientOfLogPriorLikelihood(
   const std::vector< double > & x) const
+{
+  std::vector< double > gradient;
+  this->GetGradientOfLogPriorLikelihood( x, gradient );
+  return gradient;
+}
+
+
+void
+Model
+::GetGradientOfLogPriorLikelihood(
+  const std::vector< double > & x,
+  std::vector< double > & gradient ) const
 {
   const std::vector< Parameter > & params = this->GetParameters();
   assert(x.size() == params.size());
-  std::vector< double > gradient;
+  gradient.resize( params.size() );
+  if ( !x.empty() && m_CompiledPrior.IsCompiledFrom( params ) ) {
+    m_CompiledPrior.GetGradientOfLogPriorLikelihood( &x[0], &gradient[0] );
+    return;
+  }
   for ( size_t i = 0; i < params.size(); i++ ) {
-    gradient.push_back(
-      params[i].GetPriorDistribution()->GetGradientLogProbabilityDensity( x[i]) );
+    gradient[i] =
+      params[i].GetPriorDistribution()->GetGradientLogProbabilityDensity( x[i] );
   }
-  return gradient;
 }
 
 
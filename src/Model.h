@@ -23,6 +23,7 @@
 #include <vector>
 #include <iostream>
 
+#include "CompiledPrior.h"
 #include "Parameter.h"
 #include "Random.h"
 
@@ -34,7 +35,13 @@ namespace madai {
  * Base class for Models. A Model's primary function is to compute
  * model values from a point in the Model's parameter space. In
  * addition, the log likelihood that the Model's scalar values match
- * the observed values from the system being modeled can be computed. */
+ * the observed values from the system being modeled can be computed.
+ *
+ * Reentrancy contract: the const evaluation methods must not modify
+ * the Model. Anything they need is built when the Model is set up.
+ * Models whose const evaluation methods may also be called from
+ * several threads at once, for instance to run many chains against
+ * one emulator, report this through SupportsConcurrentEvaluation(). */
 class Model {
 public:
 
@@ -62,6 +69,18 @@ public:
     OTHER_ERROR
   } ErrorType;
 
+  /** \class EvaluationCache
+   *
+   * Work that a Model can keep from the evaluation at one point to
+   * speed up the evaluation at a point that differs from it in a few
+   * parameters. Caches are created by NewEvaluationCache() and owned
+   * by the caller, so the const evaluation methods still do not
+   * modify the Model. */
+  class EvaluationCache {
+  public:
+    virtual ~EvaluationCache();
+  };
+
   Model();
   virtual ~Model();
 
@@ -71,6 +90,13 @@ public:
    * otherwise. */
   bool IsReady() const;
 
+  /** Can the const evaluation methods of this Model be called from
+   * several threads at the same time?
+   *
+   * Defaults to false. Subclasses whose evaluation has no side
+   * effects should override this to return true. */
+  virtual bool SupportsConcurrentEvaluation() const;
+
   /** Get the number of parameters. */
   virtual unsigned int GetNumberOfParameters() const;
 
@@ -110,6 +136,21 @@ public:
   std::vector< double > GetGradientOfLogPriorLikelihood(
     const std::vector< double > & x ) const;
 
+  /** Get the gradient of the log prior likelihood at x into a
+   * caller-supplied vector.
+   *
+   * \param x Point in parameter space where the gradient of the
+   * LogPriorLikelihood will be evaluated.
+   * \param gradient Storage for the gradient. It is resized to the
+   * number of parameters. */
+  void GetGradientOfLogPriorLikelihood( const std::vector< double > & x,
+                                        std::vector< double > & gradient ) const;
+
+  /** Get the compiled form of the prior distributions of the
+   * parameters, for evaluating the prior at many points. Check
+   * CompiledPrior::IsCompiledFrom() the parameters before using it. */
+  const CompiledPrior & GetCompiledPrior() const;
+
   /** Get both scalar outputs and the gradient of active parameters.
    *
    * The gradient output parameter will contain gradient components of
@@ -133,6 +174,32 @@ public:
     std::vector< double > & scalars,
     std::vector< double > & gradient) const;
 
+  /** Get the scalar outputs, the log likelihood and its gradient
+   * with respect to the active parameters in one call.
+   *
+   * Gradient-based samplers need all three at every step. By default
+   * this calls GetScalarAndGradientOutputs() and then
+   * GetScalarOutputsAndLogLikelihood(). Subclasses that compute the
+   * log likelihood on the way to the gradient should override it so
+   * that the Model is evaluated only once.
+   *
+   * \param parameters Point in parameter space where the Model should
+   * be evaluated.
+   * \param activeParameters List of parameters for which the gradient
+   * should be computed.
+   * \param scalars Output argument that will contain the scalars from
+   * evaluating the Model.
+   * \param logLikelihood Output argument for the log likelihood,
+   * including the log prior likelihood.
+   * \param gradient Output argument that will contain the gradient
+   * components requested via the activeParameters vector. */
+  virtual ErrorType GetScalarOutputsAndLogLikelihoodAndGradient(
+    const std::vector< double > & parameters,
+    const std::vector< bool > & activeParameters,
+    std::vector< double > & scalars,
+    double & logLikelihood,
+    std::vector< double > & gradient) const;
+
   /** Expect vector of length GetNumberOfScalarOutputs().
    *
    * If you never set this, all model scalar outputs are assumed to
@@ -221,6 +288,60 @@ public:
     std::vector< double > & value_gradient,
     std::vector< double > & error_gradient) const;
 
+  /** Get the scalar outputs and log likelihoods at several points.
+   *
+   * Samplers that move many points at once evaluate them through
+   * this method. By default it calls GetScalarOutputsAndLogLikelihood()
+   * for each point, in parallel threads if the Model supports
+   * concurrent evaluation and OpenMP is enabled. Subclasses that can
+   * evaluate a batch of points faster than one point at a time
+   * should override it.
+   *
+   * \param parameters Points in parameter space where the Model
+   * should be evaluated.
+   * \param scalars Output argument that will contain the scalars at
+   * each point.
+   * \param logLikelihoods Output argument that will contain the log
+   * likelihood at each point.
+   * \return The first error encountered, or NO_ERROR. */
+  virtual ErrorType GetScalarOutputsAndLogLikelihoods(
+    const std::vector< std::vector< double > > & parameters,
+    std::vector< std::vector< double > > & scalars,
+    std::vector< double > & logLikelihoods) const;
+
+  /** Create an EvaluationCache for
+   * GetScalarOutputsAndLogLikelihoodOfPartialUpdate(). The caller
+   * owns it. Returns NULL, the default, if the Model gains nothing
+   * from knowing which parameters changed. */
+  virtual EvaluationCache * NewEvaluationCache() const;
+
+  /** Get the scalar outputs and log likelihood at a point that
+   * differs from an earlier one only in some parameters.
+   *
+   * Samplers that change a few parameters at a time call this so that
+   * Models can skip the work that depends only on the unchanged
+   * parameters. By default it calls GetScalarOutputsAndLogLikelihood()
+   * and ignores the hint.
+   *
+   * \param parameters Point in parameter space where the Model should
+   * be evaluated.
+   * \param changedParameters Indices of the parameters that differ
+   * from the point \c previous was filled at.
+   * \param previous Cache filled at the earlier point, or NULL to
+   * evaluate from scratch.
+   * \param current Cache to fill at \c parameters, or NULL. It may be
+   * the same as \c previous.
+   * \param scalars Output argument for the scalars at the point.
+   * \param logLikelihood Output argument for the log likelihood,
+   * including the log prior likelihood. */
+  virtual ErrorType GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+    const std::vector< double > & parameters,
+    const std::vector< unsigned int > & changedParameters,
+    const EvaluationCache * previous,
+    EvaluationCache * current,
+    std::vector< double > & scalars,
+    double & logLikelihood) const;
+
   /** Some models don't know the output values precisely
    *
    * Instead they produce a distribution of possible output values,
@@ -264,7 +385,7 @@ public:
    * Defaults to not using the model covariance in the log likelihood
    * calculation.
    */
-  bool GetUseModelCovarianceToCalulateLogLikelihood();
+  bool GetUseModelCovarianceToCalulateLogLikelihood() const;
   void SetUseModelCovarianceToCalulateLogLikelihood(bool);
   //@}
 
@@ -310,9 +431,31 @@ protected:
   void AddParameter( const std::string & name,
                      const Distribution & priorDistribution);
 
+  /** Rebuild m_CompiledPrior from m_Parameters. AddParameter() calls
+   * this; subclasses that modify m_Parameters directly should call it
+   * afterwards. Until they do, the priors are evaluated one
+   * Distribution at a time. */
+  void UpdateCompiledPrior();
+
+  /** Prior distributions of m_Parameters, compiled for fast
+   * evaluation. */
+  CompiledPrior m_CompiledPrior;
+
   /** Add a scalar output name. */
   void AddScalarOutputName( const std::string & name );
 
+  /** Compute the log likelihood, including the log prior likelihood,
+   * of scalar outputs computed at \c parameters. This is the second
+   * half of GetScalarOutputsAndLogLikelihood().
+   *
+   * \param scalarCovariance Covariance of the scalars, or an empty
+   * vector for none. */
+  ErrorType GetLogLikelihoodOfScalarOutputs(
+    const std::vector< double > & parameters,
+    const std::vector< double > & scalars,
+    const std::vector< double > & scalarCovariance,
+    double & logLikelihood) const;
+
 
   /** A GetNumberOfScalarOutputs()-length vector.
    * if empty, assume zero vector */
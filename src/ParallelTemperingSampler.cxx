@@ -0,0 +1,550 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "ParallelTemperingSampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+
+namespace madai {
+
+
+ParallelTemperingSampler
+::ParallelTemperingSampler() :
+  Sampler(),
+  m_NumberOfTemperatures( 8 ),
+  m_MaximumTemperature( 100.0 ),
+  m_StepSize( 1.0e-2 ),
+  m_SwapInterval( 1 ),
+  m_NumberOfAdaptationSamples( 0 ),
+  m_TargetAcceptanceRate( 0.234 ),
+  m_NumberOfSteps( 0 )
+{
+}
+
+
+ParallelTemperingSampler
+::~ParallelTemperingSampler()
+{
+}
+
+
+void
+ParallelTemperingSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+
+  // No chains yet, so that Sampler::Initialize() does not move them.
+  m_ChainParameters.clear();
+  Sampler::Initialize( model );
+
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  m_StepScales.resize( model->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < model->GetNumberOfParameters(); ++i ) {
+    const Distribution * priorDist = params[i].GetPriorDistribution();
+    m_StepScales[i] =
+      priorDist->GetPercentile( 0.75 ) - priorDist->GetPercentile( 0.25 );
+  }
+
+  m_NumberOfSteps = 0;
+  this->ResetLadder();
+  this->InitializeChainsFromPriors();
+}
+
+
+void
+ParallelTemperingSampler
+::SetNumberOfTemperatures( unsigned int numberOfTemperatures )
+{
+  m_NumberOfTemperatures = std::max( numberOfTemperatures, 2u );
+  if ( m_Model != NULL ) {
+    this->ResetLadder();
+    this->InitializeChainsFromPriors();
+  }
+}
+
+
+unsigned int
+ParallelTemperingSampler
+::GetNumberOfTemperatures() const
+{
+  return m_NumberOfTemperatures;
+}
+
+
+void
+ParallelTemperingSampler
+::SetMaximumTemperature( double temperature )
+{
+  if ( temperature > 1.0 ) {
+    m_MaximumTemperature = temperature;
+  }
+  if ( m_Model != NULL ) {
+    this->ResetLadder();
+  }
+}
+
+
+double
+ParallelTemperingSampler
+::GetMaximumTemperature() const
+{
+  return m_MaximumTemperature;
+}
+
+
+void
+ParallelTemperingSampler
+::SetStepSize( double stepSize )
+{
+  m_StepSize = stepSize;
+  if ( m_Model != NULL ) {
+    this->ResetLadder();
+  }
+}
+
+
+double
+ParallelTemperingSampler
+::GetStepSize() const
+{
+  return m_StepSize;
+}
+
+
+void
+ParallelTemperingSampler
+::SetSwapInterval( unsigned int interval )
+{
+  m_SwapInterval = std::max( interval, 1u );
+}
+
+
+unsigned int
+ParallelTemperingSampler
+::GetSwapInterval() const
+{
+  return m_SwapInterval;
+}
+
+
+void
+ParallelTemperingSampler
+::SetNumberOfAdaptationSamples( unsigned int numberOfSamples )
+{
+  m_NumberOfAdaptationSamples = numberOfSamples;
+}
+
+
+unsigned int
+ParallelTemperingSampler
+::GetNumberOfAdaptationSamples() const
+{
+  return m_NumberOfAdaptationSamples;
+}
+
+
+void
+ParallelTemperingSampler
+::SetTargetAcceptanceRate( double rate )
+{
+  m_TargetAcceptanceRate = rate;
+}
+
+
+double
+ParallelTemperingSampler
+::GetTargetAcceptanceRate() const
+{
+  return m_TargetAcceptanceRate;
+}
+
+
+bool
+ParallelTemperingSampler
+::IsAdapting() const
+{
+  return ( !m_AdaptationEnded &&
+           m_NumberOfSteps < m_NumberOfAdaptationSamples );
+}
+
+
+void
+ParallelTemperingSampler
+::EndAdaptation()
+{
+  if ( this->IsAdapting() ) {
+    // Report the swap rates of the final ladder only.
+    m_NumberOfSwapProposals.assign( m_NumberOfSwapProposals.size(), 0 );
+    m_NumberOfAcceptedSwaps.assign( m_NumberOfAcceptedSwaps.size(), 0 );
+  }
+  Sampler::EndAdaptation();
+}
+
+
+std::vector< double >
+ParallelTemperingSampler
+::GetTemperatures() const
+{
+  std::vector< double > temperatures( m_InverseTemperatures.size() );
+  for ( unsigned int k = 0; k < m_InverseTemperatures.size(); ++k ) {
+    temperatures[k] = 1.0 / m_InverseTemperatures[k];
+  }
+  return temperatures;
+}
+
+
+std::vector< double >
+ParallelTemperingSampler
+::GetSwapAcceptanceRates() const
+{
+  std::vector< double > rates( m_NumberOfSwapProposals.size(), 0.0 );
+  for ( unsigned int k = 0; k < rates.size(); ++k ) {
+    if ( m_NumberOfSwapProposals[k] > 0 ) {
+      rates[k] = static_cast< double >( m_NumberOfAcceptedSwaps[k] ) /
+        static_cast< double >( m_NumberOfSwapProposals[k] );
+    }
+  }
+  return rates;
+}
+
+
+void
+ParallelTemperingSampler
+::WriteProgress( std::ostream & progress ) const
+{
+  std::vector< double > rates = this->GetSwapAcceptanceRates();
+  progress << "  Swap rates:";
+  for ( unsigned int k = 0; k < rates.size(); ++k ) {
+    progress << ' ' << static_cast< int >( 100.0 * rates[k] + 0.5 ) << '%';
+  }
+}
+
+
+void
+ParallelTemperingSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "ParallelTemperingSampler" );
+  o << m_NumberOfSteps << ' ' << m_ChainParameters.size() << '\n';
+  WriteValues( o, m_InverseTemperatures );
+  WriteValues( o, m_LogStepSizes );
+  for ( size_t chain = 0; chain < m_ChainParameters.size(); ++chain ) {
+    WriteValues( o, m_ChainParameters[ chain ] );
+    WriteValues( o, m_ChainOutputs[ chain ] );
+  }
+  WriteValues( o, m_ChainLogLikelihoods );
+  WriteValues( o, m_ChainLogPriors );
+  WriteIntegers( o, m_NumberOfSwapProposals );
+  WriteIntegers( o, m_NumberOfAcceptedSwaps );
+}
+
+
+bool
+ParallelTemperingSampler
+::ReadState( std::istream & i )
+{
+  size_t numberOfChains;
+  if ( !Sampler::ReadState( i ) ||
+       !ReadTag( i, "ParallelTemperingSampler" ) ||
+       !( i >> m_NumberOfSteps >> numberOfChains ) ||
+       numberOfChains != m_NumberOfTemperatures ||
+       !ReadValues( i, m_InverseTemperatures ) ||
+       !ReadValues( i, m_LogStepSizes ) ) {
+    return false;
+  }
+  m_ChainParameters.resize( numberOfChains );
+  m_ChainOutputs.resize( numberOfChains );
+  for ( size_t chain = 0; chain < numberOfChains; ++chain ) {
+    if ( !ReadValues( i, m_ChainParameters[ chain ] ) ||
+         !ReadValues( i, m_ChainOutputs[ chain ] ) ) {
+      return false;
+    }
+  }
+  return ( ReadValues( i, m_ChainLogLikelihoods ) &&
+           ReadValues( i, m_ChainLogPriors ) &&
+           ReadIntegers( i, m_NumberOfSwapProposals ) &&
+           ReadIntegers( i, m_NumberOfAcceptedSwaps ) &&
+           m_InverseTemperatures.size() == numberOfChains &&
+           m_ChainLogLikelihoods.size() == numberOfChains &&
+           m_ChainLogPriors.size() == numberOfChains );
+}
+
+
+void
+ParallelTemperingSampler
+::ResetLadder()
+{
+  unsigned int numberOfTemperatures = m_NumberOfTemperatures;
+  m_InverseTemperatures.resize( numberOfTemperatures );
+  m_LogStepSizes.resize( numberOfTemperatures );
+  for ( unsigned int k = 0; k < numberOfTemperatures; ++k ) {
+    double exponent = static_cast< double >( k ) /
+      static_cast< double >( numberOfTemperatures - 1 );
+    double temperature = std::pow( m_MaximumTemperature, exponent );
+    m_InverseTemperatures[k] = 1.0 / temperature;
+    m_LogStepSizes[k] = std::log( m_StepSize * std::sqrt( temperature ) );
+  }
+
+  m_NumberOfSwapProposals.assign( numberOfTemperatures - 1, 0 );
+  m_NumberOfAcceptedSwaps.assign( numberOfTemperatures - 1, 0 );
+}
+
+
+void
+ParallelTemperingSampler
+::InitializeChainsFromPriors()
+{
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  m_ChainParameters.assign( m_NumberOfTemperatures, m_CurrentParameters );
+  for ( unsigned int k = 0; k < m_NumberOfTemperatures; ++k ) {
+    for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+      if ( m_ActiveParameterIndices[i] ) {
+        m_ChainParameters[k][i] =
+          params[i].GetPriorDistribution()->GetSample( m_Random );
+      }
+    }
+  }
+  this->EvaluateChains();
+  this->SetCurrentFromColdChain();
+}
+
+
+void
+ParallelTemperingSampler
+::ParameterSetExternally()
+{
+  if ( m_Model == NULL || m_ChainParameters.empty() ) {
+    return;
+  }
+
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+  bool activeParameterChanged = false;
+  for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+    if ( m_ActiveParameterIndices[i] &&
+         m_CurrentParameters[i] != m_ChainParameters[0][i] ) {
+      activeParameterChanged = true;
+    }
+  }
+
+  for ( unsigned int k = 0; k < m_ChainParameters.size(); ++k ) {
+    if ( activeParameterChanged ) {
+      m_ChainParameters[k] = m_CurrentParameters;
+    } else {
+      for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+        if ( !m_ActiveParameterIndices[i] ) {
+          m_ChainParameters[k][i] = m_CurrentParameters[i];
+        }
+      }
+    }
+  }
+
+  this->EvaluateChains();
+  this->SetCurrentFromColdChain();
+}
+
+
+void
+ParallelTemperingSampler
+::EvaluateChains()
+{
+  m_Model->GetScalarOutputsAndLogLikelihoods(
+    m_ChainParameters, m_ChainOutputs, m_ChainLogLikelihoods );
+  m_ChainLogPriors.resize( m_ChainParameters.size() );
+  for ( unsigned int k = 0; k < m_ChainParameters.size(); ++k ) {
+    m_ChainLogPriors[k] = m_Model->GetLogPriorLikelihood( m_ChainParameters[k] );
+  }
+}
+
+
+double
+ParallelTemperingSampler
+::GetTemperedLogLikelihood( unsigned int chain,
+                            double logLikelihood,
+                            double logPrior ) const
+{
+  const double infinity = std::numeric_limits< double >::infinity();
+  // Also catches NaN from a failed evaluation.
+  if ( !( logLikelihood > -infinity ) || !( logPrior > -infinity ) ) {
+    return -infinity;
+  }
+  return logPrior + m_InverseTemperatures[chain] * ( logLikelihood - logPrior );
+}
+
+
+void
+ParallelTemperingSampler
+::UpdateChains()
+{
+  unsigned int numberOfChains =
+    static_cast< unsigned int >( m_ChainParameters.size() );
+  unsigned int numberOfParameters = m_Model->GetNumberOfParameters();
+
+  // Draw the proposals of all chains first, so that they can be
+  // evaluated together.
+  std::vector< std::vector< double > > proposals( m_ChainParameters );
+  for ( unsigned int k = 0; k < numberOfChains; ++k ) {
+    double stepSize = std::exp( m_LogStepSizes[k] );
+    for ( unsigned int i = 0; i < numberOfParameters; ++i ) {
+      if ( m_ActiveParameterIndices[i] ) {
+        proposals[k][i] += stepSize * m_StepScales[i] * m_Random.Gaussian();
+      }
+    }
+  }
+
+  std::vector< std::vector< double > > outputs;
+  std::vector< double > logLikelihoods;
+  m_Model->GetScalarOutputsAndLogLikelihoods(
+    proposals, outputs, logLikelihoods );
+
+  bool adapting = this->IsAdapting();
+  double gain = std::pow( static_cast< double >( m_NumberOfSteps + 1 ), -0.6 );
+  for ( unsigned int k = 0; k < numberOfChains; ++k ) {
+    double logPrior = m_Model->GetLogPriorLikelihood( proposals[k] );
+    double proposed =
+      this->GetTemperedLogLikelihood( k, logLikelihoods[k], logPrior );
+    double current = this->GetTemperedLogLikelihood(
+      k, m_ChainLogLikelihoods[k], m_ChainLogPriors[k] );
+
+    double acceptanceProbability = 0.0;
+    if ( proposed >= current ) {
+      acceptanceProbability = 1.0;
+    } else if ( proposed > -std::numeric_limits< double >::infinity() ) {
+      acceptanceProbability = std::exp( proposed - current );
+    }
+
+    if ( acceptanceProbability >= 1.0 ||
+         m_Random.Uniform() < acceptanceProbability ) {
+      m_ChainParameters[k] = proposals[k];
+      m_ChainOutputs[k] = outputs[k];
+      m_ChainLogLikelihoods[k] = logLikelihoods[k];
+      m_ChainLogPriors[k] = logPrior;
+    }
+
+    if ( adapting ) {
+      m_LogStepSizes[k] +=
+        gain * ( acceptanceProbability - m_TargetAcceptanceRate );
+    }
+  }
+}
+
+
+void
+ParallelTemperingSampler
+::SwapChains()
+{
+  unsigned int numberOfChains =
+    static_cast< unsigned int >( m_ChainParameters.size() );
+
+  // Swap from the hottest pair down, so that a state found by a hot
+  // chain can reach the cold chain in one sweep.
+  std::vector< double > swapProbabilities( numberOfChains - 1, 0.0 );
+  for ( unsigned int k = numberOfChains - 1; k-- > 0; ) {
+    double colder = m_ChainLogLikelihoods[k] - m_ChainLogPriors[k];
+    double hotter = m_ChainLogLikelihoods[k + 1] - m_ChainLogPriors[k + 1];
+    double logProbability =
+      ( m_InverseTemperatures[k] - m_InverseTemperatures[k + 1] ) *
+      ( hotter - colder );
+
+    double probability = 0.0;
+    if ( logProbability >= 0.0 ) {
+      probability = 1.0;
+    } else if ( logProbability == logProbability ) {
+      probability = std::exp( logProbability );
+    }
+    swapProbabilities[k] = probability;
+
+    ++m_NumberOfSwapProposals[k];
+    if ( probability >= 1.0 || m_Random.Uniform() < probability ) {
+      std::swap( m_ChainParameters[k], m_ChainParameters[k + 1] );
+      std::swap( m_ChainOutputs[k], m_ChainOutputs[k + 1] );
+      std::swap( m_ChainLogLikelihoods[k], m_ChainLogLikelihoods[k + 1] );
+      std::swap( m_ChainLogPriors[k], m_ChainLogPriors[k + 1] );
+      ++m_NumberOfAcceptedSwaps[k];
+    }
+  }
+
+  if ( !this->IsAdapting() || numberOfChains < 3 ) {
+    return;
+  }
+
+  // Move the interior temperatures so that neighbouring swap rates
+  // become equal, keeping the coldest and hottest chain fixed. The
+  // gap above a chain grows when its swaps are accepted more often
+  // than those of the next pair.
+  static const double lag = 1000.0;
+  static const double inverseAmplitude = 100.0;
+  double time = static_cast< double >( m_NumberOfSteps / m_SwapInterval );
+  double kappa = lag / ( inverseAmplitude * ( time + lag ) );
+
+  std::vector< double > temperatures = this->GetTemperatures();
+  std::vector< double > adapted( temperatures );
+  for ( unsigned int k = 0; k + 2 < numberOfChains; ++k ) {
+    double gap = temperatures[k + 1] - temperatures[k];
+    gap *= std::exp( kappa * ( swapProbabilities[k] - swapProbabilities[k + 1] ) );
+    adapted[k + 1] = adapted[k] + gap;
+  }
+  if ( adapted[numberOfChains - 2] >= adapted[numberOfChains - 1] ) {
+    // The ladder would no longer be increasing.
+    return;
+  }
+  for ( unsigned int k = 1; k + 1 < numberOfChains; ++k ) {
+    m_InverseTemperatures[k] = 1.0 / adapted[k];
+  }
+}
+
+
+void
+ParallelTemperingSampler
+::SetCurrentFromColdChain()
+{
+  m_CurrentParameters = m_ChainParameters[0];
+  m_CurrentOutputs = m_ChainOutputs[0];
+  m_CurrentLogLikelihood = m_ChainLogLikelihoods[0];
+}
+
+
+Sample
+ParallelTemperingSampler
+::NextSample()
+{
+  this->UpdateChains();
+  if ( ( m_NumberOfSteps + 1 ) % m_SwapInterval == 0 ) {
+    this->SwapChains();
+  }
+
+  ++m_NumberOfSteps;
+  if ( !m_AdaptationEnded && m_NumberOfSteps == m_NumberOfAdaptationSamples ) {
+    // Report the swap rates of the final ladder only.
+    m_NumberOfSwapProposals.assign( m_NumberOfSwapProposals.size(), 0 );
+    m_NumberOfAcceptedSwaps.assign( m_NumberOfAcceptedSwaps.size(), 0 );
+  }
+
+  this->SetCurrentFromColdChain();
+  return Sample( m_CurrentParameters,
+                 m_CurrentOutputs,
+                 m_CurrentLogLikelihood );
+}
+
+} // end namespace madai
@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_ParallelTemperingSampler_h_included
+#define madai_ParallelTemperingSampler_h_included
+
+#include <vector>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/**
+ * \class ParallelTemperingSampler
+ *
+ * Replica-exchange Metropolis sampler for multimodal posteriors.
+ *
+ * The sampler runs a ladder of Metropolis chains. Chain k targets
+ * the prior times the likelihood raised to the inverse temperature
+ * \f$ \beta_k = 1 / T_k \f$, with \f$ T_0 = 1 \f$ and the temperatures
+ * growing geometrically up to MaximumTemperature. Hot chains see a
+ * flattened posterior and cross between modes easily. After every
+ * SwapInterval steps, neighbouring chains propose to exchange their
+ * states, which carries the modes found by the hot chains down to
+ * the cold one.
+ *
+ * Every chain takes one Metropolis step per call to NextSample(). The
+ * proposals of all chains are evaluated as one batch with
+ * Model::GetScalarOutputsAndLogLikelihoods(), which uses parallel
+ * threads when the Model allows it. NextSample() returns the state of
+ * the cold chain, so a trace holds samples of the posterior only.
+ *
+ * During the first NumberOfAdaptationSamples calls to NextSample(),
+ * the step size of each chain is tuned toward TargetAcceptanceRate,
+ * and the interior temperatures are moved so that the swap
+ * acceptance rates between neighbours become equal (Vousden, Farr
+ * and Mandel, 2016). The adaptation should be done during burn-in.
+ */
+class ParallelTemperingSampler : public Sampler {
+public:
+  ParallelTemperingSampler();
+  virtual ~ParallelTemperingSampler();
+
+  /** Get the next Sample from the distribution. */
+  virtual Sample NextSample();
+
+  /** Writes the swap acceptance rates between neighbouring chains,
+   * coldest pair first. */
+  virtual void WriteProgress( std::ostream & progress ) const;
+
+  //@{
+  /** Set/Get the number of chains in the temperature ladder. At
+   * least 2; defaults to 8. Setting it draws new chains from the
+   * priors. */
+  void SetNumberOfTemperatures( unsigned int numberOfTemperatures );
+  unsigned int GetNumberOfTemperatures() const;
+  //@}
+
+  //@{
+  /** Set/Get the temperature of the hottest chain. It must be larger
+   * than 1 and defaults to 100. Setting it resets the ladder. */
+  void SetMaximumTemperature( double temperature );
+  double GetMaximumTemperature() const;
+  //@}
+
+  //@{
+  /** Set/Get the step size of the cold chain, in units of the
+   * interquartile range of the priors as in
+   * MetropolisHastingsSampler. Hotter chains start with steps larger
+   * by the square root of their temperature. Setting it resets the
+   * ladder. */
+  void SetStepSize( double stepSize );
+  double GetStepSize() const;
+  //@}
+
+  //@{
+  /** Set/Get the number of calls to NextSample() between swap
+   * proposals. Defaults to 1. */
+  void SetSwapInterval( unsigned int interval );
+  unsigned int GetSwapInterval() const;
+  //@}
+
+  //@{
+  /** Set/Get the number of calls to NextSample() during which step
+   * sizes and temperatures are adapted. Usually the number of burn-in
+   * samples. */
+  void SetNumberOfAdaptationSamples( unsigned int numberOfSamples );
+  unsigned int GetNumberOfAdaptationSamples() const;
+  //@}
+
+  //@{
+  /** Set/Get the acceptance rate of Metropolis steps that the step
+   * sizes are tuned toward. Defaults to 0.234. */
+  void SetTargetAcceptanceRate( double rate );
+  double GetTargetAcceptanceRate() const;
+  //@}
+
+  /** Returns true while step sizes and temperatures are adapted. */
+  bool IsAdapting() const;
+
+  /** Freeze the step sizes and temperatures, and count swaps from
+   * here on. */
+  virtual void EndAdaptation();
+
+  /** Get the temperatures of the chains, coldest first. */
+  std::vector< double > GetTemperatures() const;
+
+  /** Get the fraction of accepted swaps between chain k and chain
+   * k + 1, for each k. The counts restart when the adaptation ends. */
+  std::vector< double > GetSwapAcceptanceRates() const;
+
+  //@{
+  /** The state includes every chain and the adapted temperatures and
+   * step sizes. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Moves the cold chain to the new point, and every chain there if
+   * an active parameter was set. */
+  virtual void ParameterSetExternally();
+
+  /** Set up the geometric temperature ladder and the step sizes. */
+  void ResetLadder();
+
+  /** Place the chains at samples from the priors. */
+  void InitializeChainsFromPriors();
+
+  /** Evaluate the Model at the state of every chain. */
+  void EvaluateChains();
+
+  /** Take one Metropolis step in every chain. */
+  void UpdateChains();
+
+  /** Propose swaps between all neighbouring chains. */
+  void SwapChains();
+
+  /** Log of the tempered posterior of the given chain. */
+  double GetTemperedLogLikelihood( unsigned int chain,
+                                   double logLikelihood,
+                                   double logPrior ) const;
+
+  /** Make the cold chain the current state. */
+  void SetCurrentFromColdChain();
+
+  unsigned int m_NumberOfTemperatures;
+
+  double m_MaximumTemperature;
+
+  double m_StepSize;
+
+  unsigned int m_SwapInterval;
+
+  unsigned int m_NumberOfAdaptationSamples;
+
+  double m_TargetAcceptanceRate;
+
+  /** Number of calls to NextSample() so far. */
+  unsigned int m_NumberOfSteps;
+
+  /** Inverse temperatures of the chains, decreasing from 1. */
+  std::vector< double > m_InverseTemperatures;
+
+  /** Interquartile ranges of the priors. */
+  std::vector< double > m_StepScales;
+
+  /** Logarithm of the step size of each chain. */
+  std::vector< double > m_LogStepSizes;
+
+  //@{
+  /** State of each chain. The log likelihoods are the untempered
+   * ones of the Model, which include the log prior. */
+  std::vector< std::vector< double > > m_ChainParameters;
+  std::vector< std::vector< double > > m_ChainOutputs;
+  std::vector< double >                m_ChainLogLikelihoods;
+  std::vector< double >                m_ChainLogPriors;
+  //@}
+
+  //@{
+  /** Counts of proposed and accepted swaps between chain k and k+1. */
+  std::vector< unsigned long int > m_NumberOfSwapProposals;
+  std::vector< unsigned long int > m_NumberOfAcceptedSwaps;
+  //@}
+
+}; // end class ParallelTemperingSampler
+
+} // end namespace madai
+
+#endif // madai_ParallelTemperingSampler_h_included
@@ -19,15 +19,31 @@
 #include "Parameter.h"
 #include "UniformDistribution.h"
 
+#include <boost/detail/atomic_count.hpp>
+
+namespace {
+
+/** Count of the prior distributions created, shared by the threads. */
+boost::detail::atomic_count numberOfPriors( 0 );
+
+long NewPriorIdentifier()
+{
+  return ++numberOfPriors;
+}
+
+} // end anonymous namespace
+
 namespace madai {
 
 Parameter::Parameter( ) :
-  m_PriorDistribution( NULL )
+  m_PriorDistribution( NULL ),
+  m_PriorIdentifier( NewPriorIdentifier() )
 {
 }
 
 Parameter::Parameter( std::string name) :
-  m_Name( name )
+  m_Name( name ),
+  m_PriorIdentifier( NewPriorIdentifier() )
 {
   UniformDistribution * u = new UniformDistribution();
   u->SetMinimum( 0.0 );
@@ -37,7 +53,8 @@ Parameter::Parameter( std::string name) :
 
 
 Parameter::Parameter( std::string name, double minimum, double maximum ) :
-  m_Name( name )
+  m_Name( name ),
+  m_PriorIdentifier( NewPriorIdentifier() )
 {
   UniformDistribution * u = new UniformDistribution();
   u->SetMinimum( minimum );
@@ -48,7 +65,8 @@ Parameter::Parameter( std::string name, double minimum, double maximum ) :
 
 Parameter::Parameter( std::string name, const Distribution & distribution) :
   m_Name( name ),
-  m_PriorDistribution( distribution.Clone() )
+  m_PriorDistribution( distribution.Clone() ),
+  m_PriorIdentifier( NewPriorIdentifier() )
 {
 }
 
@@ -61,17 +79,21 @@ Parameter::~Parameter()
 
 Parameter::Parameter( const Parameter & other) :
   m_Name( other.m_Name ),
-  m_PriorDistribution( other.m_PriorDistribution->Clone() )
+  m_PriorDistribution( other.m_PriorDistribution->Clone() ),
+  m_PriorIdentifier( other.m_PriorIdentifier )
 {
 }
 
 
 Parameter & Parameter::operator=( const Parameter & other)
 {
+  // Clone first, which is safe for self-assignment.
+  Distribution * priorDistribution = other.m_PriorDistribution->Clone();
   m_Name = other.m_Name;
   if ( m_PriorDistribution != NULL )
     delete m_PriorDistribution;
-  m_PriorDistribution = other.m_PriorDistribution->Clone();
+  m_PriorDistribution = priorDistribution;
+  m_PriorIdentifier = other.m_PriorIdentifier;
   return *this;
 }
 
@@ -81,4 +103,10 @@ const Distribution * Parameter::GetPriorDistribution() const
   return m_PriorDistribution;
 }
 
+
+long Parameter::GetPriorIdentifier() const
+{
+  return m_PriorIdentifier;
+}
+
 } // namespace madai
@@ -74,6 +74,16 @@ public:
   Distribution * m_PriorDistribution;
   //@}
 
+  /** Number identifying the prior distribution. Each Parameter
+   * constructed with a prior gets a new one, and copies keep the
+   * number of the prior they copy, so that a replaced prior is
+   * noticed even when the new object reuses the address of the old
+   * one. */
+  long GetPriorIdentifier() const;
+
+protected:
+  long m_PriorIdentifier;
+
 }; // end class Parameter
 
 } // end namespace madai
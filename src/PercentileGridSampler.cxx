@@ -68,8 +68,7 @@ PercentileGridSampler
   m_StateVector[dim] ++;
 
   std::vector< double > y( m_Model->GetNumberOfScalarOutputs(), 0.0 );
-  Model * m = const_cast< Model * >(m_Model);
-  m->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
+  m_Model->GetScalarOutputsAndLogLikelihoodAndLikelihoodErrorGradient(
     m_CurrentParameters, m_CurrentOutputs, m_CurrentLogLikelihood, 
     m_CurrentLogLikelihoodValueGradient, m_CurrentLogLikelihoodErrorGradient);
   return Sample( m_CurrentParameters,
@@ -114,6 +113,57 @@ PercentileGridSampler
   this->Initialize( m_Model );
 }
 
+void
+PercentileGridSampler
+::SetIndex( unsigned long int index )
+{
+  if ( m_Model == NULL || this->GetNumberOfActiveParameters() == 0 )
+    return;
+  index %= this->GetNumberOfSamples();
+  for ( unsigned int dim = 0; dim < m_StateVector.size(); ++dim ) {
+    m_StateVector[dim] = 0;
+    if ( this->IsParameterActive(dim) ) {
+      m_StateVector[dim] = index % m_NumberOfSamplesInEachDimension;
+      index /= m_NumberOfSamplesInEachDimension;
+    }
+  }
+}
+
+unsigned long int
+PercentileGridSampler
+::GetIndex() const
+{
+  unsigned long int index = 0;
+  for ( unsigned int dim = static_cast< unsigned int >( m_StateVector.size() );
+        dim-- > 0; ) {
+    if ( this->IsParameterActive(dim) ) {
+      index = index * m_NumberOfSamplesInEachDimension + m_StateVector[dim];
+    }
+  }
+  return index;
+}
+
+void
+PercentileGridSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "PercentileGridSampler" );
+  o << m_NumberOfSamplesInEachDimension << '\n';
+  WriteIntegers( o, m_StateVector );
+}
+
+bool
+PercentileGridSampler
+::ReadState( std::istream & i )
+{
+  return ( Sampler::ReadState( i ) &&
+           ReadTag( i, "PercentileGridSampler" ) &&
+           ( i >> m_NumberOfSamplesInEachDimension ) &&
+           ReadIntegers( i, m_StateVector ) &&
+           m_StateVector.size() == m_CurrentParameters.size() );
+}
+
 void
 PercentileGridSampler
 ::Initialize( const Model * model )
@@ -58,6 +58,23 @@ public:
   */
   void Reset();
 
+  //@{
+  /**
+     Set/Get the index of the next sample in the grid. The first
+     active parameter varies fastest. Setting an index past the end of
+     the grid wraps around. Call SetIndex() after SetNumberOfSamples()
+     and after deactivating parameters.
+  */
+  void SetIndex( unsigned long int index );
+  unsigned long int GetIndex() const;
+  //@}
+
+  //@{
+  /** The state includes the grid and the position in it. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
 protected:
   /**
      Keeps track of which grid sample we are on. */
@@ -17,11 +17,12 @@
  *=========================================================================*/
 #include <time.h>
 
-#include <boost/random/mersenne_twister.hpp>
-#include <boost/random/normal_distribution.hpp>
-#include <boost/random/uniform_int.hpp>
-#include <boost/random/uniform_real.hpp>
-#include <boost/random/variate_generator.hpp>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include <boost/cstdint.hpp>
 
 #include <madaisys/SystemInformation.hxx>
 
@@ -29,43 +30,166 @@
 
 namespace madai {
 
+namespace {
+
+typedef boost::uint32_t Word;
+typedef boost::uint64_t Number;
+
+/** Constants of Philox4x32 (Salmon et al., "Parallel random numbers:
+ * as easy as 1, 2, 3", SC 2011). */
+//@{
+const Word PHILOX_M0 = 0xD2511F53U;
+const Word PHILOX_M1 = 0xCD9E8D57U;
+const Word PHILOX_W0 = 0x9E3779B9U;
+const Word PHILOX_W1 = 0xBB67AE85U;
+const unsigned int PHILOX_ROUNDS = 10;
+//@}
+
+/** Encrypt counter with key, in place. */
+inline void Philox( Word counter[4], const Word key[2] )
+{
+  Word k0 = key[0];
+  Word k1 = key[1];
+  for ( unsigned int round = 0; round < PHILOX_ROUNDS; ++round ) {
+    Number product0 = static_cast< Number >( PHILOX_M0 ) * counter[0];
+    Number product1 = static_cast< Number >( PHILOX_M1 ) * counter[2];
+    Word c0 = static_cast< Word >( product1 >> 32 ) ^ counter[1] ^ k0;
+    Word c2 = static_cast< Word >( product0 >> 32 ) ^ counter[3] ^ k1;
+    counter[1] = static_cast< Word >( product1 );
+    counter[3] = static_cast< Word >( product0 );
+    counter[0] = c0;
+    counter[2] = c2;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+}
+
+/** The two 64-bit numbers at index 2 * block and 2 * block + 1 of a
+ * stream. */
+inline void GenerateBlock( const Word key[2], Number stream, Number block,
+                           Number numbers[2] )
+{
+  Word counter[4] = {
+    static_cast< Word >( block ), static_cast< Word >( block >> 32 ),
+    static_cast< Word >( stream ), static_cast< Word >( stream >> 32 ) };
+  Philox( counter, key );
+  numbers[0] = ( static_cast< Number >( counter[0] ) << 32 ) | counter[1];
+  numbers[1] = ( static_cast< Number >( counter[2] ) << 32 ) | counter[3];
+}
+
+/** A double in [0, 1) from the high 53 bits of a number. */
+inline double ToUniform( Number number )
+{
+  return static_cast< double >( number >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+/** The Box-Muller transform of two uniform numbers into two
+ * independent Gaussian ones. */
+inline void BoxMuller( double u0, double u1, double & g0, double & g1 )
+{
+  static const double TWO_PI = 6.283185307179586;
+  double radius = std::sqrt( -2.0 * std::log( 1.0 - u0 ) ); // 1 - u0 > 0
+  g0 = radius * std::cos( TWO_PI * u1 );
+  g1 = radius * std::sin( TWO_PI * u1 );
+}
+
+} // end anonymous namespace
+
+
 struct Random::RandomPrivate {
-  /** Typedefs for random number generation */
+  /** Key, from the seed */
+  Word   m_Key[2];
+
+  /** Index of the stream: 0 for the sequence of the seed, and 1 plus
+   * the argument of Split() for the others */
+  Number m_Stream;
+
+  /** Index of the next number in the stream */
+  Number m_Position;
+
+  /** Block of the last two numbers generated, and its index */
   //@{
-  typedef boost::mt19937               BaseGeneratorType;
-  typedef boost::uniform_int< int >    UniformIntDistributionType;
-  typedef boost::uniform_int< long >   UniformLongDistributionType;
-  typedef boost::uniform_real<>        UniformRealDistributionType;
-  typedef boost::normal_distribution<> NormalDistributionType;
-  typedef boost::variate_generator<
-    BaseGeneratorType&,
-    UniformRealDistributionType >      UniformRealGeneratorType;
+  Number m_Block[2];
+  Number m_BlockIndex;
+  bool   m_HasBlock;
   //@}
 
-  /** Mersenne Twister random number generator */
-  BaseGeneratorType           m_BaseGenerator;
-
-  /** Uniform int distribution */
-  UniformIntDistributionType  m_UniformIntDistribution;
+  /** Second number of the last Box-Muller pair, if not yet
+   * returned, and the position just after the pair */
+  //@{
+  double m_Gaussian;
+  bool   m_HasGaussian;
+  Number m_GaussianPosition;
+  //@}
 
-  /** Uniform long distribution */
-  UniformLongDistributionType  m_UniformLongDistribution;
+  RandomPrivate();
 
-  /** Uniform real distribution */
-  UniformRealDistributionType m_UniformRealDistribution;
+  /** Start a stream at its beginning. */
+  void SetStream( const Word key[2], Number stream );
 
-  /** Uniform real generator */
-  UniformRealGeneratorType    m_UniformRealGenerator;
+  /** Next 64-bit number of the stream. */
+  Number Next();
 
-  /** Normal distribution */
-  NormalDistributionType      m_NormalDistribution;
+  /** Draw a Box-Muller pair, returning the first number and holding
+   * back the second. */
+  double DrawGaussianPair();
 
-  RandomPrivate();
+  /** Recompute the Gaussian held back by the pair that ends just
+   * before position. */
+  void RecomputeGaussian( Number position );
 };
 
 Random::RandomPrivate::RandomPrivate() :
-  m_UniformRealGenerator( m_BaseGenerator, m_UniformRealDistribution )
+  m_Stream( 0 ),
+  m_Position( 0 ),
+  m_BlockIndex( 0 ),
+  m_HasBlock( false ),
+  m_Gaussian( 0.0 ),
+  m_HasGaussian( false ),
+  m_GaussianPosition( 0 )
+{
+  m_Key[0] = m_Key[1] = 0;
+  m_Block[0] = m_Block[1] = 0;
+}
+
+void Random::RandomPrivate::SetStream( const Word key[2], Number stream )
+{
+  m_Key[0] = key[0];
+  m_Key[1] = key[1];
+  m_Stream = stream;
+  m_Position = 0;
+  m_HasBlock = false;
+  m_HasGaussian = false;
+}
+
+Number Random::RandomPrivate::Next()
+{
+  Number blockIndex = m_Position >> 1;
+  if ( !m_HasBlock || blockIndex != m_BlockIndex ) {
+    GenerateBlock( m_Key, m_Stream, blockIndex, m_Block );
+    m_BlockIndex = blockIndex;
+    m_HasBlock = true;
+  }
+  return m_Block[ m_Position++ & 1 ];
+}
+
+double Random::RandomPrivate::DrawGaussianPair()
 {
+  double u0 = ToUniform( this->Next() );
+  double u1 = ToUniform( this->Next() );
+  double gaussian;
+  BoxMuller( u0, u1, gaussian, m_Gaussian );
+  m_HasGaussian = true;
+  m_GaussianPosition = m_Position;
+  return gaussian;
+}
+
+void Random::RandomPrivate::RecomputeGaussian( Number position )
+{
+  Number current = m_Position;
+  m_Position = position - 2;
+  this->DrawGaussianPair();
+  m_Position = current;
 }
 
 Random::Random() :
@@ -87,7 +211,10 @@ Random::~Random()
 
 void Random::Reseed(unsigned long int seed)
 {
-  m_RandomImplementation->m_BaseGenerator.seed( seed );
+  Number wide = static_cast< Number >( seed );
+  Word key[2] = { static_cast< Word >( wide ),
+                  static_cast< Word >( wide >> 32 ) };
+  m_RandomImplementation->SetStream( key, 0 );
 }
 
 void Random::Reseed()
@@ -98,19 +225,28 @@ void Random::Reseed()
 
 long Random::Integer( long N )
 {
-  return m_RandomImplementation->m_UniformLongDistribution(
-      m_RandomImplementation->m_BaseGenerator, N );
+  if ( N <= 1 ) {
+    return 0;
+  }
+  // Reject the lowest 2^64 mod N numbers so that every result is
+  // equally likely.
+  Number range = static_cast< Number >( N );
+  Number threshold = ( 0 - range ) % range;
+  Number number;
+  do {
+    number = m_RandomImplementation->Next();
+  } while ( number < threshold );
+  return static_cast< long >( number % range );
 }
 
 long Random::operator()( long N )
 {
-  return m_RandomImplementation->m_UniformLongDistribution(
-      m_RandomImplementation->m_BaseGenerator, N );
+  return this->Integer( N );
 }
 
 double Random::Uniform()
 {
-  return m_RandomImplementation->m_UniformRealGenerator();
+  return ToUniform( m_RandomImplementation->Next() );
 }
 
 double Random::Uniform(double min, double max)
@@ -120,8 +256,12 @@ double Random::Uniform(double min, double max)
 
 double Random::Gaussian()
 {
-  return m_RandomImplementation->m_NormalDistribution(
-      m_RandomImplementation->m_UniformRealGenerator );
+  RandomPrivate & p = *m_RandomImplementation;
+  if ( p.m_HasGaussian ) {
+    p.m_HasGaussian = false;
+    return p.m_Gaussian;
+  }
+  return p.DrawGaussianPair();
 }
 
 double Random::Gaussian(double mean, double standardDeviation)
@@ -129,4 +269,83 @@ double Random::Gaussian(double mean, double standardDeviation)
   return standardDeviation * this->Gaussian() + mean;
 }
 
+void Random::FillUniform(double * values, unsigned int count)
+{
+  RandomPrivate & p = *m_RandomImplementation;
+  unsigned int i = 0;
+  if ( count > 0 && ( p.m_Position & 1 ) != 0 ) {
+    values[i++] = ToUniform( p.Next() );
+  }
+  // Whole blocks, each independent of the others.
+  Number numbers[2];
+  for ( ; i + 1 < count; i += 2 ) {
+    GenerateBlock( p.m_Key, p.m_Stream, p.m_Position >> 1, numbers );
+    p.m_Position += 2;
+    values[i] = ToUniform( numbers[0] );
+    values[i + 1] = ToUniform( numbers[1] );
+  }
+  if ( i < count ) {
+    values[i] = ToUniform( p.Next() );
+  }
+}
+
+void Random::FillGaussian(double * values, unsigned int count)
+{
+  RandomPrivate & p = *m_RandomImplementation;
+  unsigned int i = 0;
+  if ( count > 0 && p.m_HasGaussian ) {
+    values[i++] = p.m_Gaussian;
+    p.m_HasGaussian = false;
+  }
+  unsigned int pairs = ( count - i ) / 2;
+  this->FillUniform( values + i, 2 * pairs );
+  for ( unsigned int j = 0; j < pairs; ++j, i += 2 ) {
+    BoxMuller( values[i], values[i + 1], values[i], values[i + 1] );
+  }
+  if ( i < count ) {
+    values[i] = this->Gaussian();
+  }
+}
+
+void Random::Split(unsigned long int stream, Random & substream) const
+{
+  substream.m_RandomImplementation->SetStream(
+    m_RandomImplementation->m_Key, static_cast< Number >( stream ) + 1 );
+}
+
+void Random::JumpAhead(unsigned long int n)
+{
+  m_RandomImplementation->m_Position += static_cast< Number >( n );
+  m_RandomImplementation->m_HasGaussian = false;
+}
+
+void Random::WriteState(std::ostream & o) const
+{
+  // A held back Gaussian follows from the two numbers before the
+  // position after its pair, which is never 0.
+  const RandomPrivate & p = *m_RandomImplementation;
+  o << "Random " << p.m_Key[0] << ' ' << p.m_Key[1] << ' '
+    << p.m_Stream << ' ' << p.m_Position << ' '
+    << ( p.m_HasGaussian ? p.m_GaussianPosition : 0 ) << '\n';
+}
+
+bool Random::ReadState(std::istream & i)
+{
+  std::string tag;
+  Word key[2];
+  Number stream, position, gaussianPosition;
+  if ( !( i >> tag ) || tag != "Random" ||
+       !( i >> key[0] >> key[1] >> stream >> position >> gaussianPosition ) ||
+       gaussianPosition == 1 || gaussianPosition > position ) {
+    return false;
+  }
+  RandomPrivate & p = *m_RandomImplementation;
+  p.SetStream( key, stream );
+  p.m_Position = position;
+  if ( gaussianPosition != 0 ) {
+    p.RecomputeGaussian( gaussianPosition );
+  }
+  return true;
+}
+
 }
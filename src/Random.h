@@ -19,11 +19,19 @@
 #ifndef madai_Random_h_included
 #define madai_Random_h_included
 
+#include <iosfwd>
+
 namespace madai {
 
 /** \class Random
  *
  * A reentrant random number generator.
+ *
+ * The generator is counter based (Philox4x32-10): the n-th number of
+ * a sequence is a function of the seed, the stream and n alone. A
+ * generator can therefore skip ahead in constant time, and one seed
+ * gives many independent streams, one per chain or thread, without
+ * searching for seeds that do not overlap.
  */
 class Random {
 public:
@@ -55,10 +63,15 @@ public:
   /** Returns a long < N and >= 0 */
   virtual long operator()( long N );
 
-  /** Returns a uniform random number in the range [0.0, 1.0] */
+  /** Returns a uniform random number in the range [0.0, 1.0), a
+   * multiple of 2^-53. It is never 1.0, so 1.0 - Uniform() is
+   * positive, but it can be 0.0. */
   virtual double Uniform();
 
-  /** Returns a uniform random number in the range [min, max] */
+  /** Returns a uniform random number in the range [min, max). The
+   * result is min + Uniform() * (max - min), rounded, so max itself
+   * can come out of the rounding when Uniform() is within 2^-53 of
+   * 1.0. */
   virtual double Uniform(double min, double max);
 
   /** Returns a random number from a Gaussian distribution with mean
@@ -69,6 +82,39 @@ public:
    * and standard deviation supplied as arguments */
   virtual double Gaussian(double mean, double standardDeviation);
 
+  /** Fill values with count numbers from Uniform(), the same ones
+   * that count calls of Uniform() would return. */
+  virtual void FillUniform(double * values, unsigned int count);
+
+  /** Fill values with count numbers from Gaussian(), the same ones
+   * that count calls of Gaussian() would return. */
+  virtual void FillGaussian(double * values, unsigned int count);
+
+  /** Make substream a generator of a stream of this generator's
+   * seed, starting at its beginning. Streams with different indices
+   * never share a number, and neither share one with the sequence of
+   * the seed itself. The streams of a seed are the same whichever
+   * generator of that seed splits them, so split them from one
+   * master generator.
+   *
+   * \param stream Index of the stream, such as the index of a chain.
+   * \param substream Receives the stream. */
+  virtual void Split(unsigned long int stream, Random & substream) const;
+
+  /** Skip as many numbers as n calls of Uniform() would draw. A
+   * Gaussian() draws two Uniform() numbers for every two calls.
+   * Takes the same time for any n. */
+  virtual void JumpAhead(unsigned long int n);
+
+  /** Write the state of the generator to a stream, as text, so that
+   * ReadState() can continue the sequence of random numbers exactly
+   * where it was. */
+  virtual void WriteState(std::ostream & o) const;
+
+  /** Restore a state written by WriteState(). Returns false, leaving
+   * the generator unchanged, if the stream does not contain one. */
+  virtual bool ReadState(std::istream & i);
+
 private:
   /** Explicitly disallowed */
   Random& operator=(madai::Random &);
@@ -0,0 +1,268 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "SampleBlock.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace madai {
+
+
+/** Copy values into a row of size, padding with zeros. */
+static void CopyRow( const std::vector< double > & values,
+                     double * row, unsigned int size )
+{
+  unsigned int count = std::min( size, static_cast< unsigned int >( values.size() ) );
+  std::copy( values.begin(), values.begin() + count, row );
+  std::fill( row + count, row + size, 0.0 );
+}
+
+
+SampleBlock
+::SampleBlock() :
+  m_NumberOfSamples( 0 ),
+  m_NumberOfParameters( 0 ),
+  m_NumberOfOutputs( 0 )
+{
+}
+
+
+SampleBlock
+::~SampleBlock()
+{
+}
+
+
+void
+SampleBlock
+::Resize( unsigned int numberOfSamples,
+          unsigned int numberOfParameters,
+          unsigned int numberOfOutputs )
+{
+  m_NumberOfSamples = numberOfSamples;
+  m_NumberOfParameters = numberOfParameters;
+  m_NumberOfOutputs = numberOfOutputs;
+
+  // std::vector keeps its capacity when it shrinks.
+  m_ParameterValues.resize( numberOfSamples * numberOfParameters );
+  m_OutputValues.resize( numberOfSamples * numberOfOutputs );
+  m_LogLikelihoodValueGradients.resize( numberOfSamples * numberOfOutputs );
+  m_LogLikelihoodErrorGradients.resize( numberOfSamples * numberOfOutputs );
+  m_LogLikelihoods.resize( numberOfSamples );
+  m_Accepted.resize( numberOfSamples );
+}
+
+
+unsigned int
+SampleBlock
+::GetNumberOfSamples() const
+{
+  return m_NumberOfSamples;
+}
+
+
+unsigned int
+SampleBlock
+::GetNumberOfParameters() const
+{
+  return m_NumberOfParameters;
+}
+
+
+unsigned int
+SampleBlock
+::GetNumberOfOutputs() const
+{
+  return m_NumberOfOutputs;
+}
+
+
+double *
+SampleBlock
+::GetParameterValues( unsigned int index )
+{
+  assert( index < m_NumberOfSamples );
+  return &m_ParameterValues[0] + index * m_NumberOfParameters;
+}
+
+
+const double *
+SampleBlock
+::GetParameterValues( unsigned int index ) const
+{
+  assert( index < m_NumberOfSamples );
+  return &m_ParameterValues[0] + index * m_NumberOfParameters;
+}
+
+
+double *
+SampleBlock
+::GetOutputValues( unsigned int index )
+{
+  assert( index < m_NumberOfSamples );
+  return &m_OutputValues[0] + index * m_NumberOfOutputs;
+}
+
+
+const double *
+SampleBlock
+::GetOutputValues( unsigned int index ) const
+{
+  assert( index < m_NumberOfSamples );
+  return &m_OutputValues[0] + index * m_NumberOfOutputs;
+}
+
+
+double *
+SampleBlock
+::GetLogLikelihoodValueGradient( unsigned int index )
+{
+  assert( index < m_NumberOfSamples );
+  return &m_LogLikelihoodValueGradients[0] + index * m_NumberOfOutputs;
+}
+
+
+const double *
+SampleBlock
+::GetLogLikelihoodValueGradient( unsigned int index ) const
+{
+  assert( index < m_NumberOfSamples );
+  return &m_LogLikelihoodValueGradients[0] + index * m_NumberOfOutputs;
+}
+
+
+double *
+SampleBlock
+::GetLogLikelihoodErrorGradient( unsigned int index )
+{
+  assert( index < m_NumberOfSamples );
+  return &m_LogLikelihoodErrorGradients[0] + index * m_NumberOfOutputs;
+}
+
+
+const double *
+SampleBlock
+::GetLogLikelihoodErrorGradient( unsigned int index ) const
+{
+  assert( index < m_NumberOfSamples );
+  return &m_LogLikelihoodErrorGradients[0] + index * m_NumberOfOutputs;
+}
+
+
+double
+SampleBlock
+::GetLogLikelihood( unsigned int index ) const
+{
+  assert( index < m_NumberOfSamples );
+  return m_LogLikelihoods[index];
+}
+
+
+void
+SampleBlock
+::SetLogLikelihood( unsigned int index, double logLikelihood )
+{
+  assert( index < m_NumberOfSamples );
+  m_LogLikelihoods[index] = logLikelihood;
+}
+
+
+bool
+SampleBlock
+::IsAccepted( unsigned int index ) const
+{
+  assert( index < m_NumberOfSamples );
+  return m_Accepted[index] != 0;
+}
+
+
+void
+SampleBlock
+::SetAccepted( unsigned int index, bool accepted )
+{
+  assert( index < m_NumberOfSamples );
+  m_Accepted[index] = accepted ? 1 : 0;
+}
+
+
+void
+SampleBlock
+::SetSample( unsigned int index,
+             const std::vector< double > & parameterValues,
+             const std::vector< double > & outputValues,
+             double logLikelihood,
+             const std::vector< double > & logLikelihoodValueGradient,
+             const std::vector< double > & logLikelihoodErrorGradient,
+             bool accepted )
+{
+  assert( index < m_NumberOfSamples );
+  assert( parameterValues.size() == m_NumberOfParameters );
+  CopyRow( parameterValues, this->GetParameterValues( index ),
+           m_NumberOfParameters );
+  if ( m_NumberOfOutputs > 0 ) {
+    CopyRow( outputValues, this->GetOutputValues( index ),
+             m_NumberOfOutputs );
+    CopyRow( logLikelihoodValueGradient,
+             this->GetLogLikelihoodValueGradient( index ), m_NumberOfOutputs );
+    CopyRow( logLikelihoodErrorGradient,
+             this->GetLogLikelihoodErrorGradient( index ), m_NumberOfOutputs );
+  }
+  m_LogLikelihoods[index] = logLikelihood;
+  m_Accepted[index] = accepted ? 1 : 0;
+}
+
+
+void
+SampleBlock
+::SetSample( unsigned int index, const Sample & sample, bool accepted )
+{
+  this->SetSample( index, sample.m_ParameterValues, sample.m_OutputValues,
+                   sample.m_LogLikelihood,
+                   sample.m_LogLikelihoodValueGradient,
+                   sample.m_LogLikelihoodErrorGradient, accepted );
+}
+
+
+void
+SampleBlock
+::GetSample( unsigned int index, Sample & sample ) const
+{
+  const double * parameters = this->GetParameterValues( index );
+  sample.m_ParameterValues.assign( parameters,
+                                   parameters + m_NumberOfParameters );
+  if ( m_NumberOfOutputs > 0 ) {
+    const double * outputs = this->GetOutputValues( index );
+    sample.m_OutputValues.assign( outputs, outputs + m_NumberOfOutputs );
+    const double * valueGradient = this->GetLogLikelihoodValueGradient( index );
+    sample.m_LogLikelihoodValueGradient.assign(
+      valueGradient, valueGradient + m_NumberOfOutputs );
+    const double * errorGradient = this->GetLogLikelihoodErrorGradient( index );
+    sample.m_LogLikelihoodErrorGradient.assign(
+      errorGradient, errorGradient + m_NumberOfOutputs );
+  } else {
+    sample.m_OutputValues.clear();
+    sample.m_LogLikelihoodValueGradient.clear();
+    sample.m_LogLikelihoodErrorGradient.clear();
+  }
+  sample.m_LogLikelihood = m_LogLikelihoods[index];
+  sample.m_Comments.clear();
+}
+
+} // end namespace madai
@@ -0,0 +1,116 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_SampleBlock_h_included
+#define madai_SampleBlock_h_included
+
+#include <vector>
+
+#include "Sample.h"
+
+
+namespace madai {
+
+/** \class SampleBlock
+ *
+ * Consecutive Samples of a chain, stored as one contiguous array per
+ * field rather than one object per Sample: the parameter values of
+ * all Samples, then their output values, and so on, each row of a
+ * field following the previous one. Sampler::NextSamples() fills a
+ * SampleBlock owned by the caller, which can reuse it for the next
+ * block without allocating.
+ *
+ * Each Sample also records whether the step that produced it
+ * accepted a proposal, so that the caller need not compare it with
+ * the previous Sample.
+ */
+class SampleBlock {
+public:
+  SampleBlock();
+  virtual ~SampleBlock();
+
+  /** Make room for numberOfSamples Samples of the given sizes. The
+   * storage only grows, so a block of at most the same size needs no
+   * allocation. The contents are unspecified until set. */
+  void Resize( unsigned int numberOfSamples,
+               unsigned int numberOfParameters,
+               unsigned int numberOfOutputs );
+
+  unsigned int GetNumberOfSamples() const;
+  unsigned int GetNumberOfParameters() const;
+  unsigned int GetNumberOfOutputs() const;
+
+  //@{
+  /** Rows of a Sample, of GetNumberOfParameters() and
+   * GetNumberOfOutputs() values. The gradients are dLL/dy and
+   * sigma_y dLL/dsigma_y, as in Sample, and zero if the Sampler did
+   * not compute them. */
+  double * GetParameterValues( unsigned int index );
+  const double * GetParameterValues( unsigned int index ) const;
+  double * GetOutputValues( unsigned int index );
+  const double * GetOutputValues( unsigned int index ) const;
+  double * GetLogLikelihoodValueGradient( unsigned int index );
+  const double * GetLogLikelihoodValueGradient( unsigned int index ) const;
+  double * GetLogLikelihoodErrorGradient( unsigned int index );
+  const double * GetLogLikelihoodErrorGradient( unsigned int index ) const;
+  //@}
+
+  //@{
+  /** Log likelihood of a Sample. */
+  double GetLogLikelihood( unsigned int index ) const;
+  void SetLogLikelihood( unsigned int index, double logLikelihood );
+  //@}
+
+  //@{
+  /** Whether the step that produced a Sample moved the chain. */
+  bool IsAccepted( unsigned int index ) const;
+  void SetAccepted( unsigned int index, bool accepted );
+  //@}
+
+  /** Copy a Sample and its acceptance into a row. Values missing from
+   * the Sample, such as gradients it was not given, are set to
+   * zero. */
+  void SetSample( unsigned int index,
+                  const std::vector< double > & parameterValues,
+                  const std::vector< double > & outputValues,
+                  double logLikelihood,
+                  const std::vector< double > & logLikelihoodValueGradient,
+                  const std::vector< double > & logLikelihoodErrorGradient,
+                  bool accepted );
+  void SetSample( unsigned int index, const Sample & sample, bool accepted );
+
+  /** Copy a row into a Sample. */
+  void GetSample( unsigned int index, Sample & sample ) const;
+
+protected:
+  unsigned int m_NumberOfSamples;
+  unsigned int m_NumberOfParameters;
+  unsigned int m_NumberOfOutputs;
+
+  std::vector< double > m_ParameterValues;
+  std::vector< double > m_OutputValues;
+  std::vector< double > m_LogLikelihoodValueGradients;
+  std::vector< double > m_LogLikelihoodErrorGradients;
+  std::vector< double > m_LogLikelihoods;
+  std::vector< char >   m_Accepted;
+
+}; // end class SampleBlock
+
+} // end namespace madai
+
+#endif // madai_SampleBlock_h_included
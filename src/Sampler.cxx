@@ -18,6 +18,9 @@
 
 #include <algorithm> // std::count
 #include <cassert>
+#include <cmath>
+#include <cstdlib> // std::strtod
+#include <limits>
 
 #include "Sampler.h"
 #include "Parameter.h"
@@ -27,7 +30,8 @@ namespace madai {
 
 Sampler
 ::Sampler() :
-  m_Model( NULL )
+  m_Model( NULL ),
+  m_AdaptationEnded( false )
 {
 }
 
@@ -48,6 +52,207 @@ Sampler
 }
 
 
+void
+Sampler
+::ReseedRandomNumberGenerator( unsigned long int seed )
+{
+  m_Random.Reseed( seed );
+}
+
+
+void
+Sampler
+::SetRandomNumberStream( const Random & generator, unsigned long int stream )
+{
+  generator.Split( stream, m_Random );
+}
+
+
+void
+Sampler
+::WriteProgress( std::ostream & ) const
+{
+}
+
+
+void
+Sampler
+::EndAdaptation()
+{
+  m_AdaptationEnded = true;
+}
+
+
+void
+Sampler
+::WriteState( std::ostream & o ) const
+{
+  WriteTag( o, "Sampler" );
+  WriteIntegers( o, m_ActiveParameterIndices );
+  WriteValues( o, m_CurrentParameters );
+  WriteValues( o, m_CurrentOutputs );
+  WriteValue( o, m_CurrentLogLikelihood );
+  o << ' ' << ( m_AdaptationEnded ? 1 : 0 ) << '\n';
+  WriteValues( o, m_CurrentLogLikelihoodValueGradient );
+  WriteValues( o, m_CurrentLogLikelihoodErrorGradient );
+  m_Random.WriteState( o );
+}
+
+
+bool
+Sampler
+::ReadState( std::istream & i )
+{
+  assert( m_Model != NULL );
+
+  std::vector< bool > activeParameterIndices;
+  std::vector< double > parameters, outputs, valueGradient, errorGradient;
+  double logLikelihood;
+  int adaptationEnded;
+  if ( !ReadTag( i, "Sampler" ) ||
+       !ReadIntegers( i, activeParameterIndices ) ||
+       !ReadValues( i, parameters ) ||
+       !ReadValues( i, outputs ) ||
+       !ReadValue( i, logLikelihood ) ||
+       !( i >> adaptationEnded ) ||
+       !ReadValues( i, valueGradient ) ||
+       !ReadValues( i, errorGradient ) ||
+       activeParameterIndices.size() != m_Model->GetNumberOfParameters() ||
+       parameters.size() != m_Model->GetNumberOfParameters() ||
+       outputs.size() != m_Model->GetNumberOfScalarOutputs() ||
+       !m_Random.ReadState( i ) ) {
+    return false;
+  }
+
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  m_ActiveParameterIndices = activeParameterIndices;
+  m_ActiveParameters.clear();
+  for ( unsigned int k = 0; k < params.size(); ++k ) {
+    if ( m_ActiveParameterIndices[k] ) {
+      m_ActiveParameters.insert( params[k].m_Name );
+    }
+  }
+  m_CurrentParameters = parameters;
+  m_CurrentOutputs = outputs;
+  m_CurrentLogLikelihood = logLikelihood;
+  m_CurrentLogLikelihoodValueGradient = valueGradient;
+  m_CurrentLogLikelihoodErrorGradient = errorGradient;
+  m_AdaptationEnded = ( adaptationEnded != 0 );
+  return true;
+}
+
+
+void
+Sampler
+::WriteTag( std::ostream & o, const char * tag )
+{
+  o << tag << '\n';
+}
+
+
+bool
+Sampler
+::ReadTag( std::istream & i, const char * tag )
+{
+  std::string word;
+  return ( ( i >> word ) && word == tag );
+}
+
+
+void
+Sampler
+::WriteValue( std::ostream & o, double value )
+{
+  if ( value != value ) {
+    o << "nan";
+  } else if ( std::fabs( value ) > std::numeric_limits< double >::max() ) {
+    o << ( value > 0.0 ? "inf" : "-inf" );
+  } else {
+    std::streamsize precision =
+      o.precision( std::numeric_limits< double >::digits10 + 2 );
+    o << value;
+    o.precision( precision );
+  }
+}
+
+
+bool
+Sampler
+::ReadValue( std::istream & i, double & value )
+{
+  // Read a word, since streams do not read infinite values.
+  std::string word;
+  if ( !( i >> word ) ) {
+    return false;
+  }
+  char * end;
+  value = std::strtod( word.c_str(), &end );
+  return ( *end == '\0' );
+}
+
+
+void
+Sampler
+::WriteValues( std::ostream & o, const std::vector< double > & values )
+{
+  o << values.size();
+  for ( size_t k = 0; k < values.size(); ++k ) {
+    o << ' ';
+    WriteValue( o, values[k] );
+  }
+  o << '\n';
+}
+
+
+bool
+Sampler
+::ReadValues( std::istream & i, std::vector< double > & values )
+{
+  size_t size;
+  if ( !( i >> size ) ) {
+    return false;
+  }
+  std::vector< double > read( size );
+  for ( size_t k = 0; k < size; ++k ) {
+    if ( !ReadValue( i, read[k] ) ) {
+      return false;
+    }
+  }
+  values.swap( read );
+  return true;
+}
+
+
+void
+Sampler
+::WriteSample( std::ostream & o, const Sample & sample )
+{
+  WriteValues( o, sample.m_ParameterValues );
+  WriteValues( o, sample.m_OutputValues );
+  WriteValue( o, sample.m_LogLikelihood );
+  o << '\n';
+  WriteValues( o, sample.m_LogLikelihoodValueGradient );
+  WriteValues( o, sample.m_LogLikelihoodErrorGradient );
+}
+
+
+bool
+Sampler
+::ReadSample( std::istream & i, Sample & sample )
+{
+  Sample read;
+  if ( !ReadValues( i, read.m_ParameterValues ) ||
+       !ReadValues( i, read.m_OutputValues ) ||
+       !ReadValue( i, read.m_LogLikelihood ) ||
+       !ReadValues( i, read.m_LogLikelihoodValueGradient ) ||
+       !ReadValues( i, read.m_LogLikelihoodErrorGradient ) ) {
+    return false;
+  }
+  sample = read;
+  return true;
+}
+
+
 const Model *
 Sampler
 ::GetModel() const
@@ -98,6 +303,24 @@ Sampler
 }
 
 
+bool
+Sampler
+::ActiveIndicesChanged( const std::vector< unsigned int > & indices ) const
+{
+  unsigned int numberOfActive = 0;
+  for ( unsigned int i = 0; i < m_ActiveParameterIndices.size(); ++i ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      if ( numberOfActive >= indices.size() ||
+           indices[ numberOfActive ] != i ) {
+        return true;
+      }
+      ++numberOfActive;
+    }
+  }
+  return ( numberOfActive != indices.size() );
+}
+
+
 bool
 Sampler
 ::IsParameterActive( const std::string & parameterName ) const
@@ -281,6 +504,29 @@ Sampler
 }
 
 
+void
+Sampler
+::NextSamples( unsigned int numberOfSamples, SampleBlock & block )
+{
+  assert( m_Model != NULL );
+  block.Resize( numberOfSamples, m_Model->GetNumberOfParameters(),
+                m_Model->GetNumberOfScalarOutputs() );
+  for ( unsigned int i = 0; i < numberOfSamples; ++i ) {
+    double logLikelihood = m_CurrentLogLikelihood;
+    double * parameters = block.GetParameterValues( i );
+    std::copy( m_CurrentParameters.begin(), m_CurrentParameters.end(),
+               parameters );
+    Sample sample = this->NextSample();
+    bool accepted = ( sample.m_LogLikelihood != logLikelihood ||
+                      sample.m_ParameterValues.size() != m_CurrentParameters.size() ||
+                      !std::equal( sample.m_ParameterValues.begin(),
+                                   sample.m_ParameterValues.end(),
+                                   parameters ) );
+    block.SetSample( i, sample, accepted );
+  }
+}
+
+
 std::string
 Sampler
 ::GetErrorTypeAsString( ErrorType error )
@@ -305,6 +551,7 @@ Sampler
     return;
 
   m_Model = model;
+  m_AdaptationEnded = false;
   unsigned int np = m_Model->GetNumberOfParameters();
 
   // Activate all parameters by default.
@@ -19,12 +19,15 @@
 #ifndef madai_Sampler_h_included
 #define madai_Sampler_h_included
 
+#include <iostream>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "Model.h"
 #include "Parameter.h"
 #include "Sample.h"
+#include "SampleBlock.h"
 
 
 namespace madai {
@@ -239,6 +242,86 @@ public:
    * \return A new Sample. */
   virtual Sample NextSample() = 0;
 
+  /**
+   * Compute the next numberOfSamples Samples into a block owned by
+   * the caller, with a flag for each telling whether it moved the
+   * chain.
+   *
+   * The Samples are the ones that as many calls of NextSample() would
+   * return. The default calls NextSample() and flags a Sample as
+   * accepted if it differs from the current point before the call.
+   * Samplers that know whether they accepted override this to skip
+   * the copies.
+   *
+   * \param numberOfSamples The number of Samples to compute.
+   * \param block Receives the Samples; resized as needed. */
+  virtual void NextSamples( unsigned int numberOfSamples, SampleBlock & block );
+
+  /**
+   * Reseed the random number generator of the Sampler.
+   *
+   * Samplers running side by side need different seeds to produce
+   * independent chains. Call this before SetModel() so that the
+   * starting point depends on the seed as well.
+   *
+   * \param seed Seed for the random number generator. */
+  void ReseedRandomNumberGenerator( unsigned long int seed );
+
+  /**
+   * Make the random number generator of the Sampler a stream split
+   * from generator by Random::Split().
+   *
+   * Streams with different indices are independent, so Samplers
+   * running side by side can take streams of one master generator,
+   * one index each. As with a seed, call this before SetModel().
+   *
+   * \param generator Master generator.
+   * \param stream Index of the stream, such as the index of a chain. */
+  void SetRandomNumberStream( const Random & generator,
+                              unsigned long int stream );
+
+  /**
+   * Write Sampler-specific statistics to a progress line.
+   *
+   * SamplerCSVWriter calls this after its own progress report. The
+   * output should be short and contain no newlines. The default
+   * writes nothing.
+   *
+   * \param progress Stream that receives the progress line. */
+  virtual void WriteProgress( std::ostream & progress ) const;
+
+  /**
+   * Stop adapting the proposal, for good.
+   *
+   * Samplers that tune themselves for a number of adaptation samples
+   * freeze their tuning here instead, as they would at the end of
+   * the adaptation. SamplerCSVWriter calls this when it ends the
+   * burn-in before the adaptation is over, so that the trace comes
+   * from a fixed kernel. Whether adaptation has ended is part of the
+   * state. Subclasses that override this should call it. */
+  virtual void EndAdaptation();
+
+  /**
+   * Write the state of the Sampler to a stream, as text.
+   *
+   * The state contains the current point, the active Parameters, the
+   * state of the random number generator, and whatever a subclass
+   * needs to continue its sequence of Samples exactly, such as an
+   * adapted proposal. Settings that the Sampler does not adapt, such
+   * as the number of adaptation samples, are not part of the state.
+   *
+   * \param o Stream that receives the state. */
+  virtual void WriteState( std::ostream & o ) const;
+
+  /**
+   * Restore a state written by WriteState() of a Sampler of the same
+   * type and with the same settings, after SetModel() has been called
+   * with the same Model.
+   *
+   * \param i Stream from which the state is read.
+   * \return false if the stream does not contain such a state. */
+  virtual bool ReadState( std::istream & i );
+
   /**
    Return ErrorType as string. */
   static std::string GetErrorTypeAsString( ErrorType error );
@@ -274,6 +357,12 @@ protected:
   /** Stores the current log-likelihood gradient dLL_dy */
   std::vector< double > m_CurrentLogLikelihoodValueGradient;
 
+  /** Random number generator used by subclasses. */
+  madai::Random m_Random;
+
+  /** Set by EndAdaptation(); subclasses no longer adapt once it is. */
+  bool m_AdaptationEnded;
+
   /* Protected methods: */
 
   /** Initialize the Sampler
@@ -296,6 +385,95 @@ protected:
    * algorithm should override this method. */
   virtual void ParameterSetExternally();
 
+  /**
+   * Whether the active Parameters differ from a list of indices
+   * taken earlier, in increasing order. Activating and deactivating
+   * Parameters does not notify subclasses, so those that keep state
+   * per active Parameter compare their list before each step. */
+  bool ActiveIndicesChanged( const std::vector< unsigned int > & indices ) const;
+
+  //@{
+  /** Helpers for WriteState() and ReadState() of subclasses. A tag
+   * names the part of the state that follows. Values are written
+   * with enough digits to be read back exactly, and may be
+   * infinite. Vectors are preceded by their size, and matrices, such
+   * as those of Eigen, by their numbers of rows and columns. */
+  static void WriteTag( std::ostream & o, const char * tag );
+  static bool ReadTag( std::istream & i, const char * tag );
+  static void WriteValue( std::ostream & o, double value );
+  static bool ReadValue( std::istream & i, double & value );
+  static void WriteValues( std::ostream & o,
+                           const std::vector< double > & values );
+  static bool ReadValues( std::istream & i,
+                          std::vector< double > & values );
+  static void WriteSample( std::ostream & o, const Sample & sample );
+  static bool ReadSample( std::istream & i, Sample & sample );
+
+  template< class TInteger >
+  static void WriteIntegers( std::ostream & o,
+                             const std::vector< TInteger > & values )
+  {
+    o << values.size();
+    for ( size_t k = 0; k < values.size(); ++k ) {
+      o << ' ' << values[k];
+    }
+    o << '\n';
+  }
+
+  template< class TInteger >
+  static bool ReadIntegers( std::istream & i,
+                            std::vector< TInteger > & values )
+  {
+    size_t size;
+    if ( !( i >> size ) ) {
+      return false;
+    }
+    std::vector< TInteger > read( size );
+    for ( size_t k = 0; k < size; ++k ) {
+      TInteger value;
+      if ( !( i >> value ) ) {
+        return false;
+      }
+      read[k] = value;
+    }
+    values.swap( read );
+    return true;
+  }
+
+  template< class TMatrix >
+  static void WriteMatrix( std::ostream & o, const TMatrix & matrix )
+  {
+    o << matrix.rows() << ' ' << matrix.cols();
+    for ( long r = 0; r < static_cast< long >( matrix.rows() ); ++r ) {
+      for ( long c = 0; c < static_cast< long >( matrix.cols() ); ++c ) {
+        o << ' ';
+        WriteValue( o, matrix( r, c ) );
+      }
+    }
+    o << '\n';
+  }
+
+  template< class TMatrix >
+  static bool ReadMatrix( std::istream & i, TMatrix & matrix )
+  {
+    long rows, cols;
+    if ( !( i >> rows >> cols ) || rows < 0 || cols < 0 ) {
+      return false;
+    }
+    TMatrix read;
+    read.resize( rows, cols );
+    for ( long r = 0; r < rows; ++r ) {
+      for ( long c = 0; c < cols; ++c ) {
+        if ( !ReadValue( i, read( r, c ) ) ) {
+          return false;
+        }
+      }
+    }
+    matrix = read;
+    return true;
+  }
+  //@}
+
 }; // end Sampler
 
 } // end namespace madai
@@ -16,18 +16,93 @@
  *
  *=========================================================================*/
 
+#include <algorithm>
 #include <cassert>
+#include <cstdio> // std::rename
 #include <cstdlib>
+#include <fstream>
 #include <iomanip>
+#include <limits>
 
+#include "Configuration.h"
+#include "ConvergenceMonitor.h"
 #include "SamplerCSVWriter.h"
 #include "Sample.h"
+#include "SampleBlock.h"
 #include "Sampler.h"
 #include "Model.h"
 
 namespace madai {
 
 
+/** Prepare a ConvergenceMonitor for the active parameters of the
+ * Samplers, unless it holds the diagnostics of the run being
+ * continued. */
+static void InitializeConvergenceMonitor(
+  ConvergenceMonitor * convergenceMonitor,
+  const std::vector< Sampler * > & samplers,
+  bool continuing )
+{
+  if ( convergenceMonitor == NULL ) {
+    return;
+  }
+  unsigned int numberOfChains = static_cast< unsigned int >( samplers.size() );
+  unsigned int numberOfParameters = samplers[0]->GetNumberOfActiveParameters();
+  if ( !continuing ||
+       convergenceMonitor->GetNumberOfChains() != numberOfChains ||
+       convergenceMonitor->GetNumberOfParameters() != numberOfParameters ) {
+    convergenceMonitor->Initialize( numberOfChains, numberOfParameters );
+  }
+}
+
+
+/** Feed the active parameters of a Sample to a ConvergenceMonitor. */
+static void AddToConvergenceMonitor(
+  ConvergenceMonitor * convergenceMonitor,
+  unsigned int chain,
+  const std::vector< bool > & activeParameters,
+  const double * parameterValues,
+  std::vector< double > & values )
+{
+  values.clear();
+  for ( size_t p = 0; p < activeParameters.size(); ++p ) {
+    if ( activeParameters[p] ) {
+      values.push_back( parameterValues[p] );
+    }
+  }
+  convergenceMonitor->AddSample( chain, values );
+}
+
+
+/** Append the diagnostics of a ConvergenceMonitor to a progress
+ * line. */
+static void WriteConvergenceProgress(
+  std::ostream & progress,
+  const ConvergenceMonitor & convergenceMonitor )
+{
+  progress << "  ESS: " << static_cast< long int >(
+    convergenceMonitor.GetMinimumEffectiveSampleSize() );
+  std::streamsize precision = progress.precision( 4 );
+  progress << "  R-hat: "
+           << convergenceMonitor.GetMaximumPotentialScaleReduction();
+  progress.precision( precision );
+}
+
+
+/** Returns true if the log likelihoods of the chains over the second
+ * half of the burn-in so far are stationary. */
+static bool IsEndOfBurnIn(
+  const std::vector< std::vector< double > > & logLikelihoods )
+{
+  std::vector< std::vector< double > > secondHalves( logLikelihoods.size() );
+  for ( size_t chain = 0; chain < logLikelihoods.size(); ++chain ) {
+    const std::vector< double > & values = logLikelihoods[chain];
+    secondHalves[chain].assign( values.begin() + values.size() / 2, values.end() );
+  }
+  return ConvergenceMonitor::IsStationary( secondHalves );
+}
+
+
 int SamplerCSVWriter
 ::GenerateSamplesAndSaveToFile(
     Sampler & sampler,
@@ -37,55 +112,340 @@ int SamplerCSVWriter
     int NumberOfBurnInSamples,
     bool UseEmulatorCovariance,
     bool WriteLogLikelihoodGradients,
-    std::ostream * progress)
+    std::ostream * progress,
+    bool WriteHeaderLine,
+    int NumberOfCompletedSamples,
+    const std::string & CheckpointFile,
+    int CheckpointInterval,
+    ConvergenceMonitor * convergenceMonitor)
 {
   model.SetUseModelCovarianceToCalulateLogLikelihood(UseEmulatorCovariance);
   sampler.SetModel( &model );
+  std::vector< Sampler * > samplers( 1, &sampler );
+  InitializeConvergenceMonitor( convergenceMonitor, samplers,
+                                NumberOfCompletedSamples > NumberOfBurnInSamples );
+  std::vector< double > monitoredValues;
+  bool converged = false;
+  bool detectEndOfBurnIn = ( convergenceMonitor != NULL &&
+                             convergenceMonitor->GetDetectEndOfBurnIn() );
+  std::vector< std::vector< double > > burnInLogLikelihoods( 1 );
+  int endOfBurnIn = 0;
 
   enum phase { burnIn = 0, traceGeneration = 1 };
   int currentNumberOfSamples[2] = { NumberOfBurnInSamples, NumberOfSamples };
+  int firstSample[2] = {
+    std::min( NumberOfCompletedSamples, NumberOfBurnInSamples ),
+    std::max( NumberOfCompletedSamples - NumberOfBurnInSamples, 0 ) };
   const char * currentName[2] = {"Burn in", "Sampler"};
-  double bestLogLikelihood = 0;
-  Sample oldSample = sampler.NextSample();
+  double bestLogLikelihood = -std::numeric_limits< double >::infinity();
+  bool checkpoints = ( !CheckpointFile.empty() && CheckpointInterval > 0 );
+  SampleBlock block;
   for ( int currentPhase = burnIn; currentPhase <= traceGeneration; currentPhase++ ) {
-    int step = currentNumberOfSamples[currentPhase] / 100, percent = 1;
+    int step = currentNumberOfSamples[currentPhase] / 100;
     if ( step < 1 ) {
       step = 1; // avoid div-by-zero error
     }
+    int offset = ( currentPhase == burnIn ? 0 : NumberOfBurnInSamples );
     int successfulSteps = 0, failedSteps = 0;
-    for ( int count = 0; count < currentNumberOfSamples[currentPhase]; count++ ) {
-      Sample sample = sampler.NextSample();
-      if ( sample == oldSample ) {
-        failedSteps++;
+    int count = firstSample[currentPhase];
+    while ( count < currentNumberOfSamples[currentPhase] ) {
+      // Draw the Samples up to the next progress report or checkpoint
+      // as one block.
+      int end = std::min( currentNumberOfSamples[currentPhase],
+                          ( count / step + 1 ) * step );
+      if ( checkpoints ) {
+        end = std::min( end, ( ( offset + count ) / CheckpointInterval + 1 ) *
+                        CheckpointInterval - offset );
       }
-      else {
-        successfulSteps++;
-      }
-      oldSample = sample;
+      sampler.NextSamples( static_cast< unsigned int >( end - count ), block );
+      for ( unsigned int i = 0; i < block.GetNumberOfSamples(); ++i ) {
+        if ( block.IsAccepted( i ) ) {
+          successfulSteps++;
+        }
+        else {
+          failedSteps++;
+        }
+
+        double logLikelihood = block.GetLogLikelihood( i );
+        if ( currentPhase == burnIn && detectEndOfBurnIn ) {
+          burnInLogLikelihoods[0].push_back( logLikelihood );
+        }
 
+        if ( currentPhase == traceGeneration ) {
+          WriteSample( outFile, block, i, WriteLogLikelihoodGradients );
+          if ( convergenceMonitor != NULL ) {
+            AddToConvergenceMonitor( convergenceMonitor, 0,
+                                     sampler.GetActiveParametersByIndex(),
+                                     block.GetParameterValues( i ),
+                                     monitoredValues );
+          }
+        }
+
+        if ( logLikelihood > bestLogLikelihood ) {
+          bestLogLikelihood = logLikelihood;
+        }
+      }
       if ( currentPhase == traceGeneration ) {
-        WriteSample( outFile, sample, WriteLogLikelihoodGradients );
+        outFile.flush();
       }
+      count = end;
 
-      if ( sample.m_LogLikelihood > bestLogLikelihood || ( currentPhase == burnIn && count == 0 ) ) {
-        bestLogLikelihood = sample.m_LogLikelihood;
+      int completed = offset + count;
+      if ( checkpoints && completed % CheckpointInterval == 0 ) {
+        outFile.flush();
+        if ( !SaveCheckpoint( CheckpointFile, samplers, completed,
+                              convergenceMonitor ) ) {
+          return EXIT_FAILURE;
+        }
       }
 
+      bool monitored = ( currentPhase == traceGeneration && convergenceMonitor != NULL );
+      bool report = ( count % step == 0 );
       if ( progress != NULL ) {
-        if ( ( count + 1 ) % step == 0 ) {
-          (*progress) <<  '\r' << currentName[currentPhase] << " percent done: " << std::setfill('0') << std::setw(2) << percent++ << "%";
+        if ( report ) {
+          (*progress) <<  '\r' << currentName[currentPhase] << " percent done: " << std::setfill('0') << std::setw(2) << count / step << "%";
           (*progress) << "  Success rate: " << std::setfill('0') << std::setw(2) << 100*successfulSteps / (successfulSteps + failedSteps) << "%";
           (*progress) << "  Best log likelihood: " << bestLogLikelihood;
+          if ( monitored ) {
+            WriteConvergenceProgress( *progress, *convergenceMonitor );
+          }
+          sampler.WriteProgress( *progress );
         }
         progress->flush();
       }
+
+      if ( monitored && report && convergenceMonitor->HasConverged() ) {
+        converged = true;
+        break;
+      }
+      if ( currentPhase == burnIn && detectEndOfBurnIn && report &&
+           IsEndOfBurnIn( burnInLogLikelihoods ) ) {
+        endOfBurnIn = count;
+        break;
+      }
     }
-    if ( currentPhase == burnIn ) {
+    if ( currentPhase == burnIn && endOfBurnIn > 0 ) {
+      // The trace must come from a fixed kernel. The checkpoint
+      // records that the burn-in is over.
+      sampler.EndAdaptation();
+      if ( checkpoints &&
+           !SaveCheckpoint( CheckpointFile, samplers, NumberOfBurnInSamples,
+                            convergenceMonitor ) ) {
+        return EXIT_FAILURE;
+      }
+    }
+    if ( currentPhase == burnIn && WriteHeaderLine &&
+         NumberOfCompletedSamples <= NumberOfBurnInSamples ) {
       WriteHeader( outFile, model.GetParameters(), model.GetScalarOutputNames(), WriteLogLikelihoodGradients );
     }
     if ( progress != NULL ) {
       // Leave the success rate percentage visible
       (*progress) << "\n";
+      if ( currentPhase == burnIn && endOfBurnIn > 0 ) {
+        (*progress) << "Log likelihood stationary after " << endOfBurnIn
+                    << " burn-in samples\n";
+      }
+      if ( converged ) {
+        (*progress) << "Converged after "
+                    << convergenceMonitor->GetNumberOfSamples() << " samples\n";
+      }
+      progress->flush();
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int SamplerCSVWriter
+::GenerateSamplesAndSaveToFiles(
+    const std::vector< Sampler * > & samplers,
+    Model & model,
+    const std::vector< std::ostream * > & outFiles,
+    int NumberOfSamples,
+    int NumberOfBurnInSamples,
+    bool UseEmulatorCovariance,
+    bool WriteLogLikelihoodGradients,
+    std::ostream * progress,
+    int NumberOfCompletedSamples,
+    const std::string & CheckpointFile,
+    int CheckpointInterval,
+    ConvergenceMonitor * convergenceMonitor)
+{
+  int numberOfChains = static_cast< int >( samplers.size() );
+  if ( numberOfChains == 0 ||
+       ( outFiles.size() != 1 && outFiles.size() != samplers.size() ) ) {
+    std::cerr << "Expected one output stream, or one per sampler.\n";
+    return EXIT_FAILURE;
+  }
+  bool interleave = ( outFiles.size() == 1 );
+
+  // Set up the model before the chains share it.
+  model.SetUseModelCovarianceToCalulateLogLikelihood(UseEmulatorCovariance);
+  bool concurrent = model.SupportsConcurrentEvaluation();
+  (void)concurrent; // only used by OpenMP
+
+  for ( int chain = 0; chain < numberOfChains; ++chain ) {
+    samplers[chain]->SetModel( &model );
+  }
+
+  InitializeConvergenceMonitor( convergenceMonitor, samplers,
+                                NumberOfCompletedSamples > NumberOfBurnInSamples );
+  std::vector< double > monitoredValues;
+  bool converged = false;
+  bool detectEndOfBurnIn = ( convergenceMonitor != NULL &&
+                             convergenceMonitor->GetDetectEndOfBurnIn() );
+  std::vector< std::vector< double > > burnInLogLikelihoods( numberOfChains );
+  int endOfBurnIn = 0;
+
+  enum phase { burnIn = 0, traceGeneration = 1 };
+  int currentNumberOfSamples[2] = { NumberOfBurnInSamples, NumberOfSamples };
+  int firstSample[2] = {
+    std::min( NumberOfCompletedSamples, NumberOfBurnInSamples ),
+    std::max( NumberOfCompletedSamples - NumberOfBurnInSamples, 0 ) };
+  const char * currentName[2] = {"Burn in", "Sampler"};
+  double bestLogLikelihood = -std::numeric_limits< double >::infinity();
+  std::vector< SampleBlock > blocks( numberOfChains );
+  int samplesSinceCheckpoint = 0;
+  for ( int currentPhase = burnIn; currentPhase <= traceGeneration; currentPhase++ ) {
+    if ( currentPhase == traceGeneration &&
+         NumberOfCompletedSamples <= NumberOfBurnInSamples ) {
+      for ( size_t i = 0; i < outFiles.size(); ++i ) {
+        WriteHeader( *outFiles[i], model.GetParameters(),
+                     model.GetScalarOutputNames(), WriteLogLikelihoodGradients );
+      }
+    }
+
+    // The chains advance one block at a time, after which the block
+    // is written and the progress reported.
+    int numberOfSamples = currentNumberOfSamples[currentPhase];
+    int blockSize = std::min( std::max( numberOfSamples / 100, 1 ), 1000 );
+    std::vector< int > successfulSteps( numberOfChains, 0 );
+    std::vector< int > failedSteps( numberOfChains, 0 );
+    int first = firstSample[currentPhase];
+    for ( int start = first; start < numberOfSamples; start += blockSize ) {
+      int count = std::min( blockSize, numberOfSamples - start );
+#if defined( OPENMP_FOUND )
+      #pragma omp parallel for if ( concurrent )
+#endif // OPENMP_FOUND
+      for ( int chain = 0; chain < numberOfChains; ++chain ) {
+        samplers[chain]->NextSamples( static_cast< unsigned int >( count ),
+                                      blocks[chain] );
+        for ( int i = 0; i < count; ++i ) {
+          if ( blocks[chain].IsAccepted( i ) ) {
+            successfulSteps[chain]++;
+          } else {
+            failedSteps[chain]++;
+          }
+        }
+      }
+
+      int successful = 0;
+      for ( int chain = 0; chain < numberOfChains; ++chain ) {
+        successful += successfulSteps[chain];
+        for ( int i = 0; i < count; ++i ) {
+          bestLogLikelihood = std::max( bestLogLikelihood,
+                                        blocks[chain].GetLogLikelihood( i ) );
+          if ( currentPhase == burnIn && detectEndOfBurnIn ) {
+            burnInLogLikelihoods[chain].push_back( blocks[chain].GetLogLikelihood( i ) );
+          }
+        }
+      }
+
+      if ( currentPhase == traceGeneration ) {
+        if ( interleave ) {
+          for ( int i = 0; i < count; ++i ) {
+            for ( int chain = 0; chain < numberOfChains; ++chain ) {
+              WriteSample( *outFiles[0], blocks[chain], i,
+                           WriteLogLikelihoodGradients );
+            }
+          }
+        } else {
+          for ( int chain = 0; chain < numberOfChains; ++chain ) {
+            for ( int i = 0; i < count; ++i ) {
+              WriteSample( *outFiles[chain], blocks[chain], i,
+                           WriteLogLikelihoodGradients );
+            }
+          }
+        }
+        if ( convergenceMonitor != NULL ) {
+          for ( int chain = 0; chain < numberOfChains; ++chain ) {
+            for ( int i = 0; i < count; ++i ) {
+              AddToConvergenceMonitor( convergenceMonitor, chain,
+                                       samplers[chain]->GetActiveParametersByIndex(),
+                                       blocks[chain].GetParameterValues( i ),
+                                       monitoredValues );
+            }
+          }
+        }
+        for ( size_t i = 0; i < outFiles.size(); ++i ) {
+          outFiles[i]->flush();
+        }
+      }
+
+      samplesSinceCheckpoint += count;
+      if ( !CheckpointFile.empty() && CheckpointInterval > 0 &&
+           samplesSinceCheckpoint >= CheckpointInterval ) {
+        for ( size_t i = 0; i < outFiles.size(); ++i ) {
+          outFiles[i]->flush();
+        }
+        int completed = ( currentPhase == burnIn ? 0 : NumberOfBurnInSamples ) + start + count;
+        if ( !SaveCheckpoint( CheckpointFile, samplers, completed,
+                              convergenceMonitor ) ) {
+          return EXIT_FAILURE;
+        }
+        samplesSinceCheckpoint = 0;
+      }
+
+      bool monitored = ( currentPhase == traceGeneration && convergenceMonitor != NULL );
+      if ( progress != NULL ) {
+        int done = start + count;
+        (*progress) <<  '\r' << currentName[currentPhase] << " percent done: " << std::setfill('0') << std::setw(2) << ( 100 * done / numberOfSamples ) << "%";
+        (*progress) << "  Success rate: " << std::setfill('0') << std::setw(2) << 100 * successful / ( ( done - first ) * numberOfChains ) << "%";
+        (*progress) << "  Best log likelihood: " << bestLogLikelihood;
+        if ( monitored ) {
+          WriteConvergenceProgress( *progress, *convergenceMonitor );
+        }
+        samplers[0]->WriteProgress( *progress );
+        progress->flush();
+      }
+
+      if ( monitored && convergenceMonitor->HasConverged() ) {
+        converged = true;
+        break;
+      }
+      if ( currentPhase == burnIn && detectEndOfBurnIn &&
+           IsEndOfBurnIn( burnInLogLikelihoods ) ) {
+        endOfBurnIn = start + count;
+        break;
+      }
+    }
+    if ( currentPhase == burnIn && endOfBurnIn > 0 ) {
+      // The trace must come from fixed kernels. The checkpoint
+      // records that the burn-in is over.
+      for ( int chain = 0; chain < numberOfChains; ++chain ) {
+        samplers[chain]->EndAdaptation();
+      }
+      if ( !CheckpointFile.empty() && CheckpointInterval > 0 ) {
+        if ( !SaveCheckpoint( CheckpointFile, samplers, NumberOfBurnInSamples,
+                              convergenceMonitor ) ) {
+          return EXIT_FAILURE;
+        }
+        samplesSinceCheckpoint = 0;
+      }
+    }
+    if ( progress != NULL ) {
+      // Leave the success rate percentage visible
+      (*progress) << "\n";
+      if ( currentPhase == burnIn && endOfBurnIn > 0 ) {
+        (*progress) << "Log likelihoods stationary after " << endOfBurnIn
+                    << " burn-in samples per chain\n";
+      }
+      if ( converged ) {
+        (*progress) << "Converged after "
+                    << convergenceMonitor->GetNumberOfSamples()
+                    << " samples per chain\n";
+      }
       progress->flush();
     }
   }
@@ -138,6 +498,78 @@ SamplerCSVWriter
 }
 
 
+void
+SamplerCSVWriter
+::WriteCheckpoint( std::ostream & o,
+                   const std::vector< Sampler * > & samplers,
+                   int NumberOfCompletedSamples,
+                   const ConvergenceMonitor * convergenceMonitor )
+{
+  o << "SamplerCheckpoint " << NumberOfCompletedSamples << ' '
+    << samplers.size() << '\n';
+  for ( size_t i = 0; i < samplers.size(); ++i ) {
+    samplers[i]->WriteState( o );
+  }
+  if ( convergenceMonitor != NULL ) {
+    convergenceMonitor->WriteState( o );
+  }
+}
+
+
+bool
+SamplerCSVWriter
+::ReadCheckpoint( std::istream & i,
+                  const std::vector< Sampler * > & samplers,
+                  int & NumberOfCompletedSamples,
+                  ConvergenceMonitor * convergenceMonitor )
+{
+  std::string tag;
+  size_t numberOfSamplers;
+  int completed;
+  if ( !( i >> tag >> completed >> numberOfSamplers ) ||
+       tag != "SamplerCheckpoint" || numberOfSamplers != samplers.size() ) {
+    return false;
+  }
+  for ( size_t k = 0; k < samplers.size(); ++k ) {
+    if ( !samplers[k]->ReadState( i ) ) {
+      return false;
+    }
+  }
+  if ( convergenceMonitor != NULL && !convergenceMonitor->ReadState( i ) ) {
+    return false;
+  }
+  NumberOfCompletedSamples = completed;
+  return true;
+}
+
+
+bool
+SamplerCSVWriter
+::SaveCheckpoint( const std::string & checkpointFile,
+                  const std::vector< Sampler * > & samplers,
+                  int NumberOfCompletedSamples,
+                  const ConvergenceMonitor * convergenceMonitor )
+{
+  std::string temporaryFile = checkpointFile + ".tmp";
+  std::ofstream o( temporaryFile.c_str() );
+  WriteCheckpoint( o, samplers, NumberOfCompletedSamples, convergenceMonitor );
+  o.close();
+  if ( !o ) {
+    std::cerr << "Could not write checkpoint file '" << temporaryFile << "'.\n";
+    return false;
+  }
+  // Renaming replaces the old checkpoint at once on POSIX systems;
+  // elsewhere it has to be removed first.
+  if ( std::rename( temporaryFile.c_str(), checkpointFile.c_str() ) != 0 &&
+       ( std::remove( checkpointFile.c_str() ) != 0 ||
+         std::rename( temporaryFile.c_str(), checkpointFile.c_str() ) != 0 ) ) {
+    std::cerr << "Could not replace checkpoint file '" << checkpointFile << "'.\n";
+    return false;
+  }
+  return true;
+}
+
+
 /** Utility for writing a vector to an output stream
  *
  * The vector elements are delimited by the given delimiter */
@@ -185,4 +617,35 @@ SamplerCSVWriter
 }
 
 
+void
+SamplerCSVWriter
+::WriteSample( std::ostream & out, const SampleBlock & block,
+               unsigned int index, bool WriteLogLikelihoodGradients )
+{
+  unsigned int numberOfOutputs = block.GetNumberOfOutputs();
+  const double * parameters = block.GetParameterValues( index );
+  for ( unsigned int i = 0; i < block.GetNumberOfParameters(); ++i ) {
+    out << parameters[i] << ',';
+  }
+  if ( numberOfOutputs > 0 ) {
+    const double * outputs = block.GetOutputValues( index );
+    for ( unsigned int i = 0; i < numberOfOutputs; ++i ) {
+      out << outputs[i] << ',';
+    }
+  }
+  out << block.GetLogLikelihood( index );
+  if ( WriteLogLikelihoodGradients && numberOfOutputs > 0 ) {
+    const double * valueGradient = block.GetLogLikelihoodValueGradient( index );
+    const double * errorGradient = block.GetLogLikelihoodErrorGradient( index );
+    for ( unsigned int i = 0; i < numberOfOutputs; ++i ) {
+      out << ',' << valueGradient[i];
+    }
+    for ( unsigned int i = 0; i < numberOfOutputs; ++i ) {
+      out << ',' << errorGradient[i];
+    }
+  }
+  out << '\n';
+}
+
+
 } // end namespace madai
@@ -25,8 +25,10 @@
 
 namespace madai {
 
+class ConvergenceMonitor;
 class Parameter;
 class Sample;
+class SampleBlock;
 class Sampler;
 class Model;
 
@@ -44,6 +46,32 @@ public:
    *
    * If progress is not NULL, will print out a progress bar to that
    *  output stream.
+   *
+   * If WriteHeaderLine is false, the header line is left out, so that the
+   *  Samples can be appended to an existing trace.
+   *
+   * If CheckpointFile is not empty, a checkpoint is written to it
+   *  every CheckpointInterval Samples, burn-in included, after the
+   *  Samples so far have been flushed to outFile. A run restored from
+   *  a checkpoint with ReadCheckpoint() continues with
+   *  NumberOfCompletedSamples set to the number read from it, and
+   *  produces the same Samples as a run that was not interrupted.
+   *  The header line is not written again if the burn-in was
+   *  complete.
+   *
+   * If convergenceMonitor is not NULL, it is fed the active
+   *  parameters of the Samples after burn-in, and its diagnostics are
+   *  reported with the progress. Sampling stops before
+   *  NumberOfSamples once the ConvergenceMonitor HasConverged(). It
+   *  is initialized here unless the run continues after the burn-in
+   *  from a checkpoint, from which it should have been restored. If
+   *  it GetDetectEndOfBurnIn(), the burn-in ends before
+   *  NumberOfBurnInSamples as soon as the log likelihoods over its
+   *  second half so far are ConvergenceMonitor::IsStationary(),
+   *  checked a hundred times over the burn-in. The Sampler then
+   *  stops adapting, see Sampler::EndAdaptation(). A run continued
+   *  from a checkpoint within the burn-in looks for its end from the
+   *  checkpoint on.
    */
   static int GenerateSamplesAndSaveToFile(
     Sampler & sampler,
@@ -53,7 +81,72 @@ public:
     int NumberOfBurnInSamples=0,
     bool UseEmulatorCovariance=true,
     bool WriteLogLikelihoodGradients=false,
-    std::ostream * progress=NULL);
+    std::ostream * progress=NULL,
+    bool WriteHeaderLine=true,
+    int NumberOfCompletedSamples=0,
+    const std::string & CheckpointFile="",
+    int CheckpointInterval=0,
+    ConvergenceMonitor * convergenceMonitor=NULL);
+
+  /**
+   * Execute several Samplers side by side on the same Model and save
+   * their Samples to comma-separated value files.
+   *
+   * Each Sampler is one chain and produces NumberOfSamples Samples
+   * after NumberOfBurnInSamples burn-in Samples. The Samplers should
+   * have been reseeded with different seeds so that the chains are
+   * independent. If the Model supports concurrent evaluation, the
+   * chains run on separate OpenMP threads; otherwise they run one
+   * after the other.
+   *
+   * outFiles must contain either one stream per Sampler, or a single
+   * stream into which the Samples of all chains are interleaved
+   * (the first Sample of each chain in order, then the second, and so
+   * on).
+   *
+   * If progress is not NULL, will print out a progress bar to that
+   *  output stream.
+   *
+   * Checkpoints are written as for a single Sampler, after the first
+   *  block of Samples that reaches CheckpointInterval Samples per
+   *  chain since the last one.
+   *
+   * A convergenceMonitor is used as for a single Sampler, with one
+   *  chain per Sampler. All chains stop after the same block.
+   */
+  static int GenerateSamplesAndSaveToFiles(
+    const std::vector< Sampler * > & samplers,
+    Model & model,
+    const std::vector< std::ostream * > & outFiles,
+    int NumberOfSamples,
+    int NumberOfBurnInSamples=0,
+    bool UseEmulatorCovariance=true,
+    bool WriteLogLikelihoodGradients=false,
+    std::ostream * progress=NULL,
+    int NumberOfCompletedSamples=0,
+    const std::string & CheckpointFile="",
+    int CheckpointInterval=0,
+    ConvergenceMonitor * convergenceMonitor=NULL);
+
+  /**
+   * Writes a checkpoint: the number of Samples, burn-in included,
+   * that each Sampler has produced, followed by the state of each
+   * Sampler from Sampler::WriteState() and of the convergenceMonitor,
+   * if not NULL. */
+  static void WriteCheckpoint( std::ostream & o,
+                               const std::vector< Sampler * > & samplers,
+                               int NumberOfCompletedSamples,
+                               const ConvergenceMonitor * convergenceMonitor=NULL );
+
+  /**
+   * Restores the Samplers from a checkpoint written with the same
+   * number of Samplers of the same types, after their Model has been
+   * set, and the convergenceMonitor, if not NULL. Returns false if
+   * the checkpoint cannot be read. */
+  static bool ReadCheckpoint( std::istream & i,
+                              const std::vector< Sampler * > & samplers,
+                              int & NumberOfCompletedSamples,
+                              ConvergenceMonitor * convergenceMonitor=NULL );
 
   /**
    * Writes the header of the CSV file. This consists of the parameter
@@ -69,6 +162,23 @@ public:
   static void WriteSample( std::ostream & out, const Sample & sample,
                            bool WriteLogLikelihoodGradients = false);
 
+  /**
+   * Writes one sample of a SampleBlock to the output stream, in the
+   * same format. Unlike the Sample version, it does not flush the
+   * stream. */
+  static void WriteSample( std::ostream & out, const SampleBlock & block,
+                           unsigned int index,
+                           bool WriteLogLikelihoodGradients = false );
+
+protected:
+  /**
+   * Writes a checkpoint to a file by way of a temporary file, so that
+   * an interruption never leaves a partial checkpoint behind. */
+  static bool SaveCheckpoint( const std::string & checkpointFile,
+                              const std::vector< Sampler * > & samplers,
+                              int NumberOfCompletedSamples,
+                              const ConvergenceMonitor * convergenceMonitor );
+
 }; // end SamplerCSVWriter
 
 } // end namespace madai
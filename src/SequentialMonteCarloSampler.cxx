@@ -0,0 +1,547 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "SequentialMonteCarloSampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+const double NEGATIVE_INFINITY = -std::numeric_limits< double >::infinity();
+
+/** Log of the prior times the likelihood raised to beta. */
+double TemperedLogLikelihood( double beta, double logLikelihood, double logPrior )
+{
+  // Also catches NaN from a failed evaluation.
+  if ( !( logLikelihood > NEGATIVE_INFINITY ) ||
+       !( logPrior > NEGATIVE_INFINITY ) ) {
+    return NEGATIVE_INFINITY;
+  }
+  return logPrior + beta * ( logLikelihood - logPrior );
+}
+
+/** Effective sample size of a set of log weights. */
+double EffectiveSampleSize( const std::vector< double > & logWeights )
+{
+  double maximum = *std::max_element( logWeights.begin(), logWeights.end() );
+  if ( !( maximum > NEGATIVE_INFINITY ) ) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  double sumOfSquares = 0.0;
+  for ( size_t i = 0; i < logWeights.size(); ++i ) {
+    double weight = std::exp( logWeights[i] - maximum );
+    sum += weight;
+    sumOfSquares += weight * weight;
+  }
+  return sum * sum / sumOfSquares;
+}
+
+} // end anonymous namespace
+
+
+namespace madai {
+
+
+SequentialMonteCarloSampler
+::SequentialMonteCarloSampler() :
+  Sampler(),
+  m_NumberOfParticles( 1000 ),
+  m_NumberOfMoveSteps( 5 ),
+  m_TargetEffectiveSampleFraction( 0.5 ),
+  m_InverseTemperature( 0.0 ),
+  m_LogEvidence( 0.0 ),
+  m_ProposalScale( 1.0 ),
+  m_AcceptanceRate( 0.0 ),
+  m_NextParticle( 0 )
+{
+}
+
+
+SequentialMonteCarloSampler
+::~SequentialMonteCarloSampler()
+{
+}
+
+
+void
+SequentialMonteCarloSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+
+  m_ParticleParameters.clear();
+  m_InverseTemperatures.clear();
+  Sampler::Initialize( model );
+}
+
+
+void
+SequentialMonteCarloSampler
+::SetNumberOfParticles( unsigned int numberOfParticles )
+{
+  m_NumberOfParticles = std::max( numberOfParticles, 2u );
+  m_ParticleParameters.clear();
+  m_InverseTemperatures.clear();
+}
+
+
+unsigned int
+SequentialMonteCarloSampler
+::GetNumberOfParticles() const
+{
+  return m_NumberOfParticles;
+}
+
+
+void
+SequentialMonteCarloSampler
+::SetNumberOfMoveSteps( unsigned int numberOfSteps )
+{
+  m_NumberOfMoveSteps = numberOfSteps;
+}
+
+
+unsigned int
+SequentialMonteCarloSampler
+::GetNumberOfMoveSteps() const
+{
+  return m_NumberOfMoveSteps;
+}
+
+
+void
+SequentialMonteCarloSampler
+::SetTargetEffectiveSampleFraction( double fraction )
+{
+  if ( fraction > 0.0 && fraction < 1.0 ) {
+    m_TargetEffectiveSampleFraction = fraction;
+  }
+}
+
+
+double
+SequentialMonteCarloSampler
+::GetTargetEffectiveSampleFraction() const
+{
+  return m_TargetEffectiveSampleFraction;
+}
+
+
+bool
+SequentialMonteCarloSampler
+::IsFinished() const
+{
+  return !m_ParticleParameters.empty() && m_InverseTemperature >= 1.0;
+}
+
+
+double
+SequentialMonteCarloSampler
+::GetLogEvidence() const
+{
+  return m_LogEvidence;
+}
+
+
+const std::vector< double > &
+SequentialMonteCarloSampler
+::GetInverseTemperatures() const
+{
+  return m_InverseTemperatures;
+}
+
+
+double
+SequentialMonteCarloSampler
+::GetAcceptanceRate() const
+{
+  return m_AcceptanceRate;
+}
+
+
+void
+SequentialMonteCarloSampler
+::WriteProgress( std::ostream & progress ) const
+{
+  size_t numberOfStages = m_InverseTemperatures.empty() ?
+    0 : m_InverseTemperatures.size() - 1;
+  progress << "  Stages: " << numberOfStages
+           << "  Log evidence: " << m_LogEvidence;
+}
+
+
+void
+SequentialMonteCarloSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "SequentialMonteCarloSampler" );
+  WriteValue( o, m_InverseTemperature );
+  o << ' ';
+  WriteValue( o, m_LogEvidence );
+  o << ' ';
+  WriteValue( o, m_ProposalScale );
+  o << ' ';
+  WriteValue( o, m_AcceptanceRate );
+  o << '\n';
+  WriteValues( o, m_InverseTemperatures );
+  o << m_ParticleParameters.size() << ' ' << m_NextParticle << '\n';
+  for ( size_t particle = 0; particle < m_ParticleParameters.size(); ++particle ) {
+    WriteValues( o, m_ParticleParameters[ particle ] );
+    WriteValues( o, m_ParticleOutputs[ particle ] );
+  }
+  WriteValues( o, m_ParticleLogLikelihoods );
+  WriteValues( o, m_ParticleLogPriors );
+}
+
+
+bool
+SequentialMonteCarloSampler
+::ReadState( std::istream & i )
+{
+  size_t numberOfParticles;
+  if ( !Sampler::ReadState( i ) ||
+       !ReadTag( i, "SequentialMonteCarloSampler" ) ||
+       !ReadValue( i, m_InverseTemperature ) ||
+       !ReadValue( i, m_LogEvidence ) ||
+       !ReadValue( i, m_ProposalScale ) ||
+       !ReadValue( i, m_AcceptanceRate ) ||
+       !ReadValues( i, m_InverseTemperatures ) ||
+       !( i >> numberOfParticles >> m_NextParticle ) ) {
+    return false;
+  }
+  m_ParticleParameters.resize( numberOfParticles );
+  m_ParticleOutputs.resize( numberOfParticles );
+  for ( size_t particle = 0; particle < numberOfParticles; ++particle ) {
+    if ( !ReadValues( i, m_ParticleParameters[ particle ] ) ||
+         !ReadValues( i, m_ParticleOutputs[ particle ] ) ) {
+      return false;
+    }
+  }
+  return ( ReadValues( i, m_ParticleLogLikelihoods ) &&
+           ReadValues( i, m_ParticleLogPriors ) &&
+           m_ParticleLogLikelihoods.size() == numberOfParticles &&
+           m_ParticleLogPriors.size() == numberOfParticles );
+}
+
+
+void
+SequentialMonteCarloSampler
+::ParameterSetExternally()
+{
+  m_ParticleParameters.clear();
+  m_InverseTemperatures.clear();
+  Sampler::ParameterSetExternally();
+}
+
+
+void
+SequentialMonteCarloSampler
+::InitializeParticlesFromPriors()
+{
+  const std::vector< Parameter > & params = m_Model->GetParameters();
+  m_ParticleParameters.assign( m_NumberOfParticles, m_CurrentParameters );
+  for ( unsigned int p = 0; p < m_NumberOfParticles; ++p ) {
+    for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+      if ( m_ActiveParameterIndices[i] ) {
+        m_ParticleParameters[p][i] =
+          params[i].GetPriorDistribution()->GetSample( m_Random );
+      }
+    }
+  }
+
+  m_Model->GetScalarOutputsAndLogLikelihoods(
+    m_ParticleParameters, m_ParticleOutputs, m_ParticleLogLikelihoods );
+  m_ParticleLogPriors.resize( m_NumberOfParticles );
+  for ( unsigned int p = 0; p < m_NumberOfParticles; ++p ) {
+    m_ParticleLogPriors[p] =
+      m_Model->GetLogPriorLikelihood( m_ParticleParameters[p] );
+  }
+
+  m_InverseTemperature = 0.0;
+  m_InverseTemperatures.assign( 1, 0.0 );
+  m_LogEvidence = 0.0;
+  m_ProposalScale = 2.38 / std::sqrt(
+    static_cast< double >( std::max( this->GetNumberOfActiveParameters(), 1u ) ) );
+  m_AcceptanceRate = 0.0;
+  m_NextParticle = 0;
+}
+
+
+double
+SequentialMonteCarloSampler
+::GetDataLogLikelihood( unsigned int particle ) const
+{
+  double logLikelihood = m_ParticleLogLikelihoods[particle];
+  double logPrior = m_ParticleLogPriors[particle];
+  if ( !( logLikelihood > NEGATIVE_INFINITY ) ||
+       !( logPrior > NEGATIVE_INFINITY ) ) {
+    return NEGATIVE_INFINITY;
+  }
+  return logLikelihood - logPrior;
+}
+
+
+double
+SequentialMonteCarloSampler
+::FindNextStage( std::vector< double > & logWeights ) const
+{
+  unsigned int numberOfParticles =
+    static_cast< unsigned int >( m_ParticleParameters.size() );
+  std::vector< double > dataLogLikelihoods( numberOfParticles );
+  for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+    dataLogLikelihoods[p] = this->GetDataLogLikelihood( p );
+  }
+
+  logWeights.resize( numberOfParticles );
+  double target = m_TargetEffectiveSampleFraction * numberOfParticles;
+  double remaining = 1.0 - m_InverseTemperature;
+  double lower = 0.0;
+  double upper = remaining;
+  double increase = remaining;
+  // The effective sample size falls as the step grows, so bisect for
+  // the step where it reaches the target.
+  for ( unsigned int iteration = 0; iteration < 60; ++iteration ) {
+    for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+      logWeights[p] = ( dataLogLikelihoods[p] > NEGATIVE_INFINITY ) ?
+        increase * dataLogLikelihoods[p] : NEGATIVE_INFINITY;
+    }
+    bool enough = ( EffectiveSampleSize( logWeights ) >= target );
+    if ( iteration == 0 && enough ) {
+      return increase;
+    }
+    if ( enough ) {
+      lower = increase;
+    } else {
+      upper = increase;
+    }
+    increase = 0.5 * ( lower + upper );
+  }
+
+  increase = ( lower > 0.0 ) ? lower : upper;
+  for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+    logWeights[p] = ( dataLogLikelihoods[p] > NEGATIVE_INFINITY ) ?
+      increase * dataLogLikelihoods[p] : NEGATIVE_INFINITY;
+  }
+  return increase;
+}
+
+
+double
+SequentialMonteCarloSampler
+::Resample( const std::vector< double > & logWeights )
+{
+  unsigned int numberOfParticles =
+    static_cast< unsigned int >( logWeights.size() );
+  double maximum = *std::max_element( logWeights.begin(), logWeights.end() );
+  if ( !( maximum > NEGATIVE_INFINITY ) ) {
+    return NEGATIVE_INFINITY;
+  }
+
+  std::vector< double > cumulativeWeights( numberOfParticles );
+  double sum = 0.0;
+  for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+    sum += std::exp( logWeights[p] - maximum );
+    cumulativeWeights[p] = sum;
+  }
+
+  // Systematic resampling: one uniform offset for evenly spaced
+  // positions along the cumulative weights.
+  std::vector< unsigned int > ancestors( numberOfParticles );
+  double spacing = sum / numberOfParticles;
+  double position = spacing * m_Random.Uniform( 0.0, 1.0 );
+  unsigned int ancestor = 0;
+  for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+    while ( ancestor + 1 < numberOfParticles &&
+            cumulativeWeights[ancestor] <= position ) {
+      ++ancestor;
+    }
+    ancestors[p] = ancestor;
+    position += spacing;
+  }
+
+  std::vector< std::vector< double > > parameters( numberOfParticles );
+  std::vector< std::vector< double > > outputs( numberOfParticles );
+  std::vector< double > logLikelihoods( numberOfParticles );
+  std::vector< double > logPriors( numberOfParticles );
+  for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+    parameters[p] = m_ParticleParameters[ ancestors[p] ];
+    outputs[p] = m_ParticleOutputs[ ancestors[p] ];
+    logLikelihoods[p] = m_ParticleLogLikelihoods[ ancestors[p] ];
+    logPriors[p] = m_ParticleLogPriors[ ancestors[p] ];
+  }
+  m_ParticleParameters.swap( parameters );
+  m_ParticleOutputs.swap( outputs );
+  m_ParticleLogLikelihoods.swap( logLikelihoods );
+  m_ParticleLogPriors.swap( logPriors );
+
+  return maximum + std::log( sum / numberOfParticles );
+}
+
+
+void
+SequentialMonteCarloSampler
+::MoveParticles()
+{
+  unsigned int numberOfParticles =
+    static_cast< unsigned int >( m_ParticleParameters.size() );
+  std::vector< unsigned int > active;
+  for ( unsigned int i = 0; i < m_Model->GetNumberOfParameters(); ++i ) {
+    if ( m_ActiveParameterIndices[i] ) {
+      active.push_back( i );
+    }
+  }
+  unsigned int dimension = static_cast< unsigned int >( active.size() );
+  if ( dimension == 0 || m_NumberOfMoveSteps == 0 ) {
+    return;
+  }
+
+  // Gaussian proposal with the covariance of the particles.
+  Eigen::VectorXd mean = Eigen::VectorXd::Zero( dimension );
+  for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+    for ( unsigned int j = 0; j < dimension; ++j ) {
+      mean( j ) += m_ParticleParameters[p][ active[j] ];
+    }
+  }
+  mean /= numberOfParticles;
+  Eigen::MatrixXd covariance = Eigen::MatrixXd::Zero( dimension, dimension );
+  Eigen::VectorXd difference( dimension );
+  for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+    for ( unsigned int j = 0; j < dimension; ++j ) {
+      difference( j ) = m_ParticleParameters[p][ active[j] ] - mean( j );
+    }
+    covariance.noalias() += difference * difference.transpose();
+  }
+  covariance /= numberOfParticles;
+  // Keep the covariance positive definite when particles coincide.
+  double jitter = 1.0e-10 * covariance.diagonal().mean() +
+    std::numeric_limits< double >::min();
+  covariance.diagonal().array() += jitter;
+  Eigen::MatrixXd cholesky = covariance.llt().matrixL();
+
+  unsigned int numberOfAccepted = 0;
+  Eigen::VectorXd step( dimension );
+  for ( unsigned int s = 0; s < m_NumberOfMoveSteps; ++s ) {
+    std::vector< std::vector< double > > proposals( m_ParticleParameters );
+    for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+      for ( unsigned int j = 0; j < dimension; ++j ) {
+        step( j ) = m_Random.Gaussian();
+      }
+      step = cholesky.triangularView< Eigen::Lower >() * step;
+      step *= m_ProposalScale;
+      for ( unsigned int j = 0; j < dimension; ++j ) {
+        proposals[p][ active[j] ] += step( j );
+      }
+    }
+
+    std::vector< std::vector< double > > outputs;
+    std::vector< double > logLikelihoods;
+    m_Model->GetScalarOutputsAndLogLikelihoods(
+      proposals, outputs, logLikelihoods );
+
+    for ( unsigned int p = 0; p < numberOfParticles; ++p ) {
+      double logPrior = m_Model->GetLogPriorLikelihood( proposals[p] );
+      double proposed = TemperedLogLikelihood(
+        m_InverseTemperature, logLikelihoods[p], logPrior );
+      double current = TemperedLogLikelihood(
+        m_InverseTemperature, m_ParticleLogLikelihoods[p], m_ParticleLogPriors[p] );
+      if ( !( proposed > NEGATIVE_INFINITY ) ) {
+        continue;
+      }
+      if ( proposed >= current ||
+           std::exp( proposed - current ) > m_Random.Uniform() ) {
+        m_ParticleParameters[p] = proposals[p];
+        m_ParticleOutputs[p] = outputs[p];
+        m_ParticleLogLikelihoods[p] = logLikelihoods[p];
+        m_ParticleLogPriors[p] = logPrior;
+        ++numberOfAccepted;
+      }
+    }
+  }
+
+  m_AcceptanceRate = static_cast< double >( numberOfAccepted ) /
+    static_cast< double >( m_NumberOfMoveSteps * numberOfParticles );
+  // Nudge the scale toward the usual Metropolis acceptance rate for
+  // the next move.
+  m_ProposalScale *= std::exp( m_AcceptanceRate - 0.234 );
+}
+
+
+void
+SequentialMonteCarloSampler
+::Run()
+{
+  if ( this->IsFinished() ) {
+    return;
+  }
+  if ( m_ParticleParameters.empty() ) {
+    this->InitializeParticlesFromPriors();
+  }
+
+  std::vector< double > logWeights;
+  while ( m_InverseTemperature < 1.0 ) {
+    double increase = this->FindNextStage( logWeights );
+    if ( increase >= 1.0 - m_InverseTemperature ) {
+      m_InverseTemperature = 1.0;
+    } else {
+      m_InverseTemperature += increase;
+    }
+    m_InverseTemperatures.push_back( m_InverseTemperature );
+    m_LogEvidence += this->Resample( logWeights );
+    this->MoveParticles();
+  }
+  m_NextParticle = 0;
+}
+
+
+void
+SequentialMonteCarloSampler
+::SetCurrentParticle( unsigned int particle )
+{
+  m_CurrentParameters = m_ParticleParameters[ particle ];
+  m_CurrentOutputs = m_ParticleOutputs[ particle ];
+  m_CurrentLogLikelihood = m_ParticleLogLikelihoods[ particle ];
+}
+
+
+Sample
+SequentialMonteCarloSampler
+::NextSample()
+{
+  if ( !this->IsFinished() ) {
+    this->Run();
+  }
+  if ( m_NextParticle >= m_ParticleParameters.size() ) {
+    // All particles have been returned; move them for fresh samples.
+    this->MoveParticles();
+    m_NextParticle = 0;
+  }
+  this->SetCurrentParticle( m_NextParticle++ );
+
+  return Sample( m_CurrentParameters,
+                 m_CurrentOutputs,
+                 m_CurrentLogLikelihood );
+}
+
+} // end namespace madai
@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_SequentialMonteCarloSampler_h_included
+#define madai_SequentialMonteCarloSampler_h_included
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/**
+ * \class SequentialMonteCarloSampler
+ *
+ * Sequential Monte Carlo sampler with likelihood tempering.
+ *
+ * A population of particles is drawn from the priors and carried to
+ * the posterior through a sequence of distributions proportional to
+ * the prior times the likelihood raised to \f$ \beta \f$, with
+ * \f$ \beta \f$ rising from 0 to 1. Each stage chooses the next
+ * \f$ \beta \f$ so that the effective sample size of the reweighted
+ * particles is TargetEffectiveSampleFraction times the number of
+ * particles, resamples the particles, and moves each of them with
+ * NumberOfMoveSteps Metropolis steps. The Metropolis proposal is a
+ * Gaussian with the covariance of the particles, scaled by a factor
+ * that is tuned between stages.
+ *
+ * All particles of a step are evaluated as one batch with
+ * Model::GetScalarOutputsAndLogLikelihoods(), which uses parallel
+ * threads when the Model allows it. The product of the mean weights
+ * of the stages estimates the model evidence, the integral of the
+ * likelihood over the prior.
+ *
+ * The stages run on the first call to NextSample(), or on Run().
+ * NextSample() then returns the particles in turn. Once all of them
+ * have been returned, the particles are moved again at
+ * \f$ \beta = 1 \f$ to give the next round of samples.
+ *
+ * Changing a parameter value from outside discards the particles, so
+ * that the next call to NextSample() starts again from the priors
+ * with the new values of the inactive parameters.
+ */
+class SequentialMonteCarloSampler : public Sampler {
+public:
+  SequentialMonteCarloSampler();
+  virtual ~SequentialMonteCarloSampler();
+
+  /** Get the next Sample from the distribution. */
+  virtual Sample NextSample();
+
+  /** Writes the number of stages and the log evidence. */
+  virtual void WriteProgress( std::ostream & progress ) const;
+
+  //@{
+  /** Set/Get the number of particles. Defaults to 1000. Setting it
+   * discards the particles. */
+  void SetNumberOfParticles( unsigned int numberOfParticles );
+  unsigned int GetNumberOfParticles() const;
+  //@}
+
+  //@{
+  /** Set/Get the number of Metropolis steps that move each particle
+   * after resampling. Defaults to 5. */
+  void SetNumberOfMoveSteps( unsigned int numberOfSteps );
+  unsigned int GetNumberOfMoveSteps() const;
+  //@}
+
+  //@{
+  /** Set/Get the fraction of the particles that should remain
+   * effective after reweighting to the next stage. Smaller values
+   * take fewer, larger stages. Defaults to 0.5. */
+  void SetTargetEffectiveSampleFraction( double fraction );
+  double GetTargetEffectiveSampleFraction() const;
+  //@}
+
+  /** Carry the particles from the priors to the posterior, unless
+   * that has been done already. */
+  void Run();
+
+  /** Returns true once the particles have reached the posterior. */
+  bool IsFinished() const;
+
+  /** Get the logarithm of the model evidence estimated by Run(). The
+   * log likelihood used here excludes the prior, so the evidence is
+   * the mean likelihood over the prior. */
+  double GetLogEvidence() const;
+
+  /** Get the inverse temperatures of the stages so far, starting at
+   * zero. */
+  const std::vector< double > & GetInverseTemperatures() const;
+
+  /** Get the fraction of accepted Metropolis steps in the last move
+   * of the particles. */
+  double GetAcceptanceRate() const;
+
+  //@{
+  /** The state includes every particle and the stages so far, so a
+   * run restored after the particles have reached the posterior does
+   * not repeat them. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Discards the particles. */
+  virtual void ParameterSetExternally();
+
+  /** Draw the particles from the priors. */
+  void InitializeParticlesFromPriors();
+
+  /** Find the next inverse temperature and the log weights of the
+   * particles there. Returns the increase of the inverse
+   * temperature. */
+  double FindNextStage( std::vector< double > & logWeights ) const;
+
+  /** Resample the particles with the given log weights. Returns the
+   * log of the mean weight. */
+  double Resample( const std::vector< double > & logWeights );
+
+  /** Move the particles with NumberOfMoveSteps Metropolis steps. */
+  void MoveParticles();
+
+  /** Untempered log likelihood of a particle without its prior. */
+  double GetDataLogLikelihood( unsigned int particle ) const;
+
+  /** Make the given particle the current state. */
+  void SetCurrentParticle( unsigned int particle );
+
+  unsigned int m_NumberOfParticles;
+
+  unsigned int m_NumberOfMoveSteps;
+
+  double m_TargetEffectiveSampleFraction;
+
+  /** Current inverse temperature. */
+  double m_InverseTemperature;
+
+  /** Inverse temperatures of all stages so far. */
+  std::vector< double > m_InverseTemperatures;
+
+  /** Logarithm of the model evidence. */
+  double m_LogEvidence;
+
+  /** Scale of the proposal relative to the covariance of the
+   * particles. */
+  double m_ProposalScale;
+
+  /** Fraction of accepted steps in the last move. */
+  double m_AcceptanceRate;
+
+  //@{
+  /** State of each particle. The log likelihoods are the untempered
+   * ones of the Model, which include the log prior. */
+  std::vector< std::vector< double > > m_ParticleParameters;
+  std::vector< std::vector< double > > m_ParticleOutputs;
+  std::vector< double >                m_ParticleLogLikelihoods;
+  std::vector< double >                m_ParticleLogPriors;
+  //@}
+
+  /** Index of the particle that the next NextSample() returns. */
+  unsigned int m_NextParticle;
+
+}; // end class SequentialMonteCarloSampler
+
+} // end namespace madai
+
+#endif // madai_SequentialMonteCarloSampler_h_included
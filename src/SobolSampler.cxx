@@ -0,0 +1,431 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "SobolSampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+
+namespace {
+
+typedef boost::uint32_t Bits;
+
+const unsigned int NUMBER_OF_BITS = 32;
+
+/** Primitive polynomials and initial direction numbers of dimensions
+ * 2 to 40, from the new-joe-kuo-6.21201 table of S. Joe and F. Y. Kuo:
+ * degree s, coefficients a, and m_1 ... m_s. */
+const unsigned int NUMBER_OF_TABLE_DIMENSIONS = 39;
+const unsigned int MAXIMUM_DEGREE = 8;
+const unsigned int DEGREES[ NUMBER_OF_TABLE_DIMENSIONS ] = {
+  1, 2, 3, 3, 4, 4, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 8, 8 };
+const unsigned int COEFFICIENTS[ NUMBER_OF_TABLE_DIMENSIONS ] = {
+  0, 1, 1, 2, 1, 4, 2, 4, 7, 11, 13, 14, 1, 13, 16, 19, 22, 25, 1, 4,
+  7, 8, 14, 19, 21, 28, 31, 32, 37, 41, 42, 50, 55, 56, 59, 62, 14, 21, 22 };
+const unsigned int INITIAL_NUMBERS[ NUMBER_OF_TABLE_DIMENSIONS ][ MAXIMUM_DEGREE ] = {
+  { 1 },
+  { 1, 3 },
+  { 1, 3, 1 },
+  { 1, 1, 1 },
+  { 1, 1, 3, 3 },
+  { 1, 3, 5, 13 },
+  { 1, 1, 5, 5, 17 },
+  { 1, 1, 5, 5, 5 },
+  { 1, 1, 7, 11, 19 },
+  { 1, 1, 5, 1, 1 },
+  { 1, 1, 1, 3, 11 },
+  { 1, 3, 5, 5, 31 },
+  { 1, 3, 3, 9, 7, 49 },
+  { 1, 1, 1, 15, 21, 21 },
+  { 1, 3, 1, 13, 27, 49 },
+  { 1, 1, 1, 15, 7, 5 },
+  { 1, 3, 1, 15, 13, 25 },
+  { 1, 1, 5, 5, 19, 61 },
+  { 1, 3, 7, 11, 23, 15, 103 },
+  { 1, 3, 7, 13, 13, 15, 69 },
+  { 1, 1, 3, 13, 7, 35, 63 },
+  { 1, 3, 5, 9, 1, 25, 53 },
+  { 1, 3, 1, 13, 9, 35, 107 },
+  { 1, 3, 1, 5, 27, 61, 31 },
+  { 1, 1, 5, 11, 19, 41, 61 },
+  { 1, 3, 5, 3, 3, 13, 69 },
+  { 1, 1, 7, 13, 1, 19, 1 },
+  { 1, 3, 7, 5, 13, 19, 59 },
+  { 1, 1, 3, 9, 25, 29, 41 },
+  { 1, 3, 5, 13, 23, 1, 55 },
+  { 1, 3, 7, 3, 13, 59, 17 },
+  { 1, 3, 1, 3, 5, 53, 69 },
+  { 1, 1, 5, 5, 23, 33, 13 },
+  { 1, 1, 7, 7, 1, 61, 123 },
+  { 1, 1, 7, 9, 13, 61, 49 },
+  { 1, 3, 3, 5, 3, 55, 33 },
+  { 1, 3, 1, 15, 31, 13, 49, 245 },
+  { 1, 3, 5, 15, 31, 59, 63, 97 },
+  { 1, 3, 1, 11, 11, 11, 77, 249 } };
+
+
+/** Parity of the number of bits set. */
+inline Bits Parity( Bits x )
+{
+  x ^= x >> 16;
+  x ^= x >> 8;
+  x ^= x >> 4;
+  x ^= x >> 2;
+  x ^= x >> 1;
+  return x & 1u;
+}
+
+
+/** Random 32-bit word. */
+inline Bits RandomBits( madai::Random & random )
+{
+  Bits high = static_cast< Bits >( random.Integer( 1L << 16 ) );
+  Bits low = static_cast< Bits >( random.Integer( 1L << 16 ) );
+  return ( high << 16 ) | low;
+}
+
+} // end anonymous namespace
+
+
+namespace madai {
+
+
+SobolSampler
+::SobolSampler() :
+  Sampler(),
+  m_Scramble( true ),
+  m_Index( 0 ),
+  m_EndIndex( std::numeric_limits< unsigned long int >::max() ),
+  m_BlockSize( 64 ),
+  m_BlockPosition( 0 ),
+  m_LogImportanceWeight( 0.0 )
+{
+}
+
+
+SobolSampler
+::~SobolSampler()
+{
+}
+
+
+void
+SobolSampler
+::Initialize( const Model * model )
+{
+  assert( model != NULL );
+  m_Model = model;
+
+  Sampler::Initialize( model );
+  m_Index = 0;
+  this->ComputeDirectionNumbers();
+}
+
+
+void
+SobolSampler
+::ParameterSetExternally()
+{
+  m_Block.clear();
+  m_BlockPosition = 0;
+}
+
+
+void
+SobolSampler
+::SetIndex( unsigned long int index )
+{
+  m_Index = index;
+  m_Block.clear();
+  m_BlockPosition = 0;
+}
+
+
+unsigned long int
+SobolSampler
+::GetIndex() const
+{
+  return m_Index;
+}
+
+
+void
+SobolSampler
+::SetEndIndex( unsigned long int endIndex )
+{
+  m_EndIndex = endIndex;
+}
+
+
+unsigned long int
+SobolSampler
+::GetEndIndex() const
+{
+  return m_EndIndex;
+}
+
+
+void
+SobolSampler
+::SetScramble( bool scramble )
+{
+  if ( scramble != m_Scramble ) {
+    m_Scramble = scramble;
+    if ( m_Model != NULL ) {
+      this->ComputeDirectionNumbers();
+    }
+  }
+}
+
+
+bool
+SobolSampler
+::GetScramble() const
+{
+  return m_Scramble;
+}
+
+
+void
+SobolSampler
+::SetBlockSize( unsigned int blockSize )
+{
+  m_BlockSize = std::max( blockSize, 1u );
+}
+
+
+unsigned int
+SobolSampler
+::GetBlockSize() const
+{
+  return m_BlockSize;
+}
+
+
+double
+SobolSampler
+::GetLogImportanceWeight() const
+{
+  return m_LogImportanceWeight;
+}
+
+
+unsigned int
+SobolSampler
+::GetMaximumNumberOfDimensions()
+{
+  return NUMBER_OF_TABLE_DIMENSIONS + 1;
+}
+
+
+void
+SobolSampler
+::WriteState( std::ostream & o ) const
+{
+  Sampler::WriteState( o );
+  WriteTag( o, "SobolSampler" );
+  o << m_Scramble << ' ' << m_Index << ' ' << m_DirectionNumbers.size() << '\n';
+  for ( unsigned int d = 0; d < m_DirectionNumbers.size(); ++d ) {
+    WriteIntegers( o, m_DirectionNumbers[d] );
+  }
+  WriteIntegers( o, m_Shifts );
+}
+
+
+bool
+SobolSampler
+::ReadState( std::istream & i )
+{
+  unsigned int numberOfDimensions;
+  if ( !Sampler::ReadState( i ) ||
+       !ReadTag( i, "SobolSampler" ) ||
+       !( i >> m_Scramble >> m_Index >> numberOfDimensions ) ) {
+    return false;
+  }
+  m_DirectionNumbers.resize( numberOfDimensions );
+  for ( unsigned int d = 0; d < numberOfDimensions; ++d ) {
+    if ( !ReadIntegers( i, m_DirectionNumbers[d] ) ) {
+      return false;
+    }
+  }
+  m_Block.clear();
+  m_BlockPosition = 0;
+  return ( ReadIntegers( i, m_Shifts ) &&
+           m_Shifts.size() == numberOfDimensions );
+}
+
+
+void
+SobolSampler
+::ComputeDirectionNumbers()
+{
+  unsigned int numberOfDimensions =
+    std::min( m_Model->GetNumberOfParameters(),
+              SobolSampler::GetMaximumNumberOfDimensions() );
+  m_DirectionNumbers.assign( numberOfDimensions,
+                             std::vector< Bits >( NUMBER_OF_BITS, 0 ) );
+  m_Shifts.assign( numberOfDimensions, 0 );
+
+  for ( unsigned int d = 0; d < numberOfDimensions; ++d ) {
+    std::vector< Bits > & v = m_DirectionNumbers[d];
+    if ( d == 0 ) {
+      for ( unsigned int j = 0; j < NUMBER_OF_BITS; ++j ) {
+        v[j] = Bits( 1 ) << ( NUMBER_OF_BITS - 1 - j );
+      }
+    } else {
+      unsigned int s = DEGREES[ d - 1 ];
+      unsigned int a = COEFFICIENTS[ d - 1 ];
+      for ( unsigned int j = 0; j < s; ++j ) {
+        v[j] = Bits( INITIAL_NUMBERS[ d - 1 ][j] ) << ( NUMBER_OF_BITS - 1 - j );
+      }
+      for ( unsigned int j = s; j < NUMBER_OF_BITS; ++j ) {
+        v[j] = v[ j - s ] ^ ( v[ j - s ] >> s );
+        for ( unsigned int k = 1; k < s; ++k ) {
+          if ( ( a >> ( s - 1 - k ) ) & 1u ) {
+            v[j] ^= v[ j - k ];
+          }
+        }
+      }
+    }
+
+    if ( m_Scramble ) {
+      // Random lower triangular matrix with unit diagonal, acting on
+      // the digits from the most significant one down, followed by a
+      // random digital shift.
+      std::vector< Bits > rows( NUMBER_OF_BITS );
+      for ( unsigned int r = 0; r < NUMBER_OF_BITS; ++r ) {
+        Bits diagonal = Bits( 1 ) << ( NUMBER_OF_BITS - 1 - r );
+        Bits above = ~( ( diagonal << 1 ) - 1 );
+        rows[r] = ( RandomBits( m_Random ) & above ) | diagonal;
+      }
+      for ( unsigned int j = 0; j < NUMBER_OF_BITS; ++j ) {
+        Bits scrambled = 0;
+        for ( unsigned int r = 0; r < NUMBER_OF_BITS; ++r ) {
+          scrambled |= Parity( rows[r] & v[j] ) << ( NUMBER_OF_BITS - 1 - r );
+        }
+        v[j] = scrambled;
+      }
+      m_Shifts[d] = RandomBits( m_Random );
+    }
+  }
+  m_Block.clear();
+  m_BlockPosition = 0;
+}
+
+
+void
+SobolSampler
+::GetUnitPoint( unsigned long int index,
+                unsigned int numberOfDimensions,
+                std::vector< double > & point ) const
+{
+  assert( numberOfDimensions <= m_DirectionNumbers.size() );
+  point.resize( numberOfDimensions );
+
+  // Gray code order, as in the usual recursive construction.
+  unsigned long int gray = index ^ ( index >> 1 );
+  for ( unsigned int d = 0; d < numberOfDimensions; ++d ) {
+    Bits x = m_Shifts[d];
+    unsigned long int g = gray;
+    for ( unsigned int j = 0; g != 0 && j < NUMBER_OF_BITS; ++j, g >>= 1 ) {
+      if ( g & 1ul ) {
+        x ^= m_DirectionNumbers[d][j];
+      }
+    }
+    // The middle of the cell, which is never 0 or 1.
+    point[d] = ( static_cast< double >( x ) + 0.5 ) / 4294967296.0;
+  }
+}
+
+
+void
+SobolSampler
+::EvaluateBlock()
+{
+  const std::vector< Parameter > & parameters = m_Model->GetParameters();
+  unsigned int numberOfActive = this->GetNumberOfActiveParameters();
+  assert( numberOfActive <= m_DirectionNumbers.size() );
+
+  // Evaluate only points that will be returned before the end of the
+  // range, so that an evaluation is neither repeated by the next shard
+  // nor lost when the scan stops.
+  unsigned int blockSize =
+    m_Model->SupportsConcurrentEvaluation() ? m_BlockSize : 1;
+  if ( m_Index < m_EndIndex ) {
+    blockSize = static_cast< unsigned int >(
+      std::min( static_cast< unsigned long int >( blockSize ),
+                m_EndIndex - m_Index ) );
+  } else {
+    blockSize = 1;
+  }
+
+  std::vector< std::vector< double > > points( blockSize, m_CurrentParameters );
+  std::vector< double > unitPoint;
+  for ( unsigned int n = 0; n < blockSize; ++n ) {
+    this->GetUnitPoint( m_Index + n, numberOfActive, unitPoint );
+    unsigned int k = 0;
+    for ( unsigned int i = 0; i < parameters.size(); ++i ) {
+      if ( m_ActiveParameterIndices[i] ) {
+        points[n][i] =
+          parameters[i].GetPriorDistribution()->GetPercentile( unitPoint[k++] );
+      }
+    }
+  }
+
+  std::vector< std::vector< double > > outputs;
+  std::vector< double > logLikelihoods;
+  m_Model->GetScalarOutputsAndLogLikelihoods( points, outputs, logLikelihoods );
+
+  m_Block.resize( blockSize );
+  m_BlockLogWeights.resize( blockSize );
+  for ( unsigned int n = 0; n < blockSize; ++n ) {
+    m_Block[n] = Sample( points[n], outputs[n], logLikelihoods[n] );
+    m_BlockLogWeights[n] =
+      logLikelihoods[n] - m_Model->GetLogPriorLikelihood( points[n] );
+  }
+  m_BlockActiveParameters = m_ActiveParameterIndices;
+  m_BlockPosition = 0;
+}
+
+
+Sample
+SobolSampler
+::NextSample()
+{
+  assert( this->GetNumberOfActiveParameters() > 0 );
+
+  if ( m_BlockPosition >= m_Block.size() ||
+       m_BlockActiveParameters != m_ActiveParameterIndices ) {
+    this->EvaluateBlock();
+  }
+
+  const Sample & sample = m_Block[ m_BlockPosition ];
+  m_CurrentParameters = sample.m_ParameterValues;
+  m_CurrentOutputs = sample.m_OutputValues;
+  m_CurrentLogLikelihood = sample.m_LogLikelihood;
+  m_LogImportanceWeight = m_BlockLogWeights[ m_BlockPosition ];
+  ++m_BlockPosition;
+  ++m_Index;
+
+  return sample;
+}
+
+} // end namespace madai
@@ -0,0 +1,154 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_SobolSampler_h_included
+#define madai_SobolSampler_h_included
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "Sampler.h"
+
+
+namespace madai {
+
+/**
+ * \class SobolSampler
+ *
+ * This Sampler generates the points of a Sobol low-discrepancy
+ * sequence in the joint percentile space of the active parameters of
+ * the Model on which it operates, and maps them through the
+ * percentiles of the priors. Like PercentileGridSampler it scans the
+ * prior rather than the posterior, but any number of Samples covers
+ * the space evenly, in any number of dimensions up to
+ * GetMaximumNumberOfDimensions().
+ *
+ * By default the sequence is scrambled with a random linear matrix
+ * scramble and a random digital shift drawn from the random number
+ * generator of the Sampler, which keeps its low discrepancy while
+ * making the estimates from different seeds independent.
+ *
+ * The Samples follow the prior, so each has an importance weight
+ * proportional to its likelihood, exp(GetLogImportanceWeight()), for
+ * estimates of the posterior. The Model is evaluated for a block of
+ * points at a time, in parallel when the Model supports concurrent
+ * evaluation.
+ */
+class SobolSampler : public Sampler {
+public:
+  SobolSampler();
+  virtual ~SobolSampler();
+
+  /** Get the next Sample of the sequence. */
+  virtual Sample NextSample();
+
+  //@{
+  /** Set/Get the index in the sequence of the next Sample. Starts at
+   * 0. Points at disjoint ranges of indices are distinct, so a scan
+   * can be split between Samplers with the same seed. */
+  void SetIndex( unsigned long int index );
+  unsigned long int GetIndex() const;
+  //@}
+
+  //@{
+  /** Set/Get the index at which the range of the scan ends. No point
+   * at or past it is evaluated ahead of time, so that a block never
+   * spills into the range of another shard. Points past it are still
+   * returned, one evaluation at a time. Defaults to no end. */
+  void SetEndIndex( unsigned long int endIndex );
+  unsigned long int GetEndIndex() const;
+  //@}
+
+  //@{
+  /** Set/Get whether the sequence is scrambled. Defaults to true. */
+  void SetScramble( bool scramble );
+  bool GetScramble() const;
+  //@}
+
+  //@{
+  /** Set/Get the number of points evaluated together. Defaults to
+   * 64. A Model that does not SupportsConcurrentEvaluation() is
+   * evaluated one point at a time, since a block would not be
+   * faster. */
+  void SetBlockSize( unsigned int blockSize );
+  unsigned int GetBlockSize() const;
+  //@}
+
+  /** Log of the importance weight of the last Sample with respect to
+   * the posterior: its log likelihood minus its log prior, up to a
+   * constant. */
+  double GetLogImportanceWeight() const;
+
+  /** Maximum number of active parameters. */
+  static unsigned int GetMaximumNumberOfDimensions();
+
+  /** Compute the point at an index of the sequence, in the unit cube
+   * of the given number of dimensions. */
+  void GetUnitPoint( unsigned long int index,
+                     unsigned int numberOfDimensions,
+                     std::vector< double > & point ) const;
+
+  //@{
+  /** The state includes the index and the scrambled direction
+   * numbers. */
+  virtual void WriteState( std::ostream & o ) const;
+  virtual bool ReadState( std::istream & i );
+  //@}
+
+protected:
+  virtual void Initialize( const Model * model );
+
+  /** Discards the Samples evaluated with the previous values of the
+   * inactive parameters. */
+  virtual void ParameterSetExternally();
+
+  /** Compute the direction numbers, scrambled if requested. */
+  void ComputeDirectionNumbers();
+
+  /** Evaluate the Model at the next block of points. */
+  void EvaluateBlock();
+
+  bool m_Scramble;
+
+  unsigned long int m_Index;
+
+  unsigned long int m_EndIndex;
+
+  unsigned int m_BlockSize;
+
+  /** Direction numbers of each dimension, one per bit. */
+  std::vector< std::vector< boost::uint32_t > > m_DirectionNumbers;
+
+  /** Digital shift of each dimension. */
+  std::vector< boost::uint32_t > m_Shifts;
+
+  /** Evaluated Samples starting at m_Index, their log importance
+   * weights, and the active parameters they were generated for. */
+  std::vector< Sample > m_Block;
+  std::vector< double > m_BlockLogWeights;
+  std::vector< bool > m_BlockActiveParameters;
+  unsigned int m_BlockPosition;
+
+  double m_LogImportanceWeight;
+
+}; // end class SobolSampler
+
+} // end namespace madai
+
+#endif // madai_SobolSampler_h_included
@@ -0,0 +1,98 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "AdaptiveMetropolisSampler.h"
+#include "CorrelatedGaussianModel.h"
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_ADAPTATION_SAMPLES = 20000;
+  static const unsigned int NUMBER_OF_SAMPLES = 20000;
+
+  // The posterior is a correlated Gaussian.
+  std::vector< double > means( 2, 0.0 );
+  std::vector< double > deviations( 2, 1.0 );
+  deviations[1] = 3.0;
+  madai::CorrelatedGaussianModel model( means, deviations, 0.95 );
+  model.SetPriorBounds( -50.0, 50.0 );
+
+  madai::AdaptiveMetropolisSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  sampler.SetStepSize( 0.01 );
+  sampler.SetNumberOfAdaptationSamples( NUMBER_OF_ADAPTATION_SAMPLES );
+  sampler.SetParameterValue( "X", 0.5 );
+  sampler.SetParameterValue( "Y", -1.0 );
+
+  Eigen::MatrixXd initial = sampler.GetProposalCovariance();
+  if ( initial( 0, 1 ) != 0.0 ) {
+    std::cerr << "Initial proposal should be uncorrelated\n";
+    return EXIT_FAILURE;
+  }
+
+  for ( unsigned int i = 0; i < NUMBER_OF_ADAPTATION_SAMPLES; ++i ) {
+    sampler.NextSample();
+  }
+  if ( sampler.IsAdapting() ) {
+    std::cerr << "Sampler should stop adapting after "
+              << NUMBER_OF_ADAPTATION_SAMPLES << " samples\n";
+    return EXIT_FAILURE;
+  }
+
+  // The proposal should have learned the correlation of the posterior.
+  Eigen::MatrixXd proposal = sampler.GetProposalCovariance();
+  double correlation =
+    proposal( 0, 1 ) / std::sqrt( proposal( 0, 0 ) * proposal( 1, 1 ) );
+  double ratio = proposal( 1, 1 ) / proposal( 0, 0 );
+  if ( std::fabs( correlation - 0.95 ) > 0.05 ||
+       std::fabs( ratio - 9.0 ) > 3.0 ) {
+    std::cerr << "Learned proposal covariance\n" << proposal
+              << "\ndoes not match the shape of the posterior\n";
+    return EXIT_FAILURE;
+  }
+
+  // Frozen afterwards, with the acceptance rate near the target.
+  unsigned int accepted = 0;
+  madai::Sample oldSample = sampler.NextSample();
+  for ( unsigned int i = 0; i < NUMBER_OF_SAMPLES; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( !( sample == oldSample ) ) {
+      ++accepted;
+    }
+    oldSample = sample;
+  }
+  if ( sampler.GetProposalCovariance() != proposal ) {
+    std::cerr << "Proposal changed after the adaptation\n";
+    return EXIT_FAILURE;
+  }
+  double acceptanceRate = static_cast< double >( accepted ) / NUMBER_OF_SAMPLES;
+  if ( std::fabs( acceptanceRate - sampler.GetTargetAcceptanceRate() ) > 0.08 ) {
+    std::cerr << "Acceptance rate " << acceptanceRate
+              << " is far from the target "
+              << sampler.GetTargetAcceptanceRate() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "AutomaticDifferentiationModel.h"
+#include "DualNumber.h"
+#include "GaussianDistribution.h"
+#include "UniformDistribution.h"
+
+
+/** \class Test model whose forward model is templated on the scalar
+ * type. */
+class TestModel : public madai::AutomaticDifferentiationModel< TestModel > {
+public:
+  TestModel() :
+    m_NumberOfEvaluations( 0 )
+  {
+    madai::GaussianDistribution x0Prior;
+    x0Prior.SetMean( 0.5 );
+    x0Prior.SetStandardDeviation( 2.0 );
+    this->AddParameter( "X0", x0Prior );
+
+    madai::UniformDistribution kPrior;
+    kPrior.SetMinimum( 0.1 );
+    kPrior.SetMaximum( 10.0 );
+    this->AddParameter( "K", kPrior );
+
+    madai::UniformDistribution temperaturePrior;
+    temperaturePrior.SetMinimum( 0.5 );
+    temperaturePrior.SetMaximum( 5.0 );
+    this->AddParameter( "TEMP", temperaturePrior );
+
+    this->AddScalarOutputName( "A" );
+    this->AddScalarOutputName( "B" );
+    this->AddScalarOutputName( "C" );
+
+    m_ObservedScalarValues.push_back( 2.0 );
+    m_ObservedScalarValues.push_back( 1.5 );
+    m_ObservedScalarValues.push_back( 0.1 );
+
+    double covariance[9] = { 0.5, 0.1, 0.0,
+                             0.1, 0.3, 0.05,
+                             0.0, 0.05, 0.2 };
+    m_ObservedScalarCovariance.assign( covariance, covariance + 9 );
+
+    m_StateFlag = READY;
+  }
+
+  template< class TScalar >
+  ErrorType EvaluateScalarOutputs( const std::vector< TScalar > & parameters,
+                                   std::vector< TScalar > & scalars ) const
+  {
+    using std::atan;
+    using std::exp;
+    using std::log;
+    using std::pow;
+    using std::sin;
+    using std::sqrt;
+
+    ++m_NumberOfEvaluations;
+
+    const TScalar & x0 = parameters[0];
+    const TScalar & k = parameters[1];
+    const TScalar & temperature = parameters[2];
+
+    scalars.clear();
+    scalars.push_back( k * x0 * x0 + sin( temperature ) );
+    scalars.push_back( exp( -x0 / temperature ) * sqrt( k ) + pow( k, 1.5 ) );
+    scalars.push_back( log( temperature ) * atan( x0 ) / ( 1.0 + x0 * x0 ) );
+    return NO_ERROR;
+  }
+
+  /** Number of evaluations of the forward model, of either type. */
+  mutable unsigned int m_NumberOfEvaluations;
+
+}; // end TestModel
+
+
+bool CompareGradients( const std::vector< double > & exact,
+                       const std::vector< double > & estimate )
+{
+  if ( exact.size() != estimate.size() ) {
+    std::cerr << "Gradient has " << exact.size() << " components, expected "
+              << estimate.size() << "\n";
+    return false;
+  }
+  for ( size_t i = 0; i < exact.size(); ++i ) {
+    double tolerance = 1e-5 * std::max( 1.0, std::fabs( estimate[i] ) );
+    if ( std::fabs( exact[i] - estimate[i] ) > tolerance ) {
+      std::cerr << "Gradient component " << i << " is " << exact[i]
+                << ", finite differences give " << estimate[i] << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+
+int main( int, char *[] )
+{
+  // Basic arithmetic
+  madai::DualNumber x( 3.0, 2, 0 );
+  madai::DualNumber y( 2.0, 2, 1 );
+  madai::DualNumber z = x * x / y - 4.0;
+  if ( std::fabs( z.GetValue() - 0.5 ) > 1e-12 ||
+       std::fabs( z.GetDerivative( 0 ) - 3.0 ) > 1e-12 ||
+       std::fabs( z.GetDerivative( 1 ) + 2.25 ) > 1e-12 ) {
+    std::cerr << "Incorrect dual number arithmetic: " << z << "\n";
+    return EXIT_FAILURE;
+  }
+
+  madai::DualNumber constant( 5.0 );
+  if ( !( constant * 2.0 ).IsConstant() ) {
+    std::cerr << "Product of constants should be constant\n";
+    return EXIT_FAILURE;
+  }
+
+  TestModel model;
+  model.SetGradientEstimateStepSize( 1e-6 );
+
+  std::vector< double > parameters;
+  parameters.push_back( 0.7 );
+  parameters.push_back( 2.3 );
+  parameters.push_back( 1.9 );
+
+  // Outputs must match the double instantiation.
+  std::vector< double > scalars;
+  model.GetScalarOutputs( parameters, scalars );
+
+  for ( int test = 0; test < 2; ++test ) {
+    std::vector< bool > activeParameters( 3, true );
+    if ( test == 1 ) {
+      activeParameters[1] = false;
+    }
+
+    std::vector< double > exactScalars;
+    std::vector< double > exactGradient;
+    madai::Model::ErrorType error = model.GetScalarAndGradientOutputs(
+      parameters, activeParameters, exactScalars, exactGradient );
+    if ( error != madai::Model::NO_ERROR ) {
+      std::cerr << "GetScalarAndGradientOutputs returned "
+                << madai::Model::GetErrorTypeAsString( error ) << "\n";
+      return EXIT_FAILURE;
+    }
+
+    if ( exactScalars != scalars ) {
+      std::cerr << "Scalar outputs differ between double and DualNumber "
+                << "evaluation\n";
+      return EXIT_FAILURE;
+    }
+
+    std::vector< double > estimateScalars;
+    std::vector< double > estimateGradient;
+    model.madai::Model::GetScalarAndGradientOutputs(
+      parameters, activeParameters, estimateScalars, estimateGradient );
+
+    if ( !CompareGradients( exactGradient, estimateGradient ) ) {
+      return EXIT_FAILURE;
+    }
+
+    // The log likelihood and gradient together take one evaluation.
+    double logLikelihood;
+    model.GetScalarOutputsAndLogLikelihood( parameters, scalars, logLikelihood );
+    std::vector< double > fusedScalars;
+    std::vector< double > fusedGradient;
+    double fusedLogLikelihood;
+    unsigned int numberOfEvaluations = model.m_NumberOfEvaluations;
+    error = model.GetScalarOutputsAndLogLikelihoodAndGradient(
+      parameters, activeParameters, fusedScalars, fusedLogLikelihood,
+      fusedGradient );
+    if ( error != madai::Model::NO_ERROR ||
+         model.m_NumberOfEvaluations != numberOfEvaluations + 1 ) {
+      std::cerr << "GetScalarOutputsAndLogLikelihoodAndGradient evaluated "
+                << "the model " << model.m_NumberOfEvaluations - numberOfEvaluations
+                << " times\n";
+      return EXIT_FAILURE;
+    }
+    if ( fusedScalars != scalars || fusedLogLikelihood != logLikelihood ||
+         fusedGradient != exactGradient ) {
+      std::cerr << "Fused log likelihood and gradient differ from the "
+                << "separate evaluations\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
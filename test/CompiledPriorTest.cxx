@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "CompiledPrior.h"
+#include "GaussianDistribution.h"
+#include "UniformDistribution.h"
+
+
+/** \class Distribution that is neither uniform nor Gaussian, to
+ * exercise the fallback path. */
+class LaplaceDistribution : public madai::Distribution {
+public:
+  virtual Distribution * Clone() const { return new LaplaceDistribution; }
+  virtual double GetLogProbabilityDensity( double x ) const
+  {
+    return std::log( 0.5 ) - std::fabs( x );
+  }
+  virtual double GetGradientLogProbabilityDensity( double x ) const
+  {
+    return ( x > 0.0 ) ? -1.0 : 1.0;
+  }
+  virtual double GetProbabilityDensity( double x ) const
+  {
+    return std::exp( this->GetLogProbabilityDensity( x ) );
+  }
+  virtual double GetPercentile( double percentile ) const
+  {
+    return ( percentile < 0.5 ) ? std::log( 2.0 * percentile ) :
+      -std::log( 2.0 * ( 1.0 - percentile ) );
+  }
+  virtual double GetSample( madai::Random & r ) const
+  {
+    return this->GetPercentile( r.Uniform() );
+  }
+  virtual double GetExpectedValue() const { return 0.0; }
+  virtual double GetStandardDeviation() const { return std::sqrt( 2.0 ); }
+};
+
+
+bool ComparePrior( const std::vector< madai::Parameter > & parameters,
+                   const std::vector< double > & x )
+{
+  madai::CompiledPrior prior;
+  prior.SetParameters( parameters );
+  if ( prior.GetNumberOfParameters() != parameters.size() ) {
+    std::cerr << "Wrong number of parameters in compiled prior\n";
+    return false;
+  }
+
+  double expected = 0.0;
+  std::vector< double > expectedGradient( parameters.size() );
+  for ( size_t i = 0; i < parameters.size(); ++i ) {
+    const madai::Distribution * d = parameters[i].GetPriorDistribution();
+    expected += d->GetLogProbabilityDensity( x[i] );
+    expectedGradient[i] = d->GetGradientLogProbabilityDensity( x[i] );
+  }
+
+  double logPrior = prior.GetLogPriorLikelihood( &x[0] );
+  if ( !( std::fabs( logPrior - expected ) <= 1e-12 * std::fabs( expected ) ) &&
+       !( logPrior == expected ) ) {
+    std::cerr << "Log prior is " << logPrior << ", expected " << expected << "\n";
+    return false;
+  }
+
+  std::vector< double > gradient( parameters.size(), -99.0 );
+  prior.GetGradientOfLogPriorLikelihood( &x[0], &gradient[0] );
+  for ( size_t i = 0; i < parameters.size(); ++i ) {
+    if ( std::fabs( gradient[i] - expectedGradient[i] ) > 1e-12 ) {
+      std::cerr << "Gradient component " << i << " is " << gradient[i]
+                << ", expected " << expectedGradient[i] << "\n";
+      return false;
+    }
+  }
+
+  // A batch of two copies of the point.
+  std::vector< double > points( x );
+  points.insert( points.end(), x.begin(), x.end() );
+  double logPriors[2];
+  prior.GetLogPriorLikelihoods( &points[0], 2, logPriors );
+  if ( logPriors[0] != logPrior || logPriors[1] != logPrior ) {
+    std::cerr << "Batch evaluation differs from single evaluation\n";
+    return false;
+  }
+
+  return true;
+}
+
+
+int main( int, char *[] )
+{
+  madai::GaussianDistribution gaussian;
+  gaussian.SetMean( 1.5 );
+  gaussian.SetStandardDeviation( 0.7 );
+  madai::GaussianDistribution otherGaussian;
+  otherGaussian.SetMean( -3.0 );
+  otherGaussian.SetStandardDeviation( 2.0 );
+
+  // Grouped: uniform parameters first, then Gaussian parameters.
+  std::vector< madai::Parameter > grouped;
+  grouped.push_back( madai::Parameter( "A", 0.0, 1.0 ) );
+  grouped.push_back( madai::Parameter( "B", -5.0, 5.0 ) );
+  grouped.push_back( madai::Parameter( "C", gaussian ) );
+  grouped.push_back( madai::Parameter( "D", otherGaussian ) );
+
+  std::vector< double > x;
+  x.push_back( 0.25 );
+  x.push_back( -1.0 );
+  x.push_back( 2.0 );
+  x.push_back( -2.5 );
+  if ( !ComparePrior( grouped, x ) ) {
+    std::cerr << "Failed for grouped parameters\n";
+    return EXIT_FAILURE;
+  }
+
+  // Interleaved, with a distribution of another type.
+  std::vector< madai::Parameter > interleaved;
+  interleaved.push_back( madai::Parameter( "A", gaussian ) );
+  interleaved.push_back( madai::Parameter( "B", 0.0, 1.0 ) );
+  interleaved.push_back( madai::Parameter( "C", LaplaceDistribution() ) );
+  interleaved.push_back( madai::Parameter( "D", otherGaussian ) );
+  interleaved.push_back( madai::Parameter( "E", -5.0, 5.0 ) );
+  x.push_back( 4.0 );
+  if ( !ComparePrior( interleaved, x ) ) {
+    std::cerr << "Failed for interleaved parameters\n";
+    return EXIT_FAILURE;
+  }
+
+  // Outside the range of a uniform prior.
+  x[1] = 1.5;
+  madai::CompiledPrior prior;
+  prior.SetParameters( interleaved );
+  if ( prior.GetLogPriorLikelihood( &x[0] ) !=
+       -std::numeric_limits< double >::infinity() ) {
+    std::cerr << "Log prior outside the support should be -infinity\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ConvergenceMonitor.h"
+#include "Random.h"
+
+
+static const unsigned int NUMBER_OF_CHAINS = 4;
+static const unsigned int NUMBER_OF_SAMPLES = 100000;
+
+
+/** Feed the monitor chains of a first-order autoregressive process
+ * with coefficient phi, whose effective sample size is
+ * n (1 - phi) / (1 + phi), in the first parameter, and independent
+ * draws offset by chainOffset times the chain index in the second. */
+void FeedChains( madai::ConvergenceMonitor & monitor,
+                 madai::Random & random,
+                 double phi,
+                 double chainOffset,
+                 unsigned int numberOfSamples )
+{
+  std::vector< double > state( NUMBER_OF_CHAINS, 0.0 );
+  std::vector< double > values( 2 );
+  double innovation = std::sqrt( 1.0 - phi * phi );
+  for ( unsigned int i = 0; i < numberOfSamples; ++i ) {
+    for ( unsigned int chain = 0; chain < NUMBER_OF_CHAINS; ++chain ) {
+      state[chain] = phi * state[chain] + innovation * random.Gaussian();
+      values[0] = state[chain];
+      values[1] = chainOffset * chain + random.Gaussian();
+      monitor.AddSample( chain, values );
+    }
+  }
+}
+
+
+int main( int, char *[] )
+{
+  madai::Random random( 12345 );
+
+  // Mixed chains: the effective sample size follows the
+  // autocorrelation, and R-hat and the Geweke z are unremarkable.
+  madai::ConvergenceMonitor monitor;
+  monitor.Initialize( NUMBER_OF_CHAINS, 2 );
+  double phi = 0.9;
+  FeedChains( monitor, random, phi, 0.0, NUMBER_OF_SAMPLES );
+  if ( monitor.GetNumberOfSamples() != NUMBER_OF_SAMPLES ) {
+    std::cerr << "Monitor has " << monitor.GetNumberOfSamples()
+              << " samples, expected " << NUMBER_OF_SAMPLES << "\n";
+    return EXIT_FAILURE;
+  }
+  double total = static_cast< double >( NUMBER_OF_CHAINS * NUMBER_OF_SAMPLES );
+  double expected[2] = { total * ( 1.0 - phi ) / ( 1.0 + phi ), total };
+  for ( unsigned int p = 0; p < 2; ++p ) {
+    double ess = monitor.GetEffectiveSampleSize( p );
+    if ( std::fabs( ess / expected[p] - 1.0 ) > 0.3 ) {
+      std::cerr << "Effective sample size of parameter " << p << " is "
+                << ess << ", expected about " << expected[p] << "\n";
+      return EXIT_FAILURE;
+    }
+    if ( monitor.GetPotentialScaleReduction( p ) > 1.01 ) {
+      std::cerr << "R-hat of parameter " << p << " is "
+                << monitor.GetPotentialScaleReduction( p ) << "\n";
+      return EXIT_FAILURE;
+    }
+    if ( std::fabs( monitor.GetGewekeZ( p ) ) > 4.0 ) {
+      std::cerr << "Geweke z of parameter " << p << " is "
+                << monitor.GetGewekeZ( p ) << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The stopping criteria.
+  if ( monitor.HasConverged() ) {
+    std::cerr << "Converged without stopping criteria\n";
+    return EXIT_FAILURE;
+  }
+  monitor.SetTargetEffectiveSampleSize( 1000.0 );
+  monitor.SetPotentialScaleReductionThreshold( 1.01 );
+  if ( !monitor.HasConverged() ) {
+    std::cerr << "Did not converge\n";
+    return EXIT_FAILURE;
+  }
+  monitor.SetTargetEffectiveSampleSize( 1.0e6 );
+  if ( monitor.HasConverged() ) {
+    std::cerr << "Converged short of the target effective sample size\n";
+    return EXIT_FAILURE;
+  }
+
+  // The state continues where it left off.
+  std::stringstream state;
+  monitor.WriteState( state );
+  madai::ConvergenceMonitor restored;
+  if ( !restored.ReadState( state ) ) {
+    std::cerr << "Could not read the state\n";
+    return EXIT_FAILURE;
+  }
+  madai::Random copy( 999 );
+  madai::Random again( 999 );
+  FeedChains( monitor, copy, phi, 0.0, 1000 );
+  FeedChains( restored, again, phi, 0.0, 1000 );
+  for ( unsigned int p = 0; p < 2; ++p ) {
+    if ( restored.GetEffectiveSampleSize( p ) !=
+         monitor.GetEffectiveSampleSize( p ) ||
+         restored.GetPotentialScaleReduction( p ) !=
+         monitor.GetPotentialScaleReduction( p ) ) {
+      std::cerr << "Restored diagnostics of parameter " << p << " differ\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Chains around different values have a large R-hat, even when each
+  // is stationary.
+  madai::ConvergenceMonitor separated;
+  separated.Initialize( NUMBER_OF_CHAINS, 2 );
+  separated.SetPotentialScaleReductionThreshold( 1.1 );
+  FeedChains( separated, random, 0.5, 1.0, 10000 );
+  if ( separated.GetPotentialScaleReduction( 1 ) < 1.2 ||
+       separated.HasConverged() ) {
+    std::cerr << "R-hat of separated chains is "
+              << separated.GetPotentialScaleReduction( 1 ) << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // A drifting chain fails the Geweke test.
+  madai::ConvergenceMonitor drifting;
+  drifting.Initialize( 1, 1 );
+  std::vector< double > value( 1 );
+  for ( unsigned int i = 0; i < 10000; ++i ) {
+    value[0] = 2.0 * std::exp( -static_cast< double >( i ) / 1000.0 ) +
+      random.Gaussian();
+    drifting.AddSample( 0, value );
+  }
+  if ( std::fabs( drifting.GetGewekeZ( 0 ) ) < 4.0 ) {
+    std::cerr << "Geweke z of a drifting chain is "
+              << drifting.GetGewekeZ( 0 ) << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // The log likelihoods of chains still climbing are not stationary;
+  // once they fluctuate around one value they are.
+  std::vector< std::vector< double > > climbing( NUMBER_OF_CHAINS );
+  std::vector< std::vector< double > > settled( NUMBER_OF_CHAINS );
+  for ( unsigned int chain = 0; chain < NUMBER_OF_CHAINS; ++chain ) {
+    for ( unsigned int i = 0; i < 2000; ++i ) {
+      climbing[chain].push_back( -10.0 * std::exp(
+        -static_cast< double >( i ) / 500.0 ) + random.Gaussian() );
+      settled[chain].push_back( random.Gaussian() );
+    }
+  }
+  if ( madai::ConvergenceMonitor::IsStationary( climbing ) ) {
+    std::cerr << "Climbing log likelihoods are stationary\n";
+    return EXIT_FAILURE;
+  }
+  if ( !madai::ConvergenceMonitor::IsStationary( settled ) ) {
+    std::cerr << "Settled log likelihoods are not stationary\n";
+    return EXIT_FAILURE;
+  }
+  settled[0].resize( 50 );
+  if ( madai::ConvergenceMonitor::IsStationary( settled ) ) {
+    std::cerr << "Stationary with only 50 values\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "CorrelatedGaussianModel.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+
+namespace madai {
+
+CorrelatedGaussianModel
+::CorrelatedGaussianModel( const std::vector< double > & means,
+                           const std::vector< double > & deviations,
+                           double correlation ) :
+  m_Deviations( deviations )
+{
+  assert( means.size() == deviations.size() );
+  unsigned int n = static_cast< unsigned int >( means.size() );
+  for ( unsigned int i = 0; i < n; ++i ) {
+    std::ostringstream name;
+    if ( n <= 3 ) {
+      name << "XYZ"[i];
+    } else {
+      name << "P" << i;
+    }
+    m_Parameters.push_back( Parameter( name.str() ) );
+    this->AddScalarOutputName( name.str() );
+  }
+
+  // Usually the observed scalar values would be set from outside the
+  // Model object. As this is a test object, however, we are setting
+  // the observed values here.
+  m_ObservedScalarValues = means;
+  for ( unsigned int i = 0; i < n; ++i ) {
+    for ( unsigned int j = 0; j < n; ++j ) {
+      int distance = static_cast< int >( i ) - static_cast< int >( j );
+      m_ObservedScalarCovariance.push_back(
+        deviations[i] * deviations[j] *
+        std::pow( correlation, std::abs( distance ) ) );
+    }
+  }
+  m_Precision = Eigen::Map< Eigen::MatrixXd >(
+    &m_ObservedScalarCovariance[0], n, n ).inverse();
+
+  this->SetPriorWidth( 100.0 );
+
+  // This model is always ready
+  m_StateFlag = Model::READY;
+}
+
+
+void
+CorrelatedGaussianModel
+::SetPriorWidth( double numberOfDeviations )
+{
+  for ( unsigned int i = 0; i < m_Deviations.size(); ++i ) {
+    double halfWidth = numberOfDeviations * m_Deviations[i];
+    m_Parameters[i] = Parameter( m_Parameters[i].m_Name,
+                                 m_ObservedScalarValues[i] - halfWidth,
+                                 m_ObservedScalarValues[i] + halfWidth );
+  }
+  this->UpdateCompiledPrior();
+}
+
+
+void
+CorrelatedGaussianModel
+::SetPriorBounds( double minimum, double maximum )
+{
+  for ( unsigned int i = 0; i < m_Deviations.size(); ++i ) {
+    m_Parameters[i] = Parameter( m_Parameters[i].m_Name, minimum, maximum );
+  }
+  this->UpdateCompiledPrior();
+}
+
+
+void
+CorrelatedGaussianModel
+::AddUnobservedParameter( const std::string & name,
+                          double minimum, double maximum )
+{
+  m_Parameters.push_back( Parameter( name, minimum, maximum ) );
+  this->UpdateCompiledPrior();
+}
+
+
+Model::ErrorType
+CorrelatedGaussianModel
+::GetScalarOutputs( const std::vector< double > & parameters,
+                    std::vector< double > & scalars ) const
+{
+  scalars.assign( parameters.begin(),
+                  parameters.begin() + m_Deviations.size() );
+  return NO_ERROR;
+}
+
+
+Model::ErrorType
+CorrelatedGaussianModel
+::GetScalarOutputsAndLogLikelihood( const std::vector< double > & parameters,
+                                    std::vector< double > & scalars,
+                                    double & logLikelihood ) const
+{
+  ErrorType error = this->GetScalarOutputs( parameters, scalars );
+  if ( error != NO_ERROR ) {
+    return error;
+  }
+
+  Eigen::VectorXd difference( m_Deviations.size() );
+  for ( unsigned int i = 0; i < m_Deviations.size(); ++i ) {
+    difference( i ) = scalars[i] - m_ObservedScalarValues[i];
+  }
+  logLikelihood = -0.5 * difference.dot( m_Precision * difference ) +
+    this->GetLogPriorLikelihood( parameters );
+  return NO_ERROR;
+}
+
+
+Model::ErrorType
+CorrelatedGaussianModel
+::GetScalarOutputsAndLogLikelihoodAndGradient(
+    const std::vector< double > & parameters,
+    const std::vector< bool > & activeParameters,
+    std::vector< double > & scalars,
+    double & logLikelihood,
+    std::vector< double > & gradient ) const
+{
+  gradient.clear();
+  ErrorType error =
+    this->GetScalarOutputsAndLogLikelihood( parameters, scalars, logLikelihood );
+  if ( error != NO_ERROR ) {
+    return error;
+  }
+
+  if ( activeParameters.size() != this->GetNumberOfParameters() ) {
+    return INVALID_ACTIVE_PARAMETERS;
+  }
+
+  // Gradient of -(x - mu)^T C^-1 (x - mu) / 2.
+  Eigen::VectorXd difference( m_Deviations.size() );
+  for ( unsigned int i = 0; i < m_Deviations.size(); ++i ) {
+    difference( i ) = scalars[i] - m_ObservedScalarValues[i];
+  }
+  Eigen::VectorXd fullGradient = -( m_Precision * difference );
+  for ( unsigned int i = 0; i < activeParameters.size(); ++i ) {
+    if ( activeParameters[i] ) {
+      gradient.push_back( i < m_Deviations.size() ? fullGradient( i ) : 0.0 );
+    }
+  }
+  return NO_ERROR;
+}
+
+
+bool
+CorrelatedGaussianModel
+::SupportsConcurrentEvaluation() const
+{
+  return true;
+}
+
+} // end namespace madai
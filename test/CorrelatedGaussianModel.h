@@ -0,0 +1,94 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef madai_CorrelatedGaussianModel_h_included
+#define madai_CorrelatedGaussianModel_h_included
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Model.h"
+
+
+namespace madai {
+
+/** \class CorrelatedGaussianModel
+ *
+ * A test model whose outputs are its parameters, observed at given
+ * means with given standard deviations. Parameters i and j are
+ * correlated by correlation^|i - j|, so the posterior is a Gaussian
+ * with any mix of scales and correlations. The parameters are named
+ * X, Y and Z, or P0, P1, ... when there are more than three. The
+ * log likelihood and its gradient are computed analytically. */
+class CorrelatedGaussianModel : public Model {
+public:
+  /** Each parameter gets a uniform prior 100 standard deviations
+   * wide on either side of its mean. */
+  CorrelatedGaussianModel( const std::vector< double > & means,
+                           const std::vector< double > & deviations,
+                           double correlation = 0.0 );
+  virtual ~CorrelatedGaussianModel() {};
+
+  /** Give each observed parameter a uniform prior of the given
+   * number of standard deviations on either side of its mean. */
+  void SetPriorWidth( double numberOfDeviations );
+
+  /** Give every observed parameter the uniform prior on [minimum,
+   * maximum]. */
+  void SetPriorBounds( double minimum, double maximum );
+
+  /** Add a parameter with a uniform prior on [minimum, maximum]
+   * that the outputs do not depend on. */
+  void AddUnobservedParameter( const std::string & name,
+                               double minimum, double maximum );
+
+  /** Get the scalar outputs from the model evaluated at x. */
+  virtual ErrorType GetScalarOutputs( const std::vector< double > & parameters,
+                                      std::vector< double > & scalars ) const;
+
+  /** Same as the default, with the precision matrix computed once. */
+  virtual ErrorType GetScalarOutputsAndLogLikelihood(
+    const std::vector< double > & parameters,
+    std::vector< double > & scalars,
+    double & logLikelihood ) const;
+
+  /** Computes the gradient of the log likelihood analytically. */
+  virtual ErrorType GetScalarOutputsAndLogLikelihoodAndGradient(
+    const std::vector< double > & parameters,
+    const std::vector< bool > & activeParameters,
+    std::vector< double > & scalars,
+    double & logLikelihood,
+    std::vector< double > & gradient ) const;
+
+  /** Returns true: evaluation has no side effects. */
+  virtual bool SupportsConcurrentEvaluation() const;
+
+protected:
+  /** Standard deviations of the observed parameters. */
+  std::vector< double > m_Deviations;
+
+  /** Inverse of the observed scalar covariance. */
+  Eigen::MatrixXd m_Precision;
+
+}; // end class CorrelatedGaussianModel
+
+} // end namespace madai
+
+#endif // madai_CorrelatedGaussianModel_h_included
@@ -0,0 +1,140 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "DelayedAcceptanceSampler.h"
+#include "UniformDistribution.h"
+
+
+static const double MEANS[2] = { 1.0, -2.0 };
+static const double DEVIATIONS[2] = { 0.5, 2.0 };
+
+
+/** \class Model whose outputs are its parameters, observed at the
+ * given means with the given standard deviations, and counting its
+ * evaluations. */
+class CountingGaussianModel : public madai::Model {
+public:
+  CountingGaussianModel( const double means[2], const double deviations[2] ) :
+    m_NumberOfEvaluations( 0 )
+  {
+    madai::UniformDistribution prior;
+    prior.SetMinimum( -10.0 );
+    prior.SetMaximum( 10.0 );
+    this->AddParameter( "X", prior );
+    this->AddParameter( "Y", prior );
+    this->AddScalarOutputName( "X" );
+    this->AddScalarOutputName( "Y" );
+
+    m_ObservedScalarValues.assign( means, means + 2 );
+    m_ObservedScalarCovariance.push_back( deviations[0] * deviations[0] );
+    m_ObservedScalarCovariance.push_back( 0.0 );
+    m_ObservedScalarCovariance.push_back( 0.0 );
+    m_ObservedScalarCovariance.push_back( deviations[1] * deviations[1] );
+    m_StateFlag = READY;
+  }
+
+  virtual ErrorType GetScalarOutputs( const std::vector< double > & parameters,
+                                      std::vector< double > & scalars ) const
+  {
+    ++m_NumberOfEvaluations;
+    scalars = parameters;
+    return NO_ERROR;
+  }
+
+  mutable unsigned long int m_NumberOfEvaluations;
+};
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_BURN_IN_SAMPLES = 1000;
+  static const unsigned int NUMBER_OF_SAMPLES = 50000;
+
+  CountingGaussianModel model( MEANS, DEVIATIONS );
+
+  // A surrogate that is somewhat off, as an emulator would be.
+  double surrogateMeans[2] = { 1.2, -1.5 };
+  double surrogateDeviations[2] = { 0.6, 1.5 };
+  CountingGaussianModel surrogate( surrogateMeans, surrogateDeviations );
+
+  madai::DelayedAcceptanceSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  sampler.SetSurrogateModel( &surrogate );
+  sampler.SetStepSize( 0.1 );
+
+  for ( unsigned int i = 0; i < NUMBER_OF_BURN_IN_SAMPLES; ++i ) {
+    sampler.NextSample();
+  }
+
+  // The chain follows the Model, not the surrogate.
+  model.m_NumberOfEvaluations = 0;
+  unsigned long int numberOfProposals = sampler.GetNumberOfProposals();
+  double sum[2] = { 0.0, 0.0 };
+  double sumOfSquares[2] = { 0.0, 0.0 };
+  for ( unsigned int i = 0; i < NUMBER_OF_SAMPLES; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    for ( unsigned int j = 0; j < 2; ++j ) {
+      sum[j] += sample.m_ParameterValues[j];
+      sumOfSquares[j] += sample.m_ParameterValues[j] * sample.m_ParameterValues[j];
+    }
+  }
+  for ( unsigned int j = 0; j < 2; ++j ) {
+    double mean = sum[j] / NUMBER_OF_SAMPLES;
+    double deviation = std::sqrt( sumOfSquares[j] / NUMBER_OF_SAMPLES - mean * mean );
+    if ( std::fabs( mean - MEANS[j] ) > 0.1 * DEVIATIONS[j] ||
+         std::fabs( deviation / DEVIATIONS[j] - 1.0 ) > 0.1 ) {
+      std::cerr << "Parameter " << j << " has mean " << mean
+                << " and standard deviation " << deviation << ", expected "
+                << MEANS[j] << " and " << DEVIATIONS[j] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Only the proposals that pass the surrogate reach the Model.
+  numberOfProposals = sampler.GetNumberOfProposals() - numberOfProposals;
+  if ( numberOfProposals != NUMBER_OF_SAMPLES ) {
+    std::cerr << "Counted " << numberOfProposals << " proposals, expected "
+              << NUMBER_OF_SAMPLES << "\n";
+    return EXIT_FAILURE;
+  }
+  double evaluatedFraction =
+    static_cast< double >( model.m_NumberOfEvaluations ) / NUMBER_OF_SAMPLES;
+  if ( evaluatedFraction > 0.8 || evaluatedFraction < 0.1 ) {
+    std::cerr << "Model was evaluated for " << evaluatedFraction
+              << " of the proposals\n";
+    return EXIT_FAILURE;
+  }
+
+  // Moving the chain evaluates both models at the new point.
+  unsigned long int modelEvaluations = model.m_NumberOfEvaluations;
+  unsigned long int surrogateEvaluations = surrogate.m_NumberOfEvaluations;
+  sampler.SetParameterValue( "X", 1.0 );
+  if ( model.m_NumberOfEvaluations != modelEvaluations + 1 ||
+       surrogate.m_NumberOfEvaluations != surrogateEvaluations + 1 ) {
+    std::cerr << "Models were not evaluated at the new point\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "CorrelatedGaussianModel.h"
+#include "DifferentialEvolutionSampler.h"
+
+
+static const unsigned int NUMBER_OF_PARAMETERS = 10;
+static const double CORRELATION = 0.9;
+
+
+/** Mean of parameter i. */
+double Mean( unsigned int i )
+{
+  return static_cast< double >( i );
+}
+
+/** Standard deviation of parameter i. */
+double Deviation( unsigned int i )
+{
+  return 0.5 * ( i + 1 );
+}
+
+
+/** Run the sampler and compare the moments of its samples with the
+ * posterior, allowing the given error relative to the standard
+ * deviations. */
+bool CheckMoments( madai::DifferentialEvolutionSampler & sampler,
+                   unsigned int numberOfBurnInSamples,
+                   unsigned int numberOfSamples,
+                   double tolerance )
+{
+  for ( unsigned int s = 0; s < numberOfBurnInSamples; ++s ) {
+    sampler.NextSample();
+  }
+
+  std::vector< double > sum( NUMBER_OF_PARAMETERS, 0.0 );
+  std::vector< double > sumOfSquares( NUMBER_OF_PARAMETERS, 0.0 );
+  double sumOfProducts = 0.0;
+  for ( unsigned int s = 0; s < numberOfSamples; ++s ) {
+    madai::Sample sample = sampler.NextSample();
+    const std::vector< double > & x = sample.m_ParameterValues;
+    for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+      sum[i] += x[i];
+      sumOfSquares[i] += x[i] * x[i];
+    }
+    sumOfProducts += x[0] * x[1];
+  }
+
+  std::vector< double > deviations( NUMBER_OF_PARAMETERS );
+  for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+    double mean = sum[i] / numberOfSamples;
+    deviations[i] = std::sqrt( sumOfSquares[i] / numberOfSamples - mean * mean );
+    if ( std::fabs( mean - Mean( i ) ) > tolerance * Deviation( i ) ||
+         std::fabs( deviations[i] / Deviation( i ) - 1.0 ) > tolerance ) {
+      std::cerr << "Parameter " << i << " has mean " << mean
+                << " and standard deviation " << deviations[i]
+                << ", expected " << Mean( i ) << " and " << Deviation( i )
+                << "\n";
+      return false;
+    }
+  }
+  double correlation =
+    ( sumOfProducts / numberOfSamples -
+      ( sum[0] / numberOfSamples ) * ( sum[1] / numberOfSamples ) ) /
+    ( deviations[0] * deviations[1] );
+  if ( std::fabs( correlation - CORRELATION ) > 0.05 ) {
+    std::cerr << "Correlation of the first two parameters is " << correlation
+              << ", expected " << CORRELATION << "\n";
+    return false;
+  }
+  return true;
+}
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_BURN_IN_MOVES = 2000;
+  static const unsigned int NUMBER_OF_MOVES = 3000;
+
+  // Neighbouring parameters are strongly correlated, and the scales
+  // are very different.
+  std::vector< double > means( NUMBER_OF_PARAMETERS );
+  std::vector< double > deviations( NUMBER_OF_PARAMETERS );
+  for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+    means[i] = Mean( i );
+    deviations[i] = Deviation( i );
+  }
+  madai::CorrelatedGaussianModel model( means, deviations, CORRELATION );
+  model.SetPriorWidth( 20.0 );
+
+  // Plain DE-MC.
+  madai::DifferentialEvolutionSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  unsigned int numberOfChains = sampler.GetNumberOfWalkers();
+  if ( numberOfChains != 2 * NUMBER_OF_PARAMETERS + 2 ) {
+    std::cerr << "Unexpected default number of chains " << numberOfChains
+              << "\n";
+    return EXIT_FAILURE;
+  }
+  if ( !CheckMoments( sampler, NUMBER_OF_BURN_IN_MOVES * numberOfChains,
+                      NUMBER_OF_MOVES * numberOfChains, 0.2 ) ) {
+    std::cerr << "DE-MC sampler failed\n";
+    return EXIT_FAILURE;
+  }
+  double acceptance = sampler.GetAcceptanceFraction();
+  if ( acceptance < 0.05 || acceptance > 0.6 ) {
+    std::cerr << "Acceptance fraction " << acceptance << " is implausible\n";
+    return EXIT_FAILURE;
+  }
+
+  // With subspace crossover, which mixes more slowly on a posterior
+  // this strongly correlated.
+  madai::DifferentialEvolutionSampler crossoverSampler;
+  crossoverSampler.ReseedRandomNumberGenerator( 43 );
+  crossoverSampler.SetModel( &model );
+  crossoverSampler.SetCrossoverProbability( 0.5 );
+  if ( !CheckMoments( crossoverSampler, NUMBER_OF_BURN_IN_MOVES * numberOfChains,
+                      NUMBER_OF_MOVES * numberOfChains, 0.35 ) ) {
+    std::cerr << "DE-MC sampler with crossover failed\n";
+    return EXIT_FAILURE;
+  }
+
+  // Inactive parameters stay put in every chain.
+  sampler.DeactivateParameter( "P3" );
+  sampler.SetParameterValue( "P3", 1.5 );
+  for ( unsigned int s = 0; s < 10 * numberOfChains; ++s ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( sample.m_ParameterValues[3] != 1.5 ) {
+      std::cerr << "Inactive parameter changed\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
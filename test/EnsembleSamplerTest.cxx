@@ -0,0 +1,131 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "CorrelatedGaussianModel.h"
+#include "EnsembleSampler.h"
+
+
+static const double MEANS[2] = { 1.0, -2.0 };
+static const double DEVIATIONS[2] = { 1.0, 3.0 };
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_WALKERS = 20;
+  static const unsigned int NUMBER_OF_BURN_IN_STEPS = 500;
+  static const unsigned int NUMBER_OF_STEPS = 2000;
+
+  // The posterior is a correlated Gaussian.
+  madai::CorrelatedGaussianModel model(
+    std::vector< double >( MEANS, MEANS + 2 ),
+    std::vector< double >( DEVIATIONS, DEVIATIONS + 2 ), 0.95 );
+  model.SetPriorBounds( -50.0, 50.0 );
+
+  madai::EnsembleSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  if ( sampler.GetNumberOfWalkers() != 6 ) {
+    std::cerr << "Default number of walkers should be 6, is "
+              << sampler.GetNumberOfWalkers() << "\n";
+    return EXIT_FAILURE;
+  }
+  sampler.SetNumberOfWalkers( NUMBER_OF_WALKERS - 1 );
+  if ( sampler.GetNumberOfWalkers() != NUMBER_OF_WALKERS ) {
+    std::cerr << "Number of walkers should be rounded up to "
+              << NUMBER_OF_WALKERS << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // The walkers are returned in turn.
+  std::vector< madai::Sample > ensemble;
+  for ( unsigned int i = 0; i < NUMBER_OF_WALKERS; ++i ) {
+    ensemble.push_back( sampler.NextSample() );
+  }
+  for ( unsigned int i = 1; i < NUMBER_OF_WALKERS; ++i ) {
+    if ( ensemble[i] == ensemble[0] ) {
+      std::cerr << "Walkers should start at different points\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  for ( unsigned int i = 0; i < NUMBER_OF_BURN_IN_STEPS * NUMBER_OF_WALKERS; ++i ) {
+    sampler.NextSample();
+  }
+
+  double sum[2] = { 0.0, 0.0 };
+  double sumOfProducts[3] = { 0.0, 0.0, 0.0 };
+  unsigned int numberOfSamples = NUMBER_OF_STEPS * NUMBER_OF_WALKERS;
+  for ( unsigned int i = 0; i < numberOfSamples; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    double x = sample.m_ParameterValues[0];
+    double y = sample.m_ParameterValues[1];
+    sum[0] += x;
+    sum[1] += y;
+    sumOfProducts[0] += x * x;
+    sumOfProducts[1] += x * y;
+    sumOfProducts[2] += y * y;
+  }
+  double meanX = sum[0] / numberOfSamples;
+  double meanY = sum[1] / numberOfSamples;
+  double varianceX = sumOfProducts[0] / numberOfSamples - meanX * meanX;
+  double covariance = sumOfProducts[1] / numberOfSamples - meanX * meanY;
+  double varianceY = sumOfProducts[2] / numberOfSamples - meanY * meanY;
+  double correlation = covariance / std::sqrt( varianceX * varianceY );
+  if ( std::fabs( meanX - 1.0 ) > 0.1 || std::fabs( meanY + 2.0 ) > 0.3 ||
+       std::fabs( std::sqrt( varianceX ) - 1.0 ) > 0.1 ||
+       std::fabs( std::sqrt( varianceY ) - 3.0 ) > 0.3 ||
+       std::fabs( correlation - 0.95 ) > 0.02 ) {
+    std::cerr << "Samples have means " << meanX << ", " << meanY
+              << ", variances " << varianceX << ", " << varianceY
+              << " and correlation " << correlation
+              << ", expected 1, -2, 1, 9 and 0.95\n";
+    return EXIT_FAILURE;
+  }
+
+  double acceptance = sampler.GetAcceptanceFraction();
+  if ( acceptance < 0.2 || acceptance > 0.9 ) {
+    std::cerr << "Acceptance fraction " << acceptance << " is implausible\n";
+    return EXIT_FAILURE;
+  }
+
+  // Setting an inactive parameter sets it in all walkers.
+  sampler.DeactivateParameter( "Y" );
+  sampler.SetParameterValue( "Y", 0.5 );
+  for ( unsigned int i = 0; i < 2 * NUMBER_OF_WALKERS; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( sample.m_ParameterValues[1] != 0.5 ) {
+      std::cerr << "Inactive parameter was not set in every walker\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Setting an active parameter restarts the walkers near it.
+  sampler.SetParameterValue( "X", 10.0 );
+  madai::Sample sample = sampler.NextSample();
+  if ( std::fabs( sample.m_ParameterValues[0] - 10.0 ) > 1.0 ) {
+    std::cerr << "Walkers were not restarted around the new point\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -136,6 +136,14 @@ Gaussian2DModel
 }
 
 
+bool
+Gaussian2DModel
+::SupportsConcurrentEvaluation() const
+{
+  return true;
+}
+
+
 double
 Gaussian2DModel
 ::PartialX( double x, double value ) const
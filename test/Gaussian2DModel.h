@@ -58,6 +58,9 @@ public:
   virtual ErrorType SetObservedScalarCovariance(
     const std::vector< double > & observedScalarCovariance);
 
+  /** Returns true: evaluation has no side effects. */
+  virtual bool SupportsConcurrentEvaluation() const;
+
   /** Set the means. */
   void SetMeans( double mean[2] );
 
@@ -16,12 +16,17 @@
  *
  *=========================================================================*/
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
 #include "GaussianProcessEmulatorTestGenerator.h"
 #include "MetropolisHastingsSampler.h"
 #include "GaussianProcessEmulatedModel.h"
@@ -74,7 +79,9 @@ int main( int, char *[] ) {
   std::string ERF = TempDirectory + madai::Paths::SEPARATOR +
     DEFAULTS_EXPERIMENTAL_RESULTS_FILE;
 
-  madai::GaussianProcessEmulator gpe;
+  boost::shared_ptr< madai::GaussianProcessEmulator > sharedGPE(
+    new madai::GaussianProcessEmulator );
+  madai::GaussianProcessEmulator & gpe = *sharedGPE;
   madai::GaussianProcessEmulatorDirectoryFormatIO directoryReader;
   if ( !directoryReader.LoadTrainingData( &gpe, MOD, TempDirectory, ERF ) ) {
     std::cerr << "error loading from created directory structure\n";
@@ -143,6 +150,73 @@ int main( int, char *[] ) {
     return EXIT_FAILURE;
   }
 
+  // Models sharing one emulator must refer to the same object.
+  madai::GaussianProcessEmulatedModel sharingModel1;
+  madai::GaussianProcessEmulatedModel sharingModel2;
+  if ( sharingModel1.SetGaussianProcessEmulator( sharedGPE ) != madai::Model::NO_ERROR ||
+       sharingModel2.SetGaussianProcessEmulator(
+         sharingModel1.GetSharedGaussianProcessEmulator() ) != madai::Model::NO_ERROR ) {
+    std::cerr << "Error setting a shared emulator\n";
+    return EXIT_FAILURE;
+  }
+  if ( &sharingModel1.GetGaussianProcessEmulator() != sharedGPE.get() ||
+       &sharingModel2.GetGaussianProcessEmulator() != sharedGPE.get() ) {
+    std::cerr << "Shared emulator was copied\n";
+    return EXIT_FAILURE;
+  }
+  std::vector< double > testPoint( 2, 0.3 );
+  std::vector< double > copiedOutputs;
+  std::vector< double > sharedOutputs;
+  gpem.GetScalarOutputs( testPoint, copiedOutputs );
+  sharingModel2.GetScalarOutputs( testPoint, sharedOutputs );
+  if ( copiedOutputs != sharedOutputs ) {
+    std::cerr << "Shared and copied emulators give different outputs\n";
+    return EXIT_FAILURE;
+  }
+
+  // Conditioning a model on a fixed parameter leaves the emulator it
+  // shares untouched, and does not change its outputs.
+  std::vector< bool > varyingParameters( 2, true );
+  varyingParameters[1] = false;
+  if ( sharingModel2.ConditionOnFixedParameters(
+         varyingParameters, testPoint ) != madai::Model::NO_ERROR ) {
+    std::cerr << "Error conditioning a model on a fixed parameter\n";
+    return EXIT_FAILURE;
+  }
+  if ( sharedGPE->IsConditionedOnFixedParameters() ||
+       &sharingModel1.GetGaussianProcessEmulator() != sharedGPE.get() ||
+       !sharingModel2.GetGaussianProcessEmulator().IsConditionedOnFixedParameters() ) {
+    std::cerr << "Conditioning a model changed the shared emulator\n";
+    return EXIT_FAILURE;
+  }
+  // A model holding the only reference frees the unconditioned
+  // emulator.
+  madai::GaussianProcessEmulatedModel owningModel;
+  owningModel.SetGaussianProcessEmulator( gpe );
+  boost::weak_ptr< const madai::GaussianProcessEmulator > unconditionedGPE(
+    owningModel.GetSharedGaussianProcessEmulator() );
+  if ( owningModel.ConditionOnFixedParameters(
+         varyingParameters, testPoint ) != madai::Model::NO_ERROR ||
+       !unconditionedGPE.expired() ) {
+    std::cerr << "Unconditioned emulator was not freed\n";
+    return EXIT_FAILURE;
+  }
+  std::vector< double > conditionedOutputs;
+  sharingModel2.GetScalarOutputs( testPoint, conditionedOutputs );
+  for ( size_t i = 0; i < sharedOutputs.size(); ++i ) {
+    if ( std::fabs( conditionedOutputs[i] - sharedOutputs[i] ) > 1e-10 ) {
+      std::cerr << "Conditioned model output " << conditionedOutputs[i]
+                << " differs from " << sharedOutputs[i] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  if ( !gpem.SupportsConcurrentEvaluation() ) {
+    std::cerr << "GaussianProcessEmulatedModel should support concurrent "
+              << "evaluation\n";
+    return EXIT_FAILURE;
+  }
+
   assert (2 == gpem.GetNumberOfScalarOutputs());
   int t = gpem.GetNumberOfScalarOutputs();
   std::vector< double > observedScalarValues;
@@ -154,6 +228,105 @@ int main( int, char *[] ) {
     observedScalarCovariance[i + (t * i)] = 0.05;
   gpem.SetObservedScalarCovariance(observedScalarCovariance);
 
+  // The fused evaluation must agree with the separate ones, with and
+  // without the emulator covariance.
+  std::vector< bool > activeParameters( 2, true );
+  for ( int useCovariance = 0; useCovariance < 2; ++useCovariance ) {
+    gpem.SetUseModelCovarianceToCalulateLogLikelihood( useCovariance != 0 );
+    std::vector< double > scalars;
+    std::vector< double > gradient;
+    double logLikelihood;
+    std::vector< double > fusedScalars;
+    std::vector< double > fusedGradient;
+    double fusedLogLikelihood;
+    gpem.GetScalarAndGradientOutputs(
+      testPoint, activeParameters, scalars, gradient );
+    gpem.GetScalarOutputsAndLogLikelihood( testPoint, scalars, logLikelihood );
+    if ( gpem.GetScalarOutputsAndLogLikelihoodAndGradient(
+           testPoint, activeParameters, fusedScalars,
+           fusedLogLikelihood, fusedGradient ) != madai::Model::NO_ERROR ) {
+      std::cerr << "Error in GetScalarOutputsAndLogLikelihoodAndGradient\n";
+      return EXIT_FAILURE;
+    }
+    if ( std::fabs( fusedLogLikelihood - logLikelihood ) > 1e-10 ||
+         fusedScalars != scalars || fusedGradient != gradient ) {
+      std::cerr << "Fused log likelihood and gradient differ from the "
+                << "separate evaluations\n";
+      return EXIT_FAILURE;
+    }
+
+    // The gradient must be that of the log likelihood, which depends
+    // on the parameters through the emulator covariance as well.
+    static const double h = 1e-5;
+    for ( unsigned int i = 0; i < testPoint.size(); ++i ) {
+      std::vector< double > above( testPoint ), below( testPoint );
+      above[i] += h;
+      below[i] -= h;
+      double logLikelihoodAbove, logLikelihoodBelow;
+      gpem.GetScalarOutputsAndLogLikelihood( above, scalars, logLikelihoodAbove );
+      gpem.GetScalarOutputsAndLogLikelihood( below, scalars, logLikelihoodBelow );
+      double difference = ( logLikelihoodAbove - logLikelihoodBelow ) / ( 2.0 * h );
+      if ( std::fabs( fusedGradient[i] - difference ) >
+           1e-5 * std::max( 1.0, std::fabs( difference ) ) ) {
+        std::cerr << "Gradient " << i << " of the log likelihood is "
+                  << fusedGradient[i] << ", finite differences give "
+                  << difference << " (useCovariance = " << useCovariance
+                  << ")\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  gpem.SetUseModelCovarianceToCalulateLogLikelihood( false );
+
+  // Updating one parameter at a time from a cached point must agree
+  // with evaluating from scratch.
+  boost::shared_ptr< madai::Model::EvaluationCache > previousCache(
+    gpem.NewEvaluationCache() );
+  boost::shared_ptr< madai::Model::EvaluationCache > currentCache(
+    gpem.NewEvaluationCache() );
+  if ( !previousCache || !currentCache ) {
+    std::cerr << "GaussianProcessEmulatedModel should provide an "
+              << "EvaluationCache\n";
+    return EXIT_FAILURE;
+  }
+  std::vector< unsigned int > allParameters;
+  allParameters.push_back( 0 );
+  allParameters.push_back( 1 );
+  std::vector< double > partialPoint( testPoint );
+  std::vector< double > partialScalars;
+  double partialLogLikelihood;
+  gpem.GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+    partialPoint, allParameters, NULL, previousCache.get(),
+    partialScalars, partialLogLikelihood );
+  for ( unsigned int step = 0; step < 10; ++step ) {
+    std::vector< unsigned int > changed( 1, step % 2 );
+    partialPoint[ step % 2 ] = -0.9 + 0.19 * step;
+    if ( gpem.GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+           partialPoint, changed, previousCache.get(), currentCache.get(),
+           partialScalars, partialLogLikelihood ) != madai::Model::NO_ERROR ) {
+      std::cerr << "Error in GetScalarOutputsAndLogLikelihoodOfPartialUpdate\n";
+      return EXIT_FAILURE;
+    }
+    std::swap( previousCache, currentCache );
+
+    std::vector< double > scalars;
+    double logLikelihood;
+    gpem.GetScalarOutputsAndLogLikelihood( partialPoint, scalars, logLikelihood );
+    if ( std::fabs( partialLogLikelihood - logLikelihood ) > 1e-8 ) {
+      std::cerr << "Partial update log likelihood " << partialLogLikelihood
+                << " differs from full evaluation " << logLikelihood << "\n";
+      return EXIT_FAILURE;
+    }
+    for ( size_t i = 0; i < scalars.size(); ++i ) {
+      if ( std::fabs( partialScalars[i] - scalars[i] ) > 1e-8 ) {
+        std::cerr << "Partial update output " << i << " is "
+                  << partialScalars[i] << ", full evaluation gives "
+                  << scalars[i] << "\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
   madai::MetropolisHastingsSampler mcmc;
   // The Model needs to be completely set up before passing to the
   // Sampler because the sampler might evaluate the Model right away.
@@ -158,6 +158,57 @@ int main( int, char *[] ) {
   }
   std::cout << "Maximum error over all space: " << error << '\n';
 
+  // Conditioning on a fixed value of param_1 must not change the
+  // outputs, whether or not a point matches the fixed value.
+  std::vector< bool > activeParameters( 2, true );
+  activeParameters[1] = false;
+  std::vector< double > fixedPoint( 2, 0.3 );
+  std::vector< std::vector< double > > points;
+  for (int i = 0; i < 5; ++i) {
+    x[0] = -0.9 + 0.4 * i;
+    x[1] = 0.3;
+    points.push_back( x );
+  }
+  x[1] = -0.6;
+  points.push_back( x );
+  std::vector< std::vector< double > > expectedMeans( points.size() );
+  std::vector< std::vector< double > > expectedCovariances( points.size() );
+  for (size_t i = 0; i < points.size(); ++i) {
+    gpe.GetEmulatorOutputsAndCovariance(
+        points[i], expectedMeans[i], expectedCovariances[i]);
+  }
+  if (! gpe.ConditionOnFixedParameters( activeParameters, fixedPoint ) ||
+      ! gpe.IsConditionedOnFixedParameters() ) {
+    std::cerr << "Error conditioning on fixed parameters.\n";
+    return EXIT_FAILURE;
+  }
+  for (size_t i = 0; i < points.size(); ++i) {
+    std::vector< double > mean, covariance;
+    if (! gpe.GetEmulatorOutputs( points[i], y ) ||
+        ! gpe.GetEmulatorOutputsAndCovariance( points[i], mean, covariance ) )
+      return EXIT_FAILURE;
+    for (size_t j = 0; j < y.size(); ++j) {
+      if ((std::abs(y[j] - expectedMeans[i][j]) > 1e-10) ||
+          (std::abs(mean[j] - expectedMeans[i][j]) > 1e-10)) {
+        std::cerr << "Conditioned emulator output " << y[j]
+                  << " differs from " << expectedMeans[i][j] << '\n';
+        return EXIT_FAILURE;
+      }
+    }
+    for (size_t j = 0; j < covariance.size(); ++j) {
+      if (std::abs(covariance[j] - expectedCovariances[i][j]) > 1e-10) {
+        std::cerr << "Conditioned emulator covariance " << covariance[j]
+                  << " differs from " << expectedCovariances[i][j] << '\n';
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  gpe.ClearFixedParameters();
+  if ( gpe.IsConditionedOnFixedParameters() ) {
+    std::cerr << "Emulator still conditioned after ClearFixedParameters().\n";
+    return EXIT_FAILURE;
+  }
+
   std::string ThetaFileName = TempDirectory + madai::Paths::SEPARATOR + "thetas.dat";
   std::ofstream ThetaFile( ThetaFileName.c_str() );
   if(! directoryFormatIO.PrintThetas(&gpe,ThetaFile)) {
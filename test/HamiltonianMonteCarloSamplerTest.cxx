@@ -0,0 +1,141 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "CorrelatedGaussianModel.h"
+#include "HamiltonianMonteCarloSampler.h"
+
+
+static const unsigned int NUMBER_OF_PARAMETERS = 3;
+static const double MEANS[NUMBER_OF_PARAMETERS] = { 1.0, -2.0, 30.0 };
+static const double DEVIATIONS[NUMBER_OF_PARAMETERS] = { 0.5, 2.0, 10.0 };
+
+
+/** Draw samples and compare their moments with the posterior. */
+bool CheckMoments( madai::HamiltonianMonteCarloSampler & sampler,
+                   unsigned int numberOfSamples )
+{
+  std::vector< double > sum( NUMBER_OF_PARAMETERS, 0.0 );
+  std::vector< double > sumOfSquares( NUMBER_OF_PARAMETERS, 0.0 );
+  for ( unsigned int s = 0; s < numberOfSamples; ++s ) {
+    madai::Sample sample = sampler.NextSample();
+    for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+      sum[i] += sample.m_ParameterValues[i];
+      sumOfSquares[i] += sample.m_ParameterValues[i] * sample.m_ParameterValues[i];
+    }
+  }
+
+  for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+    double mean = sum[i] / numberOfSamples;
+    double variance = sumOfSquares[i] / numberOfSamples - mean * mean;
+    double deviation = std::sqrt( variance );
+    if ( std::fabs( mean - MEANS[i] ) > 0.15 * DEVIATIONS[i] ||
+         std::fabs( deviation / DEVIATIONS[i] - 1.0 ) > 0.15 ) {
+      std::cerr << "Parameter " << i << " has mean " << mean
+                << " and standard deviation " << deviation
+                << ", expected " << MEANS[i] << " and " << DEVIATIONS[i] << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_ADAPTATION_SAMPLES = 500;
+  static const unsigned int NUMBER_OF_SAMPLES = 2000;
+
+  // The posterior is a Gaussian with very different scales along the
+  // axes.
+  madai::CorrelatedGaussianModel model(
+    std::vector< double >( MEANS, MEANS + NUMBER_OF_PARAMETERS ),
+    std::vector< double >( DEVIATIONS, DEVIATIONS + NUMBER_OF_PARAMETERS ) );
+
+  // No-U-Turn sampler.
+  madai::HamiltonianMonteCarloSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  sampler.SetNumberOfAdaptationSamples( NUMBER_OF_ADAPTATION_SAMPLES );
+  for ( unsigned int i = 0; i < NUMBER_OF_ADAPTATION_SAMPLES; ++i ) {
+    sampler.NextSample();
+  }
+  if ( sampler.IsAdapting() ) {
+    std::cerr << "Sampler should stop adapting after "
+              << NUMBER_OF_ADAPTATION_SAMPLES << " samples\n";
+    return EXIT_FAILURE;
+  }
+
+  // The mass matrix should have learned the scales of the posterior.
+  const std::vector< double > & inverseMass = sampler.GetInverseMassMatrix();
+  for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+    double ratio = inverseMass[i] / ( DEVIATIONS[i] * DEVIATIONS[i] );
+    if ( ratio < 0.5 || ratio > 2.0 ) {
+      std::cerr << "Inverse mass " << inverseMass[i] << " of parameter " << i
+                << " does not match the posterior variance\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  unsigned int divergences = sampler.GetNumberOfDivergences();
+  double stepSize = sampler.GetStepSize();
+  if ( !CheckMoments( sampler, NUMBER_OF_SAMPLES ) ) {
+    std::cerr << "No-U-Turn sampler failed\n";
+    return EXIT_FAILURE;
+  }
+  if ( sampler.GetStepSize() != stepSize ) {
+    std::cerr << "Step size changed after the adaptation\n";
+    return EXIT_FAILURE;
+  }
+  if ( sampler.GetNumberOfDivergences() != divergences ) {
+    std::cerr << "Trajectories diverged after the adaptation\n";
+    return EXIT_FAILURE;
+  }
+
+  // Static HMC.
+  madai::HamiltonianMonteCarloSampler staticSampler;
+  staticSampler.ReseedRandomNumberGenerator( 43 );
+  staticSampler.SetModel( &model );
+  staticSampler.SetUseNoUTurn( false );
+  staticSampler.SetNumberOfLeapfrogSteps( 10 );
+  staticSampler.SetNumberOfAdaptationSamples( NUMBER_OF_ADAPTATION_SAMPLES );
+  for ( unsigned int i = 0; i < NUMBER_OF_ADAPTATION_SAMPLES; ++i ) {
+    staticSampler.NextSample();
+  }
+  if ( !CheckMoments( staticSampler, NUMBER_OF_SAMPLES ) ) {
+    std::cerr << "Static HMC sampler failed\n";
+    return EXIT_FAILURE;
+  }
+
+  // Inactive parameters stay put.
+  sampler.DeactivateParameter( "Y" );
+  sampler.SetParameterValue( "Y", 5.0 );
+  for ( unsigned int i = 0; i < 100; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( sample.m_ParameterValues[1] != 5.0 ) {
+      std::cerr << "Inactive parameter changed\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "CorrelatedGaussianModel.h"
+#include "LBFGSOptimizer.h"
+
+
+static const double DEVIATIONS[2] = { 1.0, 0.01 };
+static const double CORRELATION = 0.9;
+
+
+int main( int, char *[] )
+{
+  // Unconstrained maximum, with strongly correlated errors of very
+  // different sizes.
+  std::vector< double > means( 2, -0.5 );
+  means[0] = 1.0;
+  std::vector< double > deviations( DEVIATIONS, DEVIATIONS + 2 );
+  madai::CorrelatedGaussianModel model( means, deviations, CORRELATION );
+  model.SetPriorBounds( -10.0, 10.0 );
+  madai::LBFGSOptimizer optimizer;
+  optimizer.SetModel( &model );
+  madai::Sample maximum = optimizer.FindMaximum( 200 );
+  if ( !optimizer.HasConverged() ||
+       std::fabs( maximum.m_ParameterValues[0] - 1.0 ) > 1e-4 * DEVIATIONS[0] ||
+       std::fabs( maximum.m_ParameterValues[1] + 0.5 ) > 1e-4 * DEVIATIONS[1] ) {
+    std::cerr << "Maximum found at " << maximum.m_ParameterValues[0] << ", "
+              << maximum.m_ParameterValues[1] << ", expected 1, -0.5\n";
+    return EXIT_FAILURE;
+  }
+  // Far fewer evaluations than a fixed-step gradient ascent needs.
+  if ( optimizer.GetNumberOfModelEvaluations() > 50 ) {
+    std::cerr << "Needed " << optimizer.GetNumberOfModelEvaluations()
+              << " Model evaluations in " << optimizer.GetNumberOfIterations()
+              << " iterations\n";
+    return EXIT_FAILURE;
+  }
+
+  // Maximum outside the prior support: X stops at the bound, and Y
+  // follows the correlation.
+  means[0] = 12.0;
+  madai::CorrelatedGaussianModel boundedModel( means, deviations, CORRELATION );
+  boundedModel.SetPriorBounds( -10.0, 10.0 );
+  madai::LBFGSOptimizer boundedOptimizer;
+  boundedOptimizer.SetModel( &boundedModel );
+  maximum = boundedOptimizer.FindMaximum( 200 );
+  double expectedY = -0.5 + CORRELATION * DEVIATIONS[1] / DEVIATIONS[0] * ( 10.0 - 12.0 );
+  if ( !boundedOptimizer.HasConverged() ||
+       maximum.m_ParameterValues[0] != 10.0 ||
+       std::fabs( maximum.m_ParameterValues[1] - expectedY ) > 1e-4 * DEVIATIONS[1] ) {
+    std::cerr << "Bounded maximum found at " << maximum.m_ParameterValues[0]
+              << ", " << maximum.m_ParameterValues[1] << ", expected 10, "
+              << expectedY << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // An inactive parameter stays where it was put, and the others are
+  // maximized given it.
+  optimizer.SetParameterValue( "X", 2.0 );
+  optimizer.DeactivateParameter( "X" );
+  maximum = optimizer.FindMaximum( 200 );
+  expectedY = -0.5 + CORRELATION * DEVIATIONS[1] / DEVIATIONS[0] * ( 2.0 - 1.0 );
+  if ( maximum.m_ParameterValues[0] != 2.0 ||
+       std::fabs( maximum.m_ParameterValues[1] - expectedY ) > 1e-4 * DEVIATIONS[1] ) {
+    std::cerr << "Conditional maximum found at " << maximum.m_ParameterValues[0]
+              << ", " << maximum.m_ParameterValues[1] << ", expected 2, "
+              << expectedY << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // Swapping which parameter is inactive keeps the number of active
+  // parameters, but the maximum is now taken over X given Y.
+  optimizer.SetParameterValue( "Y", -0.49 );
+  optimizer.ActivateParameter( "X" );
+  optimizer.DeactivateParameter( "Y" );
+  maximum = optimizer.FindMaximum( 200 );
+  double expectedX = 1.0 + CORRELATION * DEVIATIONS[0] / DEVIATIONS[1] * ( -0.49 + 0.5 );
+  if ( maximum.m_ParameterValues[1] != -0.49 ||
+       std::fabs( maximum.m_ParameterValues[0] - expectedX ) > 1e-4 * DEVIATIONS[0] ) {
+    std::cerr << "Maximum after swapping found at " << maximum.m_ParameterValues[0]
+              << ", " << maximum.m_ParameterValues[1] << ", expected "
+              << expectedX << ", -0.49\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "CorrelatedGaussianModel.h"
+#include "LaplaceApproximationSampler.h"
+
+
+static const double DEVIATIONS[2] = { 1.0, 0.01 };
+static const double CORRELATION = 0.9;
+
+
+int main( int, char *[] )
+{
+  // The posterior is Gaussian inside the prior support, with strongly
+  // correlated errors of very different sizes, so the approximation is
+  // exact.
+  std::vector< double > means( 2, -0.5 );
+  means[0] = 1.0;
+  std::vector< double > deviations( DEVIATIONS, DEVIATIONS + 2 );
+  madai::CorrelatedGaussianModel model( means, deviations, CORRELATION );
+  model.SetPriorBounds( -10.0, 10.0 );
+
+  madai::LaplaceApproximationSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  if ( !sampler.ComputeApproximation() ) {
+    std::cerr << "Approximation not valid\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::vector< double > & mean = sampler.GetMean();
+  if ( std::fabs( mean[0] - 1.0 ) > 1e-4 * DEVIATIONS[0] ||
+       std::fabs( mean[1] + 0.5 ) > 1e-4 * DEVIATIONS[1] ) {
+    std::cerr << "Mean " << mean[0] << ", " << mean[1]
+              << ", expected 1, -0.5\n";
+    return EXIT_FAILURE;
+  }
+
+  Eigen::MatrixXd covariance = sampler.GetCovariance();
+  for ( unsigned int i = 0; i < 2; ++i ) {
+    for ( unsigned int j = 0; j < 2; ++j ) {
+      double expected = ( i == j ? 1.0 : CORRELATION ) *
+        DEVIATIONS[i] * DEVIATIONS[j];
+      if ( std::fabs( covariance( i, j ) - expected ) >
+           1e-4 * DEVIATIONS[i] * DEVIATIONS[j] ) {
+        std::cerr << "Covariance (" << i << ", " << j << ") is "
+                  << covariance( i, j ) << ", expected " << expected << "\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Independent draws reproduce the moments.
+  const unsigned int numberOfSamples = 20000;
+  double sums[2] = { 0.0, 0.0 };
+  double squares[2] = { 0.0, 0.0 };
+  double crossProducts = 0.0;
+  for ( unsigned int s = 0; s < numberOfSamples; ++s ) {
+    madai::Sample sample = sampler.NextSample();
+    double x = sample.m_ParameterValues[0] - mean[0];
+    double y = sample.m_ParameterValues[1] - mean[1];
+    sums[0] += x;
+    sums[1] += y;
+    squares[0] += x * x;
+    squares[1] += y * y;
+    crossProducts += x * y;
+    if ( sample.m_OutputValues != sample.m_ParameterValues ) {
+      std::cerr << "Sample outputs were not evaluated\n";
+      return EXIT_FAILURE;
+    }
+  }
+  for ( unsigned int i = 0; i < 2; ++i ) {
+    double sampleMean = sums[i] / numberOfSamples;
+    double sampleDeviation = std::sqrt( squares[i] / numberOfSamples );
+    if ( std::fabs( sampleMean ) > 0.05 * DEVIATIONS[i] ||
+         std::fabs( sampleDeviation / DEVIATIONS[i] - 1.0 ) > 0.05 ) {
+      std::cerr << "Parameter " << i << " has mean offset " << sampleMean
+                << " and deviation " << sampleDeviation << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+  double sampleCorrelation = crossProducts /
+    std::sqrt( squares[0] * squares[1] );
+  if ( std::fabs( sampleCorrelation - CORRELATION ) > 0.02 ) {
+    std::cerr << "Sample correlation " << sampleCorrelation << ", expected "
+              << CORRELATION << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // With X fixed, the approximation is the conditional Gaussian of Y.
+  sampler.SetParameterValue( "X", 2.0 );
+  sampler.DeactivateParameter( "X" );
+  madai::Sample sample = sampler.NextSample();
+  double expectedMean = -0.5 + CORRELATION * DEVIATIONS[1] / DEVIATIONS[0];
+  double expectedVariance =
+    ( 1.0 - CORRELATION * CORRELATION ) * DEVIATIONS[1] * DEVIATIONS[1];
+  covariance = sampler.GetCovariance();
+  if ( sample.m_ParameterValues[0] != 2.0 ||
+       std::fabs( sampler.GetMean()[1] - expectedMean ) > 1e-4 * DEVIATIONS[1] ||
+       covariance( 0, 0 ) != 0.0 ||
+       std::fabs( covariance( 1, 1 ) / expectedVariance - 1.0 ) > 1e-3 ) {
+    std::cerr << "Conditional approximation has mean "
+              << sampler.GetMean()[1] << " and variance " << covariance( 1, 1 )
+              << ", expected " << expectedMean << " and " << expectedVariance
+              << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // Swapping which parameter is inactive keeps the number of active
+  // parameters, but the approximation is now the conditional of X.
+  double y = sample.m_ParameterValues[1];
+  sampler.ActivateParameter( "X" );
+  sampler.DeactivateParameter( "Y" );
+  sample = sampler.NextSample();
+  expectedMean = 1.0 + CORRELATION * DEVIATIONS[0] / DEVIATIONS[1] * ( y + 0.5 );
+  expectedVariance =
+    ( 1.0 - CORRELATION * CORRELATION ) * DEVIATIONS[0] * DEVIATIONS[0];
+  covariance = sampler.GetCovariance();
+  if ( sample.m_ParameterValues[1] != y ||
+       std::fabs( sampler.GetMean()[0] - expectedMean ) > 1e-4 * DEVIATIONS[0] ||
+       covariance( 1, 1 ) != 0.0 ||
+       std::fabs( covariance( 0, 0 ) / expectedVariance - 1.0 ) > 1e-3 ) {
+    std::cerr << "Approximation after swapping has mean "
+              << sampler.GetMean()[0] << " and variance " << covariance( 0, 0 )
+              << ", expected " << expectedMean << " and " << expectedVariance
+              << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // When the priors are far narrower than the approximation, no draw
+  // lands inside them, and the sample is the maximum instead.
+  madai::CorrelatedGaussianModel narrowModel(
+    std::vector< double >( 2, 0.0 ), std::vector< double >( 2, 1.0 ) );
+  narrowModel.SetPriorBounds( -1e-4, 1e-4 );
+  madai::LaplaceApproximationSampler narrowSampler;
+  narrowSampler.ReseedRandomNumberGenerator( 42 );
+  narrowSampler.SetModel( &narrowModel );
+  for ( unsigned int s = 0; s < 10; ++s ) {
+    sample = narrowSampler.NextSample();
+    if ( sample.m_ParameterValues != narrowSampler.GetMean() ||
+         !( sample.m_LogLikelihood > -1.0 ) ) {
+      std::cerr << "Sample outside the priors at " << sample.m_ParameterValues[0]
+                << ", " << sample.m_ParameterValues[1]
+                << " with log likelihood " << sample.m_LogLikelihood << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
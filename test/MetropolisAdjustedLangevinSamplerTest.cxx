@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "CorrelatedGaussianModel.h"
+#include "MetropolisAdjustedLangevinSampler.h"
+
+
+static const unsigned int NUMBER_OF_PARAMETERS = 3;
+static const double MEANS[NUMBER_OF_PARAMETERS] = { 1.0, -2.0, 30.0 };
+static const double DEVIATIONS[NUMBER_OF_PARAMETERS] = { 0.5, 2.0, 10.0 };
+
+
+/** \class Gaussian test model that counts its evaluations. */
+class CountingGaussianModel : public madai::CorrelatedGaussianModel {
+public:
+  CountingGaussianModel() :
+    madai::CorrelatedGaussianModel(
+      std::vector< double >( MEANS, MEANS + NUMBER_OF_PARAMETERS ),
+      std::vector< double >( DEVIATIONS, DEVIATIONS + NUMBER_OF_PARAMETERS ) ),
+    m_NumberOfEvaluations( 0 ),
+    m_NumberOfGradientEvaluations( 0 )
+  {
+  }
+
+  virtual ErrorType GetScalarOutputs( const std::vector< double > & parameters,
+                                      std::vector< double > & scalars ) const
+  {
+    ++m_NumberOfEvaluations;
+    return madai::CorrelatedGaussianModel::GetScalarOutputs( parameters, scalars );
+  }
+
+  virtual ErrorType GetScalarOutputsAndLogLikelihoodAndGradient(
+    const std::vector< double > & parameters,
+    const std::vector< bool > & activeParameters,
+    std::vector< double > & scalars,
+    double & logLikelihood,
+    std::vector< double > & gradient ) const
+  {
+    ++m_NumberOfGradientEvaluations;
+    return madai::CorrelatedGaussianModel::GetScalarOutputsAndLogLikelihoodAndGradient(
+      parameters, activeParameters, scalars, logLikelihood, gradient );
+  }
+
+  /** The counters are not thread safe. */
+  virtual bool SupportsConcurrentEvaluation() const
+  {
+    return false;
+  }
+
+  mutable unsigned long int m_NumberOfEvaluations;
+  mutable unsigned long int m_NumberOfGradientEvaluations;
+};
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_BURN_IN_SAMPLES = 2000;
+  static const unsigned int NUMBER_OF_SAMPLES = 40000;
+
+  CountingGaussianModel model;
+
+  madai::MetropolisAdjustedLangevinSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  sampler.SetStepSize( 0.1 );
+  sampler.SetNumberOfAdaptationSamples( NUMBER_OF_BURN_IN_SAMPLES );
+
+  for ( unsigned int i = 0; i < NUMBER_OF_BURN_IN_SAMPLES; ++i ) {
+    sampler.NextSample();
+  }
+
+  // Each step evaluates the Model once, at the proposal.
+  model.m_NumberOfEvaluations = 0;
+  model.m_NumberOfGradientEvaluations = 0;
+  double sum[NUMBER_OF_PARAMETERS] = { 0.0, 0.0, 0.0 };
+  double sumOfSquares[NUMBER_OF_PARAMETERS] = { 0.0, 0.0, 0.0 };
+  for ( unsigned int i = 0; i < NUMBER_OF_SAMPLES; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    for ( unsigned int j = 0; j < NUMBER_OF_PARAMETERS; ++j ) {
+      sum[j] += sample.m_ParameterValues[j];
+      sumOfSquares[j] += sample.m_ParameterValues[j] * sample.m_ParameterValues[j];
+    }
+  }
+  if ( model.m_NumberOfGradientEvaluations != NUMBER_OF_SAMPLES ||
+       model.m_NumberOfEvaluations != NUMBER_OF_SAMPLES ) {
+    std::cerr << "Model was evaluated " << model.m_NumberOfEvaluations
+              << " times, with the gradient "
+              << model.m_NumberOfGradientEvaluations << " times, for "
+              << NUMBER_OF_SAMPLES << " samples\n";
+    return EXIT_FAILURE;
+  }
+
+  // The Metropolis correction makes the chain sample the posterior.
+  for ( unsigned int j = 0; j < NUMBER_OF_PARAMETERS; ++j ) {
+    double mean = sum[j] / NUMBER_OF_SAMPLES;
+    double deviation = std::sqrt( sumOfSquares[j] / NUMBER_OF_SAMPLES - mean * mean );
+    if ( std::fabs( mean - MEANS[j] ) > 0.1 * DEVIATIONS[j] ||
+         std::fabs( deviation / DEVIATIONS[j] - 1.0 ) > 0.1 ) {
+      std::cerr << "Parameter " << j << " has mean " << mean
+                << " and standard deviation " << deviation << ", expected "
+                << MEANS[j] << " and " << DEVIATIONS[j] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  double acceptanceRate = sampler.GetAcceptanceRate();
+  if ( std::fabs( acceptanceRate - sampler.GetTargetAcceptanceRate() ) > 0.1 ) {
+    std::cerr << "Acceptance rate " << acceptanceRate << " is far from the "
+              << "target " << sampler.GetTargetAcceptanceRate() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // An inactive parameter stays where it was put.
+  sampler.SetParameterValue( "Z", 25.0 );
+  sampler.DeactivateParameter( "Z" );
+  for ( unsigned int i = 0; i < 1000; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( sample.m_ParameterValues[2] != 25.0 ) {
+      std::cerr << "Inactive parameter moved to "
+                << sample.m_ParameterValues[2] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Swapping which parameter is inactive keeps the number of active
+  // parameters, but the new inactive one must stay put too.
+  double y = sampler.GetParameterValue( "Y" );
+  sampler.ActivateParameter( "Z" );
+  sampler.DeactivateParameter( "Y" );
+  for ( unsigned int i = 0; i < 1000; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( sample.m_ParameterValues[1] != y ) {
+      std::cerr << "Parameter deactivated in a swap moved to "
+                << sample.m_ParameterValues[1] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -40,5 +40,35 @@ int main( int, char *[] )
     std::cout << sample << "\n";
   }
 
+  // Prefetching several steps at once must give the serial chain.
+  madai::MetropolisHastingsSampler serialSampler;
+  madai::MetropolisHastingsSampler speculativeSampler;
+  serialSampler.ReseedRandomNumberGenerator( 42 );
+  speculativeSampler.ReseedRandomNumberGenerator( 42 );
+  serialSampler.SetModel( &model );
+  speculativeSampler.SetModel( &model );
+  serialSampler.SetStepSize( 0.5 );
+  speculativeSampler.SetStepSize( 0.5 );
+  speculativeSampler.SetSpeculativeDepth( 4 );
+  if ( speculativeSampler.GetSpeculativeDepth() != 4 ) {
+    std::cerr << "Speculative depth was not set\n";
+    return EXIT_FAILURE;
+  }
+  for ( int i = 0; i < 200; ++i ) {
+    if ( i == 100 ) {
+      // Moving the chain between batches keeps the chains equal.
+      serialSampler.SetParameterValue( "X", 22.0 );
+      speculativeSampler.SetParameterValue( "X", 22.0 );
+    }
+    madai::Sample serialSample = serialSampler.NextSample();
+    madai::Sample speculativeSample = speculativeSampler.NextSample();
+    if ( !( serialSample == speculativeSample ) ) {
+      std::cerr << "Speculative sample " << i << " differs from the serial "
+                << "chain:\n" << serialSample << "\n" << speculativeSample
+                << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,220 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MetropolisWithinGibbsSampler.h"
+#include "UniformDistribution.h"
+
+
+static const unsigned int NUMBER_OF_PARAMETERS = 3;
+static const double MEANS[NUMBER_OF_PARAMETERS] = { 1.0, -2.0, 0.0 };
+// Poorly scaled: one global step size cannot suit all parameters.
+static const double DEVIATIONS[NUMBER_OF_PARAMETERS] = { 0.01, 3.0, 0.5 };
+
+
+/** \class Model whose outputs are its parameters, observed at MEANS
+ * with standard deviations DEVIATIONS. It keeps the point of the last
+ * evaluation in an EvaluationCache and checks that partial updates
+ * change only the parameters they claim to. */
+class CachingGaussianModel : public madai::Model {
+public:
+  class PointCache : public madai::Model::EvaluationCache {
+  public:
+    std::vector< double > m_Parameters;
+  };
+
+  CachingGaussianModel() :
+    m_NumberOfPartialUpdates( 0 ),
+    m_NumberOfWrongPartialUpdates( 0 )
+  {
+    madai::UniformDistribution prior;
+    prior.SetMinimum( -10.0 );
+    prior.SetMaximum( 10.0 );
+    this->AddParameter( "X", prior );
+    this->AddParameter( "Y", prior );
+    this->AddParameter( "Z", prior );
+    this->AddScalarOutputName( "X" );
+    this->AddScalarOutputName( "Y" );
+    this->AddScalarOutputName( "Z" );
+
+    m_ObservedScalarValues.assign( MEANS, MEANS + NUMBER_OF_PARAMETERS );
+    m_ObservedScalarCovariance.assign(
+      NUMBER_OF_PARAMETERS * NUMBER_OF_PARAMETERS, 0.0 );
+    for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+      m_ObservedScalarCovariance[ i * ( NUMBER_OF_PARAMETERS + 1 ) ] =
+        DEVIATIONS[i] * DEVIATIONS[i];
+    }
+    m_StateFlag = READY;
+  }
+
+  virtual ErrorType GetScalarOutputs( const std::vector< double > & parameters,
+                                      std::vector< double > & scalars ) const
+  {
+    scalars = parameters;
+    return NO_ERROR;
+  }
+
+  virtual EvaluationCache * NewEvaluationCache() const
+  {
+    return new PointCache;
+  }
+
+  virtual ErrorType GetScalarOutputsAndLogLikelihoodOfPartialUpdate(
+    const std::vector< double > & parameters,
+    const std::vector< unsigned int > & changedParameters,
+    const EvaluationCache * previous,
+    EvaluationCache * current,
+    std::vector< double > & scalars,
+    double & logLikelihood ) const
+  {
+    const PointCache * previousPoint = dynamic_cast< const PointCache * >( previous );
+    if ( previousPoint != NULL ) {
+      ++m_NumberOfPartialUpdates;
+      std::vector< bool > changed( parameters.size(), false );
+      for ( unsigned int k = 0; k < changedParameters.size(); ++k ) {
+        changed[ changedParameters[k] ] = true;
+      }
+      for ( unsigned int i = 0; i < parameters.size(); ++i ) {
+        if ( !changed[i] && parameters[i] != previousPoint->m_Parameters[i] ) {
+          ++m_NumberOfWrongPartialUpdates;
+          break;
+        }
+      }
+    }
+    PointCache * currentPoint = dynamic_cast< PointCache * >( current );
+    if ( currentPoint != NULL ) {
+      currentPoint->m_Parameters = parameters;
+    }
+    return this->GetScalarOutputsAndLogLikelihood( parameters, scalars,
+                                                   logLikelihood );
+  }
+
+  mutable unsigned long int m_NumberOfPartialUpdates;
+  mutable unsigned long int m_NumberOfWrongPartialUpdates;
+};
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_BURN_IN_SAMPLES = 2000;
+  static const unsigned int NUMBER_OF_SAMPLES = 30000;
+
+  CachingGaussianModel model;
+
+  madai::MetropolisWithinGibbsSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  sampler.SetStepSize( 0.1 );
+  sampler.SetNumberOfAdaptationSamples( NUMBER_OF_BURN_IN_SAMPLES );
+
+  for ( unsigned int i = 0; i < NUMBER_OF_BURN_IN_SAMPLES; ++i ) {
+    sampler.NextSample();
+  }
+
+  // The adapted step sizes follow the widths of the posterior.
+  if ( sampler.GetParameterStepSize( 1 ) < 50.0 * sampler.GetParameterStepSize( 0 ) ) {
+    std::cerr << "Step sizes " << sampler.GetParameterStepSize( 0 ) << " and "
+              << sampler.GetParameterStepSize( 1 )
+              << " were not adapted to the posterior\n";
+    return EXIT_FAILURE;
+  }
+
+  double sum[NUMBER_OF_PARAMETERS] = { 0.0, 0.0, 0.0 };
+  double sumOfSquares[NUMBER_OF_PARAMETERS] = { 0.0, 0.0, 0.0 };
+  for ( unsigned int i = 0; i < NUMBER_OF_SAMPLES; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    for ( unsigned int j = 0; j < NUMBER_OF_PARAMETERS; ++j ) {
+      sum[j] += sample.m_ParameterValues[j];
+      sumOfSquares[j] += sample.m_ParameterValues[j] * sample.m_ParameterValues[j];
+    }
+  }
+  for ( unsigned int j = 0; j < NUMBER_OF_PARAMETERS; ++j ) {
+    double mean = sum[j] / NUMBER_OF_SAMPLES;
+    double deviation = std::sqrt( sumOfSquares[j] / NUMBER_OF_SAMPLES - mean * mean );
+    if ( std::fabs( mean - MEANS[j] ) > 0.1 * DEVIATIONS[j] ||
+         std::fabs( deviation / DEVIATIONS[j] - 1.0 ) > 0.1 ) {
+      std::cerr << "Parameter " << j << " has mean " << mean
+                << " and standard deviation " << deviation << ", expected "
+                << MEANS[j] << " and " << DEVIATIONS[j] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+  double acceptanceRate = sampler.GetAcceptanceRate();
+  if ( std::fabs( acceptanceRate - sampler.GetTargetAcceptanceRate() ) > 0.1 ) {
+    std::cerr << "Acceptance rate " << acceptanceRate << " is far from the "
+              << "target " << sampler.GetTargetAcceptanceRate() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // Every update told the Model which parameters changed.
+  if ( model.m_NumberOfPartialUpdates <
+       NUMBER_OF_PARAMETERS * ( NUMBER_OF_BURN_IN_SAMPLES + NUMBER_OF_SAMPLES ) ) {
+    std::cerr << "Only " << model.m_NumberOfPartialUpdates
+              << " evaluations were partial updates\n";
+    return EXIT_FAILURE;
+  }
+  if ( model.m_NumberOfWrongPartialUpdates != 0 ) {
+    std::cerr << model.m_NumberOfWrongPartialUpdates << " partial updates "
+              << "changed parameters they did not list\n";
+    return EXIT_FAILURE;
+  }
+
+  // Blocks of parameters.
+  std::vector< std::string > block;
+  block.push_back( "X" );
+  block.push_back( "W" );
+  if ( sampler.AddParameterBlock( block ) == madai::Sampler::NO_ERROR ) {
+    std::cerr << "AddParameterBlock accepted an unknown parameter\n";
+    return EXIT_FAILURE;
+  }
+  block[1] = "Y";
+  if ( sampler.AddParameterBlock( block ) != madai::Sampler::NO_ERROR ) {
+    std::cerr << "Error in AddParameterBlock\n";
+    return EXIT_FAILURE;
+  }
+  if ( sampler.AddParameterBlock( std::vector< std::string >( 1, "Y" ) ) ==
+       madai::Sampler::NO_ERROR ) {
+    std::cerr << "AddParameterBlock accepted a parameter in two blocks\n";
+    return EXIT_FAILURE;
+  }
+
+  // An inactive parameter stays where it was put.
+  sampler.SetParameterValue( "Z", 0.25 );
+  sampler.DeactivateParameter( "Z" );
+  model.m_NumberOfWrongPartialUpdates = 0;
+  for ( unsigned int i = 0; i < 1000; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( sample.m_ParameterValues[2] != 0.25 ) {
+      std::cerr << "Inactive parameter moved to "
+                << sample.m_ParameterValues[2] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+  if ( model.m_NumberOfWrongPartialUpdates != 0 ) {
+    std::cerr << model.m_NumberOfWrongPartialUpdates << " block updates "
+              << "changed parameters they did not list\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -16,8 +16,10 @@
  *
  *=========================================================================*/
 
+#include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
 
 #include "Model.h"
 #include "UniformDistribution.h"
@@ -48,6 +50,18 @@ public:
 
   virtual ~TestModel() {}
 
+  /** Replace the prior of a parameter without updating the compiled
+   * prior, as a subclass might. */
+  void ReplacePrior( unsigned int i, double minimum, double maximum )
+  {
+    m_Parameters[i] = madai::Parameter( m_Parameters[i].m_Name, minimum, maximum );
+  }
+
+  void UpdatePriors()
+  {
+    this->UpdateCompiledPrior();
+  }
+
   virtual Model::ErrorType GetScalarOutputs( const std::vector< double > &,
                                              std::vector< double > & ) const
   {
@@ -110,6 +124,12 @@ int main( int, char *[] )
     return EXIT_FAILURE;
   }
 
+  if ( model->SupportsConcurrentEvaluation() ) {
+    std::cerr << "Model should not support concurrent evaluation by default"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
   double h = 1.13;
   model->SetGradientEstimateStepSize( h );
   double retrievedH = model->GetGradientEstimateStepSize();
@@ -161,6 +181,40 @@ int main( int, char *[] )
     return EXIT_FAILURE;
   }
 
+  // A prior replaced in place is used even before the compiled prior
+  // is rebuilt, also when it is replaced twice.
+  TestModel priorModel;
+  priorModel.ReplacePrior( 0, -1.0, 1.0 );
+  priorModel.ReplacePrior( 1, 0.0, 1.0 );
+  std::vector< double > point( 3, 0.5 );
+  double logPrior = priorModel.GetLogPriorLikelihood( point );
+  if ( std::fabs( logPrior + std::log( 2.0 ) ) > 1e-12 ) {
+    std::cerr << "Log prior " << logPrior << " after replacing priors, "
+              << "expected " << -std::log( 2.0 ) << std::endl;
+    return EXIT_FAILURE;
+  }
+  priorModel.ReplacePrior( 2, 0.0, 0.25 );
+  logPrior = priorModel.GetLogPriorLikelihood( point );
+  if ( logPrior != -std::numeric_limits< double >::infinity() ) {
+    std::cerr << "Log prior " << logPrior << " outside a replaced prior"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  priorModel.ReplacePrior( 2, 0.0, 4.0 );
+  logPrior = priorModel.GetLogPriorLikelihood( point );
+  if ( std::fabs( logPrior + std::log( 8.0 ) ) > 1e-12 ||
+       priorModel.GetCompiledPrior().IsCompiledFrom( priorModel.GetParameters() ) ) {
+    std::cerr << "Log prior " << logPrior << " after replacing a prior twice, "
+              << "expected " << -std::log( 8.0 ) << std::endl;
+    return EXIT_FAILURE;
+  }
+  priorModel.UpdatePriors();
+  if ( !priorModel.GetCompiledPrior().IsCompiledFrom( priorModel.GetParameters() ) ||
+       priorModel.GetLogPriorLikelihood( point ) != logPrior ) {
+    std::cerr << "Rebuilt compiled prior is not used or differs" << std::endl;
+    return EXIT_FAILURE;
+  }
+
   std::cout << "ModelTest passed" << std::endl;
 
   return EXIT_SUCCESS;
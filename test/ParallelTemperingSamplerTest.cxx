@@ -0,0 +1,191 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ParallelTemperingSampler.h"
+#include "UniformDistribution.h"
+
+
+static const double MODE = 5.0;
+static const double WIDTH = 0.5;
+
+
+/** \class Model with two well separated modes at X = -MODE and
+ * X = MODE, and a standard Gaussian in Y. */
+class BimodalModel : public madai::Model {
+public:
+  BimodalModel()
+  {
+    madai::UniformDistribution prior;
+    prior.SetMinimum( -20.0 );
+    prior.SetMaximum( 20.0 );
+    this->AddParameter( "X", prior );
+    this->AddParameter( "Y", prior );
+    this->AddScalarOutputName( "X" );
+    this->AddScalarOutputName( "Y" );
+    m_StateFlag = READY;
+  }
+
+  virtual ErrorType GetScalarOutputs( const std::vector< double > & parameters,
+                                      std::vector< double > & scalars ) const
+  {
+    scalars = parameters;
+    return NO_ERROR;
+  }
+
+  virtual ErrorType GetScalarOutputsAndLogLikelihood(
+    const std::vector< double > & parameters,
+    std::vector< double > & scalars,
+    double & logLikelihood ) const
+  {
+    scalars = parameters;
+    double left = ( parameters[0] + MODE ) / WIDTH;
+    double right = ( parameters[0] - MODE ) / WIDTH;
+    logLikelihood =
+      std::log( std::exp( -0.5 * left * left ) + std::exp( -0.5 * right * right ) )
+      - 0.5 * parameters[1] * parameters[1]
+      + this->GetLogPriorLikelihood( parameters );
+    return NO_ERROR;
+  }
+
+  virtual bool SupportsConcurrentEvaluation() const
+  {
+    return true;
+  }
+};
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_TEMPERATURES = 6;
+  static const unsigned int NUMBER_OF_BURN_IN_SAMPLES = 2000;
+  static const unsigned int NUMBER_OF_SAMPLES = 10000;
+
+  BimodalModel model;
+
+  madai::ParallelTemperingSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  sampler.SetNumberOfTemperatures( NUMBER_OF_TEMPERATURES );
+  sampler.SetMaximumTemperature( 200.0 );
+  sampler.SetStepSize( 0.05 );
+  sampler.SetNumberOfAdaptationSamples( NUMBER_OF_BURN_IN_SAMPLES );
+
+  std::vector< double > temperatures = sampler.GetTemperatures();
+  if ( temperatures.size() != NUMBER_OF_TEMPERATURES ||
+       std::fabs( temperatures[0] - 1.0 ) > 1e-12 ||
+       std::fabs( temperatures.back() - 200.0 ) > 1e-9 ) {
+    std::cerr << "Initial ladder should run from 1 to 200\n";
+    return EXIT_FAILURE;
+  }
+
+  for ( unsigned int i = 0; i < NUMBER_OF_BURN_IN_SAMPLES; ++i ) {
+    sampler.NextSample();
+  }
+  if ( sampler.IsAdapting() ) {
+    std::cerr << "Sampler should stop adapting after the burn-in\n";
+    return EXIT_FAILURE;
+  }
+
+  // The adapted ladder keeps its ends and stays increasing.
+  temperatures = sampler.GetTemperatures();
+  if ( temperatures[0] != 1.0 ||
+       std::fabs( temperatures.back() - 200.0 ) > 1e-9 ) {
+    std::cerr << "Adaptation moved the ends of the ladder\n";
+    return EXIT_FAILURE;
+  }
+  for ( unsigned int k = 1; k < temperatures.size(); ++k ) {
+    if ( !( temperatures[k] > temperatures[k - 1] ) ) {
+      std::cerr << "Temperatures are not increasing\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The cold chain must visit both modes in equal proportion.
+  unsigned int numberOfRightSamples = 0;
+  double sumOfDistances = 0.0;
+  double sumOfSquaresY = 0.0;
+  for ( unsigned int i = 0; i < NUMBER_OF_SAMPLES; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    double x = sample.m_ParameterValues[0];
+    double y = sample.m_ParameterValues[1];
+    if ( x > 0.0 ) {
+      ++numberOfRightSamples;
+    }
+    sumOfDistances += std::fabs( std::fabs( x ) - MODE );
+    sumOfSquaresY += y * y;
+  }
+  double rightFraction =
+    static_cast< double >( numberOfRightSamples ) / NUMBER_OF_SAMPLES;
+  if ( rightFraction < 0.35 || rightFraction > 0.65 ) {
+    std::cerr << "Fraction of samples in the right mode is " << rightFraction
+              << ", expected 0.5\n";
+    return EXIT_FAILURE;
+  }
+  double meanDistance = sumOfDistances / NUMBER_OF_SAMPLES;
+  double expectedDistance = WIDTH * std::sqrt( 2.0 / M_PI );
+  if ( std::fabs( meanDistance / expectedDistance - 1.0 ) > 0.15 ) {
+    std::cerr << "Mean distance from the modes is " << meanDistance
+              << ", expected " << expectedDistance << "\n";
+    return EXIT_FAILURE;
+  }
+  double deviationY = std::sqrt( sumOfSquaresY / NUMBER_OF_SAMPLES );
+  if ( std::fabs( deviationY - 1.0 ) > 0.15 ) {
+    std::cerr << "Standard deviation of Y is " << deviationY
+              << ", expected 1\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector< double > rates = sampler.GetSwapAcceptanceRates();
+  if ( rates.size() != NUMBER_OF_TEMPERATURES - 1 ) {
+    std::cerr << "Expected one swap rate per pair of neighbours\n";
+    return EXIT_FAILURE;
+  }
+  for ( unsigned int k = 0; k < rates.size(); ++k ) {
+    if ( rates[k] < 0.05 ) {
+      std::cerr << "Swaps between chains " << k << " and " << k + 1
+                << " are rarely accepted (" << rates[k] << ")\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::ostringstream progress;
+  sampler.WriteProgress( progress );
+  if ( progress.str().find( "Swap rates:" ) == std::string::npos ) {
+    std::cerr << "Progress output lacks the swap rates\n";
+    return EXIT_FAILURE;
+  }
+
+  // Setting an inactive parameter sets it in every chain.
+  sampler.DeactivateParameter( "Y" );
+  sampler.SetParameterValue( "Y", 0.5 );
+  for ( unsigned int i = 0; i < 100; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( sample.m_ParameterValues[1] != 0.5 ) {
+      std::cerr << "Inactive parameter changed\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
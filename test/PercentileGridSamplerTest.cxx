@@ -19,6 +19,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <vector>
 
 #include "Gaussian2DModel.h"
 #include "PercentileGridSampler.h"
@@ -43,6 +44,28 @@ int main( int, char *[] )
     return EXIT_FAILURE;
   }
 
+  // Check that the grid can be entered at any index.
+  std::vector< madai::Sample > grid;
+  for ( unsigned int i = 0; i < actualNumberOfSamples; ++i ) {
+    if ( sampler.GetIndex() != i ) {
+      std::cerr << "Expected index " << i << " but got "
+                << sampler.GetIndex() << "\n";
+      return EXIT_FAILURE;
+    }
+    grid.push_back( sampler.NextSample() );
+  }
+  unsigned int indices[3] = { 5, 15, 3 + actualNumberOfSamples };
+  for ( unsigned int i = 0; i < 3; ++i ) {
+    sampler.SetIndex( indices[i] );
+    madai::Sample sample = sampler.NextSample();
+    if ( !( sample == grid[ indices[i] % actualNumberOfSamples ] ) ) {
+      std::cerr << "Sample at index " << indices[i]
+                << " differs from the one in the grid\n";
+      return EXIT_FAILURE;
+    }
+  }
+  sampler.SetIndex( 0 );
+
   // Check that parameter activation/deactivation results in the right
   // number of samples.
   sampler.DeactivateParameter( "X" );
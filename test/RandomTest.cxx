@@ -16,8 +16,11 @@
  *
  *=========================================================================*/
 
+#include <cmath> // std::fabs, std::ldexp, std::sqrt
 #include <cstdlib> // EXIT_SUCCESS
 #include <iostream>
+#include <sstream>
+#include <vector>
 #include "Random.h"
 using std::cout;
 
@@ -47,5 +50,105 @@ int main( int, char *[] ) {
   r2.Reseed();
   test(r2);
 
+  // Philox4x32-10 of a zero counter and key starts with the words
+  // 0x6627e8d5 0xe169c58d (Salmon et al. 2011), the high 53 bits of
+  // which make the first Uniform() of seed 0.
+  madai::Random zero(0);
+  if ( zero.Uniform() != std::ldexp( 0x6627e8d5e169c58dULL >> 11, -53 ) ) {
+    std::cerr << "Seed 0 does not start with the Philox known answer\n";
+    return EXIT_FAILURE;
+  }
+
+  // Bulk draws are the single draws, from any position.
+  madai::Random single(SEED), bulk(SEED);
+  single.Uniform();
+  bulk.Uniform();
+  std::vector< double > values(7);
+  for ( int round = 0; round < 3; ++round ) {
+    bulk.FillUniform(&values[0], 7);
+    for ( unsigned int i = 0; i < values.size(); ++i ) {
+      if ( values[i] != single.Uniform() ) {
+        std::cerr << "FillUniform differs from Uniform\n";
+        return EXIT_FAILURE;
+      }
+    }
+    bulk.FillGaussian(&values[0], 7);
+    for ( unsigned int i = 0; i < values.size(); ++i ) {
+      if ( values[i] != single.Gaussian() ) {
+        std::cerr << "FillGaussian differs from Gaussian\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // JumpAhead skips numbers as Uniform() would.
+  madai::Random walker(SEED), jumper(SEED);
+  for ( int i = 0; i < 1001; ++i ) {
+    walker.Uniform();
+  }
+  jumper.JumpAhead(1001);
+  if ( walker.Uniform() != jumper.Uniform() ) {
+    std::cerr << "JumpAhead differs from drawing\n";
+    return EXIT_FAILURE;
+  }
+
+  // Streams are reproducible, and differ from each other and from the
+  // sequence of the seed.
+  madai::Random master(SEED), stream1a, stream1b, stream2;
+  master.Uniform();
+  master.Split(1, stream1a);
+  master.Reseed(SEED);
+  master.Split(1, stream1b);
+  master.Split(2, stream2);
+  double first = stream1a.Uniform();
+  if ( first != stream1b.Uniform() ) {
+    std::cerr << "A stream is not reproducible\n";
+    return EXIT_FAILURE;
+  }
+  if ( first == stream2.Uniform() || first == master.Uniform() ) {
+    std::cerr << "Streams are not distinct\n";
+    return EXIT_FAILURE;
+  }
+
+  // Independent streams have uncorrelated Gaussians of unit variance.
+  const int NUMBER_OF_DRAWS = 100000;
+  double sum1 = 0.0, sum2 = 0.0, sum12 = 0.0, sum11 = 0.0;
+  for ( int i = 0; i < NUMBER_OF_DRAWS; ++i ) {
+    double g1 = stream1a.Gaussian(), g2 = stream2.Gaussian();
+    sum1 += g1;
+    sum2 += g2;
+    sum11 += g1 * g1;
+    sum12 += g1 * g2;
+  }
+  double n = static_cast< double >( NUMBER_OF_DRAWS );
+  double tolerance = 5.0 / std::sqrt( n );
+  if ( std::fabs( sum1 / n ) > tolerance ||
+       std::fabs( sum2 / n ) > tolerance ||
+       std::fabs( sum11 / n - 1.0 ) > 2.0 * tolerance ||
+       std::fabs( sum12 / n ) > tolerance ) {
+    std::cerr << "Moments of the streams are off: " << sum1 / n << ' '
+              << sum2 / n << ' ' << sum11 / n << ' ' << sum12 / n << '\n';
+    return EXIT_FAILURE;
+  }
+
+  // The state continues the sequence, including a Gaussian held back
+  // from a pair and numbers drawn after it.
+  stream1a.Gaussian();
+  stream1a.Uniform();
+  std::stringstream state;
+  stream1a.WriteState(state);
+  madai::Random restored;
+  if ( !restored.ReadState(state) ) {
+    std::cerr << "Could not read the state\n";
+    return EXIT_FAILURE;
+  }
+  for ( int i = 0; i < 5; ++i ) {
+    if ( restored.Gaussian() != stream1a.Gaussian() ||
+         restored.Integer(1000) != stream1a.Integer(1000) ) {
+      std::cerr << "Restored generator differs\n";
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 }
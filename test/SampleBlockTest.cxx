@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "AdaptiveMetropolisSampler.h"
+#include "Gaussian2DModel.h"
+#include "HamiltonianMonteCarloSampler.h"
+#include "MetropolisHastingsSampler.h"
+#include "SampleBlock.h"
+
+
+static const unsigned int NUMBER_OF_BLOCKS = 20;
+static const unsigned int BLOCK_SIZE = 50;
+
+
+/** Check that NextSamples() returns the Samples that NextSample()
+ * returns for a Sampler with the same seed, and that a Sample is
+ * flagged as accepted exactly when it moved the chain. */
+bool CheckNextSamples( const std::string & name,
+                       madai::Model & model,
+                       madai::Sampler & sampler,
+                       madai::Sampler & blockSampler )
+{
+  sampler.ReseedRandomNumberGenerator( 1234 );
+  sampler.SetModel( &model );
+  blockSampler.ReseedRandomNumberGenerator( 1234 );
+  blockSampler.SetModel( &model );
+
+  madai::SampleBlock block;
+  madai::Sample previous( sampler.GetCurrentParameters() );
+  unsigned int numberOfAccepted = 0;
+  for ( unsigned int b = 0; b < NUMBER_OF_BLOCKS; ++b ) {
+    // Vary the size of the block to exercise the reuse of storage.
+    unsigned int size = ( b % 2 == 0 ) ? BLOCK_SIZE : BLOCK_SIZE / 2;
+    blockSampler.NextSamples( size, block );
+    if ( block.GetNumberOfSamples() != size ||
+         block.GetNumberOfParameters() != model.GetNumberOfParameters() ||
+         block.GetNumberOfOutputs() != model.GetNumberOfScalarOutputs() ) {
+      std::cerr << name << ": block has the wrong size\n";
+      return false;
+    }
+    for ( unsigned int i = 0; i < size; ++i ) {
+      madai::Sample expected = sampler.NextSample();
+      madai::Sample sample;
+      block.GetSample( i, sample );
+      if ( sample.m_ParameterValues != expected.m_ParameterValues ||
+           sample.m_OutputValues != expected.m_OutputValues ||
+           sample.m_LogLikelihood != expected.m_LogLikelihood ) {
+        std::cerr << name << ": sample " << i << " of block " << b
+                  << " differs from NextSample()\n";
+        return false;
+      }
+      bool moved = ( expected.m_ParameterValues != previous.m_ParameterValues );
+      if ( block.IsAccepted( i ) != moved ) {
+        std::cerr << name << ": sample " << i << " of block " << b
+                  << " is flagged " << ( moved ? "rejected" : "accepted" )
+                  << "\n";
+        return false;
+      }
+      numberOfAccepted += moved ? 1 : 0;
+      previous = expected;
+    }
+  }
+  if ( numberOfAccepted == 0 ) {
+    std::cerr << name << ": no step was accepted\n";
+    return false;
+  }
+  return true;
+}
+
+
+int main( int, char *[] )
+{
+  madai::Gaussian2DModel model;
+
+  // A Sample survives the trip through a block.
+  madai::SampleBlock block;
+  block.Resize( 3, 2, 1 );
+  std::vector< double > parameters( 2, 1.5 );
+  std::vector< double > outputs( 1, -2.0 );
+  madai::Sample sample( parameters, outputs, -3.25 );
+  block.SetSample( 1, sample, true );
+  madai::Sample copy;
+  block.GetSample( 1, copy );
+  if ( copy.m_ParameterValues != parameters ||
+       copy.m_OutputValues != outputs ||
+       copy.m_LogLikelihood != -3.25 ||
+       copy.m_LogLikelihoodValueGradient != std::vector< double >( 1, 0.0 ) ||
+       !block.IsAccepted( 1 ) ) {
+    std::cerr << "Sample changed in the block\n";
+    return EXIT_FAILURE;
+  }
+
+  madai::MetropolisHastingsSampler mhs, mhsBlock;
+  mhs.SetStepSize( 0.5 );
+  mhsBlock.SetStepSize( 0.5 );
+  if ( !CheckNextSamples( "MetropolisHastingsSampler", model, mhs, mhsBlock ) ) {
+    return EXIT_FAILURE;
+  }
+
+  madai::MetropolisHastingsSampler speculative, speculativeBlock;
+  speculative.SetStepSize( 0.5 );
+  speculative.SetSpeculativeDepth( 3 );
+  speculativeBlock.SetStepSize( 0.5 );
+  speculativeBlock.SetSpeculativeDepth( 3 );
+  if ( !CheckNextSamples( "Speculative MetropolisHastingsSampler",
+                          model, speculative, speculativeBlock ) ) {
+    return EXIT_FAILURE;
+  }
+
+  madai::AdaptiveMetropolisSampler ams, amsBlock;
+  if ( !CheckNextSamples( "AdaptiveMetropolisSampler", model, ams, amsBlock ) ) {
+    return EXIT_FAILURE;
+  }
+
+  // The default NextSamples() of the Sampler base class.
+  madai::HamiltonianMonteCarloSampler hmcs, hmcsBlock;
+  if ( !CheckNextSamples( "HamiltonianMonteCarloSampler",
+                          model, hmcs, hmcsBlock ) ) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
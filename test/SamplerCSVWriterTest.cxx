@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AdaptiveMetropolisSampler.h"
+#include "ConvergenceMonitor.h"
+#include "Gaussian2DModel.h"
+#include "HamiltonianMonteCarloSampler.h"
+#include "MetropolisHastingsSampler.h"
+#include "SamplerCSVWriter.h"
+
+
+static const int NUMBER_OF_CHAINS = 3;
+static const int NUMBER_OF_SAMPLES = 250;
+static const int NUMBER_OF_BURN_IN_SAMPLES = 20;
+static const int MAXIMUM_NUMBER_OF_BURN_IN_SAMPLES = 100000;
+
+
+/** Split the text of a trace into lines. */
+std::vector< std::string > GetLines( const std::string & text )
+{
+  std::vector< std::string > lines;
+  std::istringstream stream( text );
+  std::string line;
+  while ( std::getline( stream, line ) ) {
+    lines.push_back( line );
+  }
+  return lines;
+}
+
+
+/** Run the chains with fixed seeds and return the traces. */
+bool RunChains( madai::Model & model,
+                bool interleave,
+                std::vector< std::string > & traces )
+{
+  std::vector< madai::MetropolisHastingsSampler * > samplers;
+  std::vector< madai::Sampler * > samplerPointers;
+  for ( int chain = 0; chain < NUMBER_OF_CHAINS; ++chain ) {
+    madai::MetropolisHastingsSampler * sampler =
+      new madai::MetropolisHastingsSampler;
+    sampler->ReseedRandomNumberGenerator( 1234 + chain );
+    sampler->SetStepSize( 0.5 );
+    samplers.push_back( sampler );
+    samplerPointers.push_back( sampler );
+  }
+
+  int numberOfStreams = interleave ? 1 : NUMBER_OF_CHAINS;
+  std::vector< std::ostringstream * > streams;
+  std::vector< std::ostream * > streamPointers;
+  for ( int i = 0; i < numberOfStreams; ++i ) {
+    streams.push_back( new std::ostringstream );
+    streamPointers.push_back( streams.back() );
+  }
+
+  int returnCode = madai::SamplerCSVWriter::GenerateSamplesAndSaveToFiles(
+    samplerPointers, model, streamPointers,
+    NUMBER_OF_SAMPLES, NUMBER_OF_BURN_IN_SAMPLES, false );
+
+  traces.clear();
+  for ( int i = 0; i < numberOfStreams; ++i ) {
+    traces.push_back( streams[i]->str() );
+    delete streams[i];
+  }
+  for ( int chain = 0; chain < NUMBER_OF_CHAINS; ++chain ) {
+    delete samplers[chain];
+  }
+
+  return ( returnCode == EXIT_SUCCESS );
+}
+
+
+/** Run a Sampler with automatic burn-in detection, and check that
+ * the burn-in ended early. */
+bool RunWithAutomaticBurnIn( madai::Sampler & sampler,
+                             madai::Model & model,
+                             int numberOfSamples )
+{
+  madai::ConvergenceMonitor monitor;
+  monitor.SetDetectEndOfBurnIn( true );
+  std::ostringstream trace, progress;
+  int returnCode = madai::SamplerCSVWriter::GenerateSamplesAndSaveToFile(
+    sampler, model, trace, numberOfSamples, MAXIMUM_NUMBER_OF_BURN_IN_SAMPLES,
+    false, false, &progress, true, 0, "", 0, &monitor );
+  if ( returnCode != EXIT_SUCCESS ) {
+    std::cerr << "GenerateSamplesAndSaveToFile failed\n";
+    return false;
+  }
+  if ( progress.str().find( "stationary after" ) == std::string::npos ) {
+    std::cerr << "The end of the burn-in was not detected\n";
+    return false;
+  }
+  return true;
+}
+
+
+/** The adaptation stops where the burn-in is found to end, so that
+ * the kernel is fixed while the trace is recorded: the proposal after
+ * the trace is the one after the burn-in alone. */
+bool CheckAdaptationEndsWithBurnIn( madai::Model & model )
+{
+  madai::AdaptiveMetropolisSampler burnInOnly, withTrace;
+  madai::AdaptiveMetropolisSampler * ams[2] = { &burnInOnly, &withTrace };
+  for ( int k = 0; k < 2; ++k ) {
+    ams[k]->ReseedRandomNumberGenerator( 77 );
+    ams[k]->SetNumberOfAdaptationSamples( MAXIMUM_NUMBER_OF_BURN_IN_SAMPLES );
+    if ( !RunWithAutomaticBurnIn( *ams[k], model, k * NUMBER_OF_SAMPLES ) ) {
+      return false;
+    }
+  }
+  if ( withTrace.IsAdapting() ||
+       withTrace.GetProposalCovariance() != burnInOnly.GetProposalCovariance() ) {
+    std::cerr << "AdaptiveMetropolisSampler adapted during the trace\n";
+    return false;
+  }
+
+  madai::HamiltonianMonteCarloSampler hmcBurnInOnly, hmcWithTrace;
+  madai::HamiltonianMonteCarloSampler * hmcs[2] = { &hmcBurnInOnly, &hmcWithTrace };
+  for ( int k = 0; k < 2; ++k ) {
+    hmcs[k]->ReseedRandomNumberGenerator( 77 );
+    hmcs[k]->SetNumberOfAdaptationSamples( MAXIMUM_NUMBER_OF_BURN_IN_SAMPLES );
+    if ( !RunWithAutomaticBurnIn( *hmcs[k], model, k * NUMBER_OF_SAMPLES ) ) {
+      return false;
+    }
+  }
+  if ( hmcWithTrace.IsAdapting() ||
+       hmcWithTrace.GetStepSize() != hmcBurnInOnly.GetStepSize() ||
+       hmcWithTrace.GetInverseMassMatrix() != hmcBurnInOnly.GetInverseMassMatrix() ) {
+    std::cerr << "HamiltonianMonteCarloSampler adapted during the trace\n";
+    return false;
+  }
+  return true;
+}
+
+
+int main( int, char *[] )
+{
+  madai::Gaussian2DModel model;
+
+  std::vector< std::string > traces;
+  if ( !RunChains( model, false, traces ) ) {
+    std::cerr << "GenerateSamplesAndSaveToFiles failed\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector< std::vector< std::string > > chainLines;
+  for ( int chain = 0; chain < NUMBER_OF_CHAINS; ++chain ) {
+    chainLines.push_back( GetLines( traces[chain] ) );
+    if ( chainLines[chain].size() != NUMBER_OF_SAMPLES + 1 ) {
+      std::cerr << "Chain " << chain << " has " << chainLines[chain].size()
+                << " lines, expected " << NUMBER_OF_SAMPLES + 1 << "\n";
+      return EXIT_FAILURE;
+    }
+    if ( chainLines[chain][0] != chainLines[0][0] ) {
+      std::cerr << "Chain " << chain << " has a different header\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Differently seeded chains must not produce the same trace.
+  if ( traces[0] == traces[1] || traces[1] == traces[2] ) {
+    std::cerr << "Chains with different seeds produced the same trace\n";
+    return EXIT_FAILURE;
+  }
+
+  // Interleaving takes one sample from each chain in turn.
+  std::vector< std::string > interleavedTraces;
+  if ( !RunChains( model, true, interleavedTraces ) ) {
+    std::cerr << "GenerateSamplesAndSaveToFiles failed when interleaving\n";
+    return EXIT_FAILURE;
+  }
+  std::vector< std::string > interleavedLines =
+    GetLines( interleavedTraces[0] );
+  if ( interleavedLines.size() != NUMBER_OF_CHAINS * NUMBER_OF_SAMPLES + 1 ) {
+    std::cerr << "Interleaved trace has " << interleavedLines.size()
+              << " lines, expected "
+              << NUMBER_OF_CHAINS * NUMBER_OF_SAMPLES + 1 << "\n";
+    return EXIT_FAILURE;
+  }
+  for ( int i = 0; i < NUMBER_OF_SAMPLES; ++i ) {
+    for ( int chain = 0; chain < NUMBER_OF_CHAINS; ++chain ) {
+      if ( interleavedLines[1 + i * NUMBER_OF_CHAINS + chain] !=
+           chainLines[chain][1 + i] ) {
+        std::cerr << "Interleaved sample " << i << " of chain " << chain
+                  << " differs from the separate trace\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  if ( !CheckAdaptationEndsWithBurnIn( model ) ) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AdaptiveMetropolisSampler.h"
+#include "EnsembleSampler.h"
+#include "Gaussian2DModel.h"
+#include "HamiltonianMonteCarloSampler.h"
+#include "MetropolisHastingsSampler.h"
+#include "ParallelTemperingSampler.h"
+#include "SamplerCSVWriter.h"
+
+
+static const unsigned int NUMBER_OF_SAMPLES_BEFORE = 300;
+static const unsigned int NUMBER_OF_SAMPLES_AFTER = 200;
+
+
+/** Run a Sampler, checkpoint it, and check that a Sampler restored
+ * from the checkpoint continues the chain exactly. */
+bool CheckContinuation( const std::string & name,
+                        madai::Model & model,
+                        madai::Sampler & sampler,
+                        madai::Sampler & restored )
+{
+  sampler.ReseedRandomNumberGenerator( 1234 );
+  sampler.SetModel( &model );
+  for ( unsigned int i = 0; i < NUMBER_OF_SAMPLES_BEFORE; ++i ) {
+    sampler.NextSample();
+  }
+
+  std::vector< madai::Sampler * > samplers( 1, &sampler );
+  std::stringstream checkpoint;
+  madai::SamplerCSVWriter::WriteCheckpoint(
+    checkpoint, samplers, NUMBER_OF_SAMPLES_BEFORE );
+
+  restored.ReseedRandomNumberGenerator( 5678 );
+  restored.SetModel( &model );
+  std::vector< madai::Sampler * > restoredSamplers( 1, &restored );
+  int numberOfCompletedSamples = 0;
+  if ( !madai::SamplerCSVWriter::ReadCheckpoint(
+         checkpoint, restoredSamplers, numberOfCompletedSamples ) ) {
+    std::cerr << name << ": could not read the checkpoint\n";
+    return false;
+  }
+  if ( numberOfCompletedSamples != NUMBER_OF_SAMPLES_BEFORE ) {
+    std::cerr << name << ": checkpoint has " << numberOfCompletedSamples
+              << " samples, expected " << NUMBER_OF_SAMPLES_BEFORE << "\n";
+    return false;
+  }
+
+  for ( unsigned int i = 0; i < NUMBER_OF_SAMPLES_AFTER; ++i ) {
+    madai::Sample expected = sampler.NextSample();
+    madai::Sample sample = restored.NextSample();
+    if ( !( sample == expected ) ||
+         sample.m_LogLikelihood != expected.m_LogLikelihood ) {
+      std::cerr << name << ": sample " << i << " after the checkpoint "
+                << "differs\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+
+int main( int, char *[] )
+{
+  madai::Gaussian2DModel model;
+
+  madai::MetropolisHastingsSampler mhs, mhsRestored;
+  mhs.SetStepSize( 0.5 );
+  mhsRestored.SetStepSize( 0.5 );
+  if ( !CheckContinuation( "MetropolisHastingsSampler",
+                           model, mhs, mhsRestored ) ) {
+    return EXIT_FAILURE;
+  }
+
+  madai::AdaptiveMetropolisSampler ams, amsRestored;
+  if ( !CheckContinuation( "AdaptiveMetropolisSampler",
+                           model, ams, amsRestored ) ) {
+    return EXIT_FAILURE;
+  }
+
+  madai::HamiltonianMonteCarloSampler hmcs, hmcsRestored;
+  if ( !CheckContinuation( "HamiltonianMonteCarloSampler",
+                           model, hmcs, hmcsRestored ) ) {
+    return EXIT_FAILURE;
+  }
+
+  madai::EnsembleSampler es, esRestored;
+  if ( !CheckContinuation( "EnsembleSampler", model, es, esRestored ) ) {
+    return EXIT_FAILURE;
+  }
+
+  madai::ParallelTemperingSampler pts, ptsRestored;
+  if ( !CheckContinuation( "ParallelTemperingSampler",
+                           model, pts, ptsRestored ) ) {
+    return EXIT_FAILURE;
+  }
+
+  // The state of one type of Sampler cannot be read into another.
+  std::vector< madai::Sampler * > samplers( 1, &mhs );
+  std::stringstream checkpoint;
+  madai::SamplerCSVWriter::WriteCheckpoint( checkpoint, samplers, 1 );
+  madai::HamiltonianMonteCarloSampler other;
+  other.SetModel( &model );
+  std::vector< madai::Sampler * > otherSamplers( 1, &other );
+  int numberOfCompletedSamples = 0;
+  if ( madai::SamplerCSVWriter::ReadCheckpoint(
+         checkpoint, otherSamplers, numberOfCompletedSamples ) ) {
+    std::cerr << "Read the checkpoint of a MetropolisHastingsSampler into "
+              << "a HamiltonianMonteCarloSampler\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
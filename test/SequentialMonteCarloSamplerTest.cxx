@@ -0,0 +1,146 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "CorrelatedGaussianModel.h"
+#include "SequentialMonteCarloSampler.h"
+
+
+static const double PRIOR_WIDTH = 20.0;
+static const double MEANS[2] = { 1.0, -2.0 };
+static const double DEVIATIONS[2] = { 0.5, 2.0 };
+static const double CORRELATION = 0.8;
+
+
+int main( int, char *[] )
+{
+  static const unsigned int NUMBER_OF_PARTICLES = 2000;
+
+  // The posterior is a Gaussian well inside the uniform priors, so
+  // the evidence is known.
+  madai::CorrelatedGaussianModel model(
+    std::vector< double >( MEANS, MEANS + 2 ),
+    std::vector< double >( DEVIATIONS, DEVIATIONS + 2 ), CORRELATION );
+  model.SetPriorBounds( -0.5 * PRIOR_WIDTH, 0.5 * PRIOR_WIDTH );
+  model.AddUnobservedParameter( "Z", -0.5 * PRIOR_WIDTH, 0.5 * PRIOR_WIDTH );
+
+  madai::SequentialMonteCarloSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  sampler.SetNumberOfParticles( NUMBER_OF_PARTICLES );
+  // Z is fixed, so only X and Y are sampled.
+  sampler.DeactivateParameter( "Z" );
+  sampler.SetParameterValue( "Z", 3.0 );
+
+  if ( sampler.IsFinished() ) {
+    std::cerr << "Sampler should not run before it is asked to\n";
+    return EXIT_FAILURE;
+  }
+  sampler.Run();
+  if ( !sampler.IsFinished() ) {
+    std::cerr << "Sampler should have reached the posterior\n";
+    return EXIT_FAILURE;
+  }
+
+  // The tempering schedule rises from 0 to 1 in several stages.
+  const std::vector< double > & schedule = sampler.GetInverseTemperatures();
+  if ( schedule.size() < 3 || schedule.front() != 0.0 ||
+       schedule.back() != 1.0 ) {
+    std::cerr << "Unexpected tempering schedule with " << schedule.size()
+              << " entries\n";
+    return EXIT_FAILURE;
+  }
+  for ( unsigned int i = 1; i < schedule.size(); ++i ) {
+    if ( !( schedule[i] > schedule[i - 1] ) ) {
+      std::cerr << "Tempering schedule is not increasing\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The evidence is the mean likelihood over the two active priors.
+  double determinant = DEVIATIONS[0] * DEVIATIONS[0] *
+    DEVIATIONS[1] * DEVIATIONS[1] * ( 1.0 - CORRELATION * CORRELATION );
+  double expectedLogEvidence = std::log(
+    2.0 * M_PI * std::sqrt( determinant ) / ( PRIOR_WIDTH * PRIOR_WIDTH ) );
+  if ( std::fabs( sampler.GetLogEvidence() - expectedLogEvidence ) > 0.15 ) {
+    std::cerr << "Log evidence is " << sampler.GetLogEvidence()
+              << ", expected " << expectedLogEvidence << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // Two rounds of particles, the second after another move.
+  unsigned int numberOfSamples = 2 * NUMBER_OF_PARTICLES;
+  double sum[2] = { 0.0, 0.0 };
+  double sumOfProducts[3] = { 0.0, 0.0, 0.0 };
+  for ( unsigned int i = 0; i < numberOfSamples; ++i ) {
+    madai::Sample sample = sampler.NextSample();
+    if ( sample.m_ParameterValues[2] != 3.0 ) {
+      std::cerr << "Inactive parameter changed\n";
+      return EXIT_FAILURE;
+    }
+    double x = sample.m_ParameterValues[0];
+    double y = sample.m_ParameterValues[1];
+    sum[0] += x;
+    sum[1] += y;
+    sumOfProducts[0] += x * x;
+    sumOfProducts[1] += x * y;
+    sumOfProducts[2] += y * y;
+  }
+  double meanX = sum[0] / numberOfSamples;
+  double meanY = sum[1] / numberOfSamples;
+  double deviationX =
+    std::sqrt( sumOfProducts[0] / numberOfSamples - meanX * meanX );
+  double deviationY =
+    std::sqrt( sumOfProducts[2] / numberOfSamples - meanY * meanY );
+  double correlation = ( sumOfProducts[1] / numberOfSamples - meanX * meanY ) /
+    ( deviationX * deviationY );
+  if ( std::fabs( meanX - MEANS[0] ) > 0.1 * DEVIATIONS[0] ||
+       std::fabs( meanY - MEANS[1] ) > 0.1 * DEVIATIONS[1] ||
+       std::fabs( deviationX / DEVIATIONS[0] - 1.0 ) > 0.1 ||
+       std::fabs( deviationY / DEVIATIONS[1] - 1.0 ) > 0.1 ||
+       std::fabs( correlation - CORRELATION ) > 0.05 ) {
+    std::cerr << "Samples have means " << meanX << ", " << meanY
+              << ", standard deviations " << deviationX << ", " << deviationY
+              << " and correlation " << correlation << "\n";
+    return EXIT_FAILURE;
+  }
+
+  double acceptance = sampler.GetAcceptanceRate();
+  if ( acceptance < 0.1 || acceptance > 0.9 ) {
+    std::cerr << "Acceptance rate " << acceptance << " is implausible\n";
+    return EXIT_FAILURE;
+  }
+
+  // Setting a parameter starts over from the priors.
+  sampler.SetParameterValue( "Z", 4.0 );
+  if ( sampler.IsFinished() ) {
+    std::cerr << "Setting a parameter should discard the particles\n";
+    return EXIT_FAILURE;
+  }
+  madai::Sample sample = sampler.NextSample();
+  if ( !sampler.IsFinished() || sample.m_ParameterValues[2] != 4.0 ) {
+    std::cerr << "Sampler did not restart with the new parameter value\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+/*=========================================================================
+ *
+ *  Copyright 2011-2013 The University of North Carolina at Chapel Hill
+ *  All rights reserved.
+ *
+ *  Licensed under the MADAI Software License. You may obtain a copy of
+ *  this license at
+ *
+ *         https://madai-public.cs.unc.edu/visualization/software-license/
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "SobolSampler.h"
+#include "UniformDistribution.h"
+
+
+static const unsigned int NUMBER_OF_PARAMETERS = 3;
+
+
+/** \class Model whose outputs are its parameters, which have uniform
+ * priors on [0, 1] and are observed at 0.5. It counts the points it
+ * is asked to evaluate together. */
+class UnitCubeModel : public madai::Model {
+public:
+  UnitCubeModel( bool concurrent = false ) :
+    m_Concurrent( concurrent ),
+    m_NumberOfEvaluations( 0 ),
+    m_LargestBlock( 0 )
+  {
+    madai::UniformDistribution prior;
+    prior.SetMinimum( 0.0 );
+    prior.SetMaximum( 1.0 );
+    const char * names[ NUMBER_OF_PARAMETERS ] = { "X", "Y", "Z" };
+    for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+      this->AddParameter( names[i], prior );
+      this->AddScalarOutputName( names[i] );
+      m_ObservedScalarValues.push_back( 0.5 );
+    }
+    m_ObservedScalarCovariance.assign(
+      NUMBER_OF_PARAMETERS * NUMBER_OF_PARAMETERS, 0.0 );
+    for ( unsigned int i = 0; i < NUMBER_OF_PARAMETERS; ++i ) {
+      m_ObservedScalarCovariance[ i * ( NUMBER_OF_PARAMETERS + 1 ) ] = 0.01;
+    }
+    m_StateFlag = READY;
+  }
+
+  virtual ErrorType GetScalarOutputs( const std::vector< double > & parameters,
+                                      std::vector< double > & scalars ) const
+  {
+    scalars = parameters;
+    return NO_ERROR;
+  }
+
+  virtual bool SupportsConcurrentEvaluation() const
+  {
+    return m_Concurrent;
+  }
+
+  virtual ErrorType GetScalarOutputsAndLogLikelihoods(
+    const std::vector< std::vector< double > > & parameters,
+    std::vector< std::vector< double > > & scalars,
+    std::vector< double > & logLikelihoods ) const
+  {
+    unsigned int size = static_cast< unsigned int >( parameters.size() );
+    m_NumberOfEvaluations += size;
+    m_LargestBlock = std::max( m_LargestBlock, size );
+    return madai::Model::GetScalarOutputsAndLogLikelihoods(
+      parameters, scalars, logLikelihoods );
+  }
+
+  bool m_Concurrent;
+  mutable unsigned int m_NumberOfEvaluations;
+  mutable unsigned int m_LargestBlock;
+};
+
+
+int main( int, char *[] )
+{
+  UnitCubeModel model;
+
+  // The unscrambled sequence starts with the familiar points.
+  madai::SobolSampler plain;
+  plain.SetScramble( false );
+  plain.SetModel( &model );
+  const double expected[3][3] = {
+    { 0.5, 0.5, 0.5 }, { 0.75, 0.25, 0.25 }, { 0.25, 0.75, 0.75 } };
+  std::vector< double > point;
+  for ( unsigned int n = 0; n < 3; ++n ) {
+    plain.GetUnitPoint( n + 1, NUMBER_OF_PARAMETERS, point );
+    for ( unsigned int d = 0; d < NUMBER_OF_PARAMETERS; ++d ) {
+      if ( std::fabs( point[d] - expected[n][d] ) > 1e-9 ) {
+        std::cerr << "Point " << n + 1 << " has coordinate " << d << " "
+                  << point[d] << ", expected " << expected[n][d] << "\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // The first 2^10 scrambled points put one point in each of 2^10
+  // intervals of each parameter, and one point in each of 32 x 32
+  // boxes of the first two.
+  const unsigned int numberOfSamples = 1024;
+  madai::SobolSampler sampler;
+  sampler.ReseedRandomNumberGenerator( 42 );
+  sampler.SetModel( &model );
+  std::vector< std::vector< unsigned int > > counts(
+    NUMBER_OF_PARAMETERS, std::vector< unsigned int >( numberOfSamples, 0 ) );
+  std::vector< unsigned int > boxCounts( numberOfSamples, 0 );
+  std::vector< madai::Sample > samples;
+  for ( unsigned int n = 0; n < numberOfSamples; ++n ) {
+    madai::Sample sample = sampler.NextSample();
+    samples.push_back( sample );
+    const std::vector< double > & x = sample.m_ParameterValues;
+    for ( unsigned int d = 0; d < NUMBER_OF_PARAMETERS; ++d ) {
+      ++counts[d][ static_cast< unsigned int >( x[d] * numberOfSamples ) ];
+    }
+    ++boxCounts[ static_cast< unsigned int >( x[0] * 32 ) * 32 +
+                 static_cast< unsigned int >( x[1] * 32 ) ];
+
+    double logWeight = sample.m_LogLikelihood -
+      model.GetLogPriorLikelihood( sample.m_ParameterValues );
+    if ( std::fabs( sampler.GetLogImportanceWeight() - logWeight ) > 1e-12 ||
+         sample.m_OutputValues != sample.m_ParameterValues ) {
+      std::cerr << "Sample " << n << " was not evaluated\n";
+      return EXIT_FAILURE;
+    }
+  }
+  for ( unsigned int i = 0; i < numberOfSamples; ++i ) {
+    for ( unsigned int d = 0; d < NUMBER_OF_PARAMETERS; ++d ) {
+      if ( counts[d][i] != 1 ) {
+        std::cerr << "Interval " << i << " of parameter " << d << " has "
+                  << counts[d][i] << " points\n";
+        return EXIT_FAILURE;
+      }
+    }
+    if ( boxCounts[i] != 1 ) {
+      std::cerr << "Box " << i << " has " << boxCounts[i] << " points\n";
+      return EXIT_FAILURE;
+    }
+  }
+  if ( sampler.GetIndex() != numberOfSamples ) {
+    std::cerr << "Index is " << sampler.GetIndex() << ", expected "
+              << numberOfSamples << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // A Sampler with the same seed started further along the sequence
+  // continues it.
+  madai::SobolSampler shard;
+  shard.ReseedRandomNumberGenerator( 42 );
+  shard.SetModel( &model );
+  shard.SetBlockSize( 7 );
+  shard.SetIndex( 500 );
+  for ( unsigned int n = 500; n < 520; ++n ) {
+    if ( !( shard.NextSample() == samples[n] ) ) {
+      std::cerr << "Sample " << n << " differs when started at 500\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // A shard evaluates no point past the end of its range, and a Model
+  // that cannot evaluate points in parallel is evaluated one point at
+  // a time.
+  UnitCubeModel concurrentModel( true );
+  madai::SobolSampler bounded;
+  bounded.ReseedRandomNumberGenerator( 42 );
+  bounded.SetModel( &concurrentModel );
+  bounded.SetIndex( 500 );
+  bounded.SetEndIndex( 510 );
+  for ( unsigned int n = 500; n < 510; ++n ) {
+    if ( !( bounded.NextSample() == samples[n] ) ) {
+      std::cerr << "Sample " << n << " differs in a bounded range\n";
+      return EXIT_FAILURE;
+    }
+  }
+  if ( concurrentModel.m_NumberOfEvaluations != 10 ) {
+    std::cerr << "Evaluated " << concurrentModel.m_NumberOfEvaluations
+              << " points for a range of 10\n";
+    return EXIT_FAILURE;
+  }
+  if ( model.m_LargestBlock != 1 ) {
+    std::cerr << "Evaluated " << model.m_LargestBlock << " points together "
+              << "for a Model without concurrent evaluation\n";
+    return EXIT_FAILURE;
+  }
+
+  // Inactive parameters stay where they were set.
+  shard.SetParameterValue( "Y", 0.3 );
+  shard.DeactivateParameter( "Y" );
+  for ( unsigned int n = 0; n < 100; ++n ) {
+    if ( shard.NextSample().m_ParameterValues[1] != 0.3 ) {
+      std::cerr << "Inactive parameter changed\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}